@@ -0,0 +1,48 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef ARGUMENTS_H_
+#define ARGUMENTS_H_
+
+#include <filesystem>
+
+#include "render_device.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr auto kDefaultHeadlessFrameCount = 1000u;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct Arguments {
+    Backend backend = Backend::kMetal;
+    uint32_t frame_count = kDefaultHeadlessFrameCount;
+    uint32_t thread_count = 0;
+    uint32_t frames_in_flight = kDefaultFramesInFlight;
+    std::filesystem::path shader_cache_directory;
+    bool hot_reload = false;
+    //! A frame time budget in milliseconds dynamic resolution aims for, zero disables it.
+    float frame_budget = 0.0f;
+    bool idle = false;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Parse command line arguments.
+//! Pass "--headless [frame_count]" to run an example without a window and a GPU,
+//! "--software [frame_count]" to run it on the software rasterizer and "--threads count" to set workers of jobs.
+//! "--frames-in-flight count" sets how many frames the CPU can record ahead of the GPU.
+//! "--shader-cache directory" stores compiled shader libraries so warm starts skip compilation.
+//! "--hot-reload" watches assets and reloads changed shaders while an example runs.
+//! "--frame-budget milliseconds" scales the render resolution to keep frames within a budget.
+//! "--idle" updates and renders a window only when something changes, and a keep-alive frame otherwise.
+//! \param argc The number of arguments.
+//! \param argv Arguments.
+//! \return Parsed arguments.
+extern Arguments ParseArguments(int argc, char *argv[]);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,137 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef ASSET_ARCHIVE_H_
+#define ASSET_ARCHIVE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "file_view.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr auto kAssetArchiveMagic = 0x4b41504du; // "MPAK"
+constexpr auto kAssetArchiveVersion = 1u;
+constexpr auto kAssetArchiveAlignment = 16u;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct AssetArchiveHeader {
+    uint32_t magic = kAssetArchiveMagic;
+    uint32_t version = kAssetArchiveVersion;
+    uint32_t entry_count = 0;
+    uint32_t reserved = 0;
+    uint64_t index_offset = 0;
+    uint64_t names_offset = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Entries are sorted by hashes of names so a lookup is a binary search without touching names.
+struct AssetArchiveEntry {
+    uint64_t hash = 0;
+    uint32_t name_offset = 0;
+    uint32_t name_size = 0;
+    uint64_t data_offset = 0;
+    uint64_t data_size = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A read only archive of assets. The archive is mapped once and every asset is a view into it.
+class AssetArchive {
+public:
+    //! Constructor.
+    //! \param path An archive file path.
+    explicit AssetArchive(const std::filesystem::path &path);
+
+    //! Find an asset.
+    //! \param name A name of an asset, a path relative to the packed directory with forward slashes.
+    //! \return The content of an asset, or nothing if an archive doesn't contain it.
+    [[nodiscard]]
+    std::optional<std::span<const std::byte>> Find(std::string_view name) const;
+
+    //! Retrieve the content of an asset as bytes.
+    //! \param name A name of an asset.
+    //! \return The content of an asset.
+    [[nodiscard]]
+    std::span<const std::byte> GetBytes(std::string_view name) const;
+
+    //! Retrieve the content of an asset as a string.
+    //! \param name A name of an asset.
+    //! \return The content of an asset.
+    [[nodiscard]]
+    std::string_view GetString(std::string_view name) const;
+
+    //! Query whether an archive contains an asset.
+    //! \param name A name of an asset.
+    //! \return True if an archive contains an asset.
+    [[nodiscard]]
+    inline auto Contains(std::string_view name) const {
+        return Find(name).has_value();
+    }
+
+    //! Retrieve the number of assets.
+    //! \return The number of assets.
+    [[nodiscard]]
+    inline auto GetCount() const {
+        return _entries.size();
+    }
+
+private:
+    //! Retrieve a name of an entry.
+    [[nodiscard]]
+    std::string_view GetName(const AssetArchiveEntry &entry) const;
+
+private:
+    FileView _view;
+    std::span<const AssetArchiveEntry> _entries;
+    std::span<const char> _names;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class AssetArchiveWriter {
+public:
+    //! Add an asset.
+    //! \param name A name of an asset.
+    //! \param data The content of an asset.
+    void Add(const std::string &name, std::vector<std::byte> data);
+
+    //! Add every regular file in a directory recursively, names are relative to the directory.
+    //! \param directory A directory.
+    void AddDirectory(const std::filesystem::path &directory);
+
+    //! Write an archive.
+    //! \param path An archive file path.
+    void Write(const std::filesystem::path &path) const;
+
+    //! Retrieve the number of assets.
+    //! \return The number of assets.
+    [[nodiscard]]
+    inline auto GetCount() const {
+        return _assets.size();
+    }
+
+private:
+    struct Asset {
+        std::string name;
+        std::vector<std::byte> data;
+    };
+
+private:
+    std::vector<Asset> _assets;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,100 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef ASSET_COOKER_H_
+#define ASSET_COOKER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "job_system.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct AssetCookResult {
+    std::vector<std::byte> data;
+    std::vector<std::filesystem::path> dependencies;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A processor converts a source asset into a runtime ready asset.
+class AssetProcessor {
+public:
+    //! Destructor.
+    virtual ~AssetProcessor() = default;
+
+    //! Retrieve an identifier of a processor. Cooked assets are invalidated when the identifier is changed.
+    //! \return An identifier of a processor.
+    [[nodiscard]]
+    virtual std::string GetIdentifier() const = 0;
+
+    //! Query whether a processor handles an asset.
+    //! \param path A source asset path.
+    //! \return True if a processor handles an asset.
+    [[nodiscard]]
+    virtual bool Accept(const std::filesystem::path &path) const = 0;
+
+    //! Process an asset. It is called from many threads at the same time.
+    //! \param path A source asset path.
+    //! \param source The content of a source asset.
+    //! \return A cooked asset and other files were read to cook it.
+    virtual AssetCookResult Process(const std::filesystem::path &path, std::span<const std::byte> source) const = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct AssetCookStatistics {
+    uint32_t cooked_count = 0;
+    uint32_t skipped_count = 0;
+    uint32_t removed_count = 0;
+    uint32_t failed_count = 0;
+    std::vector<std::string> errors;
+    std::chrono::duration<double> elapsed_time = std::chrono::duration<double>::zero();
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A cooker mirrors a source directory into an output directory of cooked assets. The key of every asset, a hash of
+//! its processor, its content and the content of its dependencies, is kept in a database, so only assets whose key
+//! is changed are cooked again. Assets are independent and cooked in parallel.
+class AssetCooker {
+public:
+    //! Constructor.
+    //! \param job_system A job system cooks assets, it must outlive a cooker.
+    explicit AssetCooker(JobSystem *job_system);
+
+    //! Add a processor. An asset is copied as is if no processor accepts it.
+    //! \param processor A processor.
+    void AddProcessor(std::unique_ptr<AssetProcessor> processor);
+
+    //! Cook assets.
+    //! \param source_directory A directory of source assets.
+    //! \param output_directory A directory where cooked assets are written.
+    //! \param database_path A database file path, it must not be inside the output directory.
+    //! \return Statistics.
+    AssetCookStatistics Cook(const std::filesystem::path &source_directory,
+                             const std::filesystem::path &output_directory,
+                             const std::filesystem::path &database_path);
+
+private:
+    //! Find a processor of an asset.
+    [[nodiscard]]
+    const AssetProcessor *FindProcessor(const std::filesystem::path &path) const;
+
+private:
+    JobSystem *_job_system = nullptr;
+    std::vector<std::unique_ptr<AssetProcessor>> _processors;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,281 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef BVH_H_
+#define BVH_H_
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "frustum.h"
+#include "job_system.h"
+#include "mesh.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr auto kBvhBinCount = 16u;
+constexpr auto kBvhMaxLeafSize = 8u;
+
+// A node this deep is a leaf regardless of its size, it bounds the stack of a traversal.
+constexpr auto kBvhMaxDepth = 64u;
+constexpr auto kBvhNoHit = ~0u;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct Aabb {
+    std::array<float, 3> min = {std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+                                std::numeric_limits<float>::max()};
+    std::array<float, 3> max = {std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(),
+                                std::numeric_limits<float>::lowest()};
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct Ray {
+    std::array<float, 3> origin = {0.0f, 0.0f, 0.0f};
+    std::array<float, 3> direction = {0.0f, 0.0f, 1.0f};
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct BvhHit {
+    uint32_t primitive = kBvhNoHit;
+    float distance = std::numeric_limits<float>::infinity();
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A node is 32 bytes. Children of an interior node are adjacent, so a node refers to the first one only.
+struct BvhNode {
+    std::array<float, 3> min = {};
+    //! The first child of an interior node, or the first primitive of a leaf.
+    uint32_t offset = 0;
+    std::array<float, 3> max = {};
+    //! The number of primitives of a leaf, zero for an interior node.
+    uint32_t count = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct BvhStatistics {
+    uint32_t primitive_count = 0;
+    uint32_t node_count = 0;
+    uint32_t leaf_count = 0;
+    uint32_t subtree_count = 0;
+    //! The surface area heuristic cost of a tree, relative to testing a primitive.
+    float cost = 0.0f;
+    std::chrono::duration<double> build_time = std::chrono::duration<double>::zero();
+    std::chrono::duration<double> refit_time = std::chrono::duration<double>::zero();
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Unproject a point through a camera.
+//! \param view_projection A view projection matrix with depth in [0, 1].
+//! \param x A horizontal position in [-1, 1] from left to right.
+//! \param y A vertical position in [-1, 1] from bottom to top.
+//! \return A ray from the near plane with a normalized direction.
+Ray MakeRay(const Matrix4 &view_projection, float x, float y);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Intersect a ray with a triangle.
+//! \param ray A ray.
+//! \param p0 A position of a triangle.
+//! \param p1 A position of a triangle.
+//! \param p2 A position of a triangle.
+//! \return The distance along a ray to a hit, or infinity without a hit. Both sides of a triangle are hit.
+float IntersectTriangle(const Ray &ray, const std::array<float, 3> &p0, const std::array<float, 3> &p1,
+                        const std::array<float, 3> &p2);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Calculate bounds of triangles of a mesh.
+//! \param mesh A mesh.
+//! \return Bounds of every triangle.
+std::vector<Aabb> MakeTriangleBounds(const Mesh &mesh);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A bounding volume hierarchy over bounds of primitives, split by the surface area heuristic over binned centroids.
+class Bvh {
+public:
+    //! Constructor.
+    //! \param job_system A job system builds a tree, it must outlive a tree.
+    explicit Bvh(JobSystem *job_system);
+
+    //! Build a tree. Large nodes are binned on jobs, and subtrees below them are built in parallel.
+    //! \param bounds Bounds of primitives.
+    void Build(std::span<const Aabb> bounds);
+
+    //! Update bounds of nodes after primitives moved, keeping the topology of a tree.
+    //! \param bounds Bounds of primitives in the order they were built with.
+    void Refit(std::span<const Aabb> bounds);
+
+    //! Find the nearest hit of a ray.
+    //! \param ray A ray.
+    //! \param max_distance The maximum distance along a ray.
+    //! \param intersect A function returns the distance to a primitive along a ray, or infinity without a hit.
+    //! \return The nearest hit.
+    template<typename F>
+    BvhHit Intersect(const Ray &ray, float max_distance, F &&intersect) const;
+
+    //! Find primitives whose bounds overlap a box.
+    //! \param box A box.
+    //! \param primitives Indices of overlapped primitives.
+    void Query(const Aabb &box, std::vector<uint32_t> &primitives) const;
+
+    //! Retrieve nodes, the first node is the root.
+    //! \return Nodes.
+    [[nodiscard]]
+    inline std::span<const BvhNode> GetNodes() const {
+        return _nodes;
+    }
+
+    //! Retrieve statistics.
+    //! \return Statistics.
+    [[nodiscard]]
+    inline const auto &GetStatistics() const {
+        return _statistics;
+    }
+
+private:
+    struct Bin {
+        Aabb bounds;
+        uint32_t count = 0;
+    };
+
+    using Bins = std::array<Bin, kBvhBinCount>;
+
+    //! Bounds are copied next to a primitive, so a build reads primitives of a node contiguously.
+    struct Reference {
+        Aabb bounds;
+        uint32_t primitive = 0;
+    };
+
+    struct Task {
+        uint32_t node = 0;
+        uint32_t begin = 0;
+        uint32_t end = 0;
+        uint32_t depth = 0;
+    };
+
+private:
+    //! Build nodes from a root. Ranges small enough are left to subtrees if there is a list of them.
+    void BuildNodes(std::vector<BvhNode> &nodes, const Task &root, std::vector<Task> *subtrees);
+
+    //! Split primitives of a node, or make it a leaf.
+    //! \return The number of primitives of the first child, or zero for a leaf.
+    uint32_t Split(BvhNode &node, const Task &task, bool parallel);
+
+    //! Map chunks of a range on jobs and merge the results, or map a whole range at once.
+    template<typename T, typename Map, typename Merge>
+    T Reduce(uint32_t begin, uint32_t end, bool parallel, Map &&map, Merge &&merge);
+
+private:
+    JobSystem *_job_system = nullptr;
+    std::vector<Aabb> _bounds;
+    std::vector<Reference> _references;
+    std::vector<uint32_t> _primitives;
+    std::vector<BvhNode> _nodes;
+    BvhStatistics _statistics;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template<typename F>
+BvhHit Bvh::Intersect(const Ray &ray, float max_distance, F &&intersect) const {
+    BvhHit hit;
+    hit.distance = max_distance;
+    if (_nodes.empty()) {
+        hit.distance = std::numeric_limits<float>::infinity();
+        return hit;
+    }
+
+    std::array<float, 3> inv_direction;
+    for (auto i = 0u; i != 3; ++i) {
+        inv_direction[i] = 1.0f / ray.direction[i];
+    }
+
+    // Slabs of a node give the distance a ray enters it, or infinity if it misses.
+    auto enter = [&](const BvhNode &node) {
+        auto near = 0.0f;
+        auto far = hit.distance;
+        for (auto i = 0u; i != 3; ++i) {
+            auto t0 = (node.min[i] - ray.origin[i]) * inv_direction[i];
+            auto t1 = (node.max[i] - ray.origin[i]) * inv_direction[i];
+            near = std::max(near, std::min(t0, t1));
+            far = std::min(far, std::max(t0, t1));
+        }
+        return near <= far ? near : std::numeric_limits<float>::infinity();
+    };
+
+    std::array<uint32_t, kBvhMaxDepth> stack;
+    auto stack_size = 0u;
+    auto index = enter(_nodes[0]) < std::numeric_limits<float>::infinity() ? 0u : kBvhNoHit;
+
+    while (index != kBvhNoHit) {
+        auto &node = _nodes[index];
+        index = kBvhNoHit;
+
+        if (node.count) {
+            for (auto i = node.offset; i != node.offset + node.count; ++i) {
+                auto distance = intersect(_primitives[i], ray);
+                if (distance < hit.distance) {
+                    hit.primitive = _primitives[i];
+                    hit.distance = distance;
+                }
+            }
+        } else {
+            // Visit the nearer child first, so the farther one is likely pruned by a closer hit.
+            auto near_index = node.offset;
+            auto far_index = node.offset + 1;
+            auto near = enter(_nodes[near_index]);
+            auto far = enter(_nodes[far_index]);
+            if (far < near) {
+                std::swap(near_index, far_index);
+                std::swap(near, far);
+            }
+
+            if (near < std::numeric_limits<float>::infinity()) {
+                index = near_index;
+                if (far < std::numeric_limits<float>::infinity()) {
+                    stack[stack_size++] = far_index;
+                }
+            }
+        }
+
+        // Nodes on the stack were entered before a closer hit, so test them again.
+        while (index == kBvhNoHit && stack_size) {
+            auto candidate = stack[--stack_size];
+            if (enter(_nodes[candidate]) < std::numeric_limits<float>::infinity()) {
+                index = candidate;
+            }
+        }
+    }
+
+    if (hit.primitive == kBvhNoHit) {
+        hit.distance = std::numeric_limits<float>::infinity();
+    }
+    return hit;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Find the nearest triangle of a mesh a ray hits.
+//! \param bvh A tree built with bounds of triangles of a mesh.
+//! \param mesh A mesh.
+//! \param ray A ray.
+//! \return The nearest hit, a primitive is the index of a triangle.
+BvhHit IntersectMesh(const Bvh &bvh, const Mesh &mesh, const Ray &ray);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -7,6 +7,7 @@
 #define CAMERA_H_
 
 #include "utility.h"
+#include "vector_math.h"
 
 //----------------------------------------------------------------------------------------------------------------------
 
@@ -37,6 +38,27 @@ public:
     //! \param radius The radius.
     void SetRadius(float radius);
 
+    //! Retrieve a vertical field of view.
+    //! \return A vertical field of view in radians.
+    [[nodiscard]]
+    inline auto GetFov() const {
+        return _fov;
+    }
+
+    //! Retrieve the radius, the distance from a target.
+    //! \return The radius.
+    [[nodiscard]]
+    inline auto GetRadius() const {
+        return _radius;
+    }
+
+    //! Retrieve a position.
+    //! \return A position.
+    [[nodiscard]]
+    inline auto GetPosition() const {
+        return _position;
+    }
+
     //! Retrieve a forward vector.
     //! \return A forward vector.
     [[nodiscard]]
@@ -0,0 +1,383 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef COMMAND_STREAM_H_
+#define COMMAND_STREAM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "job_system.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// A recorder writes commands into chunks of this many bytes, chunks are kept and reused by later frames.
+constexpr auto kCommandChunkSize = 65536u;
+
+// The largest size of inline bytes, Metal doesn't accept more with setVertexBytes.
+constexpr auto kCommandMaxBytesSize = 4096u;
+
+// Every command starts at a multiple of this, so fields of commands are aligned.
+constexpr auto kCommandAlignment = 8u;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+enum class CommandType : uint16_t {
+    kSetPipeline,
+    kSetBuffer,
+    kSetBytes,
+    kDraw,
+    kDrawIndexed
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+enum class CommandStage : uint8_t {
+    kVertex,
+    kFragment
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Values are equal to MTLPrimitiveType.
+enum class CommandPrimitiveType : uint8_t {
+    kPoint,
+    kLine,
+    kLineStrip,
+    kTriangle,
+    kTriangleStrip
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Values are equal to MTLIndexType.
+enum class CommandIndexType : uint8_t {
+    kUInt16,
+    kUInt32
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct CommandHeader {
+    CommandType type = CommandType::kSetPipeline;
+    //! The size of a command with its payload, the next command starts right after it.
+    uint16_t size = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Pipelines and buffers are referred by handles, which a backend resolves to its own objects when it executes.
+struct SetPipelineCommand {
+    static constexpr auto kType = CommandType::kSetPipeline;
+
+    CommandHeader header;
+    uint32_t pipeline = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct SetBufferCommand {
+    static constexpr auto kType = CommandType::kSetBuffer;
+
+    CommandHeader header;
+    CommandStage stage = CommandStage::kVertex;
+    uint8_t index = 0;
+    uint32_t buffer = 0;
+    uint32_t offset = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Bytes follow a command, see GetBytes. A command is aligned, so bytes are aligned too.
+struct alignas(kCommandAlignment) SetBytesCommand {
+    static constexpr auto kType = CommandType::kSetBytes;
+
+    CommandHeader header;
+    CommandStage stage = CommandStage::kVertex;
+    uint8_t index = 0;
+    uint32_t size = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct DrawCommand {
+    static constexpr auto kType = CommandType::kDraw;
+
+    CommandHeader header;
+    CommandPrimitiveType primitive_type = CommandPrimitiveType::kTriangle;
+    uint32_t vertex_start = 0;
+    uint32_t vertex_count = 0;
+    uint32_t instance_count = 1;
+    uint32_t base_instance = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct DrawIndexedCommand {
+    static constexpr auto kType = CommandType::kDrawIndexed;
+
+    CommandHeader header;
+    CommandPrimitiveType primitive_type = CommandPrimitiveType::kTriangle;
+    CommandIndexType index_type = CommandIndexType::kUInt16;
+    uint32_t index_count = 0;
+    uint32_t index_buffer = 0;
+    uint32_t index_offset = 0;
+    uint32_t instance_count = 1;
+    int32_t base_vertex = 0;
+    uint32_t base_instance = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static_assert(std::is_trivially_copyable_v<SetPipelineCommand> && std::is_trivially_copyable_v<SetBufferCommand> &&
+              std::is_trivially_copyable_v<SetBytesCommand> && std::is_trivially_copyable_v<DrawCommand> &&
+              std::is_trivially_copyable_v<DrawIndexedCommand>);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Retrieve bytes of a set bytes command.
+//! \param command A set bytes command.
+//! \return Bytes of a command.
+inline const std::byte *GetBytes(const SetBytesCommand &command) {
+    return reinterpret_cast<const std::byte *>(&command + 1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A recorder writes commands into its own chunks, so threads record at once with a recorder each and without locks.
+class CommandRecorder {
+public:
+    //! Set a pipeline.
+    //! \param pipeline A handle of a pipeline.
+    void SetPipeline(uint32_t pipeline);
+
+    //! Set a buffer.
+    //! \param stage A shader stage.
+    //! \param index An index of an argument table.
+    //! \param buffer A handle of a buffer.
+    //! \param offset An offset of a buffer.
+    void SetBuffer(CommandStage stage, uint32_t index, uint32_t buffer, uint32_t offset = 0);
+
+    //! Set bytes, they are copied into a recorder.
+    //! \param stage A shader stage.
+    //! \param index An index of an argument table.
+    //! \param data Bytes.
+    //! \param size The size of bytes, up to kCommandMaxBytesSize.
+    void SetBytes(CommandStage stage, uint32_t index, const void *data, uint32_t size);
+
+    //! Set bytes of a value, the size is known at compile time so a copy is inlined.
+    //! \param stage A shader stage.
+    //! \param index An index of an argument table.
+    //! \param data A value.
+    template<typename T>
+    void SetBytes(CommandStage stage, uint32_t index, const T &data) {
+        static_assert(std::is_trivially_copyable_v<T> && sizeof(T) <= kCommandMaxBytesSize);
+        std::memcpy(AllocateBytes(stage, index, sizeof(T)), &data, sizeof(T));
+    }
+
+    //! Draw primitives.
+    //! \param primitive_type A primitive type.
+    //! \param vertex_start The first vertex.
+    //! \param vertex_count The number of vertices.
+    //! \param instance_count The number of instances.
+    //! \param base_instance The first instance.
+    void Draw(CommandPrimitiveType primitive_type, uint32_t vertex_start, uint32_t vertex_count,
+              uint32_t instance_count = 1, uint32_t base_instance = 0);
+
+    //! Draw indexed primitives.
+    //! \param primitive_type A primitive type.
+    //! \param index_count The number of indices.
+    //! \param index_type A type of indices.
+    //! \param index_buffer A handle of an index buffer.
+    //! \param index_offset An offset of an index buffer in bytes.
+    //! \param instance_count The number of instances.
+    //! \param base_vertex A value is added to indices.
+    //! \param base_instance The first instance.
+    void DrawIndexed(CommandPrimitiveType primitive_type, uint32_t index_count, CommandIndexType index_type,
+                     uint32_t index_buffer, uint32_t index_offset, uint32_t instance_count = 1,
+                     int32_t base_vertex = 0, uint32_t base_instance = 0);
+
+    //! Forget recorded commands, chunks are kept for the next recording.
+    void Reset();
+
+    //! Call a function with every command in the recorded order.
+    //! \param function A function is called with a command, for example SetPipelineCommand or DrawCommand.
+    template<typename F>
+    void Replay(F &&function) const;
+
+    //! Retrieve the number of recorded commands.
+    //! \return The number of commands.
+    [[nodiscard]]
+    inline auto GetCommandCount() const {
+        return _command_count;
+    }
+
+    //! Retrieve the size of recorded commands.
+    //! \return The size of commands in bytes.
+    [[nodiscard]]
+    inline auto GetByteSize() const {
+        return _byte_size;
+    }
+
+    //! Retrieve the number of chunks in use.
+    //! \return The number of chunks.
+    [[nodiscard]]
+    inline auto GetChunkCount() const {
+        return _chunk_count;
+    }
+
+private:
+    struct Chunk {
+        std::unique_ptr<std::byte[]> data;
+        uint32_t size = 0;
+    };
+
+private:
+    //! Allocate a command.
+    //! \param payload_size The size of a payload follows a command.
+    //! \return A command with its header filled.
+    template<typename T>
+    T &Allocate(uint32_t payload_size = 0);
+
+    //! Allocate a set bytes command.
+    //! \return Bytes of a command to be copied to.
+    std::byte *AllocateBytes(CommandStage stage, uint32_t index, uint32_t size);
+
+    //! Move to the next chunk, reusing one if there is.
+    void NextChunk();
+
+private:
+    std::vector<Chunk> _chunks;
+    uint32_t _chunk_count = 0;
+    std::byte *_cursor = nullptr;
+    std::byte *_end = nullptr;
+    uint32_t _command_count = 0;
+    uint64_t _byte_size = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template<typename T>
+T &CommandRecorder::Allocate(uint32_t payload_size) {
+    auto size = (static_cast<uint32_t>(sizeof(T)) + payload_size + kCommandAlignment - 1) & ~(kCommandAlignment - 1);
+    if (static_cast<size_t>(_end - _cursor) < size) {
+        NextChunk();
+    }
+
+    auto command = new (_cursor) T;
+    command->header.type = T::kType;
+    command->header.size = static_cast<uint16_t>(size);
+    _cursor += size;
+    ++_command_count;
+    _byte_size += size;
+    return *command;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template<typename F>
+void CommandRecorder::Replay(F &&function) const {
+    for (auto i = 0u; i != _chunk_count; ++i) {
+        auto cursor = static_cast<const std::byte *>(_chunks[i].data.get());
+        auto end = i + 1 == _chunk_count ? _cursor : cursor + _chunks[i].size;
+
+        while (cursor != end) {
+            auto header = std::launder(reinterpret_cast<const CommandHeader *>(cursor));
+            switch (header->type) {
+                case CommandType::kSetPipeline:
+                    function(*std::launder(reinterpret_cast<const SetPipelineCommand *>(cursor)));
+                    break;
+                case CommandType::kSetBuffer:
+                    function(*std::launder(reinterpret_cast<const SetBufferCommand *>(cursor)));
+                    break;
+                case CommandType::kSetBytes:
+                    function(*std::launder(reinterpret_cast<const SetBytesCommand *>(cursor)));
+                    break;
+                case CommandType::kDraw:
+                    function(*std::launder(reinterpret_cast<const DrawCommand *>(cursor)));
+                    break;
+                case CommandType::kDrawIndexed:
+                    function(*std::launder(reinterpret_cast<const DrawIndexedCommand *>(cursor)));
+                    break;
+            }
+            cursor += header->size;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct CommandStreamStatistics {
+    uint32_t recorder_count = 0;
+    uint64_t command_count = 0;
+    uint64_t byte_size = 0;
+    uint32_t chunk_count = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A stream is an ordered list of recorders. Recorders are filled in parallel and executed in order, a backend
+//! executes a recorder as a unit, for example with a render command encoder of a parallel render command encoder.
+//! State doesn't carry over between recorders, so a recorder sets every pipeline and buffer it draws with.
+class CommandStream {
+public:
+    //! Forget recorders of the previous frame, their chunks are kept.
+    void Reset();
+
+    //! Append a recorder to the end of a stream. Call it from a single thread.
+    //! \return A recorder.
+    CommandRecorder &AddRecorder();
+
+    //! Append recorders and record a batch of items into each of them in parallel. Commands are in the order of items.
+    //! \param job_system A job system.
+    //! \param count The number of items.
+    //! \param batch_size The number of items are recorded into a recorder.
+    //! \param function A function records items in [begin, end).
+    void Record(JobSystem &job_system, uint32_t count, uint32_t batch_size,
+                const std::function<void(CommandRecorder &, uint32_t, uint32_t)> &function);
+
+    //! Call a function with every command of every recorder in order.
+    //! \param function A function is called with a command.
+    template<typename F>
+    void Replay(F &&function) const {
+        for (auto i = 0u; i != _recorder_count; ++i) {
+            _recorders[i]->Replay(function);
+        }
+    }
+
+    //! Retrieve a recorder.
+    //! \param index An index of a recorder.
+    //! \return A recorder.
+    [[nodiscard]]
+    inline const auto &GetRecorder(uint32_t index) const {
+        return *_recorders[index];
+    }
+
+    //! Retrieve the number of recorders.
+    //! \return The number of recorders.
+    [[nodiscard]]
+    inline auto GetRecorderCount() const {
+        return _recorder_count;
+    }
+
+    //! Retrieve statistics of recorded commands.
+    //! \return Statistics.
+    [[nodiscard]]
+    CommandStreamStatistics GetStatistics() const;
+
+private:
+    std::vector<std::unique_ptr<CommandRecorder>> _recorders;
+    uint32_t _recorder_count = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
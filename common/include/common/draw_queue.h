@@ -0,0 +1,197 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef DRAW_QUEUE_H_
+#define DRAW_QUEUE_H_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "command_stream.h"
+#include "job_system.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Bits of a sort key from the most significant one, a pass never interleaves with another and draws of a pass are
+// grouped by pipelines, then by materials, then ordered by depth.
+constexpr auto kDrawPassBits = 6u;
+constexpr auto kDrawPipelineBits = 14u;
+constexpr auto kDrawMaterialBits = 20u;
+constexpr auto kDrawDepthBits = 24u;
+
+static_assert(kDrawPassBits + kDrawPipelineBits + kDrawMaterialBits + kDrawDepthBits == 64);
+
+constexpr auto kDrawMaxBindings = 4u;
+
+// The number of buffer indices of a stage a queue tracks, like the buffer argument table of Metal.
+constexpr auto kDrawMaxBufferIndices = 31u;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Make a sort key of a draw.
+//! \param pass A pass, up to 2^kDrawPassBits.
+//! \param pipeline A pipeline, up to 2^kDrawPipelineBits.
+//! \param material A material, up to 2^kDrawMaterialBits.
+//! \param depth A depth in [0, 1], pass 1 - depth to order draws back to front.
+//! \return A sort key.
+uint64_t MakeDrawKey(uint32_t pass, uint32_t pipeline, uint32_t material, float depth);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Sort keys with a stable least significant digit radix sort. Digits every key shares are skipped, so keys which
+//! differ in a few fields take a few passes.
+//! \param keys Keys.
+//! \param order Indices of keys in sorted order.
+void RadixSort(std::span<const uint64_t> keys, std::vector<uint32_t> &order);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct DrawBinding {
+    CommandStage stage = CommandStage::kVertex;
+    uint8_t index = 0;
+    uint32_t buffer = 0;
+    uint32_t offset = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct DrawPacket {
+    uint32_t pass = 0;
+    uint32_t pipeline = 0;
+    //! A material only orders draws, draws of a material usually bind the same buffers.
+    uint32_t material = 0;
+    //! A depth in [0, 1], draws of a material are emitted front to back. Pass 1 - depth to emit back to front.
+    float depth = 0.0f;
+    std::array<DrawBinding, kDrawMaxBindings> bindings = {};
+    uint32_t binding_count = 0;
+    CommandPrimitiveType primitive_type = CommandPrimitiveType::kTriangle;
+    bool indexed = true;
+    CommandIndexType index_type = CommandIndexType::kUInt16;
+    uint32_t index_buffer = 0;
+    uint32_t index_offset = 0;
+    //! The number of indices of an indexed draw, or the number of vertices.
+    uint32_t count = 0;
+    //! The first vertex of a draw which isn't indexed.
+    uint32_t first_vertex = 0;
+    uint32_t instance_count = 1;
+    int32_t base_vertex = 0;
+    uint32_t base_instance = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct DrawQueueStatistics {
+    uint32_t draw_count = 0;
+    //! The number of state changes draws ask for, every one is issued without filtering.
+    uint64_t requested_state_count = 0;
+    //! The number of state changes are recorded after redundant ones are dropped.
+    uint64_t emitted_state_count = 0;
+    uint64_t pipeline_count = 0;
+    uint64_t buffer_count = 0;
+    uint64_t bytes_count = 0;
+    std::chrono::duration<double> sort_time = std::chrono::duration<double>::zero();
+    std::chrono::duration<double> emit_time = std::chrono::duration<double>::zero();
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A queue collects draws of a frame, sorts them by keys and records them into commands, dropping a state change if
+//! the same state is already set.
+class DrawQueue {
+public:
+    //! Forget draws of the previous frame.
+    void Reset();
+
+    //! Submit a draw.
+    //! \param packet A draw.
+    void Submit(const DrawPacket &packet);
+
+    //! Submit a draw with bytes, for example transforms of an object.
+    //! \param packet A draw.
+    //! \param stage A shader stage of bytes.
+    //! \param index An index of an argument table of bytes.
+    //! \param data Bytes, they are copied.
+    //! \param size The size of bytes, up to kCommandMaxBytesSize.
+    void Submit(const DrawPacket &packet, CommandStage stage, uint32_t index, const void *data, uint32_t size);
+
+    //! Sort draws by keys.
+    void Sort();
+
+    //! Record draws into a recorder.
+    //! \param recorder A recorder.
+    void Emit(CommandRecorder &recorder);
+
+    //! Record draws into recorders appended to a stream in parallel. Every recorder begins without state.
+    //! \param stream A stream.
+    //! \param job_system A job system.
+    //! \param batch_size The number of draws of a recorder.
+    void Emit(CommandStream &stream, JobSystem &job_system, uint32_t batch_size);
+
+    //! Retrieve the number of draws.
+    //! \return The number of draws.
+    [[nodiscard]]
+    inline auto GetDrawCount() const {
+        return static_cast<uint32_t>(_items.size());
+    }
+
+    //! Retrieve statistics of the last frame.
+    //! \return Statistics.
+    [[nodiscard]]
+    inline const auto &GetStatistics() const {
+        return _statistics;
+    }
+
+private:
+    struct Item {
+        DrawPacket packet;
+        uint32_t bytes_offset = 0;
+        uint32_t bytes_size = 0;
+        CommandStage bytes_stage = CommandStage::kVertex;
+        uint8_t bytes_index = 0;
+    };
+
+    //! State is set to a recorder, a slot holds either a buffer or bytes like an argument table of Metal.
+    struct Slot {
+        uint32_t buffer = ~0u;
+        uint32_t offset = 0;
+        uint32_t bytes_offset = 0;
+        uint32_t bytes_size = 0;
+    };
+
+    struct State {
+        uint32_t pipeline = ~0u;
+        std::array<std::array<Slot, kDrawMaxBufferIndices>, 2> slots;
+    };
+
+    struct Counts {
+        uint64_t pipeline_count = 0;
+        uint64_t buffer_count = 0;
+        uint64_t bytes_count = 0;
+    };
+
+private:
+    //! Record draws in a range of the sorted order.
+    void Emit(uint32_t begin, uint32_t end, CommandRecorder &recorder, Counts &counts) const;
+
+    //! Update statistics after draws are recorded.
+    void UpdateStatistics(const Counts &counts, std::chrono::steady_clock::time_point start_time);
+
+private:
+    std::vector<Item> _items;
+    std::vector<uint64_t> _keys;
+    std::vector<uint32_t> _order;
+    std::vector<std::byte> _bytes;
+    uint64_t _requested_state_count = 0;
+    bool _sorted = false;
+    DrawQueueStatistics _statistics;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
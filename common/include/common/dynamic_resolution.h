@@ -0,0 +1,137 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef DYNAMIC_RESOLUTION_H_
+#define DYNAMIC_RESOLUTION_H_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "utility.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// A frame at 60 Hz.
+constexpr auto kDefaultFrameBudget = std::chrono::duration<double>(1.0 / 60.0);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A policy decides a render scale from recent frame times.
+class ResolutionPolicy {
+public:
+    //! Destructor.
+    virtual ~ResolutionPolicy() = default;
+
+    //! Evaluate a render scale.
+    //! \param frame_time An average frame time at the current scale.
+    //! \param budget A frame time budget.
+    //! \param scale The current scale of both width and height.
+    //! \return A scale a policy wants, a controller clamps it.
+    virtual float Evaluate(std::chrono::duration<double> frame_time, std::chrono::duration<double> budget,
+                           float scale) = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A policy assumes a frame time is proportional to the number of pixels, and scales them by the ratio of a budget to
+//! a frame time, leaving headroom under a budget.
+class BudgetResolutionPolicy : public ResolutionPolicy {
+public:
+    //! Constructor.
+    //! \param headroom The fraction of a budget a policy aims for.
+    explicit BudgetResolutionPolicy(float headroom = 0.85f);
+
+    //! Evaluate a render scale.
+    float Evaluate(std::chrono::duration<double> frame_time, std::chrono::duration<double> budget,
+                   float scale) override;
+
+private:
+    float _headroom = 0.85f;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct DynamicResolutionSettings {
+    std::chrono::duration<double> budget = kDefaultFrameBudget;
+    float min_scale = 0.5f;
+    float max_scale = 1.0f;
+    //! The number of frames are averaged before a scale is evaluated, it is larger than frames in flight so frames
+    //! rendered at a previous scale are outweighed.
+    uint32_t window_size = 8;
+    //! A scale is raised only if a frame time is under this fraction of a budget, and lowered only if it is over the
+    //! lower one, so a frame time in between holds a scale. The lower one leaves room for frames slower than average.
+    float raise_threshold = 0.8f;
+    float lower_threshold = 0.95f;
+    //! A scale is raised by a step at least, so noise doesn't resize targets, and lowered by a step at least, so a
+    //! policy underestimating a frame time doesn't stall over a budget.
+    float min_step = 0.05f;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct DynamicResolutionStatistics {
+    uint64_t frame_count = 0;
+    uint64_t change_count = 0;
+    //! The average frame time of the last window.
+    std::chrono::duration<double> frame_time = std::chrono::duration<double>::zero();
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A controller watches frame times against a budget and adjusts a render scale with a policy.
+class DynamicResolution {
+public:
+    //! Constructor.
+    //! \param settings Settings.
+    //! \param policy A policy, a BudgetResolutionPolicy if it is null.
+    explicit DynamicResolution(const DynamicResolutionSettings &settings = {},
+                               std::unique_ptr<ResolutionPolicy> policy = nullptr);
+
+    //! Add a frame time.
+    //! \param cpu_time CPU time of a frame.
+    //! \param gpu_time GPU time of a frame, the longer one bounds a frame.
+    //! \return True if a scale changes.
+    bool Update(std::chrono::duration<double> cpu_time, std::chrono::duration<double> gpu_time);
+
+    //! Scale a resolution.
+    //! \param resolution A resolution.
+    //! \return A resolution at the current scale, at least a pixel.
+    [[nodiscard]]
+    Resolution Scale(const Resolution &resolution) const;
+
+    //! Retrieve the current scale.
+    //! \return The current scale.
+    [[nodiscard]]
+    inline auto GetScale() const {
+        return _scale;
+    }
+
+    //! Retrieve settings.
+    //! \return Settings.
+    [[nodiscard]]
+    inline const auto &GetSettings() const {
+        return _settings;
+    }
+
+    //! Retrieve statistics.
+    //! \return Statistics.
+    [[nodiscard]]
+    inline const auto &GetStatistics() const {
+        return _statistics;
+    }
+
+private:
+    DynamicResolutionSettings _settings;
+    std::unique_ptr<ResolutionPolicy> _policy;
+    float _scale = 1.0f;
+    std::vector<double> _frame_times;
+    DynamicResolutionStatistics _statistics;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -7,23 +7,87 @@
 #define EXAMPLE_H_
 
 #include <imgui.h>
+#ifdef __OBJC__
 #include <QuartzCore/CAMetalLayer.h>
 #include <Metal/Metal.h>
+#endif
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
-#include "window.h"
 #include "utility.h"
+#include "vector_math.h"
 #include "timer.h"
 #include "camera.h"
+#include "arguments.h"
+#include "render_device.h"
+#include "software_device.h"
+#include "frame_allocator.h"
+#include "asset_archive.h"
+#include "file_watcher.h"
+#include "shader_cache.h"
+#include "pipeline_cache.h"
+#include "bvh.h"
+#include "job_system.h"
+#include "command_stream.h"
+#include "draw_queue.h"
+#include "triple_buffer.h"
+#include "input_queue.h"
+#include "dynamic_resolution.h"
+#ifdef __OBJC__
+#include "window.h"
+#include "metal_device.h"
+#include "metal_pipeline_factory.h"
+#include "upload_queue.h"
+#include "metal_command_encoder.h"
+#include "metal_upscaler.h"
+#endif
 
 //----------------------------------------------------------------------------------------------------------------------
 
 constexpr auto kMetalLayerDrawableCount = 2;
-constexpr auto kMetalLayerPixelFormat = MTLPixelFormatBGRA8Unorm;
+
+// Frames have uniforms of their own, one more than frames in flight as the simulation thread updates a frame ahead.
+constexpr auto kMaxFrameCount = kMaxFramesInFlight + 1;
+
+// An idle example still updates a frame this often, so polled state like changed files isn't missed.
+constexpr auto kIdleKeepAliveInterval = std::chrono::milliseconds(500);
 
 //----------------------------------------------------------------------------------------------------------------------
 
 class Window;
+class MetalDevice;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! State of a frame the simulation thread hands to the render thread.
+struct FrameSnapshot {
+    //! Destructor.
+    ~FrameSnapshot();
+
+    //! Copy ImGui draw data, the simulation thread begins the next ImGui frame while a snapshot is drawn.
+    //! \param source ImGui draw data.
+    void CopyDrawData(const ImDrawData &source);
+
+    uint32_t index = 0;
+    Resolution resolution = {0, 0};
+    Camera camera;
+    ImDrawData draw_data;
+    std::vector<ImDrawList *> draw_lists;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct FrameStatistics {
+    uint64_t rendered_count = 0;
+    //! The number of display refreshes skipped as nothing changed.
+    uint64_t skipped_count = 0;
+};
 
 //----------------------------------------------------------------------------------------------------------------------
 
@@ -31,14 +95,17 @@ class Example {
 public:
     //! Constructor.
     //! \param title The example title.
-    explicit Example(const std::string &title);
+    //! \param arguments Arguments select a backend executes the frame loop.
+    explicit Example(const std::string &title, const Arguments &arguments = {});
     
     //! Destructor.
     virtual ~Example();
     
+#ifdef __OBJC__
     //! Bind Metal to a window.
     //! \param window A window is bounded by Metal.
     void BindToWindow(Window *window);
+#endif
 
     //! Initialize.
     void Init();
@@ -46,40 +113,99 @@ public:
     //! Terminate.
     void Term();
 
-    //! Resize.
+    //! Request a resize, it is applied at the next frame boundary once per frame however many requests come.
     //! \param resolution A resolution.
-    void Resize(const Resolution &resolution);
+    //! \param live True during a live resize, a resolution is applied once it stays the same for a frame.
+    void Resize(const Resolution &resolution, bool live = false);
+
+    //! Start the simulation thread, it updates frames while the calling thread renders them.
+    void StartSimulation();
 
-    //! Update.
+    //! Update a frame and publish its snapshot.
     void Update();
 
-    //! Render.
+    //! Render the latest published snapshot, or skip a frame while an idle example has nothing new.
     void Render();
 
-    //! Handle mouse button down event.
-    //! \param button The button that is pressing.
-    //! \param point A point of the mouse cursor.
-    void OnMouseButtonDown(NSEvent* event, const NSPoint &point);
+    //! Request a frame, an idle example updates and renders it. Input and resizes request one, call it when a scene
+    //! changes without them.
+    void Invalidate();
 
-    //! Handle mouse button up event.
-    //! \param button The button that is releasing.
-    //! \param point A point of the mouse cursor.
-    void OnMouseButtonUp(NSEvent* event, const NSPoint &point);
+    //! Handle mouse button down event, it is queued until the next update.
+    //! \param x A horizontal position of the mouse cursor from the left of the view.
+    //! \param y A vertical position of the mouse cursor from the top of the view.
+    void OnMouseButtonDown(float x, float y);
 
-    //! Handle mouse move event.
-    //! \param button The button that is pressing.
-    //! \param point A position of the mouse cursor.
-    void OnMouseMove(NSEvent* event, const NSPoint &point);
+    //! Handle mouse button up event, it is queued until the next update.
+    //! \param x A horizontal position of the mouse cursor from the left of the view.
+    //! \param y A vertical position of the mouse cursor from the top of the view.
+    void OnMouseButtonUp(float x, float y);
 
-    //! Handle mouse wheel event.
+    //! Handle mouse move event, it is queued until the next update.
+    //! \param x A horizontal position of the mouse cursor from the left of the view.
+    //! \param y A vertical position of the mouse cursor from the top of the view.
+    //! \param drag True if the left button is pressing.
+    void OnMouseMove(float x, float y, bool drag = false);
+
+    //! Handle mouse wheel event, it is queued until the next update.
     //! \param delta The rotated distance by wheel.
     void OnMouseWheel(float delta);
-    
+
+    //! Retrieve a render device.
+    //! \return A render device.
+    [[nodiscard]]
+    inline auto GetRenderDevice() const {
+        return _render_device.get();
+    }
+
+    //! Retrieve a dynamic resolution.
+    //! \return A dynamic resolution, or null if it is disabled.
+    [[nodiscard]]
+    inline auto GetDynamicResolution() const {
+        return _dynamic_resolution.get();
+    }
+
+    //! Retrieve the number of rendered and skipped frames.
+    //! \return Statistics.
+    [[nodiscard]]
+    FrameStatistics GetFrameStatistics() const;
+
 protected:
-    //! Record draw commands for ImGui.
+#ifdef __OBJC__
+    //! Record draw commands for ImGui. ImGui is drawn after upscaling instead while a frame renders at a scaled
+    //! resolution.
     //! \param descriptor A render pass descriptor.
     //! \param encoder A render command encoder.
     void RecordDrawImGuiCommands(MTLRenderPassDescriptor *descriptor, id<MTLRenderCommandEncoder> encoder);
+#endif
+
+    //! Cast a ray from the mouse cursor through the camera.
+    //! \return A ray in world space.
+    [[nodiscard]]
+    Ray GetMouseRay() const;
+
+    //! Pick a triangle of a mesh under the mouse cursor.
+    //! \param bvh A tree built with bounds of triangles of a mesh.
+    //! \param mesh A mesh in world space.
+    //! \return The nearest hit, a primitive is the index of a triangle.
+    [[nodiscard]]
+    BvhHit PickMesh(const Bvh &bvh, const Mesh &mesh) const;
+
+    //! Mount an archive packed from an asset directory. Loose files are used if the archive doesn't exist, or if hot
+    //! reload is enabled, then the directory is watched instead.
+    //! \param archive_path An archive file path.
+    //! \param directory An asset directory was packed.
+    void MountAssetArchive(const std::filesystem::path &archive_path, const std::filesystem::path &directory);
+
+#ifdef __OBJC__
+    //! Load a shader. Every entrypoint of a file comes from a single library is compiled once.
+    //! \param file_path The file path that contains the shader code.
+    //! \param entrypoint The name of shader entrypoint function where shader execution begin.
+    //! \param macros Preprocessor macros.
+    //! \return A handle to MTLFunction, or nil without a Metal device.
+    id<MTLFunction> LoadShader(const std::filesystem::path &file_path, const std::string &entrypoint,
+                               const ShaderMacros &macros = {});
+#endif
 
     //! Handle initialize event.
     virtual void OnInit() = 0;
@@ -87,31 +213,55 @@ protected:
     //! Handle terminate event.
     virtual void OnTerm() = 0;
 
-    //! Handle resize event.
-    //! \param resolution A resolution.
+    //! Handle resize event on the render thread, before the first frame of a resolution is rendered.
+    //! \param resolution A resolution to render at, scaled from a window resolution by dynamic resolution.
     virtual void OnResize(const Resolution &resolution) = 0;
 
-    //! Handle update event.
-    //! \param index The current index of swap chain image.
+    //! Handle update event, on the simulation thread once it is started.
+    //! \param index The index of a frame, state OnRender reads is kept per index as a frame renders concurrently.
     virtual void OnUpdate(uint32_t index) = 0;
 
     //! Handle render event.
-    //! \param index The current index of swap chain image.
+    //! \param index The index of a frame OnUpdate updated.
     virtual void OnRender(uint32_t index) = 0;
+
+    //! Handle file change event at a frame boundary of the render thread when hot reload is enabled.
+    //! \param path A changed file path.
+    virtual void OnFileChange(const std::filesystem::path &path) {}
+
+    //! Handle pipeline reload event at a frame boundary of the render thread, request pipeline states again to use
+    //! reloaded ones.
+    virtual void OnPipelineReload() {}
     
 protected:
     //! Initialize a device.
-    void InitDevice();
-    
-    //! Initialize a command queue.
-    void InitCommandQueue();
-    
-    //! Initialize a semaphore.
-    void InitSemaphore();
-    
+    //! \param arguments Arguments select a backend executes the frame loop.
+    void InitDevice(const Arguments &arguments);
+
+    //! Initialize a frame allocator for uniforms.
+    void InitFrameAllocator();
+
+    //! Initialize dynamic resolution.
+    //! \param frame_budget A frame time budget in milliseconds, zero disables it.
+    void InitDynamicResolution(float frame_budget);
+
     //! Initialize ImGui.
     void InitImGui();
 
+    //! Dispatch changed files and swap reloaded pipeline states in.
+    void UpdateHotReload();
+
+    //! Apply queued input events to the camera.
+    void UpdateInput();
+
+    //! Apply the last requested resolution to the camera and ImGui.
+    void UpdateResolution();
+
+    //! Resize a swapchain and a scaled texture.
+    //! \param resolution A window resolution.
+    //! \param render_resolution A resolution to render at.
+    void ResizeRenderTargets(const Resolution &resolution, const Resolution &render_resolution);
+
     //! Terminate ImGui.
     void TermImGui();
 
@@ -121,6 +271,43 @@ protected:
     //! End ImGui pass.
     void EndImGuiPass();
 
+    //! Stop the simulation thread.
+    void StopSimulation();
+
+    //! Wait until a frame is requested or a keep-alive frame is due.
+    void WaitForChange();
+
+#ifdef __OBJC__
+    // Metal and AppKit parts of the frame loop, they are implemented in metal_example.cpp.
+
+    //! Initialize a Metal device, uniforms and caches live on it.
+    //! \param arguments Arguments.
+    void InitMetalDevice(const Arguments &arguments);
+
+    //! Initialize ImGui backends for Metal and AppKit.
+    void InitMetalImGui();
+
+    //! Terminate ImGui backends for Metal and AppKit.
+    void TermMetalImGui();
+
+    //! Begin an ImGui frame with input from AppKit.
+    void BeginMetalImGuiPass();
+
+    //! Begin a frame, a command buffer and a drawable are acquired and pending uploads are recorded.
+    void BeginMetalFrame();
+
+    //! End a frame, a scaled texture is upscaled into a drawable.
+    void EndMetalFrame();
+
+    //! Resize a drawable and a scaled texture.
+    //! \param resolution A window resolution.
+    //! \param render_resolution A resolution to render at.
+    void ResizeMetalTargets(const Resolution &resolution, const Resolution &render_resolution);
+
+    //! Record commands upscale a scaled texture into a drawable and draw ImGui over it.
+    void RecordUpscaleCommands();
+#endif
+
 protected:
     std::string _title;
     Timer _timer;
@@ -128,16 +315,86 @@ protected:
     uint32_t _fps = 0;
     Timer::Duration _fps_time = Timer::Duration::zero();
     Camera _camera;
-    NSPoint _mouse_point = {0, 0};
+    simd::float2 _mouse_point = {0.0f, 0.0f};
+    InputQueue _input_queue;
+    std::vector<InputEvent> _input_events;
+    Resolution _resolution = {0, 0};
+    std::atomic<uint64_t> _requested_resolution = 0;
+    std::atomic<bool> _live_resize = false;
+    uint64_t _pending_resolution = 0;
+    Resolution _display_resolution = {0, 0};
+    Resolution _render_resolution = {0, 0};
+    std::unique_ptr<DynamicResolution> _dynamic_resolution;
+    uint32_t _frames_in_flight = kDefaultFramesInFlight;
+    uint32_t _frame_count = kDefaultFramesInFlight + 1;
     uint32_t _frame_index = 0;
+    bool _hot_reload = false;
+    // Everything below runs jobs on it, so it is destroyed last.
+    JobSystem _job_system;
+    std::unique_ptr<RenderDevice> _render_device;
+    MetalDevice *_metal_device = nullptr;
+    SoftwareDevice *_software_device = nullptr;
+    std::vector<std::byte> _uniform_memory;
+    std::unique_ptr<FrameAllocator> _frame_allocator;
+    std::unique_ptr<AssetArchive> _asset_archive;
+    std::unique_ptr<FileWatcher> _file_watcher;
+    std::unique_ptr<ShaderCache> _shader_cache;
+    std::unique_ptr<PipelineCache> _pipeline_cache;
+    // Examples record draws of a frame into it on the render thread, a backend executes it.
+    CommandStream _command_stream;
+    // Examples submit draws of a frame to it, it sorts and records them into the command stream.
+    DrawQueue _draw_queue;
+    TripleBuffer<FrameSnapshot> _snapshots;
+    std::thread _simulation_thread;
+    bool _idle = false;
+    std::mutex _change_mutex;
+    std::condition_variable _change_condition;
+    bool _changed = true;
+    std::atomic<bool> _simulation_idle = false;
+    std::atomic<uint64_t> _rendered_frame_count = 0;
+    std::atomic<uint64_t> _skipped_frame_count = 0;
+#ifdef __OBJC__
+    std::unique_ptr<UploadQueue> _upload_queue;
+    std::unique_ptr<MetalUpscaler> _upscaler;
     id<MTLDevice> _device;
     id<MTLCommandQueue> _command_queue;
-    dispatch_semaphore_t _semaphore = nil;
     id<MTLCommandBuffer> _command_buffer;
+    id<MTLBuffer> _uniform_buffer;
     CAMetalLayer *_layer = nil;
     id<CAMetalDrawable> _drawable;
+    //! A texture an example renders into, a drawable texture or a scaled texture upscaled into a drawable.
+    id<MTLTexture> _color_texture;
+    id<MTLTexture> _scaled_texture;
+#endif
 };
 
 //----------------------------------------------------------------------------------------------------------------------
 
+//! Create an example with arguments.
+using ExampleFactory = std::function<std::unique_ptr<Example>(const Arguments &)>;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Run an example on a window, or headless with a backend other than Metal.
+//! \param argc The number of arguments.
+//! \param argv Arguments.
+//! \param factory A factory creates an example.
+//! \return An exit code.
+int RunExample(int argc, char *argv[], const ExampleFactory &factory);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Run an example on a window, or headless with a backend other than Metal.
+//! \param argc The number of arguments.
+//! \param argv Arguments.
+//! \return An exit code.
+template<typename T>
+int RunExample(int argc, char *argv[]) {
+    return RunExample(argc, argv, [](const Arguments &arguments) {
+        return std::make_unique<T>(arguments);
+    });
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
 #endif
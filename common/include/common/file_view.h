@@ -0,0 +1,83 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef FILE_VIEW_H_
+#define FILE_VIEW_H_
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Mapping costs a few system calls and page faults, so smaller files are read at once.
+constexpr auto kFileViewMapThreshold = 64u * 1024u;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A read only view of the whole content of a file.
+//! A regular file is memory mapped unless it is small, otherwise the file is read into memory with bulk reads.
+class FileView {
+public:
+    //! Constructor.
+    //! \param path A file path.
+    explicit FileView(const std::filesystem::path &path);
+
+    //! Move constructor.
+    FileView(FileView &&other) noexcept;
+
+    //! Move assignment.
+    FileView &operator=(FileView &&other) noexcept;
+
+    //! Destructor.
+    ~FileView();
+
+    //! Retrieve the content as bytes.
+    //! \return The content of a file.
+    [[nodiscard]]
+    inline std::span<const std::byte> GetBytes() const {
+        return {_data, _size};
+    }
+
+    //! Retrieve the content as a string.
+    //! \return The content of a file.
+    [[nodiscard]]
+    inline std::string_view GetString() const {
+        return {reinterpret_cast<const char*>(_data), _size};
+    }
+
+    //! Retrieve the size of the content.
+    //! \return The size of the content.
+    [[nodiscard]]
+    inline auto GetSize() const {
+        return _size;
+    }
+
+    //! Query whether the content is memory mapped.
+    //! \return True if the content is memory mapped.
+    [[nodiscard]]
+    inline auto IsMapped() const {
+        return _mapping != nullptr;
+    }
+
+private:
+    //! Read the content with bulk reads.
+    void Read(int fd, size_t size_hint);
+
+    //! Unmap the content.
+    void Unmap();
+
+private:
+    void *_mapping = nullptr;
+    const std::byte *_data = nullptr;
+    size_t _size = 0;
+    std::vector<std::byte> _buffer;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
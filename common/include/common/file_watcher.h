@@ -0,0 +1,67 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef FILE_WATCHER_H_
+#define FILE_WATCHER_H_
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// How often a watching thread checks whether it should stop.
+constexpr auto kFileWatcherInterval = std::chrono::milliseconds(100);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A watcher records files are written in a directory and its subdirectories on a background thread.
+//! It uses inotify on Linux and FSEvents on macOS, other platforms scan modification times.
+class FileWatcher {
+public:
+    //! Constructor.
+    //! \param directory A directory to watch.
+    explicit FileWatcher(const std::filesystem::path &directory);
+
+    //! Destructor.
+    ~FileWatcher();
+
+    //! Retrieve files are changed since the last poll. It never blocks on a watching thread.
+    //! \return Changed file paths without duplicates.
+    std::vector<std::filesystem::path> Poll();
+
+    //! Retrieve a watched directory.
+    //! \return A watched directory.
+    [[nodiscard]]
+    inline const auto &GetDirectory() const {
+        return _directory;
+    }
+
+private:
+    //! Watch a directory until a watcher is destroyed.
+    void Watch();
+
+    //! Record a changed file.
+    void Record(const std::filesystem::path &path);
+
+private:
+    std::filesystem::path _directory;
+    std::mutex _mutex;
+    std::vector<std::filesystem::path> _changes;
+    std::atomic<bool> _stop = false;
+#if defined(__APPLE__)
+    void *_stream = nullptr;
+#elif defined(__linux__)
+    int _descriptor = -1;
+#endif
+    std::thread _thread;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
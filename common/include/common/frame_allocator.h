@@ -0,0 +1,92 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef FRAME_ALLOCATOR_H_
+#define FRAME_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Metal requires constant buffer offsets to be aligned to 256 bytes on macOS.
+constexpr auto kUniformAlignment = 256u;
+constexpr auto kDefaultUniformFrameSize = 1u << 20;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template<typename T>
+struct FrameAllocation {
+    T *data = nullptr;
+    uint64_t offset = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A linear allocator over persistent memory which is split into a region per frame in flight.
+//! Allocations of a frame are released at once when the frame region is reset for reuse.
+class FrameAllocator {
+public:
+    //! Constructor.
+    //! \param data Memory of frame_count * frame_size bytes which is not owned by an allocator.
+    //! \param frame_size The size of a frame region, it is rounded down to the alignment.
+    //! \param frame_count The number of frame regions.
+    //! \param alignment The alignment of allocations, it must be a power of two.
+    FrameAllocator(void *data, uint64_t frame_size, uint32_t frame_count, uint64_t alignment = kUniformAlignment);
+
+    //! Reset a frame region. The GPU must have finished using the region.
+    //! \param frame_index The index of the current frame in flight.
+    void Reset(uint32_t frame_index);
+
+    //! Allocate memory from the current frame region.
+    //! \param size The size of an allocation.
+    //! \return An allocation.
+    FrameAllocation<std::byte> Allocate(uint64_t size);
+
+    //! Allocate memory for an object from the current frame region.
+    //! \return An allocation.
+    template<typename T>
+    FrameAllocation<T> Allocate() {
+        static_assert(std::is_trivially_copyable_v<T>, "Uniforms must be trivially copyable.");
+        auto allocation = Allocate(sizeof(T));
+        return {new (allocation.data) T, allocation.offset};
+    }
+
+    //! Retrieve the size of a frame region.
+    //! \return The size of a frame region.
+    [[nodiscard]]
+    inline auto GetFrameSize() const {
+        return _frame_size;
+    }
+
+    //! Retrieve the used size of the current frame region.
+    //! \return The used size.
+    [[nodiscard]]
+    inline auto GetUsedSize() const {
+        return _head - _frame_begin;
+    }
+
+    //! Retrieve the largest used size of any frame.
+    //! \return The largest used size.
+    [[nodiscard]]
+    inline auto GetPeakSize() const {
+        return _peak_size;
+    }
+
+private:
+    std::byte *_data = nullptr;
+    uint64_t _frame_size = 0;
+    uint32_t _frame_count = 0;
+    uint64_t _alignment = 0;
+    uint64_t _frame_begin = 0;
+    uint64_t _head = 0;
+    uint64_t _peak_size = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
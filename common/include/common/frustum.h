@@ -0,0 +1,82 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef FRUSTUM_H_
+#define FRUSTUM_H_
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#include "vector_math.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A column major matrix like simd::float4x4, so culling is portable.
+using Matrix4 = std::array<float, 16>;
+
+//! A plane (a, b, c, d) where a point p is in front of it if a * p.x + b * p.y + c * p.z + d >= 0.
+using Plane = std::array<float, 4>;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Convert a matrix.
+//! \param matrix A matrix.
+//! \return A matrix.
+inline Matrix4 ConvertToMatrix4(const simd::float4x4 &matrix) {
+    Matrix4 result;
+    static_assert(sizeof(result) == sizeof(matrix.columns));
+    std::memcpy(result.data(), &matrix.columns, sizeof(result));
+    return result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Multiply matrices.
+//! \param a A matrix.
+//! \param b A matrix.
+//! \return a * b.
+Matrix4 Multiply(const Matrix4 &a, const Matrix4 &b);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Invert a matrix.
+//! \param matrix A matrix.
+//! \return The inverse of a matrix, or a zero matrix if it is singular.
+Matrix4 Invert(const Matrix4 &matrix);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Retrieve the position of a viewer from a rigid view matrix.
+//! \param view A view matrix.
+//! \return The position of a viewer.
+std::array<float, 3> GetViewPosition(const Matrix4 &view);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! The planes bound a view volume of a projection with depth in [0, 1], the planes face inward and are normalized.
+struct Frustum {
+    std::array<Plane, 6> planes;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Extract planes of a frustum.
+//! \param view_projection A view projection matrix.
+//! \return A frustum in the space before a view projection matrix.
+Frustum MakeFrustum(const Matrix4 &view_projection);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Query whether a sphere may be visible.
+//! \param frustum A frustum.
+//! \param center The center of a sphere.
+//! \param radius The radius of a sphere.
+//! \return False if a sphere is entirely outside of a plane.
+bool IsVisible(const Frustum &frustum, const std::array<float, 3> &center, float radius);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
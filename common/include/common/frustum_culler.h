@@ -0,0 +1,168 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef FRUSTUM_CULLER_H_
+#define FRUSTUM_CULLER_H_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "frustum.h"
+#include "job_system.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Objects are split into chunks of this many objects which are culled on worker threads.
+constexpr auto kFrustumCullChunkSize = 16384u;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Bounding spheres in a structure of arrays, so lanes of a register load consecutive objects.
+struct BoundingSpheres {
+    std::vector<float> center_x;
+    std::vector<float> center_y;
+    std::vector<float> center_z;
+    std::vector<float> radius;
+
+    //! Add a sphere.
+    //! \param center The center of a sphere.
+    //! \param sphere_radius The radius of a sphere.
+    void Add(const std::array<float, 3> &center, float sphere_radius);
+
+    //! Retrieve the number of spheres.
+    //! \return The number of spheres.
+    [[nodiscard]]
+    inline auto GetCount() const {
+        return radius.size();
+    }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Axis aligned bounding boxes in a structure of arrays.
+struct BoundingBoxes {
+    std::vector<float> min_x;
+    std::vector<float> min_y;
+    std::vector<float> min_z;
+    std::vector<float> max_x;
+    std::vector<float> max_y;
+    std::vector<float> max_z;
+
+    //! Add a box.
+    //! \param min The minimum corner of a box.
+    //! \param max The maximum corner of a box.
+    void Add(const std::array<float, 3> &min, const std::array<float, 3> &max);
+
+    //! Retrieve the number of boxes.
+    //! \return The number of boxes.
+    [[nodiscard]]
+    inline auto GetCount() const {
+        return min_x.size();
+    }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+enum class FrustumCullMode {
+    kScalar,
+    kSimd
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Cull spheres in a range.
+//! \param frustum A frustum.
+//! \param spheres Spheres.
+//! \param begin The first sphere.
+//! \param end The sphere after the last one.
+//! \param mode Whether lanes of a register test many spheres at once.
+//! \param visible Indices of visible spheres are written, it must have room for every sphere of a range.
+//! \return The number of visible spheres.
+size_t CullSpheres(const Frustum &frustum, const BoundingSpheres &spheres, size_t begin, size_t end,
+                   FrustumCullMode mode, uint32_t *visible);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Cull boxes in a range.
+//! \param frustum A frustum.
+//! \param boxes Boxes.
+//! \param begin The first box.
+//! \param end The box after the last one.
+//! \param mode Whether lanes of a register test many boxes at once.
+//! \param visible Indices of visible boxes are written, it must have room for every box of a range.
+//! \return The number of visible boxes.
+size_t CullBoxes(const Frustum &frustum, const BoundingBoxes &boxes, size_t begin, size_t end,
+                 FrustumCullMode mode, uint32_t *visible);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct FrustumCullStatistics {
+    uint64_t tested_count = 0;
+    uint64_t visible_count = 0;
+    uint32_t chunk_count = 0;
+    std::chrono::duration<double> elapsed_time = std::chrono::duration<double>::zero();
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A culler splits objects into chunks and culls them on jobs and the calling thread. Visible indices are compacted
+//! in the order of objects.
+class FrustumCuller {
+public:
+    //! Constructor.
+    //! \param job_system A job system culls chunks, it must outlive a culler.
+    //! \param mode Whether lanes of a register test many objects at once.
+    explicit FrustumCuller(JobSystem *job_system, FrustumCullMode mode = FrustumCullMode::kSimd);
+
+    //! Cull spheres.
+    //! \param frustum A frustum.
+    //! \param spheres Spheres.
+    //! \param visible Indices of visible spheres in increasing order.
+    void Cull(const Frustum &frustum, const BoundingSpheres &spheres, std::vector<uint32_t> &visible);
+
+    //! Cull boxes.
+    //! \param frustum A frustum.
+    //! \param boxes Boxes.
+    //! \param visible Indices of visible boxes in increasing order.
+    void Cull(const Frustum &frustum, const BoundingBoxes &boxes, std::vector<uint32_t> &visible);
+
+    //! Set a mode.
+    //! \param mode Whether lanes of a register test many objects at once.
+    inline void SetMode(FrustumCullMode mode) {
+        _mode = mode;
+    }
+
+    //! Retrieve a mode.
+    //! \return A mode.
+    [[nodiscard]]
+    inline auto GetMode() const {
+        return _mode;
+    }
+
+    //! Retrieve statistics of the last cull.
+    //! \return Statistics.
+    [[nodiscard]]
+    inline const auto &GetStatistics() const {
+        return _statistics;
+    }
+
+private:
+    //! Cull chunks of objects with a function which culls a range.
+    template<typename F>
+    void CullChunks(size_t count, std::vector<uint32_t> &visible, F &&function);
+
+private:
+    JobSystem *_job_system = nullptr;
+    FrustumCullMode _mode = FrustumCullMode::kSimd;
+    std::vector<size_t> _chunk_counts;
+    FrustumCullStatistics _statistics;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
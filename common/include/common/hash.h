@@ -0,0 +1,66 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef HASH_H_
+#define HASH_H_
+
+#include <cstdint>
+#include <string_view>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr auto kHashSeed = 14695981039346656037ull;
+constexpr auto kHashPrime = 1099511628211ull;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Hash bytes with 64 bit FNV-1a.
+//! \param data A pointer to bytes.
+//! \param size The size of bytes.
+//! \param seed A seed to chain hashes.
+//! \return A hash.
+inline uint64_t Hash(const void *data, size_t size, uint64_t seed = kHashSeed) {
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (auto i = size_t(0); i != size; ++i) {
+        seed = (seed ^ bytes[i]) * kHashPrime;
+    }
+    return seed;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Hash a string with 64 bit FNV-1a.
+//! \param data A string.
+//! \param seed A seed to chain hashes.
+//! \return A hash.
+inline uint64_t Hash(std::string_view data, uint64_t seed = kHashSeed) {
+    return Hash(data.data(), data.size(), seed);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Hash a string after its size, so chained strings can't collide by moving characters between them.
+//! \param data A string.
+//! \param seed A seed to chain hashes.
+//! \return A hash.
+inline uint64_t HashWithSize(std::string_view data, uint64_t seed = kHashSeed) {
+    auto size = static_cast<uint64_t>(data.size());
+    return Hash(data.data(), data.size(), Hash(&size, sizeof(size), seed));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Combine a hash with a value.
+//! \param seed A hash.
+//! \param value A value.
+//! \return A combined hash.
+template<typename T>
+inline uint64_t HashCombine(uint64_t seed, const T &value) {
+    return Hash(&value, sizeof(T), seed);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
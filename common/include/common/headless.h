@@ -0,0 +1,35 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef HEADLESS_H_
+#define HEADLESS_H_
+
+#include "utility.h"
+#include "arguments.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class Example;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class Headless {
+public:
+    //! Constructor.
+    //! \param resolution A resolution of the off screen swapchain.
+    explicit Headless(const Resolution &resolution);
+
+    //! Run the main loop for the given number of frames and report CPU frame times.
+    //! \param example An example will be run.
+    //! \param frame_count The number of frames to run.
+    void MainLoop(Example *example, uint32_t frame_count);
+
+private:
+    Resolution _resolution;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
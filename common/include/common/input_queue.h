@@ -0,0 +1,86 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef INPUT_QUEUE_H_
+#define INPUT_QUEUE_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// The number of pending events, a window produces a few hundred per second even with a high rate mouse.
+constexpr auto kInputQueueCapacity = 1024u;
+
+static_assert((kInputQueueCapacity & (kInputQueueCapacity - 1)) == 0);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+enum class InputEventType : uint32_t {
+    kMouseButtonDown,
+    kMouseButtonUp,
+    kMouseMove,
+    kMouseDrag,
+    kMouseWheel
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct InputEvent {
+    InputEventType type = InputEventType::kMouseMove;
+    //! A point of the mouse cursor in the view where the origin is the top left corner, a wheel has no point.
+    float x = 0.0f;
+    float y = 0.0f;
+    //! The rotated distance by wheel.
+    float delta = 0.0f;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct InputQueueStatistics {
+    //! The number of events are drained.
+    uint64_t event_count = 0;
+    //! The number of events are merged into a preceding one.
+    uint64_t coalesced_count = 0;
+    //! The number of events are dropped as a queue is full.
+    uint64_t dropped_count = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A lock-free ring of input events from a single producer, a thread handles events of a window, to a single
+//! consumer, a thread updates frames.
+class InputQueue {
+public:
+    //! Push an event, only a producer calls it.
+    //! \param event An event.
+    //! \return False if a queue is full, an event is dropped then.
+    bool Push(const InputEvent &event);
+
+    //! Pop every pending event, only a consumer calls it. Consecutive moves and drags are coalesced into the last one
+    //! as a point is absolute, and consecutive wheels into one with the sum of deltas.
+    //! \param events Events, pending events are appended.
+    void Drain(std::vector<InputEvent> &events);
+
+    //! Retrieve statistics, only a consumer calls it.
+    //! \return Statistics.
+    [[nodiscard]]
+    InputQueueStatistics GetStatistics() const;
+
+private:
+    std::array<InputEvent, kInputQueueCapacity> _events;
+    // A producer and a consumer each write their own cache line.
+    alignas(64) std::atomic<uint32_t> _tail = 0;
+    std::atomic<uint64_t> _dropped_count = 0;
+    alignas(64) std::atomic<uint32_t> _head = 0;
+    uint64_t _event_count = 0;
+    uint64_t _coalesced_count = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
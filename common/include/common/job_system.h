@@ -0,0 +1,206 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef JOB_SYSTEM_H_
+#define JOB_SYSTEM_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// A deque of a worker holds this many jobs, more jobs go to the shared queue.
+constexpr auto kJobDequeCapacity = 4096u;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class JobCounter;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct Job {
+    std::function<void()> function;
+    //! A counter is decremented once a job is done.
+    JobCounter *counter = nullptr;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A counter of jobs which aren't done yet. Jobs depending on a counter are queued once it drops to zero. Wait for a
+//! counter before destroying it, the last job may still be finishing with it right after it drops to zero.
+class JobCounter {
+public:
+    //! Query whether jobs of a counter are done.
+    //! \return True if every job is done.
+    [[nodiscard]]
+    inline bool IsDone() const {
+        return !_count.load(std::memory_order_acquire);
+    }
+
+private:
+    friend class JobSystem;
+
+    std::atomic<uint32_t> _count = 0;
+    // A counter is decremented under a lock, so a waiter locks it once to know the last job let it go.
+    mutable std::mutex _mutex;
+    std::vector<Job *> _continuations;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A deque a worker pushes to and pops from its bottom while others steal from its top without locks.
+class JobDeque {
+public:
+    //! Constructor.
+    JobDeque();
+
+    //! Push a job to the bottom, only its owner can push.
+    //! \param job A job.
+    //! \return False if a deque is full.
+    bool Push(Job *job);
+
+    //! Pop a job from the bottom, only its owner can pop.
+    //! \return A job, or nullptr if a deque is empty.
+    Job *Pop();
+
+    //! Steal a job from the top, any thread can steal.
+    //! \return A job, or nullptr if a deque is empty or another thread took it first.
+    Job *Steal();
+
+private:
+    // Indices only grow, so a slot is never confused with an older job in the same slot.
+    alignas(64) std::atomic<int64_t> _top = 0;
+    alignas(64) std::atomic<int64_t> _bottom = 0;
+    std::unique_ptr<std::atomic<Job *>[]> _jobs;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct JobStatistics {
+    //! The number of jobs are executed by workers and waiting threads.
+    uint64_t executed_count = 0;
+    //! The number of jobs are taken from a deque of another worker.
+    uint64_t stolen_count = 0;
+    //! The number of jobs are executed by threads waiting for a counter.
+    uint64_t helped_count = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A job system runs jobs on workers with a deque each. A worker runs its own jobs last in first out and steals from
+//! others when it runs out, so jobs spawned by a job stay on a warm core. A thread waiting for a counter runs jobs
+//! instead of blocking, so a job can wait for jobs it spawned.
+class JobSystem {
+public:
+    //! Constructor.
+    //! \param thread_count The number of worker threads, zero uses all cores.
+    explicit JobSystem(uint32_t thread_count = 0);
+
+    //! Destructor. Pending jobs are finished before workers exit.
+    ~JobSystem();
+
+    //! Run a job.
+    //! \param function A function of a job.
+    //! \param counter A counter is incremented now and decremented once a job is done, or nullptr.
+    void Run(std::function<void()> function, JobCounter *counter = nullptr);
+
+    //! Run a job once jobs of a dependency are done.
+    //! \param function A function of a job.
+    //! \param counter A counter is incremented now and decremented once a job is done, or nullptr.
+    //! \param dependency A counter of jobs must be done first.
+    void Run(std::function<void()> function, JobCounter *counter, JobCounter &dependency);
+
+    //! Run a job whose result is retrieved later, for work nothing waits for within a frame.
+    //! \param function A function of a job.
+    //! \param counter A counter is incremented now and decremented once a job is done, or nullptr.
+    //! \return A future of the result of a job, an exception is rethrown from it.
+    template<typename F>
+    auto Submit(F &&function, JobCounter *counter = nullptr) {
+        using Result = std::invoke_result_t<F>;
+
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(function));
+        auto future = task->get_future();
+        Run([task]() { (*task)(); }, counter);
+        return future;
+    }
+
+    //! Run jobs until jobs of a counter are done.
+    //! \param counter A counter.
+    void Wait(const JobCounter &counter);
+
+    //! Split a range into jobs and wait for them, the calling thread runs jobs as well. The first exception thrown by
+    //! a function is rethrown once every job is done.
+    //! \param count The number of items.
+    //! \param grain_size The minimum number of items of a job.
+    //! \param function A function processes items in [begin, end).
+    void ParallelFor(uint32_t count, uint32_t grain_size, const std::function<void(uint32_t, uint32_t)> &function);
+
+    //! Retrieve the number of worker threads.
+    //! \return The number of worker threads.
+    [[nodiscard]]
+    inline auto GetThreadCount() const {
+        return static_cast<uint32_t>(_threads.size());
+    }
+
+    //! Retrieve statistics since construction or the last reset.
+    //! \return Statistics.
+    [[nodiscard]]
+    JobStatistics GetStatistics() const;
+
+    //! Reset statistics.
+    void ResetStatistics();
+
+private:
+    struct alignas(64) Worker {
+        JobDeque deque;
+        std::atomic<uint64_t> executed_count = 0;
+        std::atomic<uint64_t> stolen_count = 0;
+    };
+
+private:
+    //! Queue a job to a deque of the calling worker, or to the shared queue.
+    void Push(Job *job);
+
+    //! Take a job from a deque of the calling worker, the shared queue or other workers.
+    //! \param index The index of the calling worker, or the number of workers for other threads.
+    //! \return A job, or nullptr if none is found.
+    Job *Take(uint32_t index);
+
+    //! Execute a job and queue jobs depending on its counter if it is the last one.
+    void Execute(Job *job);
+
+    //! Execute jobs until the system is destroyed.
+    //! \param index The index of a worker.
+    void Work(uint32_t index);
+
+    //! Retrieve the index of the calling worker.
+    //! \return The index of a worker, or the number of workers for other threads.
+    [[nodiscard]]
+    uint32_t GetWorkerIndex() const;
+
+private:
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::deque<Job *> _jobs;
+    std::atomic<uint32_t> _queued_count = 0;
+    std::atomic<uint32_t> _sleeping_count = 0;
+    std::atomic<uint64_t> _helped_count = 0;
+    bool _stop = false;
+    std::vector<std::thread> _threads;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,105 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef LOD_H_
+#define LOD_H_
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "mesh.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr auto kMaxLodCount = 8u;
+
+// Every level has about this fraction of the triangles of the previous level.
+constexpr auto kDefaultLodReduction = 0.5f;
+
+// The largest error in pixels is accepted on screen.
+constexpr auto kDefaultLodThreshold = 1.0f;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct LodLevel {
+    uint32_t index_offset = 0;
+    uint32_t index_count = 0;
+    //! The largest distance from the surface of the first level, in units of positions.
+    float error = 0.0f;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Levels of detail of a mesh from the finest to the coarsest. Indices of every level are in one array and they
+//! refer to vertices of the mesh, so levels share one vertex buffer and one index buffer.
+struct LodChain {
+    std::vector<uint32_t> indices;
+    std::vector<LodLevel> levels;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Build levels of detail by simplifying every level from the previous one.
+//! \param mesh A mesh, it is the first level.
+//! \param max_level_count The maximum number of levels.
+//! \param reduction The fraction of triangles every level keeps.
+//! \return Levels of detail, the chain stops early when a mesh can't be simplified any more.
+LodChain BuildLodChain(const Mesh &mesh, uint32_t max_level_count = kMaxLodCount,
+                       float reduction = kDefaultLodReduction);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A viewer for selecting levels of detail.
+struct LodView {
+    std::array<float, 3> position = {0.0f, 0.0f, 0.0f};
+    //! The number of pixels an error of one unit covers at a distance of one unit.
+    float pixel_scale = 1.0f;
+    float threshold = kDefaultLodThreshold;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Make a viewer from a perspective projection, for example the position and field of view of Camera.
+//! \param position The position of a viewer.
+//! \param fov The vertical field of view in radians.
+//! \param viewport_height The height of a viewport in pixels.
+//! \param threshold The largest error in pixels is accepted on screen.
+//! \return A viewer.
+LodView MakeLodView(const std::array<float, 3> &position, float fov, float viewport_height,
+                    float threshold = kDefaultLodThreshold);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct LodObject {
+    std::array<float, 3> center = {0.0f, 0.0f, 0.0f};
+    float radius = 0.0f;
+    float scale = 1.0f;
+    uint32_t chain = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Select the coarsest level whose error projected to the nearest point of a bounding sphere is within a threshold.
+//! \param view A viewer.
+//! \param object An object.
+//! \param chain Levels of detail of an object.
+//! \return A level.
+uint32_t SelectLod(const LodView &view, const LodObject &object, const LodChain &chain);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Select levels of many objects.
+//! \param view A viewer.
+//! \param objects Objects.
+//! \param chains Levels of detail which objects refer to.
+//! \param levels Selected levels of objects.
+void SelectLods(const LodView &view, std::span<const LodObject> objects, std::span<const LodChain> chains,
+                std::span<uint8_t> levels);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,106 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef MESH_H_
+#define MESH_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include "job_system.h"
+#include "vertex_layout.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+using MeshLayout = VertexLayout<Position<Float3>, Normal<Snorm8x4>, TexCoord<Half2>>;
+using MeshVertex = MeshLayout::Vertex;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Values of MTLIndexType.
+enum class MeshIndexFormat : uint32_t {
+    kUInt16 = 0,
+    kUInt32 = 1
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! An indexed triangle list. Indices are kept as 32 bits until they are packed for a GPU.
+struct Mesh {
+    std::vector<MeshVertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct MeshStatistics {
+    uint64_t vertex_count = 0;
+    uint64_t triangle_count = 0;
+    float acmr_before = 0.0f;
+    float acmr_after = 0.0f;
+    float fetch_ratio_before = 0.0f;
+    float fetch_ratio_after = 0.0f;
+    std::chrono::duration<double> parse_time = std::chrono::duration<double>::zero();
+    std::chrono::duration<double> optimize_time = std::chrono::duration<double>::zero();
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Retrieve the smallest index format can address every vertex of a mesh.
+//! \param mesh A mesh.
+//! \return An index format.
+MeshIndexFormat GetIndexFormat(const Mesh &mesh);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Retrieve the size of an index.
+//! \param format An index format.
+//! \return The size of an index.
+uint32_t GetIndexSize(MeshIndexFormat format);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Pack indices of a mesh for a GPU.
+//! \param mesh A mesh.
+//! \param format An index format, it must address every vertex.
+//! \return Packed indices.
+std::vector<std::byte> PackIndices(const Mesh &mesh, MeshIndexFormat format);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A loader reads binary glTF and OBJ files straight from a mapped file. OBJ text is parsed in chunks and binary
+//! glTF primitives are decoded on many threads, then a mesh is optimized for the post transform vertex cache,
+//! overdraw and vertex fetch.
+class MeshLoader {
+public:
+    //! Constructor.
+    //! \param job_system A job system parses a file, it must outlive a loader.
+    explicit MeshLoader(JobSystem *job_system);
+
+    //! Load a mesh.
+    //! \param path A path of a ".glb" or ".obj" file.
+    //! \param optimize True if a mesh is optimized.
+    //! \return A mesh.
+    Mesh Load(const std::filesystem::path &path, bool optimize = true);
+
+    //! Retrieve statistics of the last load.
+    //! \return Statistics.
+    [[nodiscard]]
+    inline const auto &GetStatistics() const {
+        return _statistics;
+    }
+
+private:
+    JobSystem *_job_system = nullptr;
+    MeshStatistics _statistics;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,70 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef MESH_OPTIMIZER_H_
+#define MESH_OPTIMIZER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "mesh.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// The size of a FIFO post transform cache which is used to analyze a mesh, it is close to what a GPU keeps.
+constexpr auto kVertexCacheSize = 16u;
+
+// The size of a line of a cache which is used to analyze vertex fetch.
+constexpr auto kVertexFetchLineSize = 64u;
+
+// How much worse the cache efficiency of a cluster may get to draw it in a better order for overdraw.
+constexpr auto kOverdrawThreshold = 1.05f;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Reorder triangles to reuse transformed vertices, the order is chosen by scoring vertices like Forsyth's algorithm.
+//! \param indices Indices of a triangle list.
+//! \param vertex_count The number of vertices.
+void OptimizeVertexCache(std::span<uint32_t> indices, size_t vertex_count);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Reorder clusters of triangles so triangles facing outward are drawn first, which occlude the rest of a mesh.
+//! A triangle list should be optimized for the vertex cache before.
+//! \param indices Indices of a triangle list.
+//! \param vertices Vertices.
+//! \param threshold How much worse the cache efficiency of a cluster may get.
+void OptimizeOverdraw(std::span<uint32_t> indices, std::span<const MeshVertex> vertices,
+                      float threshold = kOverdrawThreshold);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Reorder vertices in the order they are first used, and remove vertices which are not used.
+//! \param mesh A mesh.
+void OptimizeVertexFetch(Mesh &mesh);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Compute the average cache miss ratio, the number of transformed vertices per a triangle.
+//! \param indices Indices of a triangle list.
+//! \param vertex_count The number of vertices.
+//! \param cache_size The size of a FIFO cache.
+//! \return The average cache miss ratio, 3 is the worst and 0.5 is the best for a large grid.
+float AnalyzeVertexCache(std::span<const uint32_t> indices, size_t vertex_count,
+                         uint32_t cache_size = kVertexCacheSize);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Compute the ratio of fetched bytes to the size of used vertices.
+//! \param indices Indices of a triangle list.
+//! \param vertex_count The number of vertices.
+//! \param stride The size of a vertex.
+//! \return The ratio of fetched bytes, 1 means every vertex is fetched once.
+float AnalyzeVertexFetch(std::span<const uint32_t> indices, size_t vertex_count, uint32_t stride);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,40 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef MESH_SIMPLIFIER_H_
+#define MESH_SIMPLIFIER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "mesh.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct MeshSimplifyResult {
+    std::vector<uint32_t> indices;
+    //! The largest distance from a simplified surface to the input surface, in units of positions.
+    float error = 0.0f;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Simplify a triangle list with quadric error metrics. Edges are collapsed onto one of their vertices, so indices of
+//! a simplified mesh refer to vertices of a mesh and every level of detail shares one vertex buffer. Borders are kept
+//! in place and vertices on attribute seams aren't moved.
+//! \param mesh A mesh whose vertices are referred to.
+//! \param indices Indices of a triangle list to simplify.
+//! \param target_index_count The number of indices to reduce to.
+//! \param target_error The largest error is allowed.
+//! \return Indices of a simplified triangle list and its error.
+MeshSimplifyResult SimplifyMesh(const Mesh &mesh, std::span<const uint32_t> indices, size_t target_index_count,
+                                float target_error = std::numeric_limits<float>::max());
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
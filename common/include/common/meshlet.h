@@ -0,0 +1,88 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef MESHLET_H_
+#define MESHLET_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "frustum.h"
+#include "mesh.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Limits which suit mesh shaders, 124 triangles keep local indices of a meshlet in 372 bytes.
+constexpr auto kMeshletMaxVertexCount = 64u;
+constexpr auto kMeshletMaxTriangleCount = 124u;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct Meshlet {
+    uint32_t vertex_offset = 0;
+    uint32_t triangle_offset = 0;
+    uint32_t vertex_count = 0;
+    uint32_t triangle_count = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A bounding sphere and a cone of normals of a meshlet. A meshlet faces away from a viewer at p if
+//! dot(normalize(cone_apex - p), cone_axis) >= cone_cutoff, and a cutoff of 1 means normals are too wide to tell.
+struct MeshletBounds {
+    std::array<float, 3> center = {0.0f, 0.0f, 0.0f};
+    float radius = 0.0f;
+    std::array<float, 3> cone_apex = {0.0f, 0.0f, 0.0f};
+    std::array<float, 3> cone_axis = {0.0f, 0.0f, 0.0f};
+    float cone_cutoff = 1.0f;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Meshlets of a mesh. Vertices are indices into vertices of a mesh, and triangles are indices into vertices of a
+//! meshlet, three per a triangle.
+struct MeshletSet {
+    std::vector<Meshlet> meshlets;
+    std::vector<MeshletBounds> bounds;
+    std::vector<uint32_t> vertices;
+    std::vector<uint8_t> triangles;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct MeshletCullStatistics {
+    uint32_t meshlet_count = 0;
+    uint32_t frustum_culled_count = 0;
+    uint32_t backface_culled_count = 0;
+    uint64_t triangle_count = 0;
+    uint64_t visible_triangle_count = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Split a mesh into meshlets. A meshlet grows by triangles adjacent to it which add the fewest vertices, so the
+//! result only depends on a mesh.
+//! \param mesh A mesh, it should be optimized for the vertex cache before.
+//! \param max_vertex_count The maximum number of vertices of a meshlet, up to 256.
+//! \param max_triangle_count The maximum number of triangles of a meshlet.
+//! \return Meshlets.
+MeshletSet BuildMeshlets(const Mesh &mesh, uint32_t max_vertex_count = kMeshletMaxVertexCount,
+                         uint32_t max_triangle_count = kMeshletMaxTriangleCount);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Cull meshlets outside of a frustum or facing away from a viewer, and write indices of the rest.
+//! \param meshlet_set Meshlets.
+//! \param view A view matrix.
+//! \param projection A projection matrix.
+//! \param indices Indices into vertices of a mesh, they are replaced with triangles of visible meshlets.
+//! \return Statistics.
+MeshletCullStatistics CullMeshlets(const MeshletSet &meshlet_set, const Matrix4 &view, const Matrix4 &projection,
+                                   std::vector<uint32_t> &indices);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
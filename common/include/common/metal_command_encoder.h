@@ -0,0 +1,47 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef METAL_COMMAND_ENCODER_H_
+#define METAL_COMMAND_ENCODER_H_
+
+#include <Metal/Metal.h>
+#include <vector>
+
+#include "command_stream.h"
+#include "job_system.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Metal objects handles of commands refer to, a handle is an index of them.
+struct MetalCommandResources {
+    std::vector<id<MTLRenderPipelineState>> pipelines;
+    std::vector<id<MTLBuffer>> buffers;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Encode commands of a recorder.
+//! \param recorder A recorder.
+//! \param resources Objects handles of commands refer to.
+//! \param encoder A render command encoder, it isn't ended.
+void EncodeCommands(const CommandRecorder &recorder, const MetalCommandResources &resources,
+                    id<MTLRenderCommandEncoder> encoder);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Encode a command stream with a parallel render command encoder. A render command encoder per recorder is created in
+//! the order of recorders and they are encoded by jobs.
+//! \param stream A command stream.
+//! \param resources Objects handles of commands refer to.
+//! \param command_buffer A command buffer.
+//! \param descriptor A render pass descriptor.
+//! \param job_system A job system.
+void EncodeCommandStream(const CommandStream &stream, const MetalCommandResources &resources,
+                         id<MTLCommandBuffer> command_buffer, MTLRenderPassDescriptor *descriptor,
+                         JobSystem &job_system);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
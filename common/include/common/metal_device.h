@@ -0,0 +1,167 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef METAL_DEVICE_H_
+#define METAL_DEVICE_H_
+
+#include <QuartzCore/CAMetalLayer.h>
+#include <Metal/Metal.h>
+#include <atomic>
+#include <memory>
+
+#include "render_device.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr auto kMetalLayerPixelFormat = MTLPixelFormatBGRA8Unorm;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class MetalSwapchain : public Swapchain {
+public:
+    //! Constructor.
+    //! \param device A Metal device.
+    //! \param image_count The number of images.
+    MetalSwapchain(id<MTLDevice> device, uint32_t image_count);
+
+    //! Bind a swapchain to a layer.
+    //! \param layer A layer is presented by a swapchain.
+    void BindToLayer(CAMetalLayer *layer);
+
+    //! Resize images.
+    //! \param resolution A resolution.
+    void Resize(const Resolution &resolution) override;
+
+    //! Acquire a next image.
+    void AcquireNextImage() override;
+
+    //! Release the acquired image.
+    void ReleaseImage();
+
+    //! Retrieve a resolution.
+    //! \return A resolution of images.
+    [[nodiscard]]
+    Resolution GetResolution() const override;
+
+    //! Retrieve the number of images.
+    //! \return The number of images.
+    [[nodiscard]]
+    uint32_t GetImageCount() const override;
+
+    //! Retrieve a layer.
+    //! \return A layer.
+    [[nodiscard]]
+    inline auto GetLayer() const {
+        return _layer;
+    }
+
+    //! Retrieve the acquired drawable.
+    //! \return The acquired drawable.
+    [[nodiscard]]
+    inline auto GetDrawable() const {
+        return _drawable;
+    }
+
+private:
+    id<MTLDevice> _device;
+    uint32_t _image_count = 0;
+    Resolution _resolution = {0, 0};
+    CAMetalLayer *_layer = nil;
+    id<CAMetalDrawable> _drawable;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class MetalDevice : public RenderDevice {
+public:
+    //! Constructor.
+    //! \param frame_count The number of frames can be in flight.
+    //! \param drawable_count The number of drawables.
+    MetalDevice(uint32_t frame_count, uint32_t drawable_count);
+
+    //! Wait until the device can accept a new frame.
+    void WaitForFrame() override;
+
+    //! Begin a frame.
+    void BeginFrame() override;
+
+    //! End a frame. Submit recorded work and present the acquired image.
+    void EndFrame() override;
+
+    //! Wait until all submitted frames have completed.
+    void WaitIdle() override;
+
+    //! Retrieve a backend.
+    //! \return A backend.
+    [[nodiscard]]
+    Backend GetBackend() const override;
+
+    //! Retrieve a device name.
+    //! \return A device name.
+    [[nodiscard]]
+    std::string GetName() const override;
+
+    //! Retrieve a swapchain.
+    //! \return A swapchain.
+    [[nodiscard]]
+    Swapchain* GetSwapchain() override;
+
+    //! Retrieve GPU time of the last completed frame.
+    //! \return GPU time, zero without a GPU.
+    [[nodiscard]]
+    std::chrono::duration<double> GetGpuTime() const override;
+
+    //! Retrieve a device.
+    //! \return A device.
+    [[nodiscard]]
+    inline auto GetDevice() const {
+        return _device;
+    }
+
+    //! Retrieve a command queue.
+    //! \return A command queue.
+    [[nodiscard]]
+    inline auto GetCommandQueue() const {
+        return _command_queue;
+    }
+
+    //! Retrieve a command buffer of the current frame.
+    //! \return A command buffer.
+    [[nodiscard]]
+    inline auto GetCommandBuffer() const {
+        return _command_buffer;
+    }
+
+    //! Retrieve a Metal swapchain.
+    //! \return A Metal swapchain.
+    [[nodiscard]]
+    inline auto GetMetalSwapchain() {
+        return _swapchain.get();
+    }
+
+private:
+    //! Initialize a device.
+    void InitDevice();
+
+    //! Initialize a command queue.
+    void InitCommandQueue();
+
+    //! Initialize a semaphore.
+    //! \param frame_count The number of frames can be in flight.
+    void InitSemaphore(uint32_t frame_count);
+
+private:
+    id<MTLDevice> _device;
+    id<MTLCommandQueue> _command_queue;
+    dispatch_semaphore_t _semaphore = nil;
+    id<MTLCommandBuffer> _command_buffer;
+    std::unique_ptr<MetalSwapchain> _swapchain;
+    // A completed handler may outlive a device.
+    std::shared_ptr<std::atomic<double>> _gpu_time = std::make_shared<std::atomic<double>>(0.0);
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
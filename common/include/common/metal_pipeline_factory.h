@@ -0,0 +1,62 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef METAL_PIPELINE_FACTORY_H_
+#define METAL_PIPELINE_FACTORY_H_
+
+#include <Metal/Metal.h>
+
+#include "pipeline_cache.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class MetalPipelineState : public PipelineState {
+public:
+    //! Constructor.
+    //! \param pipeline_state A Metal render pipeline state.
+    explicit MetalPipelineState(id<MTLRenderPipelineState> pipeline_state);
+
+    //! Retrieve a render pipeline state.
+    //! \return A render pipeline state.
+    [[nodiscard]]
+    inline auto GetPipelineState() const {
+        return _pipeline_state;
+    }
+
+private:
+    id<MTLRenderPipelineState> _pipeline_state;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Wait for a pipeline state and retrieve its Metal render pipeline state.
+//! \param future A future of a pipeline state.
+//! \return A render pipeline state.
+inline id<MTLRenderPipelineState> GetMetalPipelineState(const PipelineFuture &future) {
+    return std::static_pointer_cast<MetalPipelineState>(future.get())->GetPipelineState();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class MetalPipelineFactory : public PipelineFactory {
+public:
+    //! Constructor.
+    //! \param device A Metal device.
+    //! \param shader_cache A shader cache provides shader functions.
+    MetalPipelineFactory(id<MTLDevice> device, ShaderCache *shader_cache);
+
+    //! Create a pipeline state.
+    //! \param descriptor A pipeline descriptor.
+    //! \return A pipeline state.
+    std::shared_ptr<PipelineState> Create(const PipelineDescriptor &descriptor) override;
+
+private:
+    id<MTLDevice> _device;
+    ShaderCache *_shader_cache = nullptr;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,75 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef METAL_SHADER_COMPILER_H_
+#define METAL_SHADER_COMPILER_H_
+
+#include <Metal/Metal.h>
+
+#include "shader_cache.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class MetalShaderLibrary : public ShaderLibrary {
+public:
+    //! Constructor.
+    //! \param library A Metal library.
+    explicit MetalShaderLibrary(id<MTLLibrary> library);
+
+    //! Retrieve a function.
+    //! \param entrypoint The name of shader entrypoint function where shader execution begin.
+    //! \return A handle to MTLFunction.
+    [[nodiscard]]
+    id<MTLFunction> GetFunction(const std::string &entrypoint) const;
+
+    //! Retrieve a library.
+    //! \return A library.
+    [[nodiscard]]
+    inline auto GetLibrary() const {
+        return _library;
+    }
+
+private:
+    id<MTLLibrary> _library;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class MetalShaderCompiler : public ShaderCompiler {
+public:
+    //! Constructor.
+    //! \param device A Metal device.
+    //! \param use_toolchain Compile with the offline toolchain so libraries can be stored as binaries.
+    MetalShaderCompiler(id<MTLDevice> device, bool use_toolchain);
+
+    //! Retrieve an identifier of a compiler. It changes with a device and an OS version.
+    //! \return An identifier of a compiler.
+    [[nodiscard]]
+    std::string GetIdentifier() const override;
+
+    //! Compile a source to a library.
+    //! \param source A shader source.
+    //! \param macros Preprocessor macros.
+    //! \return A library and its binary, the binary is empty if the toolchain isn't available.
+    ShaderCompileResult Compile(std::string_view source, const ShaderMacros &macros) override;
+
+    //! Load a library from a binary.
+    //! \param binary A metallib binary.
+    //! \return A library.
+    std::shared_ptr<ShaderLibrary> Load(std::span<const std::byte> binary) override;
+
+private:
+    //! Compile a source to a metallib binary with the offline toolchain.
+    //! \return A metallib binary, or empty if the toolchain fails.
+    std::vector<std::byte> CompileWithToolchain(std::string_view source, const ShaderMacros &macros);
+
+private:
+    id<MTLDevice> _device;
+    bool _use_toolchain = false;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,33 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef METAL_UPSCALER_H_
+#define METAL_UPSCALER_H_
+
+#include <Metal/Metal.h>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! An upscaler draws a texture over a whole render target with bilinear filtering.
+class MetalUpscaler {
+public:
+    //! Constructor.
+    //! \param device A device.
+    //! \param pixel_format A pixel format of render targets.
+    MetalUpscaler(id<MTLDevice> device, MTLPixelFormat pixel_format);
+
+    //! Encode a draw of a texture over a render target.
+    //! \param encoder A render command encoder, it isn't ended.
+    //! \param texture A texture.
+    void Encode(id<MTLRenderCommandEncoder> encoder, id<MTLTexture> texture);
+
+private:
+    id<MTLRenderPipelineState> _pipeline_state;
+    id<MTLSamplerState> _sampler_state;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
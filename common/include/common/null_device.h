@@ -0,0 +1,107 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef NULL_DEVICE_H_
+#define NULL_DEVICE_H_
+
+#include <semaphore>
+
+#include "render_device.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class NullSwapchain : public Swapchain {
+public:
+    //! Constructor.
+    //! \param image_count The number of images.
+    explicit NullSwapchain(uint32_t image_count);
+
+    //! Resize images.
+    //! \param resolution A resolution.
+    void Resize(const Resolution &resolution) override;
+
+    //! Acquire a next image.
+    void AcquireNextImage() override;
+
+    //! Retrieve a resolution.
+    //! \return A resolution of images.
+    [[nodiscard]]
+    Resolution GetResolution() const override;
+
+    //! Retrieve the number of images.
+    //! \return The number of images.
+    [[nodiscard]]
+    uint32_t GetImageCount() const override;
+
+    //! Retrieve the index of the acquired image.
+    //! \return The index of the acquired image.
+    [[nodiscard]]
+    inline auto GetImageIndex() const {
+        return _image_index;
+    }
+
+private:
+    uint32_t _image_count = 0;
+    uint32_t _image_index = 0;
+    Resolution _resolution = {0, 0};
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class NullDevice : public RenderDevice {
+public:
+    //! Constructor.
+    //! \param frame_count The number of frames can be in flight.
+    //! \param image_count The number of swapchain images.
+    NullDevice(uint32_t frame_count, uint32_t image_count);
+
+    //! Wait until the device can accept a new frame.
+    void WaitForFrame() override;
+
+    //! Begin a frame.
+    void BeginFrame() override;
+
+    //! End a frame. There is no GPU so the frame completes immediately.
+    void EndFrame() override;
+
+    //! Wait until all submitted frames have completed.
+    void WaitIdle() override;
+
+    //! Retrieve a backend.
+    //! \return A backend.
+    [[nodiscard]]
+    Backend GetBackend() const override;
+
+    //! Retrieve a device name.
+    //! \return A device name.
+    [[nodiscard]]
+    std::string GetName() const override;
+
+    //! Retrieve a swapchain.
+    //! \return A swapchain.
+    [[nodiscard]]
+    Swapchain* GetSwapchain() override;
+
+    //! Retrieve GPU time of the last completed frame.
+    //! \return GPU time, zero without a GPU.
+    [[nodiscard]]
+    std::chrono::duration<double> GetGpuTime() const override;
+
+    //! Retrieve the number of submitted frames.
+    //! \return The number of submitted frames.
+    [[nodiscard]]
+    inline auto GetSubmitCount() const {
+        return _submit_count;
+    }
+
+private:
+    std::counting_semaphore<> _semaphore;
+    NullSwapchain _swapchain;
+    uint64_t _submit_count = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
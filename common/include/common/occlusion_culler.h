@@ -0,0 +1,181 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef OCCLUSION_CULLER_H_
+#define OCCLUSION_CULLER_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <span>
+#include <vector>
+
+#include "frustum.h"
+#include "frustum_culler.h"
+#include "job_system.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr auto kOcclusionDepthWidth = 256u;
+constexpr auto kOcclusionDepthHeight = 128u;
+
+// Rows of a depth buffer are rasterized in bands of this many rows, one band per task.
+constexpr auto kOcclusionBandHeight = 16u;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A level of a depth pyramid, every texel has the nearest and the farthest depth of texels it covers below.
+struct OcclusionDepthLevel {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<float> min_depths;
+    std::vector<float> max_depths;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct OcclusionCullStatistics {
+    uint32_t occluder_count = 0;
+    uint64_t triangle_count = 0;
+    //! The number of triangles are left after clipping and rejecting small ones.
+    uint64_t rasterized_triangle_count = 0;
+    uint64_t tested_count = 0;
+    uint64_t occluded_count = 0;
+    std::chrono::duration<double> render_time = std::chrono::duration<double>::zero();
+    std::chrono::duration<double> cull_time = std::chrono::duration<double>::zero();
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A culler rasterizes occluders to a low resolution depth buffer on worker threads, builds a pyramid of it and
+//! rejects boxes behind it. Depth is in [0, 1] with 0 at the near plane like the projection of Camera. Occluders write
+//! the farthest depth in a pixel and boxes are tested over a pixel more around them, so a box peeking out of
+//! occluders is kept.
+class OcclusionCuller {
+public:
+    //! Constructor.
+    //! \param job_system A job system rasterizes occluders, it must outlive a culler.
+    //! \param width The width of a depth buffer.
+    //! \param height The height of a depth buffer.
+    explicit OcclusionCuller(JobSystem *job_system, uint32_t width = kOcclusionDepthWidth,
+                             uint32_t height = kOcclusionDepthHeight);
+
+    //! Destructor. Rendering in progress is finished first.
+    ~OcclusionCuller();
+
+    //! Begin a frame and forget occluders of the previous frame.
+    //! \param view_projection A view projection matrix, for example projection * view of Camera.
+    void Begin(const Matrix4 &view_projection);
+
+    //! Add an occluder. Positions and indices must be alive until rendering is done.
+    //! \param positions Positions of an occluder.
+    //! \param indices Indices of triangles of an occluder.
+    //! \param model A model matrix of an occluder.
+    void AddOccluder(std::span<const std::array<float, 3>> positions, std::span<const uint32_t> indices,
+                     const Matrix4 &model);
+
+    //! Rasterize occluders and build a depth pyramid on jobs. It returns right away so the calling thread
+    //! can do other work of a frame.
+    //! \return A future is ready when boxes can be tested.
+    std::future<void> Render();
+
+    //! Query whether a box may be visible.
+    //! \param min The minimum corner of a box.
+    //! \param max The maximum corner of a box.
+    //! \return False if a box is entirely behind occluders.
+    [[nodiscard]]
+    bool IsVisible(const std::array<float, 3> &min, const std::array<float, 3> &max) const;
+
+    //! Cull boxes, for example ones are visible from a frustum culler.
+    //! \param boxes Boxes.
+    //! \param candidates Indices of boxes to test.
+    //! \param visible Indices of candidates which may be visible in the order of candidates.
+    void Cull(const BoundingBoxes &boxes, std::span<const uint32_t> candidates, std::vector<uint32_t> &visible);
+
+    //! Retrieve a level of a depth pyramid, the first level is the depth buffer.
+    //! \param level A level.
+    //! \return A level of a depth pyramid.
+    [[nodiscard]]
+    inline const auto &GetDepthLevel(uint32_t level) const {
+        return _levels[level];
+    }
+
+    //! Retrieve the number of levels of a depth pyramid.
+    //! \return The number of levels.
+    [[nodiscard]]
+    inline auto GetDepthLevelCount() const {
+        return static_cast<uint32_t>(_levels.size());
+    }
+
+    //! Retrieve statistics of the last frame.
+    //! \return Statistics.
+    [[nodiscard]]
+    inline const auto &GetStatistics() const {
+        return _statistics;
+    }
+
+private:
+    struct Occluder {
+        std::span<const std::array<float, 3>> positions;
+        std::span<const uint32_t> indices;
+        Matrix4 model_view_projection = {};
+    };
+
+    struct Triangle {
+        std::array<float, 3> a = {};
+        std::array<float, 3> b = {};
+        std::array<float, 3> c = {};
+        std::array<float, 3> bias = {};
+        std::array<float, 3> depth_plane = {};
+        int32_t min_x = 0;
+        int32_t min_y = 0;
+        int32_t max_x = 0;
+        int32_t max_y = 0;
+    };
+
+private:
+    //! Transform, clip and set up triangles of a chunk.
+    void SetupChunk(uint32_t chunk);
+
+    //! Set up a triangle in clip space.
+    void SetupTriangle(const std::array<std::array<float, 4>, 3> &vertices, std::vector<Triangle> &triangles) const;
+
+    //! Set up a triangle in screen space.
+    void SetupScreenTriangle(const std::array<const std::array<float, 4> *, 3> &vertices,
+                             std::vector<Triangle> &triangles) const;
+
+    //! Submit tasks rasterizing bands once triangles are set up.
+    void SubmitBands();
+
+    //! Clear and rasterize rows of a band.
+    void RasterizeBand(uint32_t band);
+
+    //! Build a depth pyramid from a depth buffer.
+    void BuildPyramid();
+
+private:
+    uint32_t _width = 0;
+    uint32_t _height = 0;
+    uint32_t _stride = 0;
+    Matrix4 _view_projection = {};
+    std::vector<Occluder> _occluders;
+    std::vector<uint64_t> _triangle_offsets;
+    std::vector<std::vector<Triangle>> _chunk_triangles;
+    std::vector<float> _depths;
+    std::vector<OcclusionDepthLevel> _levels;
+    std::atomic<uint32_t> _pending_count = 0;
+    std::promise<void> _promise;
+    std::chrono::steady_clock::time_point _render_start_time;
+    std::vector<size_t> _chunk_counts;
+    OcclusionCullStatistics _statistics;
+    JobSystem *_job_system = nullptr;
+    JobCounter _counter;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,149 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef PIPELINE_CACHE_H_
+#define PIPELINE_CACHE_H_
+
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "job_system.h"
+#include "shader_cache.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct PipelineVertexAttribute {
+    uint32_t format = 0;
+    uint32_t offset = 0;
+    uint32_t buffer_index = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct PipelineVertexLayout {
+    uint32_t stride = 0;
+    uint32_t step_function = 0;
+    uint32_t step_rate = 1;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A backend independent description of a render pipeline. Formats are values of the backend enumerations.
+struct PipelineDescriptor {
+    std::filesystem::path shader_path;
+    std::string vertex_entrypoint;
+    std::string fragment_entrypoint;
+    ShaderMacros macros;
+    std::vector<PipelineVertexAttribute> attributes;
+    std::vector<PipelineVertexLayout> layouts;
+    std::vector<uint32_t> color_formats;
+    uint32_t depth_format = 0;
+    uint32_t sample_count = 1;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class PipelineState {
+public:
+    //! Destructor.
+    virtual ~PipelineState() = default;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+using PipelineFuture = std::shared_future<std::shared_ptr<PipelineState>>;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class PipelineFactory {
+public:
+    //! Destructor.
+    virtual ~PipelineFactory() = default;
+
+    //! Create a pipeline state. It is called from jobs.
+    //! \param descriptor A pipeline descriptor.
+    //! \return A pipeline state.
+    virtual std::shared_ptr<PipelineState> Create(const PipelineDescriptor &descriptor) = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct PipelineCacheStatistics {
+    uint64_t request_count = 0;
+    uint64_t hit_count = 0;
+    uint64_t create_count = 0;
+    uint64_t reload_count = 0;
+    uint64_t reload_failure_count = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct PipelineReloadResult {
+    uint32_t swap_count = 0;
+    std::vector<std::string> errors;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class PipelineCache {
+public:
+    //! Constructor.
+    //! \param factory A factory creates pipeline states.
+    //! \param job_system A job system creates pipeline states, it must outlive a cache.
+    PipelineCache(std::unique_ptr<PipelineFactory> factory, JobSystem *job_system);
+
+    //! Destructor. Pipeline states being created are finished first.
+    ~PipelineCache();
+
+    //! Request a pipeline state. A state is created on a job unless it is already requested.
+    //! \param descriptor A pipeline descriptor.
+    //! \return A future of a pipeline state.
+    PipelineFuture GetPipelineState(const PipelineDescriptor &descriptor);
+
+    //! Request pipeline states so they are created in parallel before they are used.
+    //! \param descriptors Pipeline descriptors.
+    void WarmUp(std::span<const PipelineDescriptor> descriptors);
+
+    //! Recreate pipeline states use a shader file on jobs. States in use are kept until CommitReloads.
+    //! \param shader_path A changed shader file path.
+    void Reload(const std::filesystem::path &shader_path);
+
+    //! Swap recreated pipeline states in, call it at a frame boundary. It never waits for workers, states are still
+    //! being created are swapped by a later call and a state fails to be created keeps the previous one.
+    //! Callers request pipeline states again to observe swapped ones.
+    //! \return The number of swapped states and errors of failed ones.
+    PipelineReloadResult CommitReloads();
+
+    //! Compute a key of a pipeline descriptor.
+    //! \param descriptor A pipeline descriptor.
+    //! \return A key.
+    [[nodiscard]]
+    static uint64_t ComputeKey(const PipelineDescriptor &descriptor);
+
+    //! Retrieve statistics.
+    //! \return Statistics.
+    [[nodiscard]]
+    PipelineCacheStatistics GetStatistics() const;
+
+private:
+    std::unique_ptr<PipelineFactory> _factory;
+    mutable std::mutex _mutex;
+    std::unordered_map<uint64_t, PipelineFuture> _futures;
+    std::unordered_map<uint64_t, PipelineDescriptor> _descriptors;
+    std::unordered_map<uint64_t, PipelineFuture> _reloads;
+    PipelineCacheStatistics _statistics;
+    JobSystem *_job_system = nullptr;
+    JobCounter _counter;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
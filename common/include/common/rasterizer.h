@@ -0,0 +1,208 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef RASTERIZER_H_
+#define RASTERIZER_H_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+
+#include "job_system.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr auto kRasterTileSize = 64u;
+constexpr auto kRasterMaxVaryingCount = 8u;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+using RasterColor = std::array<float, 4>;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct RasterVertex {
+    std::array<float, 4> position = {};
+    std::array<float, kRasterMaxVaryingCount> varyings = {};
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A vertex shader writes a clip space position and varyings of the given vertex.
+using RasterVertexShader = std::function<void(uint32_t index, RasterVertex &output)>;
+
+//! A fragment shader returns a color from perspective correct interpolated varyings.
+using RasterFragmentShader = std::function<RasterColor(const float *varyings)>;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct RasterPipeline {
+    RasterVertexShader vertex_shader;
+    RasterFragmentShader fragment_shader;
+    uint32_t varying_count = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct RasterStatistics {
+    uint32_t thread_count = 0;
+    uint64_t draw_count = 0;
+    uint64_t triangle_count = 0;
+    uint64_t pixel_count = 0;
+    std::chrono::duration<double> elapsed_time = std::chrono::duration<double>::zero();
+
+    //! Retrieve the number of triangles per second.
+    //! \return The number of triangles per second.
+    [[nodiscard]]
+    inline auto GetTrianglesPerSecond() const {
+        return elapsed_time.count() > 0.0 ? triangle_count / elapsed_time.count() : 0.0;
+    }
+
+    //! Retrieve the number of pixels per second.
+    //! \return The number of pixels per second.
+    [[nodiscard]]
+    inline auto GetPixelsPerSecond() const {
+        return elapsed_time.count() > 0.0 ? pixel_count / elapsed_time.count() : 0.0;
+    }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class RasterTarget {
+public:
+    //! Resize a target. The content is undefined after resizing.
+    //! \param width A width.
+    //! \param height A height.
+    void Resize(uint32_t width, uint32_t height);
+
+    //! Clear a target.
+    //! \param color A clear color.
+    void Clear(const RasterColor &color);
+
+    //! Retrieve a width.
+    //! \return A width.
+    [[nodiscard]]
+    inline auto GetWidth() const {
+        return _width;
+    }
+
+    //! Retrieve a height.
+    //! \return A height.
+    [[nodiscard]]
+    inline auto GetHeight() const {
+        return _height;
+    }
+
+    //! Retrieve pixels in BGRA8 format.
+    //! \return Pixels.
+    [[nodiscard]]
+    inline std::span<const uint32_t> GetPixels() const {
+        return _pixels;
+    }
+
+    //! Retrieve pixels in BGRA8 format.
+    //! \return Pixels.
+    [[nodiscard]]
+    inline std::span<uint32_t> GetPixels() {
+        return _pixels;
+    }
+
+private:
+    uint32_t _width = 0;
+    uint32_t _height = 0;
+    std::vector<uint32_t> _pixels;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class Rasterizer {
+public:
+    //! Constructor.
+    //! \param job_system A job system shades vertices and rasterizes tiles, it must outlive a rasterizer.
+    explicit Rasterizer(JobSystem *job_system);
+
+    //! Draw indexed triangles.
+    //! \param target A render target.
+    //! \param pipeline A pipeline executes vertices and fragments.
+    //! \param indices Indices of triangles.
+    void DrawIndexed(RasterTarget &target, const RasterPipeline &pipeline, std::span<const uint16_t> indices);
+
+    //! Draw indexed triangles.
+    //! \param target A render target.
+    //! \param pipeline A pipeline executes vertices and fragments.
+    //! \param indices Indices of triangles.
+    void DrawIndexed(RasterTarget &target, const RasterPipeline &pipeline, std::span<const uint32_t> indices);
+
+    //! Reset statistics.
+    void ResetStatistics();
+
+    //! Retrieve the number of threads.
+    //! \return The number of threads.
+    [[nodiscard]]
+    inline auto GetThreadCount() const {
+        return _job_system->GetThreadCount();
+    }
+
+    //! Retrieve statistics.
+    //! \return Statistics.
+    [[nodiscard]]
+    inline const auto &GetStatistics() const {
+        return _statistics;
+    }
+
+private:
+    struct Triangle {
+        std::array<float, 3> a = {};
+        std::array<float, 3> b = {};
+        std::array<float, 3> c = {};
+        std::array<float, 3> bias = {};
+        std::array<float, 3> inv_w = {};
+        std::array<std::array<float, kRasterMaxVaryingCount>, 3> varyings = {};
+        float inv_area = 0.0f;
+        int32_t min_x = 0;
+        int32_t min_y = 0;
+        int32_t max_x = 0;
+        int32_t max_y = 0;
+    };
+
+private:
+    //! Draw indexed triangles.
+    template<typename T>
+    void DrawIndexed(RasterTarget &target, const RasterPipeline &pipeline, std::span<const T> indices);
+
+    //! Execute a vertex shader for vertices are referenced.
+    void ShadeVertices(const RasterPipeline &pipeline, uint32_t vertex_count);
+
+    //! Clip a triangle to the near plane and set up triangles in screen space.
+    void SetupTriangle(const RasterTarget &target, const RasterPipeline &pipeline,
+                       const RasterVertex &v0, const RasterVertex &v1, const RasterVertex &v2);
+
+    //! Set up a triangle in screen space.
+    void SetupScreenTriangle(const RasterTarget &target, const RasterPipeline &pipeline,
+                             const std::array<const RasterVertex*, 3> &vertices);
+
+    //! Bin triangles into tiles.
+    void BinTriangles(const RasterTarget &target);
+
+    //! Rasterize a tile.
+    //! \return The number of shaded pixels.
+    uint64_t RasterizeTile(RasterTarget &target, const RasterPipeline &pipeline, uint32_t tile_index);
+
+private:
+    JobSystem *_job_system = nullptr;
+    uint32_t _tile_count_x = 0;
+    uint32_t _tile_count_y = 0;
+    std::vector<RasterVertex> _vertices;
+    std::vector<Triangle> _triangles;
+    std::vector<std::vector<uint32_t>> _bins;
+    RasterStatistics _statistics;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,70 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef RENDER_DEVICE_H_
+#define RENDER_DEVICE_H_
+
+#include <chrono>
+#include <string>
+
+#include "swapchain.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr auto kMinFramesInFlight = 1u;
+constexpr auto kMaxFramesInFlight = 4u;
+constexpr auto kDefaultFramesInFlight = 2u;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+enum class Backend {
+    kMetal,
+    kNull,
+    kSoftware
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class RenderDevice {
+public:
+    //! Destructor.
+    virtual ~RenderDevice() = default;
+
+    //! Wait until the device can accept a new frame.
+    virtual void WaitForFrame() = 0;
+
+    //! Begin a frame.
+    virtual void BeginFrame() = 0;
+
+    //! End a frame. Submit recorded work and present the acquired image.
+    virtual void EndFrame() = 0;
+
+    //! Wait until all submitted frames have completed.
+    virtual void WaitIdle() = 0;
+
+    //! Retrieve a backend.
+    //! \return A backend.
+    [[nodiscard]]
+    virtual Backend GetBackend() const = 0;
+
+    //! Retrieve a device name.
+    //! \return A device name.
+    [[nodiscard]]
+    virtual std::string GetName() const = 0;
+
+    //! Retrieve a swapchain.
+    //! \return A swapchain.
+    [[nodiscard]]
+    virtual Swapchain* GetSwapchain() = 0;
+
+    //! Retrieve GPU time of the last completed frame.
+    //! \return GPU time, zero without a GPU.
+    [[nodiscard]]
+    virtual std::chrono::duration<double> GetGpuTime() const = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
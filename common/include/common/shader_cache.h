@@ -0,0 +1,145 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef SHADER_CACHE_H_
+#define SHADER_CACHE_H_
+
+#include <cstddef>
+#include <filesystem>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+using ShaderMacros = std::map<std::string, std::string>;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class ShaderLibrary {
+public:
+    //! Destructor.
+    virtual ~ShaderLibrary() = default;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct ShaderCompileResult {
+    std::shared_ptr<ShaderLibrary> library;
+    std::vector<std::byte> binary;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class ShaderCompiler {
+public:
+    //! Destructor.
+    virtual ~ShaderCompiler() = default;
+
+    //! Retrieve an identifier of a compiler. Binaries are invalidated when the identifier is changed.
+    //! \return An identifier of a compiler.
+    [[nodiscard]]
+    virtual std::string GetIdentifier() const = 0;
+
+    //! Compile a source to a library.
+    //! \param source A shader source.
+    //! \param macros Preprocessor macros.
+    //! \return A library and its binary, the binary is empty if a compiler can't serialize a library.
+    virtual ShaderCompileResult Compile(std::string_view source, const ShaderMacros &macros) = 0;
+
+    //! Load a library from a binary.
+    //! \param binary A binary was returned by Compile.
+    //! \return A library.
+    virtual std::shared_ptr<ShaderLibrary> Load(std::span<const std::byte> binary) = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct ShaderCacheStatistics {
+    uint64_t memory_hit_count = 0;
+    uint64_t disk_hit_count = 0;
+    uint64_t compile_count = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class AssetArchive;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A library cache is addressed by the content of a source, macros and a compiler identifier.
+//! A source file is compiled once no matter how many entrypoints are used from it.
+class ShaderCache {
+public:
+    //! Constructor.
+    //! \param compiler A compiler.
+    //! \param directory A directory where binaries are stored, an empty path disables the disk cache.
+    explicit ShaderCache(std::unique_ptr<ShaderCompiler> compiler, const std::filesystem::path &directory = {});
+
+    //! Read shader files in a directory from an archive instead of loose files. It must be called before retrieving
+    //! libraries and the archive must outlive a cache.
+    //! \param archive An archive was packed from a directory.
+    //! \param directory A directory was packed.
+    void MountArchive(const AssetArchive *archive, const std::filesystem::path &directory);
+
+    //! Retrieve a library of a shader file.
+    //! \param path A shader file path, a file in a mounted directory is read from an archive.
+    //! \param macros Preprocessor macros.
+    //! \return A library.
+    std::shared_ptr<ShaderLibrary> GetLibrary(const std::filesystem::path &path, const ShaderMacros &macros = {});
+
+    //! Retrieve a library of a shader source. Libraries of different keys are loaded and compiled concurrently, and
+    //! a caller of a key in flight waits for it instead of compiling it again.
+    //! \param source A shader source.
+    //! \param macros Preprocessor macros.
+    //! \return A library.
+    std::shared_ptr<ShaderLibrary> GetLibraryFromSource(std::string_view source, const ShaderMacros &macros = {});
+
+    //! Compute a key of a shader.
+    //! \param source A shader source.
+    //! \param macros Preprocessor macros.
+    //! \return A key.
+    [[nodiscard]]
+    uint64_t ComputeKey(std::string_view source, const ShaderMacros &macros) const;
+
+    //! Evict all libraries in memory, ones in flight still complete for their callers. Binaries on disk are kept.
+    void Clear();
+
+    //! Retrieve statistics.
+    //! \return Statistics.
+    [[nodiscard]]
+    ShaderCacheStatistics GetStatistics() const;
+
+private:
+    //! Build a file path of a binary.
+    [[nodiscard]]
+    std::filesystem::path BuildBinaryPath(uint64_t key) const;
+
+    //! Load a binary from disk.
+    std::shared_ptr<ShaderLibrary> LoadBinary(uint64_t key);
+
+    //! Store a binary to disk.
+    void StoreBinary(uint64_t key, std::span<const std::byte> binary);
+
+private:
+    std::unique_ptr<ShaderCompiler> _compiler;
+    std::string _compiler_identifier;
+    std::filesystem::path _directory;
+    const AssetArchive *_archive = nullptr;
+    std::filesystem::path _archive_directory;
+    mutable std::mutex _mutex;
+    std::unordered_map<uint64_t, std::shared_future<std::shared_ptr<ShaderLibrary>>> _libraries;
+    ShaderCacheStatistics _statistics;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,47 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef SHADER_PROCESSOR_H_
+#define SHADER_PROCESSOR_H_
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "asset_cooker.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A processor makes a shader source self contained. Local includes are inlined, comments and blank lines are
+//! stripped, so a runtime compiler neither searches files nor parses text it throws away.
+class ShaderSourceProcessor : public AssetProcessor {
+public:
+    //! Retrieve an identifier of a processor.
+    //! \return An identifier of a processor.
+    [[nodiscard]]
+    std::string GetIdentifier() const override;
+
+    //! Query whether a processor handles an asset.
+    //! \param path A source asset path.
+    //! \return True if an asset is a Metal shader.
+    [[nodiscard]]
+    bool Accept(const std::filesystem::path &path) const override;
+
+    //! Process a shader.
+    //! \param path A shader path.
+    //! \param source A shader source.
+    //! \return A self contained shader source and included files.
+    AssetCookResult Process(const std::filesystem::path &path, std::span<const std::byte> source) const override;
+
+private:
+    //! Append a source to an output while inlining local includes.
+    void Preprocess(const std::filesystem::path &path, std::string_view source, std::string &output,
+                    std::vector<std::filesystem::path> &stack, AssetCookResult &result) const;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
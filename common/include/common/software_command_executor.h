@@ -0,0 +1,68 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef SOFTWARE_COMMAND_EXECUTOR_H_
+#define SOFTWARE_COMMAND_EXECUTOR_H_
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "command_stream.h"
+#include "rasterizer.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// The number of buffer indices of a stage an executor binds, like the buffer argument table of Metal.
+constexpr auto kSoftwareMaxBufferIndices = 31u;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Pipelines and memory handles of commands refer to, a handle is an index of them.
+struct SoftwareCommandResources {
+    std::vector<const RasterPipeline *> pipelines;
+    std::vector<std::span<const std::byte>> buffers;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! An executor draws commands with a rasterizer, it is the software counterpart of EncodeCommandStream. Shaders of a
+//! pipeline read bound buffers and bytes from an executor while a draw executes.
+class SoftwareCommandExecutor {
+public:
+    //! Constructor.
+    //! \param rasterizer A rasterizer draws, it must outlive an executor.
+    explicit SoftwareCommandExecutor(Rasterizer *rasterizer);
+
+    //! Execute recorders of a stream in order.
+    //! \param stream A command stream.
+    //! \param resources Pipelines and memory handles of commands refer to.
+    //! \param target A render target.
+    void Execute(const CommandStream &stream, const SoftwareCommandResources &resources, RasterTarget &target);
+
+    //! Retrieve memory bound at an index of a stage, call it from shaders.
+    //! \param stage A shader stage.
+    //! \param index An index of an argument table.
+    //! \return Bound memory at its offset, or null if nothing is bound.
+    template<typename T>
+    [[nodiscard]]
+    inline const T *GetBinding(CommandStage stage, uint32_t index) const {
+        return reinterpret_cast<const T *>(_bindings[static_cast<size_t>(stage)][index]);
+    }
+
+private:
+    //! Execute commands of a recorder, state doesn't carry over from the previous recorder.
+    void Execute(const CommandRecorder &recorder, const SoftwareCommandResources &resources, RasterTarget &target);
+
+private:
+    Rasterizer *_rasterizer = nullptr;
+    std::array<std::array<const std::byte *, kSoftwareMaxBufferIndices>, 2> _bindings = {};
+    std::vector<uint32_t> _indices;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
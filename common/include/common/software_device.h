@@ -0,0 +1,126 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef SOFTWARE_DEVICE_H_
+#define SOFTWARE_DEVICE_H_
+
+#include <semaphore>
+#include <vector>
+
+#include "render_device.h"
+#include "rasterizer.h"
+#include "software_command_executor.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class SoftwareSwapchain : public Swapchain {
+public:
+    //! Constructor.
+    //! \param image_count The number of images.
+    explicit SoftwareSwapchain(uint32_t image_count);
+
+    //! Resize images.
+    //! \param resolution A resolution.
+    void Resize(const Resolution &resolution) override;
+
+    //! Acquire a next image.
+    void AcquireNextImage() override;
+
+    //! Retrieve a resolution.
+    //! \return A resolution of images.
+    [[nodiscard]]
+    Resolution GetResolution() const override;
+
+    //! Retrieve the number of images.
+    //! \return The number of images.
+    [[nodiscard]]
+    uint32_t GetImageCount() const override;
+
+    //! Retrieve the acquired image.
+    //! \return The acquired image.
+    [[nodiscard]]
+    inline auto &GetImage() {
+        return _images[_image_index];
+    }
+
+private:
+    uint32_t _image_index = 0;
+    Resolution _resolution = {0, 0};
+    std::vector<RasterTarget> _images;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class SoftwareDevice : public RenderDevice {
+public:
+    //! Constructor.
+    //! \param frame_count The number of frames can be in flight.
+    //! \param image_count The number of swapchain images.
+    //! \param job_system A job system rasterizes, it must outlive a device.
+    SoftwareDevice(uint32_t frame_count, uint32_t image_count, JobSystem *job_system);
+
+    //! Wait until the device can accept a new frame.
+    void WaitForFrame() override;
+
+    //! Begin a frame.
+    void BeginFrame() override;
+
+    //! End a frame. Draws are executed while recording so the frame is already completed.
+    void EndFrame() override;
+
+    //! Wait until all submitted frames have completed.
+    void WaitIdle() override;
+
+    //! Retrieve a backend.
+    //! \return A backend.
+    [[nodiscard]]
+    Backend GetBackend() const override;
+
+    //! Retrieve a device name.
+    //! \return A device name.
+    [[nodiscard]]
+    std::string GetName() const override;
+
+    //! Retrieve a swapchain.
+    //! \return A swapchain.
+    [[nodiscard]]
+    Swapchain* GetSwapchain() override;
+
+    //! Retrieve GPU time of the last completed frame.
+    //! \return GPU time, zero without a GPU.
+    [[nodiscard]]
+    std::chrono::duration<double> GetGpuTime() const override;
+
+    //! Retrieve a software swapchain.
+    //! \return A software swapchain.
+    [[nodiscard]]
+    inline auto GetSoftwareSwapchain() {
+        return &_swapchain;
+    }
+
+    //! Retrieve a rasterizer.
+    //! \return A rasterizer.
+    [[nodiscard]]
+    inline auto GetRasterizer() {
+        return &_rasterizer;
+    }
+
+    //! Retrieve a command executor.
+    //! \return A command executor draws with the rasterizer of a device.
+    [[nodiscard]]
+    inline auto GetCommandExecutor() {
+        return &_command_executor;
+    }
+
+private:
+    std::counting_semaphore<> _semaphore;
+    SoftwareSwapchain _swapchain;
+    Rasterizer _rasterizer;
+    SoftwareCommandExecutor _command_executor;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,38 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef SWAPCHAIN_H_
+#define SWAPCHAIN_H_
+
+#include "utility.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class Swapchain {
+public:
+    //! Destructor.
+    virtual ~Swapchain() = default;
+
+    //! Resize images.
+    //! \param resolution A resolution.
+    virtual void Resize(const Resolution &resolution) = 0;
+
+    //! Acquire a next image.
+    virtual void AcquireNextImage() = 0;
+
+    //! Retrieve a resolution.
+    //! \return A resolution of images.
+    [[nodiscard]]
+    virtual Resolution GetResolution() const = 0;
+
+    //! Retrieve the number of images.
+    //! \return The number of images.
+    [[nodiscard]]
+    virtual uint32_t GetImageCount() const = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,117 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef TRIPLE_BUFFER_H_
+#define TRIPLE_BUFFER_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A triple buffer hands values from a writer thread to a reader thread without locks. A writer fills its own buffer
+//! and publishes it by swapping it with the middle one, and a reader takes the middle one by swapping it with its
+//! own, so neither waits for the other to finish with a buffer. A reader always gets the latest published value.
+template<typename T>
+class TripleBuffer {
+public:
+    //! Retrieve the buffer of a writer.
+    //! \return The buffer of a writer, it keeps whatever it had when it was published last time.
+    [[nodiscard]]
+    inline T &GetWriteBuffer() {
+        return _buffers[_write_index];
+    }
+
+    //! Publish the buffer of a writer, a writer continues with another buffer.
+    void Publish() {
+        auto state = _state.load(std::memory_order_relaxed);
+        while (!_state.compare_exchange_weak(state, (state & kClosedBit) | kPublishedBit | _write_index,
+                                             std::memory_order_acq_rel, std::memory_order_relaxed)) {
+        }
+        _write_index = state & kIndexMask;
+        _state.notify_all();
+    }
+
+    //! Acquire the latest published buffer.
+    //! \return False if nothing is published since the last acquire, the buffer of a reader is kept then.
+    bool Acquire() {
+        auto state = _state.load(std::memory_order_relaxed);
+        do {
+            if (!(state & kPublishedBit)) {
+                return false;
+            }
+        } while (!_state.compare_exchange_weak(state, (state & kClosedBit) | _read_index, std::memory_order_acq_rel,
+                                               std::memory_order_relaxed));
+        _read_index = state & kIndexMask;
+        _state.notify_all();
+        return true;
+    }
+
+    //! Retrieve the buffer of a reader.
+    //! \return The buffer of a reader.
+    [[nodiscard]]
+    inline T &GetReadBuffer() {
+        return _buffers[_read_index];
+    }
+
+    //! Query whether a writer published a buffer a reader hasn't acquired.
+    //! \return True if a buffer is published.
+    [[nodiscard]]
+    inline bool IsPublished() const {
+        return _state.load(std::memory_order_acquire) & kPublishedBit;
+    }
+
+    //! Wait until a writer publishes a buffer a reader hasn't acquired.
+    //! \return False if a buffer is closed.
+    bool WaitForPublish() const {
+        auto state = _state.load(std::memory_order_acquire);
+        while (!(state & (kPublishedBit | kClosedBit))) {
+            _state.wait(state, std::memory_order_acquire);
+            state = _state.load(std::memory_order_acquire);
+        }
+        return !(state & kClosedBit);
+    }
+
+    //! Wait until a reader acquires the last published buffer, so a writer stays a buffer ahead at most.
+    //! \return False if a buffer is closed.
+    bool WaitForAcquire() const {
+        auto state = _state.load(std::memory_order_acquire);
+        while ((state & kPublishedBit) && !(state & kClosedBit)) {
+            _state.wait(state, std::memory_order_acquire);
+            state = _state.load(std::memory_order_acquire);
+        }
+        return !(state & kClosedBit);
+    }
+
+    //! Close a buffer, threads waiting for it return.
+    void Close() {
+        _state.fetch_or(kClosedBit, std::memory_order_acq_rel);
+        _state.notify_all();
+    }
+
+    //! Query whether a buffer is closed.
+    //! \return True if a buffer is closed.
+    [[nodiscard]]
+    inline bool IsClosed() const {
+        return _state.load(std::memory_order_acquire) & kClosedBit;
+    }
+
+private:
+    // The middle buffer is packed with flags, so a swap and its flags change at once.
+    static constexpr uint32_t kIndexMask = 0x3;
+    static constexpr uint32_t kPublishedBit = 0x4;
+    static constexpr uint32_t kClosedBit = 0x8;
+
+private:
+    std::array<T, 3> _buffers;
+    uint32_t _write_index = 0;
+    uint32_t _read_index = 1;
+    std::atomic<uint32_t> _state = 2;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,132 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef UPLOAD_QUEUE_H_
+#define UPLOAD_QUEUE_H_
+
+#include <Metal/Metal.h>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "upload_ring.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct UploadQueueStatistics {
+    uint64_t copy_count = 0;
+    uint64_t flush_count = 0;
+    uint64_t stall_count = 0;
+    uint64_t dedicated_count = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A queue copies data to private resources through a persistent staging ring. Copies are recorded into a single
+//! blit pass when a queue is flushed, and their staging memory is released when the command buffer has completed.
+class UploadQueue {
+public:
+    //! Constructor.
+    //! \param device A Metal device.
+    //! \param command_queue A command queue submits copies when a queue is flushed outside a frame.
+    //! \param size The size of a staging ring.
+    UploadQueue(id<MTLDevice> device, id<MTLCommandQueue> command_queue, uint64_t size = kDefaultUploadRingSize);
+
+    //! Upload data to a buffer.
+    //! \param buffer A destination buffer.
+    //! \param offset An offset of a destination buffer.
+    //! \param data Data to copy, it can be released after this call.
+    //! \param size The size of data.
+    void Upload(id<MTLBuffer> buffer, uint64_t offset, const void *data, uint64_t size);
+
+    //! Upload data to a texture.
+    //! \param texture A destination texture.
+    //! \param level A mipmap level.
+    //! \param slice A slice.
+    //! \param region A region of a destination texture.
+    //! \param data Data to copy, it can be released after this call.
+    //! \param bytes_per_row The number of bytes per a row of data.
+    //! \param bytes_per_image The number of bytes per an image of data, zero for a 2D texture.
+    void Upload(id<MTLTexture> texture, uint32_t level, uint32_t slice, MTLRegion region, const void *data,
+                uint64_t bytes_per_row, uint64_t bytes_per_image);
+
+    //! Record pending copies into a single blit pass of a command buffer.
+    //! \param command_buffer A command buffer is committed by a caller.
+    void Flush(id<MTLCommandBuffer> command_buffer);
+
+    //! Record pending copies into a command buffer of a queue and commit it.
+    void Submit();
+
+    //! Retrieve the number of pending copies.
+    //! \return The number of pending copies.
+    [[nodiscard]]
+    inline auto GetPendingCount() const {
+        return _copies.size();
+    }
+
+    //! Retrieve a staging ring.
+    //! \return A staging ring.
+    [[nodiscard]]
+    inline const auto &GetRing() const {
+        return _ring;
+    }
+
+    //! Retrieve statistics.
+    //! \return Statistics.
+    [[nodiscard]]
+    inline const auto &GetStatistics() const {
+        return _statistics;
+    }
+
+private:
+    struct Copy {
+        id<MTLBuffer> source;
+        uint64_t source_offset = 0;
+        uint64_t size = 0;
+        id<MTLBuffer> buffer;
+        uint64_t offset = 0;
+        id<MTLTexture> texture;
+        uint32_t level = 0;
+        uint32_t slice = 0;
+        MTLRegion region = {};
+        uint64_t bytes_per_row = 0;
+        uint64_t bytes_per_image = 0;
+    };
+
+    //! Command buffers can complete in a different order than copies were flushed, because a caller commits them.
+    struct FenceState {
+        std::mutex mutex;
+        uint64_t completed = 0;
+        std::set<uint64_t> signaled;
+    };
+
+private:
+    //! Copy data to staging memory.
+    //! \return A staging buffer and an offset in it.
+    std::pair<id<MTLBuffer>, uint64_t> Stage(const void *data, uint64_t size);
+
+    //! Retrieve the last fence value before which every fence is completed.
+    [[nodiscard]]
+    uint64_t GetCompletedFence() const;
+
+    //! Signal a fence is completed.
+    static void Signal(FenceState &fence_state, uint64_t fence);
+
+private:
+    id<MTLDevice> _device;
+    id<MTLCommandQueue> _command_queue;
+    id<MTLBuffer> _staging_buffer;
+    UploadRing _ring;
+    std::vector<Copy> _copies;
+    uint64_t _fence = 0;
+    std::shared_ptr<FenceState> _fence_state;
+    UploadQueueStatistics _statistics;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
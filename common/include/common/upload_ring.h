@@ -0,0 +1,99 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef UPLOAD_RING_H_
+#define UPLOAD_RING_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Metal requires a source offset of a copy to a texture to be a multiple of its pixel size, 16 bytes at most.
+constexpr auto kUploadAlignment = 16u;
+constexpr auto kDefaultUploadRingSize = 16u << 20;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct UploadRingAllocation {
+    std::byte *data = nullptr;
+    uint64_t offset = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A ring allocator over persistent staging memory. Allocations are grouped into batches which are closed with a
+//! fence value when they are submitted, and a batch is released once the GPU has completed its fence.
+class UploadRing {
+public:
+    //! Constructor.
+    //! \param data Memory of size bytes which is not owned by a ring.
+    //! \param size The size of memory, it is rounded down to the alignment.
+    //! \param alignment The alignment of allocations, it must be a power of two.
+    UploadRing(void *data, uint64_t size, uint64_t alignment = kUploadAlignment);
+
+    //! Allocate memory. An allocation never wraps around the end of memory.
+    //! \param size The size of an allocation.
+    //! \return An allocation, or nothing if there is no free space until submitted batches are released.
+    std::optional<UploadRingAllocation> Allocate(uint64_t size);
+
+    //! Close allocations since the last submission into a batch.
+    //! \param fence A fence value which is signaled when the GPU has completed the batch, it must increase.
+    void Submit(uint64_t fence);
+
+    //! Release batches whose fence is completed.
+    //! \param completed_fence The last fence value the GPU has completed.
+    void Retire(uint64_t completed_fence);
+
+    //! Retrieve the size of memory.
+    //! \return The size of memory.
+    [[nodiscard]]
+    inline auto GetSize() const {
+        return _size;
+    }
+
+    //! Retrieve the used size including padding at the end of memory.
+    //! \return The used size.
+    [[nodiscard]]
+    inline auto GetUsedSize() const {
+        return _head - _tail;
+    }
+
+    //! Retrieve the largest used size.
+    //! \return The largest used size.
+    [[nodiscard]]
+    inline auto GetPeakSize() const {
+        return _peak_size;
+    }
+
+    //! Retrieve the number of batches are not released.
+    //! \return The number of batches.
+    [[nodiscard]]
+    inline auto GetBatchCount() const {
+        return _batches.size();
+    }
+
+private:
+    struct Batch {
+        uint64_t fence = 0;
+        uint64_t end = 0;
+    };
+
+private:
+    std::byte *_data = nullptr;
+    uint64_t _size = 0;
+    uint64_t _alignment = 0;
+    // Positions increase monotonically, an offset is a position modulo the size.
+    uint64_t _head = 0;
+    uint64_t _tail = 0;
+    uint64_t _peak_size = 0;
+    std::deque<Batch> _batches;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -6,13 +6,19 @@
 #ifndef UTILITY_H_
 #define UTILITY_H_
 
+#ifdef __OBJC__
 #include <Metal/Metal.h>
+#endif
+#ifdef __APPLE__
 #include <simd/simd.h>
+#endif
 #include <cstdint>
 #include <cmath>
 #include <stdexcept>
 #include <tuple>
 #include <filesystem>
+#include <string>
+#include <string_view>
 
 //----------------------------------------------------------------------------------------------------------------------
 
@@ -20,6 +26,10 @@ using Resolution = std::tuple<uint32_t, uint32_t>;
 
 //----------------------------------------------------------------------------------------------------------------------
 
+constexpr auto kFHDResolution = Resolution(1280, 720);
+
+//----------------------------------------------------------------------------------------------------------------------
+
 //! Retrieve a width from a resolution.
 //! \param resolution A resolution.
 //! \return A width.
@@ -54,6 +64,18 @@ extern std::string ReadFile(const std::filesystem::path &path);
 
 //----------------------------------------------------------------------------------------------------------------------
 
+#ifdef __OBJC__
+
+//! Create a string refers characters without copying them.
+//! \param string Characters in UTF-8, they must outlive a string.
+//! \return A string.
+inline NSString *MakeString(std::string_view string) {
+    return [[NSString alloc] initWithBytesNoCopy:const_cast<char*>(string.data()) length:string.size()
+                                        encoding:NSUTF8StringEncoding freeWhenDone:NO];
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
 //! Compile a shader.
 //! \param A Metal device.
 //! \param file_path The file path that contains the shader code.
@@ -62,6 +84,8 @@ extern std::string ReadFile(const std::filesystem::path &path);
 extern id<MTLFunction> CompileShader(id<MTLDevice> device, const std::filesystem::path &file_path,
                                      const std::string &entrypoint);
 
+#endif
+
 //----------------------------------------------------------------------------------------------------------------------
 
 template<typename T>
@@ -0,0 +1,64 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef VECTOR3_H_
+#define VECTOR3_H_
+
+#include <array>
+#include <cmath>
+#include <limits>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A vector of positions and normals in meshes, it is shared by mesh processing so they don't convert.
+using Vector3 = std::array<float, 3>;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Subtract vectors.
+//! \param a A vector.
+//! \param b A vector.
+//! \return a - b.
+inline Vector3 Subtract(const Vector3 &a, const Vector3 &b) {
+    return {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Compute a dot product.
+//! \param a A vector.
+//! \param b A vector.
+//! \return a . b in T, double keeps the precision of sums of large products.
+template<typename T = float>
+inline T Dot(const Vector3 &a, const Vector3 &b) {
+    return static_cast<T>(a[0]) * b[0] + static_cast<T>(a[1]) * b[1] + static_cast<T>(a[2]) * b[2];
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Compute a cross product.
+//! \param a A vector.
+//! \param b A vector.
+//! \return a x b.
+inline Vector3 Cross(const Vector3 &a, const Vector3 &b) {
+    return {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Normalize a vector.
+//! \param v A vector.
+//! \return A unit vector, or +Z if a vector is too short to have a direction.
+inline Vector3 Normalize(const Vector3 &v) {
+    auto length = std::sqrt(Dot(v, v));
+    if (length <= std::numeric_limits<float>::min()) {
+        return {0.0f, 0.0f, 1.0f};
+    }
+    return {v[0] / length, v[1] / length, v[2] / length};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
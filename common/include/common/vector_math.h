@@ -0,0 +1,141 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef VECTOR_MATH_H_
+#define VECTOR_MATH_H_
+
+#ifdef __APPLE__
+#include <simd/simd.h>
+#else
+#include <cmath>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// The subset of simd an example and the camera use, so the frame loop builds where simd doesn't exist. Types have the
+// same size and alignment as simd ones, as uniforms are laid out with them.
+namespace simd {
+
+struct float2 {
+    float x, y;
+};
+
+struct alignas(16) float3 {
+    float x, y, z;
+};
+
+struct alignas(16) float4 {
+    float x, y, z, w;
+};
+
+//! A column major matrix.
+struct float4x4 {
+    float4 columns[4];
+};
+
+} // namespace simd
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr simd::float4x4 matrix_identity_float4x4 = {{{1.0f, 0.0f, 0.0f, 0.0f},
+                                                      {0.0f, 1.0f, 0.0f, 0.0f},
+                                                      {0.0f, 0.0f, 1.0f, 0.0f},
+                                                      {0.0f, 0.0f, 0.0f, 1.0f}}};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline simd::float3 operator+(const simd::float3 &a, const simd::float3 &b) {
+    return {a.x + b.x, a.y + b.y, a.z + b.z};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline simd::float3 operator-(const simd::float3 &a, const simd::float3 &b) {
+    return {a.x - b.x, a.y - b.y, a.z - b.z};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline simd::float3 operator*(const simd::float3 &a, float b) {
+    return {a.x * b, a.y * b, a.z * b};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline simd::float3 simd_make_float3(float x, float y, float z) {
+    return {x, y, z};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline simd::float4 simd_make_float4(float x, float y, float z, float w) {
+    return {x, y, z, w};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline simd::float4 simd_make_float4(const simd::float3 &xyz, float w) {
+    return {xyz.x, xyz.y, xyz.z, w};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline float simd_dot(const simd::float3 &a, const simd::float3 &b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline simd::float3 simd_cross(const simd::float3 &a, const simd::float3 &b) {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline simd::float3 simd_normalize(const simd::float3 &a) {
+    return a * (1.0f / std::sqrt(simd_dot(a, a)));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline simd::float4x4 simd_matrix(const simd::float4 &c0, const simd::float4 &c1, const simd::float4 &c2,
+                                  const simd::float4 &c3) {
+    return {{c0, c1, c2, c3}};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline simd::float4 simd_mul(const simd::float4x4 &a, const simd::float4 &b) {
+    const auto &c = a.columns;
+    return {c[0].x * b.x + c[1].x * b.y + c[2].x * b.z + c[3].x * b.w,
+            c[0].y * b.x + c[1].y * b.y + c[2].y * b.z + c[3].y * b.w,
+            c[0].z * b.x + c[1].z * b.y + c[2].z * b.z + c[3].z * b.w,
+            c[0].w * b.x + c[1].w * b.y + c[2].w * b.z + c[3].w * b.w};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline simd::float4x4 simd_mul(const simd::float4x4 &a, const simd::float4x4 &b) {
+    return {{simd_mul(a, b.columns[0]), simd_mul(a, b.columns[1]), simd_mul(a, b.columns[2]),
+             simd_mul(a, b.columns[3])}};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline bool simd_equal(const simd::float4x4 &a, const simd::float4x4 &b) {
+    for (auto i = 0; i != 4; ++i) {
+        const auto &x = a.columns[i];
+        const auto &y = b.columns[i];
+        if (x.x != y.x || x.y != y.y || x.z != y.z || x.w != y.w) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
+
+#endif
@@ -0,0 +1,401 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef VERTEX_LAYOUT_H_
+#define VERTEX_LAYOUT_H_
+
+#ifdef __OBJC__
+#include <Metal/Metal.h>
+#endif
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "pipeline_cache.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Metal requires offsets of vertex attributes and a vertex stride to be multiples of 4 bytes.
+constexpr auto kVertexAttributeAlignment = 4u;
+
+// The value of MTLVertexStepFunctionPerVertex.
+constexpr auto kVertexStepFunctionPerVertex = 1u;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Convert a float to a half with rounding to nearest even.
+//! \param value A float.
+//! \return Bits of a half.
+constexpr uint16_t EncodeHalf(float value) {
+    auto bits = std::bit_cast<uint32_t>(value);
+    auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+    auto exponent = static_cast<int32_t>((bits >> 23) & 0xffu) - 127 + 15;
+    auto mantissa = bits & 0x7fffffu;
+
+    // Infinity and NaN keep a payload bit so NaN stays NaN.
+    if (((bits >> 23) & 0xffu) == 0xffu) {
+        return sign | 0x7c00u | (mantissa ? 0x200u : 0u);
+    }
+
+    // Overflow to infinity.
+    if (exponent >= 0x1f) {
+        return sign | 0x7c00u;
+    }
+
+    // Underflow to a denormal or zero.
+    if (exponent <= 0) {
+        if (exponent < -10) {
+            return sign;
+        }
+        mantissa |= 0x800000u;
+        auto shift = static_cast<uint32_t>(14 - exponent);
+        auto half = mantissa >> shift;
+        auto rest = mantissa & ((1u << shift) - 1u);
+        auto midpoint = 1u << (shift - 1u);
+        if (rest > midpoint || (rest == midpoint && (half & 1u))) {
+            ++half;
+        }
+        return sign | static_cast<uint16_t>(half);
+    }
+
+    // A carry of rounding moves into the exponent, and may round up to infinity.
+    auto half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    auto rest = mantissa & 0x1fffu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) {
+        ++half;
+    }
+    return sign | static_cast<uint16_t>(half);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Convert a half to a float.
+//! \param value Bits of a half.
+//! \return A float.
+constexpr float DecodeHalf(uint16_t value) {
+    auto sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+    auto exponent = (value >> 10) & 0x1fu;
+    auto mantissa = static_cast<uint32_t>(value & 0x3ffu);
+
+    if (exponent == 0x1fu) {
+        return std::bit_cast<float>(sign | 0x7f800000u | (mantissa << 13));
+    }
+
+    if (exponent == 0) {
+        if (!mantissa) {
+            return std::bit_cast<float>(sign);
+        }
+
+        // Normalize a denormal.
+        exponent = 1;
+        while (!(mantissa & 0x400u)) {
+            mantissa <<= 1;
+            --exponent;
+        }
+        mantissa &= 0x3ffu;
+    }
+
+    return std::bit_cast<float>(sign | ((exponent + 127 - 15) << 23) | (mantissa << 13));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+enum class VertexEncoding {
+    kFloat,
+    kHalf,
+    kUnorm,
+    kSnorm
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A format of a vertex attribute.
+//! \tparam T The type of a stored component.
+//! \tparam N The number of components.
+//! \tparam E How a component is encoded.
+//! \tparam MetalFormat The value of the matching MTLVertexFormat.
+template<typename T, uint32_t N, VertexEncoding E, uint32_t MetalFormat>
+struct VertexFormat {
+    static constexpr auto kComponentCount = N;
+    static constexpr auto kEncoding = E;
+    static constexpr auto kMetalFormat = MetalFormat;
+
+    using Values = std::array<float, N>;
+
+    struct alignas(kVertexAttributeAlignment) Storage {
+        std::array<T, N> components = {};
+    };
+
+    //! Encode values.
+    //! \param values Values, normalized formats clamp them to their range.
+    //! \return Stored components.
+    static constexpr Storage Encode(const Values &values) {
+        Storage storage;
+        for (auto i = 0u; i != N; ++i) {
+            storage.components[i] = EncodeComponent(values[i]);
+        }
+        return storage;
+    }
+
+    //! Decode values.
+    //! \param storage Stored components.
+    //! \return Values.
+    static constexpr Values Decode(const Storage &storage) {
+        Values values = {};
+        for (auto i = 0u; i != N; ++i) {
+            values[i] = DecodeComponent(storage.components[i]);
+        }
+        return values;
+    }
+
+private:
+    static constexpr T EncodeComponent(float value) {
+        constexpr auto kMax = static_cast<float>(std::numeric_limits<T>::max());
+
+        if constexpr (E == VertexEncoding::kFloat) {
+            return value;
+        } else if constexpr (E == VertexEncoding::kHalf) {
+            return EncodeHalf(value);
+        } else if constexpr (E == VertexEncoding::kUnorm) {
+            value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+            return static_cast<T>(value * kMax + 0.5f);
+        } else {
+            value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+            return static_cast<T>(value * kMax + (value < 0.0f ? -0.5f : 0.5f));
+        }
+    }
+
+    static constexpr float DecodeComponent(T component) {
+        constexpr auto kMax = static_cast<float>(std::numeric_limits<T>::max());
+
+        if constexpr (E == VertexEncoding::kFloat) {
+            return component;
+        } else if constexpr (E == VertexEncoding::kHalf) {
+            return DecodeHalf(component);
+        } else if constexpr (E == VertexEncoding::kUnorm) {
+            return component / kMax;
+        } else {
+            // The most negative value and the one after it both decode to -1.
+            return component / kMax < -1.0f ? -1.0f : component / kMax;
+        }
+    }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+using Float1 = VertexFormat<float, 1, VertexEncoding::kFloat, 28>;
+using Float2 = VertexFormat<float, 2, VertexEncoding::kFloat, 29>;
+using Float3 = VertexFormat<float, 3, VertexEncoding::kFloat, 30>;
+using Float4 = VertexFormat<float, 4, VertexEncoding::kFloat, 31>;
+using Half2 = VertexFormat<uint16_t, 2, VertexEncoding::kHalf, 25>;
+// Half3 stores 6 bytes of components in 8 bytes, attributes after it must start at a multiple of 4 bytes.
+// Metal reads only the components, so a position costs as much as Half4 and the last 2 bytes are padding.
+using Half3 = VertexFormat<uint16_t, 3, VertexEncoding::kHalf, 26>;
+using Half4 = VertexFormat<uint16_t, 4, VertexEncoding::kHalf, 27>;
+using Unorm8x4 = VertexFormat<uint8_t, 4, VertexEncoding::kUnorm, 9>;
+using Snorm8x4 = VertexFormat<int8_t, 4, VertexEncoding::kSnorm, 12>;
+using Unorm16x2 = VertexFormat<uint16_t, 2, VertexEncoding::kUnorm, 19>;
+using Unorm16x4 = VertexFormat<uint16_t, 4, VertexEncoding::kUnorm, 21>;
+using Snorm16x2 = VertexFormat<int16_t, 2, VertexEncoding::kSnorm, 22>;
+using Snorm16x4 = VertexFormat<int16_t, 4, VertexEncoding::kSnorm, 24>;
+
+static_assert(sizeof(Half3::Storage) == 8, "Half3 is padded to 4 bytes.");
+
+#ifdef __OBJC__
+static_assert(Float1::kMetalFormat == MTLVertexFormatFloat);
+static_assert(Float2::kMetalFormat == MTLVertexFormatFloat2);
+static_assert(Float3::kMetalFormat == MTLVertexFormatFloat3);
+static_assert(Float4::kMetalFormat == MTLVertexFormatFloat4);
+static_assert(Half2::kMetalFormat == MTLVertexFormatHalf2);
+static_assert(Half3::kMetalFormat == MTLVertexFormatHalf3);
+static_assert(Half4::kMetalFormat == MTLVertexFormatHalf4);
+static_assert(Unorm8x4::kMetalFormat == MTLVertexFormatUChar4Normalized);
+static_assert(Snorm8x4::kMetalFormat == MTLVertexFormatChar4Normalized);
+static_assert(Unorm16x2::kMetalFormat == MTLVertexFormatUShort2Normalized);
+static_assert(Unorm16x4::kMetalFormat == MTLVertexFormatUShort4Normalized);
+static_assert(Snorm16x2::kMetalFormat == MTLVertexFormatShort2Normalized);
+static_assert(Snorm16x4::kMetalFormat == MTLVertexFormatShort4Normalized);
+static_assert(kVertexStepFunctionPerVertex == MTLVertexStepFunctionPerVertex);
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template<typename F>
+struct Position {
+    using Format = F;
+};
+
+template<typename F>
+struct Normal {
+    using Format = F;
+};
+
+template<typename F>
+struct Tangent {
+    using Format = F;
+};
+
+template<typename F>
+struct Color {
+    using Format = F;
+};
+
+template<typename F>
+struct TexCoord {
+    using Format = F;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Tightly packed storage of attributes in order. Every storage is aligned to 4 bytes so there is no padding.
+template<typename... Attributes>
+struct VertexStorage;
+
+template<typename A>
+struct VertexStorage<A> {
+    typename A::Format::Storage head;
+};
+
+template<typename A, typename... Rest>
+struct VertexStorage<A, Rest...> {
+    typename A::Format::Storage head;
+    VertexStorage<Rest...> tail;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template<template<typename> class Semantic, typename A>
+struct IsVertexSemantic : std::false_type {
+};
+
+template<template<typename> class Semantic, typename F>
+struct IsVertexSemantic<Semantic, Semantic<F>> : std::true_type {
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A layout of interleaved vertex attributes, for example VertexLayout<Position<Half3>, Color<Unorm8x4>>.
+//! An attribute index is its position in the list, it matches [[attribute(index)]] in a shader.
+template<typename... Attributes>
+class VertexLayout {
+public:
+    static_assert(sizeof...(Attributes) > 0, "A vertex layout needs an attribute.");
+
+    using Vertex = VertexStorage<Attributes...>;
+
+    static constexpr uint32_t kAttributeCount = sizeof...(Attributes);
+    static constexpr uint32_t kStride = (sizeof(typename Attributes::Format::Storage) + ...);
+
+    static_assert(sizeof(Vertex) == kStride, "A vertex must be tightly packed.");
+    static_assert(kStride % kVertexAttributeAlignment == 0, "A vertex stride must be a multiple of 4 bytes.");
+    static_assert(std::is_trivially_copyable_v<Vertex>, "A vertex must be trivially copyable.");
+
+    //! Make a vertex.
+    //! \param values Values of attributes in order.
+    //! \return A vertex.
+    static constexpr Vertex MakeVertex(const typename Attributes::Format::Values &...values) {
+        Vertex vertex = {};
+        Encode<0>(vertex, values...);
+        return vertex;
+    }
+
+    //! Retrieve an attribute index of a semantic.
+    //! \return An attribute index.
+    template<template<typename> class Semantic>
+    static constexpr uint32_t GetIndex() {
+        constexpr std::array<bool, kAttributeCount> kMatches = {IsVertexSemantic<Semantic, Attributes>::value...};
+        for (auto i = 0u; i != kAttributeCount; ++i) {
+            if (kMatches[i]) {
+                return i;
+            }
+        }
+        return kAttributeCount;
+    }
+
+    //! Retrieve values of an attribute of a vertex.
+    //! \param vertex A vertex.
+    //! \return Values of an attribute.
+    template<template<typename> class Semantic>
+    static constexpr auto Get(const Vertex &vertex) {
+        constexpr auto kIndex = GetIndex<Semantic>();
+        static_assert(kIndex < kAttributeCount, "A vertex layout doesn't have the semantic.");
+        return Decode<kIndex>(vertex);
+    }
+
+    //! Set values of an attribute of a vertex.
+    //! \param vertex A vertex.
+    //! \param values Values of an attribute.
+    template<template<typename> class Semantic, typename Values>
+    static constexpr void Set(Vertex &vertex, const Values &values) {
+        constexpr auto kIndex = GetIndex<Semantic>();
+        static_assert(kIndex < kAttributeCount, "A vertex layout doesn't have the semantic.");
+        Encode<kIndex>(vertex, values);
+    }
+
+    //! Retrieve the offset of an attribute.
+    //! \param index An attribute index.
+    //! \return An offset.
+    static constexpr uint32_t GetOffset(uint32_t index) {
+        constexpr std::array<uint32_t, kAttributeCount> kSizes = {sizeof(typename Attributes::Format::Storage)...};
+        auto offset = 0u;
+        for (auto i = 0u; i != index; ++i) {
+            offset += kSizes[i];
+        }
+        return offset;
+    }
+
+    //! Retrieve vertex attributes of a pipeline descriptor.
+    //! \param buffer_index The index of a vertex buffer.
+    //! \return Vertex attributes.
+    static std::vector<PipelineVertexAttribute> GetAttributes(uint32_t buffer_index = 0) {
+        std::vector<PipelineVertexAttribute> attributes = {{Attributes::Format::kMetalFormat, 0, buffer_index}...};
+        for (auto i = 0u; i != kAttributeCount; ++i) {
+            attributes[i].offset = GetOffset(i);
+        }
+        return attributes;
+    }
+
+    //! Retrieve a vertex layout of a pipeline descriptor.
+    //! \return A vertex layout.
+    static constexpr PipelineVertexLayout GetLayout() {
+        return {kStride, kVertexStepFunctionPerVertex, 1};
+    }
+
+private:
+    //! Access storage of an attribute.
+    template<uint32_t I, typename S>
+    static constexpr auto &GetStorage(S &storage) {
+        if constexpr (I == 0) {
+            return storage.head;
+        } else {
+            return GetStorage<I - 1>(storage.tail);
+        }
+    }
+
+    template<uint32_t I, typename Values, typename... Rest>
+    static constexpr void Encode(Vertex &vertex, const Values &values, const Rest &...rest) {
+        GetStorage<I>(vertex) = FormatOf<I>::Encode(values);
+        if constexpr (sizeof...(Rest) > 0) {
+            Encode<I + 1>(vertex, rest...);
+        }
+    }
+
+    template<uint32_t I>
+    static constexpr auto Decode(const Vertex &vertex) {
+        return FormatOf<I>::Decode(GetStorage<I>(vertex));
+    }
+
+    template<uint32_t I>
+    using FormatOf = typename std::tuple_element_t<I, std::tuple<Attributes...>>::Format;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
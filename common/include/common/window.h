@@ -12,10 +12,6 @@
 
 //----------------------------------------------------------------------------------------------------------------------
 
-constexpr auto kFHDResolution = Resolution(1280, 720);
-
-//----------------------------------------------------------------------------------------------------------------------
-
 class Example;
 
 //----------------------------------------------------------------------------------------------------------------------
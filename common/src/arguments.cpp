@@ -0,0 +1,53 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "arguments.h"
+
+#include <fmt/format.h>
+#include <cctype>
+#include <string_view>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Arguments ParseArguments(int argc, char *argv[]) {
+    Arguments arguments;
+
+    for (auto i = 1; i < argc; ++i) {
+        std::string_view argument = argv[i];
+        if (argument == "--headless" || argument == "--software") {
+            arguments.backend = argument == "--headless" ? Backend::kNull : Backend::kSoftware;
+
+            // The number of frames is optional.
+            if (i + 1 < argc && std::isdigit(argv[i + 1][0])) {
+                arguments.frame_count = std::stoul(argv[++i]);
+            }
+        } else if (argument == "--threads" && i + 1 < argc) {
+            arguments.thread_count = std::stoul(argv[++i]);
+        } else if (argument == "--frames-in-flight" && i + 1 < argc) {
+            arguments.frames_in_flight = std::stoul(argv[++i]);
+            if (arguments.frames_in_flight < kMinFramesInFlight || arguments.frames_in_flight > kMaxFramesInFlight) {
+                throw std::runtime_error(fmt::format("The number of frames in flight must be in [{}, {}].",
+                                                     kMinFramesInFlight, kMaxFramesInFlight));
+            }
+        } else if (argument == "--shader-cache" && i + 1 < argc) {
+            arguments.shader_cache_directory = argv[++i];
+        } else if (argument == "--hot-reload") {
+            arguments.hot_reload = true;
+        } else if (argument == "--frame-budget" && i + 1 < argc) {
+            arguments.frame_budget = std::stof(argv[++i]);
+            if (arguments.frame_budget <= 0.0f) {
+                throw std::runtime_error("The frame budget must be positive.");
+            }
+        } else if (argument == "--idle") {
+            arguments.idle = true;
+        } else {
+            throw std::runtime_error(fmt::format("Unknown argument: {}.", argument));
+        }
+    }
+
+    return arguments;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
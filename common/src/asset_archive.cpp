@@ -0,0 +1,190 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "asset_archive.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+#include "hash.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline auto AlignUp(uint64_t offset, uint64_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+
+AssetArchive::AssetArchive(const std::filesystem::path &path) :
+_view(path) {
+    auto bytes = _view.GetBytes();
+
+    AssetArchiveHeader header;
+    if (bytes.size() < sizeof(header)) {
+        throw std::runtime_error(fmt::format("Fail to load an archive {}.", path.string()));
+    }
+    std::copy_n(bytes.data(), sizeof(header), reinterpret_cast<std::byte*>(&header));
+
+    if (header.magic != kAssetArchiveMagic || header.version != kAssetArchiveVersion) {
+        throw std::runtime_error(fmt::format("Fail to load an archive {}, the format is unknown.", path.string()));
+    }
+
+    auto index_size = uint64_t{header.entry_count} * sizeof(AssetArchiveEntry);
+    if (header.index_offset % alignof(AssetArchiveEntry) || header.index_offset + index_size > bytes.size() ||
+        header.names_offset > bytes.size()) {
+        throw std::runtime_error(fmt::format("Fail to load an archive {}, it is truncated.", path.string()));
+    }
+
+    // Both a mapping and a read buffer are aligned enough to refer entries in place.
+    _entries = {reinterpret_cast<const AssetArchiveEntry*>(bytes.data() + header.index_offset), header.entry_count};
+    _names = {reinterpret_cast<const char*>(bytes.data() + header.names_offset), bytes.size() - header.names_offset};
+
+    for (auto &entry : _entries) {
+        if (entry.data_offset + entry.data_size > bytes.size() ||
+            uint64_t{entry.name_offset} + entry.name_size > _names.size()) {
+            throw std::runtime_error(fmt::format("Fail to load an archive {}, it is truncated.", path.string()));
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::optional<std::span<const std::byte>> AssetArchive::Find(std::string_view name) const {
+    auto hash = Hash(name);
+    auto iter = std::lower_bound(_entries.begin(), _entries.end(), hash, [](auto &entry, auto hash) {
+        return entry.hash < hash;
+    });
+
+    for (; iter != _entries.end() && iter->hash == hash; ++iter) {
+        if (GetName(*iter) == name) {
+            return _view.GetBytes().subspan(iter->data_offset, iter->data_size);
+        }
+    }
+
+    return std::nullopt;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::span<const std::byte> AssetArchive::GetBytes(std::string_view name) const {
+    if (auto bytes = Find(name)) {
+        return *bytes;
+    }
+    throw std::runtime_error(fmt::format("Fail to find {} in an archive.", name));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::string_view AssetArchive::GetString(std::string_view name) const {
+    auto bytes = GetBytes(name);
+    return {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::string_view AssetArchive::GetName(const AssetArchiveEntry &entry) const {
+    return {_names.data() + entry.name_offset, entry.name_size};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void AssetArchiveWriter::Add(const std::string &name, std::vector<std::byte> data) {
+    _assets.push_back({name, std::move(data)});
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void AssetArchiveWriter::AddDirectory(const std::filesystem::path &directory) {
+    for (auto &entry : std::filesystem::recursive_directory_iterator(directory)) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+
+        FileView view(entry.path());
+        auto bytes = view.GetBytes();
+        Add(entry.path().lexically_relative(directory).generic_string(), {bytes.begin(), bytes.end()});
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void AssetArchiveWriter::Write(const std::filesystem::path &path) const {
+    // Sort assets by names so the same directory always produces the same archive.
+    std::vector<const Asset*> assets;
+    for (auto &asset : _assets) {
+        assets.push_back(&asset);
+    }
+    std::sort(assets.begin(), assets.end(), [](auto lhs, auto rhs) {
+        return lhs->name < rhs->name;
+    });
+
+    auto duplicate = std::adjacent_find(assets.begin(), assets.end(), [](auto lhs, auto rhs) {
+        return lhs->name == rhs->name;
+    });
+    if (duplicate != assets.end()) {
+        throw std::runtime_error(fmt::format("Fail to write an archive, {} is added twice.", (*duplicate)->name));
+    }
+
+    // Lay out blobs first, then the index and names.
+    std::vector<AssetArchiveEntry> entries;
+    std::string names;
+    uint64_t offset = sizeof(AssetArchiveHeader);
+    for (auto asset : assets) {
+        AssetArchiveEntry entry;
+        entry.hash = Hash(asset->name);
+        entry.name_offset = static_cast<uint32_t>(names.size());
+        entry.name_size = static_cast<uint32_t>(asset->name.size());
+        entry.data_offset = AlignUp(offset, kAssetArchiveAlignment);
+        entry.data_size = asset->data.size();
+        entries.push_back(entry);
+
+        names += asset->name;
+        offset = entry.data_offset + entry.data_size;
+    }
+
+    AssetArchiveHeader header;
+    header.entry_count = static_cast<uint32_t>(entries.size());
+    header.index_offset = AlignUp(offset, kAssetArchiveAlignment);
+    header.names_offset = header.index_offset + entries.size() * sizeof(AssetArchiveEntry);
+
+    std::vector<std::byte> archive(header.names_offset + names.size());
+    std::copy_n(reinterpret_cast<const std::byte*>(&header), sizeof(header), archive.data());
+    for (size_t i = 0; i != assets.size(); ++i) {
+        std::copy(assets[i]->data.begin(), assets[i]->data.end(), archive.data() + entries[i].data_offset);
+    }
+
+    std::stable_sort(entries.begin(), entries.end(), [](auto &lhs, auto &rhs) {
+        return lhs.hash < rhs.hash;
+    });
+    std::copy_n(reinterpret_cast<const std::byte*>(entries.data()), entries.size() * sizeof(AssetArchiveEntry),
+                archive.data() + header.index_offset);
+    std::copy_n(reinterpret_cast<const std::byte*>(names.data()), names.size(), archive.data() + header.names_offset);
+
+    // Write to a temporary file and rename it so readers never see a partial archive.
+    auto temp_path = path;
+    temp_path += ".tmp";
+
+    std::ofstream fout(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!fout.is_open()) {
+        throw std::runtime_error(fmt::format("Fail to open {}.", temp_path.string()));
+    }
+    fout.write(reinterpret_cast<const char*>(archive.data()), static_cast<std::streamsize>(archive.size()));
+    fout.close();
+
+    std::filesystem::rename(temp_path, path);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
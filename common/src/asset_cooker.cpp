@@ -0,0 +1,266 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "asset_cooker.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+
+#include "file_view.h"
+#include "hash.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr auto kAssetCookDatabaseHeader = "cook 1";
+constexpr auto kAssetCopyIdentifier = "copy";
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct AssetRecord {
+    uint64_t key = 0;
+    std::vector<std::string> dependencies;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+using AssetDatabase = std::map<std::string, AssetRecord>;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline auto LoadDatabase(const std::filesystem::path &path) {
+    AssetDatabase database;
+
+    std::ifstream fin(path);
+    std::string line;
+    if (!fin.is_open() || !std::getline(fin, line) || line != kAssetCookDatabaseHeader) {
+        return database;
+    }
+
+    // Every line is a key, a name and dependencies separated by tabs.
+    while (std::getline(fin, line)) {
+        std::istringstream stream(line);
+        std::string key, name, dependency;
+        if (!std::getline(stream, key, '\t') || !std::getline(stream, name, '\t')) {
+            continue;
+        }
+
+        AssetRecord record;
+        record.key = std::stoull(key, nullptr, 16);
+        while (std::getline(stream, dependency, '\t')) {
+            record.dependencies.push_back(dependency);
+        }
+        database.emplace(name, std::move(record));
+    }
+
+    return database;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline void StoreDatabase(const std::filesystem::path &path, const AssetDatabase &database) {
+    auto temp_path = path;
+    temp_path += ".tmp";
+
+    std::ofstream fout(temp_path, std::ios::out | std::ios::trunc);
+    if (!fout.is_open()) {
+        throw std::runtime_error(fmt::format("Fail to open {}.", temp_path.string()));
+    }
+
+    fout << kAssetCookDatabaseHeader << '\n';
+    for (auto &[name, record] : database) {
+        fout << fmt::format("{:016x}\t{}", record.key, name);
+        for (auto &dependency : record.dependencies) {
+            fout << '\t' << dependency;
+        }
+        fout << '\n';
+    }
+    fout.close();
+
+    std::filesystem::rename(temp_path, path);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline auto ComputeAssetKey(const std::string &identifier, const std::string &name, std::span<const std::byte> source,
+                            const std::filesystem::path &source_directory,
+                            const std::vector<std::string> &dependencies) {
+    auto key = Hash(name, Hash(identifier));
+    key = Hash(source.data(), source.size(), key);
+
+    // A missing dependency only changes a key by its name, the processor reports it when it runs.
+    for (auto &dependency : dependencies) {
+        key = Hash(dependency, key);
+
+        std::error_code error;
+        if (std::filesystem::is_regular_file(source_directory / dependency, error)) {
+            FileView view(source_directory / dependency);
+            key = Hash(view.GetString(), key);
+        }
+    }
+
+    return key;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline void WriteAsset(const std::filesystem::path &path, std::span<const std::byte> data) {
+    std::filesystem::create_directories(path.parent_path());
+
+    auto temp_path = path;
+    temp_path += ".tmp";
+
+    std::ofstream fout(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!fout.is_open()) {
+        throw std::runtime_error(fmt::format("Fail to open {}.", temp_path.string()));
+    }
+    fout.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    fout.close();
+
+    std::filesystem::rename(temp_path, path);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+AssetCooker::AssetCooker(JobSystem *job_system) :
+_job_system(job_system) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void AssetCooker::AddProcessor(std::unique_ptr<AssetProcessor> processor) {
+    _processors.push_back(std::move(processor));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+AssetCookStatistics AssetCooker::Cook(const std::filesystem::path &source_directory,
+                                      const std::filesystem::path &output_directory,
+                                      const std::filesystem::path &database_path) {
+    auto start_time = std::chrono::steady_clock::now();
+
+    if (!std::filesystem::is_directory(source_directory)) {
+        throw std::runtime_error(fmt::format("Fail to find a directory {}.", source_directory.string()));
+    }
+
+    auto database = LoadDatabase(database_path);
+
+    std::vector<std::string> names;
+    for (auto &entry : std::filesystem::recursive_directory_iterator(source_directory)) {
+        if (entry.is_regular_file()) {
+            names.push_back(entry.path().lexically_relative(source_directory).generic_string());
+        }
+    }
+    std::sort(names.begin(), names.end());
+
+    struct Outcome {
+        std::optional<AssetRecord> record;
+        bool cooked = false;
+        std::string error;
+    };
+
+    auto cook_asset = [&](const std::string &name, const AssetRecord *previous) {
+        Outcome outcome;
+        try {
+            auto source_path = source_directory / name;
+            auto output_path = output_directory / name;
+            auto processor = FindProcessor(source_path);
+            auto identifier = processor ? processor->GetIdentifier() : kAssetCopyIdentifier;
+
+            FileView source(source_path);
+            if (previous && std::filesystem::exists(output_path)) {
+                auto key = ComputeAssetKey(identifier, name, source.GetBytes(), source_directory,
+                                           previous->dependencies);
+                if (key == previous->key) {
+                    outcome.record = *previous;
+                    return outcome;
+                }
+            }
+
+            AssetCookResult result;
+            if (processor) {
+                result = processor->Process(source_path, source.GetBytes());
+            } else {
+                result.data.assign(source.GetBytes().begin(), source.GetBytes().end());
+            }
+            WriteAsset(output_path, result.data);
+
+            AssetRecord record;
+            for (auto &dependency : result.dependencies) {
+                record.dependencies.push_back(dependency.lexically_relative(source_directory).generic_string());
+            }
+            record.key = ComputeAssetKey(identifier, name, source.GetBytes(), source_directory,
+                                         record.dependencies);
+            outcome.record = std::move(record);
+            outcome.cooked = true;
+        }
+        catch (const std::exception &exception) {
+            outcome.error = fmt::format("Fail to cook {}: {}", name, exception.what());
+        }
+        return outcome;
+    };
+
+    // Records of previous cooks are found up front, so the database is only touched on this thread.
+    std::vector<const AssetRecord *> previous_records(names.size());
+    for (auto i = size_t(0); i != names.size(); ++i) {
+        if (auto iter = database.find(names[i]); iter != database.end()) {
+            previous_records[i] = &iter->second;
+        }
+    }
+
+    // Every asset is read, hashed and cooked on a job.
+    std::vector<Outcome> outcomes(names.size());
+    _job_system->ParallelFor(static_cast<uint32_t>(names.size()), 1, [&](uint32_t begin, uint32_t end) {
+        for (auto i = begin; i != end; ++i) {
+            outcomes[i] = cook_asset(names[i], previous_records[i]);
+        }
+    });
+
+    AssetCookStatistics statistics;
+    AssetDatabase next_database;
+    for (size_t i = 0; i != names.size(); ++i) {
+        auto &outcome = outcomes[i];
+        if (!outcome.record) {
+            ++statistics.failed_count;
+            statistics.errors.push_back(std::move(outcome.error));
+            continue;
+        }
+
+        ++(outcome.cooked ? statistics.cooked_count : statistics.skipped_count);
+        next_database.emplace(names[i], std::move(*outcome.record));
+    }
+
+    // Remove assets whose sources are removed.
+    for (auto &[name, record] : database) {
+        if (!std::binary_search(names.begin(), names.end(), name)) {
+            std::error_code error;
+            if (std::filesystem::remove(output_directory / name, error)) {
+                ++statistics.removed_count;
+            }
+        }
+    }
+
+    StoreDatabase(database_path, next_database);
+
+    statistics.elapsed_time = std::chrono::steady_clock::now() - start_time;
+    return statistics;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+const AssetProcessor *AssetCooker::FindProcessor(const std::filesystem::path &path) const {
+    for (auto &processor : _processors) {
+        if (processor->Accept(path)) {
+            return processor.get();
+        }
+    }
+    return nullptr;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -5,6 +5,10 @@
 
 #include "camera.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+
 //----------------------------------------------------------------------------------------------------------------------
 
 auto Perspective(float fov, float aspect_ratio, float near, float far) {
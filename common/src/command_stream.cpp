@@ -0,0 +1,162 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "command_stream.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void CommandRecorder::SetPipeline(uint32_t pipeline) {
+    auto &command = Allocate<SetPipelineCommand>();
+    command.pipeline = pipeline;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void CommandRecorder::SetBuffer(CommandStage stage, uint32_t index, uint32_t buffer, uint32_t offset) {
+    auto &command = Allocate<SetBufferCommand>();
+    command.stage = stage;
+    command.index = static_cast<uint8_t>(index);
+    command.buffer = buffer;
+    command.offset = offset;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void CommandRecorder::SetBytes(CommandStage stage, uint32_t index, const void *data, uint32_t size) {
+    if (size > kCommandMaxBytesSize) {
+        throw std::runtime_error(fmt::format("Fail to record {} bytes, up to {} bytes can be set.", size,
+                                             kCommandMaxBytesSize));
+    }
+
+    std::memcpy(AllocateBytes(stage, index, size), data, size);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void CommandRecorder::Draw(CommandPrimitiveType primitive_type, uint32_t vertex_start, uint32_t vertex_count,
+                           uint32_t instance_count, uint32_t base_instance) {
+    auto &command = Allocate<DrawCommand>();
+    command.primitive_type = primitive_type;
+    command.vertex_start = vertex_start;
+    command.vertex_count = vertex_count;
+    command.instance_count = instance_count;
+    command.base_instance = base_instance;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void CommandRecorder::DrawIndexed(CommandPrimitiveType primitive_type, uint32_t index_count,
+                                  CommandIndexType index_type, uint32_t index_buffer, uint32_t index_offset,
+                                  uint32_t instance_count, int32_t base_vertex, uint32_t base_instance) {
+    auto &command = Allocate<DrawIndexedCommand>();
+    command.primitive_type = primitive_type;
+    command.index_type = index_type;
+    command.index_count = index_count;
+    command.index_buffer = index_buffer;
+    command.index_offset = index_offset;
+    command.instance_count = instance_count;
+    command.base_vertex = base_vertex;
+    command.base_instance = base_instance;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void CommandRecorder::Reset() {
+    _chunk_count = 0;
+    _cursor = nullptr;
+    _end = nullptr;
+    _command_count = 0;
+    _byte_size = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::byte *CommandRecorder::AllocateBytes(CommandStage stage, uint32_t index, uint32_t size) {
+    auto &command = Allocate<SetBytesCommand>(size);
+    command.stage = stage;
+    command.index = static_cast<uint8_t>(index);
+    command.size = size;
+    return reinterpret_cast<std::byte *>(&command + 1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void CommandRecorder::NextChunk() {
+    if (_chunk_count) {
+        auto &chunk = _chunks[_chunk_count - 1];
+        chunk.size = static_cast<uint32_t>(_cursor - chunk.data.get());
+    }
+
+    if (_chunk_count == _chunks.size()) {
+        Chunk chunk;
+        chunk.data = std::make_unique_for_overwrite<std::byte[]>(kCommandChunkSize);
+        _chunks.push_back(std::move(chunk));
+    }
+
+    auto &chunk = _chunks[_chunk_count++];
+    _cursor = chunk.data.get();
+    _end = _cursor + kCommandChunkSize;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void CommandStream::Reset() {
+    for (auto i = 0u; i != _recorder_count; ++i) {
+        _recorders[i]->Reset();
+    }
+    _recorder_count = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+CommandRecorder &CommandStream::AddRecorder() {
+    if (_recorder_count == _recorders.size()) {
+        _recorders.push_back(std::make_unique<CommandRecorder>());
+    }
+    return *_recorders[_recorder_count++];
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void CommandStream::Record(JobSystem &job_system, uint32_t count, uint32_t batch_size,
+                           const std::function<void(CommandRecorder &, uint32_t, uint32_t)> &function) {
+    if (!count) {
+        return;
+    }
+
+    batch_size = std::max(batch_size, 1u);
+    auto first = _recorder_count;
+    auto batch_count = (count + batch_size - 1) / batch_size;
+    for (auto i = 0u; i != batch_count; ++i) {
+        AddRecorder();
+    }
+
+    job_system.ParallelFor(batch_count, 1, [&](uint32_t begin, uint32_t end) {
+        for (auto i = begin; i != end; ++i) {
+            auto item = i * batch_size;
+            function(*_recorders[first + i], item, std::min(item + batch_size, count));
+        }
+    });
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+CommandStreamStatistics CommandStream::GetStatistics() const {
+    CommandStreamStatistics statistics;
+    statistics.recorder_count = _recorder_count;
+    for (auto i = 0u; i != _recorder_count; ++i) {
+        statistics.command_count += _recorders[i]->GetCommandCount();
+        statistics.byte_size += _recorders[i]->GetByteSize();
+        statistics.chunk_count += _recorders[i]->GetChunkCount();
+    }
+    return statistics;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
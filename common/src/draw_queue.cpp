@@ -0,0 +1,260 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "draw_queue.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr auto kRadixBits = 8u;
+constexpr auto kRadixSize = 1u << kRadixBits;
+constexpr auto kRadixDigitCount = 64u / kRadixBits;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+
+uint64_t MakeDrawKey(uint32_t pass, uint32_t pipeline, uint32_t material, float depth) {
+    if (pass >> kDrawPassBits || pipeline >> kDrawPipelineBits || material >> kDrawMaterialBits) {
+        throw std::runtime_error(fmt::format("Fail to make a draw key of pass {}, pipeline {} and material {}.", pass,
+                                             pipeline, material));
+    }
+
+    // NaN is taken as the near plane.
+    depth = depth > 0.0f ? std::min(depth, 1.0f) : 0.0f;
+    auto quantized_depth = static_cast<uint64_t>(depth * static_cast<float>((1u << kDrawDepthBits) - 1) + 0.5f);
+
+    auto key = static_cast<uint64_t>(pass);
+    key = key << kDrawPipelineBits | pipeline;
+    key = key << kDrawMaterialBits | material;
+    key = key << kDrawDepthBits | quantized_depth;
+    return key;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void RadixSort(std::span<const uint64_t> keys, std::vector<uint32_t> &order) {
+    auto count = static_cast<uint32_t>(keys.size());
+    order.resize(count);
+    if (!count) {
+        return;
+    }
+
+    // Histograms of every digit are counted in a single pass over keys.
+    std::array<std::array<uint32_t, kRadixSize>, kRadixDigitCount> histograms = {};
+    for (auto key : keys) {
+        for (auto i = 0u; i != kRadixDigitCount; ++i) {
+            ++histograms[i][(key >> (i * kRadixBits)) & (kRadixSize - 1)];
+        }
+    }
+
+    // Keys move with indices, so a pass reads them contiguously instead of through the order.
+    struct Entry {
+        uint64_t key = 0;
+        uint32_t index = 0;
+    };
+
+    std::vector<Entry> entries(count);
+    std::vector<Entry> sorted_entries(count);
+    for (auto i = 0u; i != count; ++i) {
+        entries[i] = {keys[i], i};
+    }
+
+    for (auto i = 0u; i != kRadixDigitCount; ++i) {
+        auto shift = i * kRadixBits;
+        auto &histogram = histograms[i];
+        if (histogram[(keys[0] >> shift) & (kRadixSize - 1)] == count) {
+            continue;
+        }
+
+        std::array<uint32_t, kRadixSize> offsets;
+        std::exclusive_scan(histogram.begin(), histogram.end(), offsets.begin(), 0u);
+        for (auto &entry : entries) {
+            sorted_entries[offsets[(entry.key >> shift) & (kRadixSize - 1)]++] = entry;
+        }
+        entries.swap(sorted_entries);
+    }
+
+    for (auto i = 0u; i != count; ++i) {
+        order[i] = entries[i].index;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void DrawQueue::Reset() {
+    _items.clear();
+    _keys.clear();
+    _bytes.clear();
+    _requested_state_count = 0;
+    _sorted = false;
+    _statistics = {};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void DrawQueue::Submit(const DrawPacket &packet) {
+    if (packet.binding_count > kDrawMaxBindings) {
+        throw std::runtime_error(fmt::format("Fail to submit a draw with {} bindings.", packet.binding_count));
+    }
+
+    for (auto i = 0u; i != packet.binding_count; ++i) {
+        if (packet.bindings[i].index >= kDrawMaxBufferIndices) {
+            throw std::runtime_error(fmt::format("Fail to submit a draw binds a buffer at {}.",
+                                                 packet.bindings[i].index));
+        }
+    }
+
+    _keys.push_back(MakeDrawKey(packet.pass, packet.pipeline, packet.material, packet.depth));
+
+    Item item;
+    item.packet = packet;
+    _items.push_back(item);
+    _requested_state_count += 1 + packet.binding_count;
+    _sorted = false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void DrawQueue::Submit(const DrawPacket &packet, CommandStage stage, uint32_t index, const void *data,
+                       uint32_t size) {
+    if (index >= kDrawMaxBufferIndices || size > kCommandMaxBytesSize) {
+        throw std::runtime_error(fmt::format("Fail to submit a draw sets {} bytes at {}.", size, index));
+    }
+
+    Submit(packet);
+
+    auto &item = _items.back();
+    item.bytes_offset = static_cast<uint32_t>(_bytes.size());
+    item.bytes_size = size;
+    item.bytes_stage = stage;
+    item.bytes_index = static_cast<uint8_t>(index);
+    _bytes.insert(_bytes.end(), static_cast<const std::byte *>(data), static_cast<const std::byte *>(data) + size);
+    _requested_state_count += size ? 1 : 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void DrawQueue::Sort() {
+    auto start_time = std::chrono::steady_clock::now();
+    RadixSort(_keys, _order);
+    _sorted = true;
+    _statistics.sort_time = std::chrono::steady_clock::now() - start_time;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void DrawQueue::Emit(CommandRecorder &recorder) {
+    auto start_time = std::chrono::steady_clock::now();
+    if (!_sorted) {
+        _order.resize(_items.size());
+        std::iota(_order.begin(), _order.end(), 0u);
+    }
+
+    Counts counts;
+    Emit(0, GetDrawCount(), recorder, counts);
+    UpdateStatistics(counts, start_time);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void DrawQueue::Emit(CommandStream &stream, JobSystem &job_system, uint32_t batch_size) {
+    auto start_time = std::chrono::steady_clock::now();
+    if (!_sorted) {
+        _order.resize(_items.size());
+        std::iota(_order.begin(), _order.end(), 0u);
+    }
+
+    batch_size = std::max(batch_size, 1u);
+    std::vector<Counts> batch_counts((GetDrawCount() + batch_size - 1) / batch_size);
+    stream.Record(job_system, GetDrawCount(), batch_size, [&](CommandRecorder &recorder, uint32_t begin,
+                                                              uint32_t end) {
+        Emit(begin, end, recorder, batch_counts[begin / batch_size]);
+    });
+
+    Counts counts;
+    for (auto &batch_count : batch_counts) {
+        counts.pipeline_count += batch_count.pipeline_count;
+        counts.buffer_count += batch_count.buffer_count;
+        counts.bytes_count += batch_count.bytes_count;
+    }
+    UpdateStatistics(counts, start_time);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void DrawQueue::Emit(uint32_t begin, uint32_t end, CommandRecorder &recorder, Counts &counts) const {
+    State state;
+
+    for (auto i = begin; i != end; ++i) {
+        auto &item = _items[_order[i]];
+        auto &packet = item.packet;
+
+        if (state.pipeline != packet.pipeline) {
+            recorder.SetPipeline(packet.pipeline);
+            state.pipeline = packet.pipeline;
+            ++counts.pipeline_count;
+        }
+
+        for (auto j = 0u; j != packet.binding_count; ++j) {
+            auto &binding = packet.bindings[j];
+            auto &slot = state.slots[static_cast<uint32_t>(binding.stage)][binding.index];
+            if (slot.buffer != binding.buffer || slot.offset != binding.offset) {
+                recorder.SetBuffer(binding.stage, binding.index, binding.buffer, binding.offset);
+                slot.buffer = binding.buffer;
+                slot.offset = binding.offset;
+                slot.bytes_size = 0;
+                ++counts.buffer_count;
+            }
+        }
+
+        if (item.bytes_size) {
+            auto &slot = state.slots[static_cast<uint32_t>(item.bytes_stage)][item.bytes_index];
+            auto bytes = _bytes.data() + item.bytes_offset;
+            if (slot.buffer != ~0u || slot.bytes_size != item.bytes_size ||
+                std::memcmp(_bytes.data() + slot.bytes_offset, bytes, item.bytes_size)) {
+                recorder.SetBytes(item.bytes_stage, item.bytes_index, bytes, item.bytes_size);
+                slot.buffer = ~0u;
+                slot.bytes_offset = item.bytes_offset;
+                slot.bytes_size = item.bytes_size;
+                ++counts.bytes_count;
+            }
+        }
+
+        if (packet.indexed) {
+            recorder.DrawIndexed(packet.primitive_type, packet.count, packet.index_type, packet.index_buffer,
+                                 packet.index_offset, packet.instance_count, packet.base_vertex,
+                                 packet.base_instance);
+        } else {
+            recorder.Draw(packet.primitive_type, packet.first_vertex, packet.count, packet.instance_count,
+                          packet.base_instance);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void DrawQueue::UpdateStatistics(const Counts &counts, std::chrono::steady_clock::time_point start_time) {
+    _statistics.draw_count = GetDrawCount();
+    _statistics.requested_state_count = _requested_state_count;
+    _statistics.pipeline_count = counts.pipeline_count;
+    _statistics.buffer_count = counts.buffer_count;
+    _statistics.bytes_count = counts.bytes_count;
+    _statistics.emitted_state_count = counts.pipeline_count + counts.buffer_count + counts.bytes_count;
+    _statistics.emit_time = std::chrono::steady_clock::now() - start_time;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,102 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "dynamic_resolution.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+BudgetResolutionPolicy::BudgetResolutionPolicy(float headroom) :
+_headroom(headroom) {
+    if (headroom <= 0.0f || headroom > 1.0f) {
+        throw std::runtime_error(fmt::format("Fail to create a policy with headroom {}.", headroom));
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+float BudgetResolutionPolicy::Evaluate(std::chrono::duration<double> frame_time, std::chrono::duration<double> budget,
+                                       float scale) {
+    if (frame_time.count() <= 0.0) {
+        return scale;
+    }
+
+    // A scale applies to both width and height, so pixels change by its square.
+    return scale * static_cast<float>(std::sqrt(_headroom * budget.count() / frame_time.count()));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+DynamicResolution::DynamicResolution(const DynamicResolutionSettings &settings,
+                                     std::unique_ptr<ResolutionPolicy> policy) :
+_settings(settings),
+_policy(std::move(policy)) {
+    if (_settings.budget.count() <= 0.0 || _settings.min_scale <= 0.0f || _settings.min_scale > _settings.max_scale ||
+        _settings.raise_threshold >= _settings.lower_threshold || !_settings.window_size) {
+        throw std::runtime_error(fmt::format("Fail to create a dynamic resolution of budget {:.3f} ms and scales in "
+                                             "[{}, {}].", _settings.budget.count() * 1000.0, _settings.min_scale,
+                                             _settings.max_scale));
+    }
+
+    if (!_policy) {
+        _policy = std::make_unique<BudgetResolutionPolicy>();
+    }
+
+    _scale = _settings.max_scale;
+    _frame_times.reserve(_settings.window_size);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool DynamicResolution::Update(std::chrono::duration<double> cpu_time, std::chrono::duration<double> gpu_time) {
+    ++_statistics.frame_count;
+
+    _frame_times.push_back(std::max(cpu_time, gpu_time).count());
+    if (_frame_times.size() < _settings.window_size) {
+        return false;
+    }
+
+    auto frame_time = std::chrono::duration<double>(
+            std::accumulate(_frame_times.begin(), _frame_times.end(), 0.0) / static_cast<double>(_frame_times.size()));
+    _statistics.frame_time = frame_time;
+    _frame_times.clear();
+
+    // Hold a scale while a frame time is between the thresholds.
+    auto over_budget = frame_time > _settings.budget * _settings.lower_threshold;
+    auto under_budget = frame_time < _settings.budget * _settings.raise_threshold;
+    if (!over_budget && !under_budget) {
+        return false;
+    }
+
+    auto scale = _policy->Evaluate(frame_time, _settings.budget, _scale);
+    if (over_budget) {
+        scale = std::min(scale, _scale - _settings.min_step);
+    } else if (scale - _scale < _settings.min_step) {
+        return false;
+    }
+
+    scale = std::clamp(scale, _settings.min_scale, _settings.max_scale);
+    if (scale == _scale) {
+        return false;
+    }
+
+    _scale = scale;
+    ++_statistics.change_count;
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Resolution DynamicResolution::Scale(const Resolution &resolution) const {
+    auto width = static_cast<uint32_t>(std::lround(static_cast<float>(GetWidth(resolution)) * _scale));
+    auto height = static_cast<uint32_t>(std::lround(static_cast<float>(GetHeight(resolution)) * _scale));
+    return {std::max(width, 1u), std::max(height, 1u)};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
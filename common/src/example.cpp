@@ -5,38 +5,98 @@
 
 #include "example.h"
 
-#include <imgui_impl_osx.h>
-#include <imgui_impl_metal.h>
+#include <cfloat>
+#include <iostream>
+#include <utility>
 
-#include "window.h"
+#include "headless.h"
+#include "null_device.h"
 
 using namespace std::chrono_literals;
 
 //----------------------------------------------------------------------------------------------------------------------
 
-Example::Example(const std::string &title) :
-_title(title) {
-    InitDevice();
-    InitCommandQueue();
-    InitSemaphore();
-    InitImGui();
+namespace {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline uint64_t PackResolution(const Resolution &resolution) {
+    return static_cast<uint64_t>(GetWidth(resolution)) << 32 | GetHeight(resolution);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-Example::~Example() {
-    TermImGui();
+inline Resolution UnpackResolution(uint64_t resolution) {
+    return {static_cast<uint32_t>(resolution >> 32), static_cast<uint32_t>(resolution)};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int RunExampleLoop(int argc, char *argv[], const ExampleFactory &factory) {
+    try {
+        auto arguments = ParseArguments(argc, argv);
+        auto example = factory(arguments);
+        if (arguments.backend != Backend::kMetal) {
+            Headless(kFHDResolution).MainLoop(example.get(), arguments.frame_count);
+        } else {
+#ifdef __OBJC__
+            Window::GetInstance()->MainLoop(example.get());
+#endif
+        }
+    }
+    catch (const std::exception &exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+
+FrameSnapshot::~FrameSnapshot() {
+    for (auto draw_list : draw_lists) {
+        IM_DELETE(draw_list);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void FrameSnapshot::CopyDrawData(const ImDrawData &source) {
+    for (auto draw_list : draw_lists) {
+        IM_DELETE(draw_list);
+    }
+    draw_lists.clear();
+
+    for (auto i = 0; i != source.CmdListsCount; ++i) {
+        draw_lists.push_back(source.CmdLists[i]->CloneOutput());
+    }
+
+    draw_data = source;
+    draw_data.CmdLists = draw_lists.data();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Example::Example(const std::string &title, const Arguments &arguments) :
+_title(title),
+_hot_reload(arguments.hot_reload),
+_job_system(arguments.thread_count),
+_idle(arguments.idle) {
+    InitDevice(arguments);
+    InitFrameAllocator();
+    InitDynamicResolution(arguments.frame_budget);
+    InitImGui();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-void Example::BindToWindow(Window *window) {
-    _layer = (CAMetalLayer*)[window->GetView() layer];
-    
-    // 
-    _layer.device = _device;
-    _layer.maximumDrawableCount = kMetalLayerDrawableCount;
-    _layer.pixelFormat = kMetalLayerPixelFormat;
+Example::~Example() {
+    StopSimulation();
+    TermImGui();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -49,25 +109,40 @@ void Example::Init() {
 //----------------------------------------------------------------------------------------------------------------------
 
 void Example::Term() {
+    StopSimulation();
+    _render_device->WaitIdle();
     OnTerm();
     _timer.Stop();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-void Example::Resize(const Resolution &resolution) {
-    @synchronized(_layer) {
-        _camera.SetAspectRatio(GetAspectRatio(resolution));
-
-        // Resize a layer drawable size.
-        _layer.drawableSize = CGSizeMake(GetWidth(resolution), GetHeight(resolution));
+void Example::Resize(const Resolution &resolution, bool live) {
+    // Neither thread is blocked, the simulation thread picks the last request up when it begins a frame.
+    _live_resize.store(live, std::memory_order_relaxed);
+    _requested_resolution.store(PackResolution(resolution), std::memory_order_release);
+    Invalidate();
+}
 
-        // Update the display size to ImGui.
-        ImGui::GetIO().DisplaySize = ImVec2(GetWidth(resolution), GetHeight(resolution));
+//----------------------------------------------------------------------------------------------------------------------
 
-        // Resize by an example.
-        OnResize(resolution);
-    }
+void Example::StartSimulation() {
+    _simulation_thread = std::thread([this]() {
+        // Stay a frame ahead of the render thread at most.
+        do {
+            if (_idle) {
+                WaitForChange();
+            }
+
+#ifdef __OBJC__
+            @autoreleasepool {
+                Update();
+            }
+#else
+            Update();
+#endif
+        } while (_snapshots.WaitForAcquire());
+    });
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -85,105 +160,236 @@ void Example::Update() {
         ++_cps;
     }
 
-    // Wait until the command buffer has completed its work.
-    dispatch_semaphore_wait(_semaphore, DISPATCH_TIME_FOREVER);
-    
-    // Advance the current frame index.
-    _frame_index = ++_frame_index % kMetalLayerDrawableCount;
-    
+    // Move the camera with input since the last update.
+    UpdateInput();
+    UpdateResolution();
+
+    // Advance the current frame index and recycle uniforms of the frame, the render thread released them before it
+    // acquired the last snapshot.
+    _frame_index = (_frame_index + 1) % _frame_count;
+    _frame_allocator->Reset(_frame_index);
+
     // Update ImGui by an example.
     BeginImGuiPass();
     OnUpdate(_frame_index);
     EndImGuiPass();
+
+    // Hand a frame to the render thread.
+    auto &snapshot = _snapshots.GetWriteBuffer();
+
+    // Keep updating while the camera moves or ImGui is interacted with, they change without input every frame. A
+    // snapshot published two frames ago is compared, so a frame or two more are updated after they settle.
+    if (_idle && (!simd_equal(snapshot.camera.GetView(), _camera.GetView()) ||
+                  !simd_equal(snapshot.camera.GetProjection(), _camera.GetProjection()) ||
+                  ImGui::IsAnyItemActive())) {
+        Invalidate();
+    }
+
+    snapshot.index = _frame_index;
+    snapshot.resolution = _resolution;
+    snapshot.camera = _camera;
+    snapshot.CopyDrawData(*ImGui::GetDrawData());
+    _snapshots.Publish();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
 void Example::Render() {
-    @synchronized(_layer) {
-        // Acquire a next drawable.
-        _drawable = [_layer nextDrawable];
+    // Skip a frame while the simulation thread is idle, the last image stays on screen.
+    if (_simulation_idle.load(std::memory_order_acquire) && !_snapshots.IsPublished()) {
+        _skipped_frame_count.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
 
-        // Render by an example.
-        _command_buffer = [_command_queue commandBuffer];
-        OnRender(_frame_index);
+    // Wait for a frame to render.
+    if (!_snapshots.WaitForPublish()) {
+        return;
+    }
 
-        // Schedule a drawable presentation.
-        [_command_buffer presentDrawable:_drawable];
-        _drawable = nil;
+    // Wait until the device can accept a new frame. A snapshot is acquired after it, so uniforms the simulation thread
+    // writes next aren't used by the device anymore.
+    _render_device->WaitForFrame();
+    _snapshots.Acquire();
+    auto &snapshot = _snapshots.GetReadBuffer();
+    auto start_time = std::chrono::steady_clock::now();
+
+    // Swap reloaded resources in before an example uses them.
+    UpdateHotReload();
+
+    // Resize render targets when the first frame of a resolution arrives, a frame is rendered at the resolution
+    // it is updated with, or at a scale of it.
+    auto render_resolution = snapshot.resolution;
+    if (_dynamic_resolution) {
+        render_resolution = _dynamic_resolution->Scale(render_resolution);
+    }
+    if (snapshot.resolution != _display_resolution || render_resolution != _render_resolution) {
+        ResizeRenderTargets(snapshot.resolution, render_resolution);
+    }
 
-        // Signal a semaphore after the command buffer has processed.
-        __weak dispatch_semaphore_t semaphore = _semaphore;
-        [_command_buffer addCompletedHandler:^(id<MTLCommandBuffer> commandBuffer) {
-            dispatch_semaphore_signal(semaphore);
-        }];
+    // Acquire a next image and begin a frame.
+    _render_device->BeginFrame();
+#ifdef __OBJC__
+    if (_metal_device) {
+        BeginMetalFrame();
+    }
+#endif
 
-        // Commit a command buffer.
-        [_command_buffer commit];
+    // Render by an example.
+    OnRender(snapshot.index);
+#ifdef __OBJC__
+    if (_metal_device) {
+        EndMetalFrame();
+    }
+#endif
+
+    // Submit a frame and present an image.
+    _render_device->EndFrame();
+    _rendered_frame_count.fetch_add(1, std::memory_order_relaxed);
+
+    // GPU time lags behind by frames in flight, a window of frame times outweighs it.
+    if (_dynamic_resolution) {
+        _dynamic_resolution->Update(std::chrono::steady_clock::now() - start_time, _render_device->GetGpuTime());
     }
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-void Example::OnMouseButtonDown(NSEvent* event, const NSPoint &point) {
-    _mouse_point = point;
+void Example::Invalidate() {
+    {
+        std::lock_guard lock(_change_mutex);
+        _changed = true;
+    }
+    _change_condition.notify_one();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-void Example::OnMouseButtonUp(NSEvent* event, const NSPoint &point) {
-    _mouse_point = point;
+FrameStatistics Example::GetFrameStatistics() const {
+    FrameStatistics statistics;
+    statistics.rendered_count = _rendered_frame_count.load(std::memory_order_relaxed);
+    statistics.skipped_count = _skipped_frame_count.load(std::memory_order_relaxed);
+    return statistics;
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-void Example::OnMouseMove(NSEvent* event, const NSPoint &point) {
-    if (event.type == NSEventTypeLeftMouseDragged) {
-        _camera.RotateBy({static_cast<float>(point.x - _mouse_point.x),
-                          static_cast<float>(point.y - _mouse_point.y)});
-    }
-    _mouse_point = point;
+void Example::OnMouseButtonDown(float x, float y) {
+    _input_queue.Push({InputEventType::kMouseButtonDown, x, y});
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Example::OnMouseButtonUp(float x, float y) {
+    _input_queue.Push({InputEventType::kMouseButtonUp, x, y});
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Example::OnMouseMove(float x, float y, bool drag) {
+    _input_queue.Push({drag ? InputEventType::kMouseDrag : InputEventType::kMouseMove, x, y});
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
 void Example::OnMouseWheel(float delta) {
-    _camera.ZoomBy(delta);
+    _input_queue.Push({InputEventType::kMouseWheel, 0.0f, 0.0f, delta});
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-void Example::RecordDrawImGuiCommands(MTLRenderPassDescriptor *descriptor, id<MTLRenderCommandEncoder> encoder) {
-    ImGui_ImplMetal_NewFrame(descriptor);
-    ImGui::Render();
-    ImGui_ImplMetal_RenderDrawData(ImGui::GetDrawData(), _command_buffer, encoder);
+Ray Example::GetMouseRay() const {
+    auto width = std::max(static_cast<float>(GetWidth(_resolution)), 1.0f);
+    auto height = std::max(static_cast<float>(GetHeight(_resolution)), 1.0f);
+
+    // A mouse point is in the view where the origin is the top left corner.
+    auto x = _mouse_point.x / width * 2.0f - 1.0f;
+    auto y = 1.0f - _mouse_point.y / height * 2.0f;
+    return MakeRay(Multiply(ConvertToMatrix4(_camera.GetProjection()), ConvertToMatrix4(_camera.GetView())), x, y);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-void Example::InitDevice() {
-    _device = MTLCreateSystemDefaultDevice();
-    if (!_device) {
-        throw std::runtime_error("Fail to create a device.");
+BvhHit Example::PickMesh(const Bvh &bvh, const Mesh &mesh) const {
+    return IntersectMesh(bvh, mesh, GetMouseRay());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Example::MountAssetArchive(const std::filesystem::path &archive_path, const std::filesystem::path &directory) {
+    // An archive is stale as soon as a source changes.
+    if (_hot_reload) {
+        _file_watcher = std::make_unique<FileWatcher>(directory);
+        return;
+    }
+
+    if (!std::filesystem::exists(archive_path)) {
+        return;
+    }
+
+    _asset_archive = std::make_unique<AssetArchive>(archive_path);
+    if (_shader_cache) {
+        _shader_cache->MountArchive(_asset_archive.get(), directory);
     }
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-void Example::InitCommandQueue() {
-    _command_queue = [_device newCommandQueue];
-    if (!_command_queue) {
-        throw std::runtime_error("Fail to create a command queue.");
+void Example::InitDevice(const Arguments &arguments) {
+    _frames_in_flight = arguments.frames_in_flight;
+    _frame_count = _frames_in_flight + 1;
+
+    switch (arguments.backend) {
+        case Backend::kMetal:
+#ifdef __OBJC__
+            InitMetalDevice(arguments);
+            break;
+#else
+            throw std::runtime_error("Fail to create a device: Metal is unavailable.");
+#endif
+        case Backend::kNull:
+            _render_device = std::make_unique<NullDevice>(_frames_in_flight, kMetalLayerDrawableCount);
+            break;
+        case Backend::kSoftware: {
+            auto software_device = std::make_unique<SoftwareDevice>(_frames_in_flight, kMetalLayerDrawableCount,
+                                                                    &_job_system);
+            _software_device = software_device.get();
+            _render_device = std::move(software_device);
+            break;
+        }
+        default:
+            throw std::runtime_error("Fail to create a device: unknown backend.");
     }
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
-void Example::InitSemaphore() {
-    _semaphore = dispatch_semaphore_create(kMetalLayerDrawableCount);
-    if (!_semaphore) {
-        throw std::runtime_error("Fail to create a semaphore");
+void Example::InitFrameAllocator() {
+    const auto kSize = kDefaultUniformFrameSize * _frame_count;
+
+    void *data = nullptr;
+#ifdef __OBJC__
+    // Uniforms are in a buffer the GPU reads with a Metal device.
+    data = _uniform_buffer.contents;
+#endif
+    if (!data) {
+        _uniform_memory.resize(kSize);
+        data = _uniform_memory.data();
     }
+
+    _frame_allocator = std::make_unique<FrameAllocator>(data, kDefaultUniformFrameSize, _frame_count);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Example::InitDynamicResolution(float frame_budget) {
+    if (frame_budget <= 0.0f) {
+        return;
+    }
+
+    DynamicResolutionSettings settings;
+    settings.budget = std::chrono::duration<double, std::milli>(frame_budget);
+    settings.window_size = std::max(settings.window_size, _frames_in_flight * 2);
+    _dynamic_resolution = std::make_unique<DynamicResolution>(settings);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -195,29 +401,144 @@ void Example::InitImGui() {
     // Use the classic theme.
     ImGui::StyleColorsClassic();
 
-    ImGui_ImplMetal_Init(_device);
-    ImGui_ImplOSX_Init();
+#ifdef __OBJC__
+    if (_metal_device) {
+        InitMetalImGui();
+        return;
+    }
+#endif
+
+    // Don't leave a layout file wherever a headless example runs.
+    ImGui::GetIO().IniFilename = nullptr;
+
+    // Build a font atlas as there is no renderer to do it.
+    unsigned char *pixels = nullptr;
+    int width = 0, height = 0;
+    ImGui::GetIO().Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Example::UpdateHotReload() {
+    if (_file_watcher) {
+        for (auto &path : _file_watcher->Poll()) {
+            if (_pipeline_cache) {
+                _pipeline_cache->Reload(path);
+            }
+            OnFileChange(path);
+        }
+    }
+
+    if (_pipeline_cache) {
+        auto result = _pipeline_cache->CommitReloads();
+        for (auto &error : result.errors) {
+            std::cerr << error << std::endl;
+        }
+        if (result.swap_count) {
+            OnPipelineReload();
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Example::UpdateInput() {
+    _input_events.clear();
+    _input_queue.Drain(_input_events);
+
+    for (auto &event : _input_events) {
+        switch (event.type) {
+            case InputEventType::kMouseDrag:
+                // Coalesced drags rotate once by the distance from the last point.
+                _camera.RotateBy({event.x - _mouse_point.x, event.y - _mouse_point.y});
+                break;
+            case InputEventType::kMouseWheel:
+                _camera.ZoomBy(event.delta);
+                continue;
+            default:
+                break;
+        }
+        _mouse_point = {event.x, event.y};
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Example::UpdateResolution() {
+    auto requested_resolution = _requested_resolution.load(std::memory_order_acquire);
+    if (requested_resolution == PackResolution(_resolution)) {
+        return;
+    }
+
+    // Debounce a live resize, a layer stretches the last image until a size stays the same for a frame.
+    auto pending_resolution = std::exchange(_pending_resolution, requested_resolution);
+    if (_live_resize.load(std::memory_order_relaxed) && pending_resolution != requested_resolution) {
+        return;
+    }
+
+    _resolution = UnpackResolution(requested_resolution);
+    _camera.SetAspectRatio(GetAspectRatio(_resolution));
+
+    // Update the display size to ImGui.
+    ImGui::GetIO().DisplaySize = ImVec2(GetWidth(_resolution), GetHeight(_resolution));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Example::ResizeRenderTargets(const Resolution &resolution, const Resolution &render_resolution) {
+#ifdef __OBJC__
+    if (_metal_device) {
+        ResizeMetalTargets(resolution, render_resolution);
+    } else
+#endif
+    {
+        // There is no window to upscale into, images are rendered at a scaled resolution.
+        _render_device->GetSwapchain()->Resize(render_resolution);
+    }
+
+    _display_resolution = resolution;
+    _render_resolution = render_resolution;
+
+    // Resize by an example.
+    OnResize(render_resolution);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
 void Example::TermImGui() {
-    ImGui_ImplMetal_Shutdown();
-    ImGui_ImplOSX_Shutdown();
+#ifdef __OBJC__
+    if (_metal_device) {
+        TermMetalImGui();
+    }
+#endif
     ImGui::DestroyContext();
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
 void Example::BeginImGuiPass() {
-    ImGui_ImplOSX_NewFrame(nullptr);
+#ifdef __OBJC__
+    if (_metal_device) {
+        BeginMetalImGuiPass();
+    } else
+#endif
+    {
+        // ImGui requires a positive time step.
+        auto delta_time = std::chrono::duration<float>(_timer.GetDeltaTime()).count();
+        ImGui::GetIO().DeltaTime = std::max(delta_time, FLT_EPSILON);
+    }
     ImGui::NewFrame();
     ImGui::PushStyleVar(ImGuiStyleVar_WindowRounding, 0);
     ImGui::Begin("Metal", nullptr,
                  ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
     ImGui::TextUnformatted(_title.c_str());
-    ImGui::TextUnformatted(_device.name.UTF8String);
+    ImGui::TextUnformatted(_render_device->GetName().c_str());
     ImGui::Text("%.2f ms/frame(%u FPS)", _timer.GetDeltaTime().count(), _fps);
+    if (_idle) {
+        auto statistics = GetFrameStatistics();
+        ImGui::Text("%llu rendered, %llu skipped", static_cast<unsigned long long>(statistics.rendered_count),
+                    static_cast<unsigned long long>(statistics.skipped_count));
+    }
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -225,7 +546,45 @@ void Example::BeginImGuiPass() {
 void Example::EndImGuiPass() {
     ImGui::End();
     ImGui::PopStyleVar();
-    ImGui::EndFrame();
+
+    // Build draw data on the simulation thread, the render thread draws a copy of them.
+    ImGui::Render();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Example::StopSimulation() {
+    _snapshots.Close();
+    Invalidate();
+    if (_simulation_thread.joinable()) {
+        _simulation_thread.join();
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Example::WaitForChange() {
+    std::unique_lock lock(_change_mutex);
+    if (!_changed) {
+        _simulation_idle.store(true, std::memory_order_release);
+        _change_condition.wait_for(lock, kIdleKeepAliveInterval, [this]() {
+            return _changed || _snapshots.IsClosed();
+        });
+        _simulation_idle.store(false, std::memory_order_release);
+    }
+    _changed = false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int RunExample(int argc, char *argv[], const ExampleFactory &factory) {
+#ifdef __OBJC__
+    @autoreleasepool {
+        return RunExampleLoop(argc, argv, factory);
+    }
+#else
+    return RunExampleLoop(argc, argv, factory);
+#endif
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,119 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "file_view.h"
+
+#include <fmt/format.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <stdexcept>
+#include <utility>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+FileView::FileView(const std::filesystem::path &path) {
+    auto fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(fmt::format("Fail to open {}.", path.string()));
+    }
+
+    struct stat status = {};
+    if (fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size >= kFileViewMapThreshold) {
+        auto mapping = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping != MAP_FAILED) {
+            // Start reading ahead as the whole content is usually consumed.
+            posix_madvise(mapping, status.st_size, POSIX_MADV_WILLNEED);
+
+            _mapping = mapping;
+            _data = static_cast<const std::byte*>(mapping);
+            _size = status.st_size;
+        }
+    }
+
+    // Fall back to reading if a file is small, special or can't be mapped.
+    if (!_mapping) {
+        try {
+            Read(fd, S_ISREG(status.st_mode) ? status.st_size : 0);
+        }
+        catch (...) {
+            close(fd);
+            throw;
+        }
+    }
+
+    close(fd);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+FileView::FileView(FileView &&other) noexcept {
+    *this = std::move(other);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+FileView &FileView::operator=(FileView &&other) noexcept {
+    if (this != &other) {
+        Unmap();
+        _mapping = std::exchange(other._mapping, nullptr);
+        _size = std::exchange(other._size, 0);
+        _buffer = std::move(other._buffer);
+        _data = _mapping ? std::exchange(other._data, nullptr) : _buffer.data();
+        other._data = nullptr;
+    }
+    return *this;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+FileView::~FileView() {
+    Unmap();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void FileView::Read(int fd, size_t size_hint) {
+    constexpr auto kChunkSize = size_t(64 * 1024);
+
+    // Special files may report a wrong size so read until the end of a file.
+    // One more byte lets a read of the exact size hit the end without growing.
+    _buffer.resize(size_hint ? size_hint + 1 : kChunkSize);
+    auto size = size_t(0);
+    while (true) {
+        if (size == _buffer.size()) {
+            _buffer.resize(_buffer.size() * 2);
+        }
+
+        auto count = read(fd, _buffer.data() + size, _buffer.size() - size);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Fail to read a file.");
+        }
+        if (count == 0) {
+            break;
+        }
+        size += count;
+    }
+
+    _buffer.resize(size);
+    _data = _buffer.data();
+    _size = size;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void FileView::Unmap() {
+    if (_mapping) {
+        munmap(_mapping, _size);
+        _mapping = nullptr;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
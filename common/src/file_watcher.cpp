@@ -0,0 +1,181 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "file_watcher.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+#if defined(__APPLE__)
+#include <CoreServices/CoreServices.h>
+#elif defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+//----------------------------------------------------------------------------------------------------------------------
+
+FileWatcher::FileWatcher(const std::filesystem::path &directory) :
+_directory(std::filesystem::canonical(directory)) {
+#if defined(__APPLE__)
+    // Events are reported with resolved paths, so the directory is canonical.
+    auto callback = [](ConstFSEventStreamRef stream, void *info, size_t count, void *paths,
+                       const FSEventStreamEventFlags flags[], const FSEventStreamEventId ids[]) {
+        auto watcher = static_cast<FileWatcher*>(info);
+        for (size_t i = 0; i != count; ++i) {
+            auto changed = kFSEventStreamEventFlagItemCreated | kFSEventStreamEventFlagItemModified |
+                           kFSEventStreamEventFlagItemRenamed;
+            if ((flags[i] & kFSEventStreamEventFlagItemIsFile) && (flags[i] & changed)) {
+                watcher->Record(static_cast<char**>(paths)[i]);
+            }
+        }
+    };
+
+    FSEventStreamContext context = {0, this, nullptr, nullptr, nullptr};
+    auto path = CFStringCreateWithCString(nullptr, _directory.c_str(), kCFStringEncodingUTF8);
+    auto paths = CFArrayCreate(nullptr, reinterpret_cast<const void**>(&path), 1, &kCFTypeArrayCallBacks);
+    auto stream = FSEventStreamCreate(nullptr, callback, &context, paths, kFSEventStreamEventIdSinceNow,
+                                      std::chrono::duration<double>(kFileWatcherInterval).count(),
+                                      kFSEventStreamCreateFlagFileEvents | kFSEventStreamCreateFlagNoDefer);
+    CFRelease(paths);
+    CFRelease(path);
+    if (!stream) {
+        throw std::runtime_error(fmt::format("Fail to watch {}.", _directory.string()));
+    }
+
+    FSEventStreamSetDispatchQueue(stream, dispatch_get_global_queue(QOS_CLASS_UTILITY, 0));
+    FSEventStreamStart(stream);
+    _stream = stream;
+#else
+#if defined(__linux__)
+    _descriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (_descriptor < 0) {
+        throw std::runtime_error(fmt::format("Fail to watch {}.", _directory.string()));
+    }
+#endif
+    _thread = std::thread(&FileWatcher::Watch, this);
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+FileWatcher::~FileWatcher() {
+    _stop = true;
+#if defined(__APPLE__)
+    auto stream = static_cast<FSEventStreamRef>(_stream);
+    FSEventStreamStop(stream);
+    FSEventStreamInvalidate(stream);
+    FSEventStreamRelease(stream);
+#else
+    _thread.join();
+#if defined(__linux__)
+    close(_descriptor);
+#endif
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::vector<std::filesystem::path> FileWatcher::Poll() {
+    std::vector<std::filesystem::path> changes;
+    {
+        std::lock_guard lock(_mutex);
+        changes.swap(_changes);
+    }
+
+    // An editor usually writes a file several times when it saves.
+    std::sort(changes.begin(), changes.end());
+    changes.erase(std::unique(changes.begin(), changes.end()), changes.end());
+    return changes;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void FileWatcher::Watch() {
+#if defined(__linux__)
+    // Inotify isn't recursive, every directory is watched on its own.
+    std::unordered_map<int, std::filesystem::path> directories;
+    auto add_watch = [&](const std::filesystem::path &directory) {
+        constexpr auto kMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+
+        directories[inotify_add_watch(_descriptor, directory.c_str(), kMask)] = directory;
+        std::error_code error;
+        for (auto &entry : std::filesystem::recursive_directory_iterator(directory, error)) {
+            if (entry.is_directory()) {
+                directories[inotify_add_watch(_descriptor, entry.path().c_str(), kMask)] = entry.path();
+            }
+        }
+    };
+    add_watch(_directory);
+
+    alignas(inotify_event) char buffer[4096];
+    while (!_stop) {
+        pollfd descriptor = {_descriptor, POLLIN, 0};
+        auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(kFileWatcherInterval).count();
+        if (poll(&descriptor, 1, static_cast<int>(timeout)) <= 0) {
+            continue;
+        }
+
+        ssize_t size;
+        while ((size = read(_descriptor, buffer, sizeof(buffer))) > 0) {
+            for (auto offset = 0; offset < size;) {
+                auto event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
+
+                auto iter = directories.find(event->wd);
+                if (iter == directories.end() || !event->len) {
+                    continue;
+                }
+
+                auto path = iter->second / event->name;
+                if (event->mask & IN_ISDIR) {
+                    if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                        add_watch(path);
+                    }
+                } else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                    Record(path);
+                }
+            }
+        }
+    }
+#elif !defined(__APPLE__)
+    // Compare modification times with the previous scan.
+    std::unordered_map<std::string, std::filesystem::file_time_type> times;
+    auto scan = [&](bool record) {
+        std::error_code error;
+        for (auto &entry : std::filesystem::recursive_directory_iterator(_directory, error)) {
+            if (!entry.is_regular_file()) {
+                continue;
+            }
+
+            auto time = entry.last_write_time(error);
+            auto [iter, inserted] = times.try_emplace(entry.path().string(), time);
+            if (!inserted && iter->second != time) {
+                iter->second = time;
+                Record(entry.path());
+            } else if (inserted && record) {
+                Record(entry.path());
+            }
+        }
+    };
+
+    scan(false);
+    while (!_stop) {
+        std::this_thread::sleep_for(kFileWatcherInterval);
+        scan(true);
+    }
+#endif
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void FileWatcher::Record(const std::filesystem::path &path) {
+    std::lock_guard lock(_mutex);
+    _changes.push_back(path);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,54 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "frame_allocator.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <stdexcept>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+FrameAllocator::FrameAllocator(void *data, uint64_t frame_size, uint32_t frame_count, uint64_t alignment) :
+_data(static_cast<std::byte*>(data)),
+_frame_size(frame_size & ~(alignment - 1)),
+_frame_count(frame_count),
+_alignment(alignment) {
+    if (!alignment || (alignment & (alignment - 1))) {
+        throw std::runtime_error(fmt::format("Fail to create a frame allocator: {} isn't a power of two.", alignment));
+    }
+
+    if (!_data || !_frame_size || !_frame_count) {
+        throw std::runtime_error("Fail to create a frame allocator: no memory.");
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void FrameAllocator::Reset(uint32_t frame_index) {
+    if (frame_index >= _frame_count) {
+        throw std::runtime_error(fmt::format("Fail to reset a frame allocator: invalid frame {}.", frame_index));
+    }
+
+    _frame_begin = _frame_size * frame_index;
+    _head = _frame_begin;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+FrameAllocation<std::byte> FrameAllocator::Allocate(uint64_t size) {
+    auto offset = (_head + _alignment - 1) & ~(_alignment - 1);
+    if (offset + size > _frame_begin + _frame_size) {
+        throw std::runtime_error(fmt::format("Fail to allocate {} bytes: {} of {} bytes are used.",
+                                             size, GetUsedSize(), _frame_size));
+    }
+
+    _head = offset + size;
+    _peak_size = std::max(_peak_size, GetUsedSize());
+
+    return {_data + offset, offset};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,126 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "frustum.h"
+
+#include <cmath>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Matrix4 Multiply(const Matrix4 &a, const Matrix4 &b) {
+    Matrix4 result = {};
+    for (auto column = 0u; column != 4; ++column) {
+        for (auto row = 0u; row != 4; ++row) {
+            for (auto k = 0u; k != 4; ++k) {
+                result[column * 4 + row] += a[k * 4 + row] * b[column * 4 + k];
+            }
+        }
+    }
+    return result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Matrix4 Invert(const Matrix4 &matrix) {
+    // Expand cofactors by 2x2 minors of the upper and the lower two rows.
+    auto &m = matrix;
+    auto s0 = m[0] * m[5] - m[1] * m[4];
+    auto s1 = m[0] * m[9] - m[1] * m[8];
+    auto s2 = m[0] * m[13] - m[1] * m[12];
+    auto s3 = m[4] * m[9] - m[5] * m[8];
+    auto s4 = m[4] * m[13] - m[5] * m[12];
+    auto s5 = m[8] * m[13] - m[9] * m[12];
+    auto c0 = m[2] * m[7] - m[3] * m[6];
+    auto c1 = m[2] * m[11] - m[3] * m[10];
+    auto c2 = m[2] * m[15] - m[3] * m[14];
+    auto c3 = m[6] * m[11] - m[7] * m[10];
+    auto c4 = m[6] * m[15] - m[7] * m[14];
+    auto c5 = m[10] * m[15] - m[11] * m[14];
+
+    auto determinant = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    if (determinant == 0.0f) {
+        return {};
+    }
+
+    auto inv_determinant = 1.0f / determinant;
+    return {( m[5] * c5 - m[9] * c4 + m[13] * c3) * inv_determinant,
+            (-m[1] * c5 + m[9] * c2 - m[13] * c1) * inv_determinant,
+            ( m[1] * c4 - m[5] * c2 + m[13] * c0) * inv_determinant,
+            (-m[1] * c3 + m[5] * c1 - m[9] * c0) * inv_determinant,
+            (-m[4] * c5 + m[8] * c4 - m[12] * c3) * inv_determinant,
+            ( m[0] * c5 - m[8] * c2 + m[12] * c1) * inv_determinant,
+            (-m[0] * c4 + m[4] * c2 - m[12] * c0) * inv_determinant,
+            ( m[0] * c3 - m[4] * c1 + m[8] * c0) * inv_determinant,
+            ( m[7] * s5 - m[11] * s4 + m[15] * s3) * inv_determinant,
+            (-m[3] * s5 + m[11] * s2 - m[15] * s1) * inv_determinant,
+            ( m[3] * s4 - m[7] * s2 + m[15] * s0) * inv_determinant,
+            (-m[3] * s3 + m[7] * s1 - m[11] * s0) * inv_determinant,
+            (-m[6] * s5 + m[10] * s4 - m[14] * s3) * inv_determinant,
+            ( m[2] * s5 - m[10] * s2 + m[14] * s1) * inv_determinant,
+            (-m[2] * s4 + m[6] * s2 - m[14] * s0) * inv_determinant,
+            ( m[2] * s3 - m[6] * s1 + m[10] * s0) * inv_determinant};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::array<float, 3> GetViewPosition(const Matrix4 &view) {
+    // Rows of the rotation are the axes of a viewer, and the translation is those axes dotted by the negated position.
+    std::array<float, 3> position = {0.0f, 0.0f, 0.0f};
+    for (auto axis = 0u; axis != 3; ++axis) {
+        for (auto k = 0u; k != 3; ++k) {
+            position[k] -= view[k * 4 + axis] * view[12 + axis];
+        }
+    }
+    return position;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Frustum MakeFrustum(const Matrix4 &view_projection) {
+    auto row = [&](uint32_t index) {
+        return Plane{view_projection[index], view_projection[4 + index], view_projection[8 + index],
+                     view_projection[12 + index]};
+    };
+
+    auto x = row(0);
+    auto y = row(1);
+    auto z = row(2);
+    auto w = row(3);
+
+    // Clip space is -w <= x <= w, -w <= y <= w and 0 <= z <= w.
+    Frustum frustum;
+    for (auto i = 0u; i != 4; ++i) {
+        frustum.planes[0][i] = w[i] + x[i];
+        frustum.planes[1][i] = w[i] - x[i];
+        frustum.planes[2][i] = w[i] + y[i];
+        frustum.planes[3][i] = w[i] - y[i];
+        frustum.planes[4][i] = z[i];
+        frustum.planes[5][i] = w[i] - z[i];
+    }
+
+    for (auto &plane : frustum.planes) {
+        auto length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        if (length > 0.0f) {
+            for (auto &value : plane) {
+                value /= length;
+            }
+        }
+    }
+
+    return frustum;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool IsVisible(const Frustum &frustum, const std::array<float, 3> &center, float radius) {
+    for (auto &plane : frustum.planes) {
+        if (plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3] < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
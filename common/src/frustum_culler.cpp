@@ -0,0 +1,269 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "frustum_culler.h"
+
+#include <algorithm>
+#include <cstring>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Eight lanes map to an AVX register, otherwise four lanes map to a SSE or a NEON register on both GCC and Clang.
+#ifdef __AVX__
+constexpr auto kLaneCount = 8u;
+#else
+constexpr auto kLaneCount = 4u;
+#endif
+
+using FloatN = float __attribute__((vector_size(kLaneCount * sizeof(float))));
+using MaskN = int32_t __attribute__((vector_size(kLaneCount * sizeof(int32_t))));
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline auto Splat(float value) {
+    return FloatN{} + value;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline auto Load(const float *values) {
+    // Vectors of std::vector aren't aligned to a register.
+    FloatN vector;
+    std::memcpy(&vector, values, sizeof(vector));
+    return vector;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline auto Append(MaskN mask, size_t index, uint32_t *visible) {
+    // Indices are written unconditionally and only visible ones are kept, so there is no branch to mispredict.
+    auto count = size_t(0);
+    for (auto lane = 0u; lane != kLaneCount; ++lane) {
+        visible[count] = static_cast<uint32_t>(index + lane);
+        count += mask[lane] & 1;
+    }
+    return count;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline bool IsBoxVisible(const Frustum &frustum, const BoundingBoxes &boxes, size_t index) {
+    for (auto &plane : frustum.planes) {
+        // A box is outside of a plane if the corner furthest along the normal is.
+        auto x = plane[0] >= 0.0f ? boxes.max_x[index] : boxes.min_x[index];
+        auto y = plane[1] >= 0.0f ? boxes.max_y[index] : boxes.min_y[index];
+        auto z = plane[2] >= 0.0f ? boxes.max_z[index] : boxes.min_z[index];
+        if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+size_t CullSpheresScalar(const Frustum &frustum, const BoundingSpheres &spheres, size_t begin, size_t end,
+                         uint32_t *visible) {
+    auto count = size_t(0);
+    for (auto i = begin; i != end; ++i) {
+        visible[count] = static_cast<uint32_t>(i);
+        count += IsVisible(frustum, {spheres.center_x[i], spheres.center_y[i], spheres.center_z[i]},
+                           spheres.radius[i]);
+    }
+    return count;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+size_t CullBoxesScalar(const Frustum &frustum, const BoundingBoxes &boxes, size_t begin, size_t end,
+                       uint32_t *visible) {
+    auto count = size_t(0);
+    for (auto i = begin; i != end; ++i) {
+        visible[count] = static_cast<uint32_t>(i);
+        count += IsBoxVisible(frustum, boxes, i);
+    }
+    return count;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+size_t CullSpheresSimd(const Frustum &frustum, const BoundingSpheres &spheres, size_t begin, size_t end,
+                       uint32_t *visible) {
+    std::array<std::array<FloatN, 4>, 6> planes;
+    for (auto i = 0u; i != 6; ++i) {
+        for (auto j = 0u; j != 4; ++j) {
+            planes[i][j] = Splat(frustum.planes[i][j]);
+        }
+    }
+
+    auto count = size_t(0);
+    auto i = begin;
+    for (; i + kLaneCount <= end; i += kLaneCount) {
+        auto x = Load(&spheres.center_x[i]);
+        auto y = Load(&spheres.center_y[i]);
+        auto z = Load(&spheres.center_z[i]);
+        auto r = -Load(&spheres.radius[i]);
+
+        auto mask = MaskN{} - 1;
+        for (auto &plane : planes) {
+            mask &= (plane[0] * x + plane[1] * y + plane[2] * z + plane[3]) >= r;
+        }
+        count += Append(mask, i, visible + count);
+    }
+
+    return count + CullSpheresScalar(frustum, spheres, i, end, visible + count);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+size_t CullBoxesSimd(const Frustum &frustum, const BoundingBoxes &boxes, size_t begin, size_t end,
+                     uint32_t *visible) {
+    // Corners furthest along normals only depend on signs of planes, so they are chosen once for all boxes.
+    struct Corner {
+        std::array<FloatN, 4> plane;
+        std::array<const float *, 3> axes;
+    };
+
+    std::array<Corner, 6> corners;
+    for (auto i = 0u; i != 6; ++i) {
+        auto &plane = frustum.planes[i];
+        for (auto j = 0u; j != 4; ++j) {
+            corners[i].plane[j] = Splat(plane[j]);
+        }
+        corners[i].axes = {plane[0] >= 0.0f ? boxes.max_x.data() : boxes.min_x.data(),
+                           plane[1] >= 0.0f ? boxes.max_y.data() : boxes.min_y.data(),
+                           plane[2] >= 0.0f ? boxes.max_z.data() : boxes.min_z.data()};
+    }
+
+    auto count = size_t(0);
+    auto i = begin;
+    for (; i + kLaneCount <= end; i += kLaneCount) {
+        auto mask = MaskN{} - 1;
+        for (auto &corner : corners) {
+            auto x = Load(corner.axes[0] + i);
+            auto y = Load(corner.axes[1] + i);
+            auto z = Load(corner.axes[2] + i);
+            mask &= (corner.plane[0] * x + corner.plane[1] * y + corner.plane[2] * z + corner.plane[3]) >= 0.0f;
+        }
+        count += Append(mask, i, visible + count);
+    }
+
+    return count + CullBoxesScalar(frustum, boxes, i, end, visible + count);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void BoundingSpheres::Add(const std::array<float, 3> &center, float sphere_radius) {
+    center_x.push_back(center[0]);
+    center_y.push_back(center[1]);
+    center_z.push_back(center[2]);
+    radius.push_back(sphere_radius);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void BoundingBoxes::Add(const std::array<float, 3> &min, const std::array<float, 3> &max) {
+    min_x.push_back(min[0]);
+    min_y.push_back(min[1]);
+    min_z.push_back(min[2]);
+    max_x.push_back(max[0]);
+    max_y.push_back(max[1]);
+    max_z.push_back(max[2]);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+size_t CullSpheres(const Frustum &frustum, const BoundingSpheres &spheres, size_t begin, size_t end,
+                   FrustumCullMode mode, uint32_t *visible) {
+    if (mode == FrustumCullMode::kSimd) {
+        return CullSpheresSimd(frustum, spheres, begin, end, visible);
+    } else {
+        return CullSpheresScalar(frustum, spheres, begin, end, visible);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+size_t CullBoxes(const Frustum &frustum, const BoundingBoxes &boxes, size_t begin, size_t end,
+                 FrustumCullMode mode, uint32_t *visible) {
+    if (mode == FrustumCullMode::kSimd) {
+        return CullBoxesSimd(frustum, boxes, begin, end, visible);
+    } else {
+        return CullBoxesScalar(frustum, boxes, begin, end, visible);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+FrustumCuller::FrustumCuller(JobSystem *job_system, FrustumCullMode mode)
+: _job_system(job_system)
+, _mode(mode) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template<typename F>
+void FrustumCuller::CullChunks(size_t count, std::vector<uint32_t> &visible, F &&function) {
+    auto start_time = std::chrono::steady_clock::now();
+
+    // Every chunk writes visible indices to its own range, which are compacted afterwards.
+    visible.resize(count);
+    auto chunk_count = (count + kFrustumCullChunkSize - 1) / kFrustumCullChunkSize;
+    _chunk_counts.assign(chunk_count, 0);
+
+    auto cull_chunk = [&, data = visible.data()](size_t chunk) {
+        auto begin = chunk * kFrustumCullChunkSize;
+        auto end = std::min(begin + kFrustumCullChunkSize, count);
+        _chunk_counts[chunk] = function(begin, end, data + begin);
+    };
+
+    // The calling thread culls chunks as well instead of waiting idle.
+    _job_system->ParallelFor(static_cast<uint32_t>(chunk_count), 1, [&cull_chunk](uint32_t begin, uint32_t end) {
+        for (auto chunk = begin; chunk != end; ++chunk) {
+            cull_chunk(chunk);
+        }
+    });
+
+    auto visible_count = size_t(0);
+    for (auto chunk = size_t(0); chunk != chunk_count; ++chunk) {
+        auto source = visible.data() + chunk * kFrustumCullChunkSize;
+        if (source != visible.data() + visible_count) {
+            std::memmove(visible.data() + visible_count, source, _chunk_counts[chunk] * sizeof(uint32_t));
+        }
+        visible_count += _chunk_counts[chunk];
+    }
+    visible.resize(visible_count);
+
+    _statistics.tested_count = count;
+    _statistics.visible_count = visible_count;
+    _statistics.chunk_count = static_cast<uint32_t>(chunk_count);
+    _statistics.elapsed_time = std::chrono::steady_clock::now() - start_time;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void FrustumCuller::Cull(const Frustum &frustum, const BoundingSpheres &spheres, std::vector<uint32_t> &visible) {
+    CullChunks(spheres.GetCount(), visible, [&](size_t begin, size_t end, uint32_t *chunk_visible) {
+        return CullSpheres(frustum, spheres, begin, end, _mode, chunk_visible);
+    });
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void FrustumCuller::Cull(const Frustum &frustum, const BoundingBoxes &boxes, std::vector<uint32_t> &visible) {
+    CullChunks(boxes.GetCount(), visible, [&](size_t begin, size_t end, uint32_t *chunk_visible) {
+        return CullBoxes(frustum, boxes, begin, end, _mode, chunk_visible);
+    });
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,67 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "headless.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+
+#include "example.h"
+#include "software_device.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Headless::Headless(const Resolution &resolution) :
+_resolution(resolution) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Headless::MainLoop(Example *example, uint32_t frame_count) {
+    example->Init();
+    example->Resize(_resolution);
+
+    Timer timer;
+    auto min_time = Timer::Duration::max();
+    auto max_time = Timer::Duration::zero();
+    auto total_time = Timer::Duration::zero();
+
+    timer.Start();
+    for (auto i = 0u; i != frame_count; ++i) {
+        // Update and render serially, so every frame is measured alone.
+        example->Update();
+        example->Render();
+
+        // Measure CPU time of a frame.
+        timer.Tick();
+        auto frame_time = timer.GetDeltaTime();
+        min_time = std::min(min_time, frame_time);
+        max_time = std::max(max_time, frame_time);
+        total_time += frame_time;
+    }
+
+    example->Term();
+
+    if (frame_count) {
+        fmt::print("{} frames: {:.3f} ms/frame (min {:.3f} ms, max {:.3f} ms)\n",
+                   frame_count, total_time.count() / frame_count, min_time.count(), max_time.count());
+    }
+
+    // Report the scale dynamic resolution settled at.
+    if (auto dynamic_resolution = example->GetDynamicResolution()) {
+        const auto &statistics = dynamic_resolution->GetStatistics();
+        fmt::print("Render scale: {:.2f} after {} changes, {:.3f} ms/frame\n", dynamic_resolution->GetScale(),
+                   statistics.change_count, statistics.frame_time.count() * 1000.0);
+    }
+
+    // Report throughput of the software rasterizer.
+    if (auto render_device = example->GetRenderDevice(); render_device->GetBackend() == Backend::kSoftware) {
+        const auto &statistics = static_cast<SoftwareDevice*>(render_device)->GetRasterizer()->GetStatistics();
+        fmt::print("{} threads: {:.0f} triangles/s, {:.0f} pixels/s\n",
+                   statistics.thread_count, statistics.GetTrianglesPerSecond(), statistics.GetPixelsPerSecond());
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
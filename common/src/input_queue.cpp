@@ -0,0 +1,65 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "input_queue.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool InputQueue::Push(const InputEvent &event) {
+    auto tail = _tail.load(std::memory_order_relaxed);
+    if (tail - _head.load(std::memory_order_acquire) == kInputQueueCapacity) {
+        _dropped_count.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    _events[tail & (kInputQueueCapacity - 1)] = event;
+    _tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void InputQueue::Drain(std::vector<InputEvent> &events) {
+    auto head = _head.load(std::memory_order_relaxed);
+    auto tail = _tail.load(std::memory_order_acquire);
+    auto first = events.size();
+
+    for (; head != tail; ++head) {
+        auto &event = _events[head & (kInputQueueCapacity - 1)];
+        ++_event_count;
+
+        if (events.size() != first && events.back().type == event.type) {
+            switch (event.type) {
+                case InputEventType::kMouseMove:
+                case InputEventType::kMouseDrag:
+                    events.back() = event;
+                    ++_coalesced_count;
+                    continue;
+                case InputEventType::kMouseWheel:
+                    events.back().delta += event.delta;
+                    ++_coalesced_count;
+                    continue;
+                default:
+                    break;
+            }
+        }
+
+        events.push_back(event);
+    }
+
+    _head.store(head, std::memory_order_release);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+InputQueueStatistics InputQueue::GetStatistics() const {
+    InputQueueStatistics statistics;
+    statistics.event_count = _event_count;
+    statistics.coalesced_count = _coalesced_count;
+    statistics.dropped_count = _dropped_count.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
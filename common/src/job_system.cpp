@@ -0,0 +1,357 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "job_system.h"
+
+#include <algorithm>
+#include <bit>
+#include <exception>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static_assert(std::has_single_bit(kJobDequeCapacity));
+
+// An idle worker yields this many times before it sleeps, jobs of a frame often come in bursts.
+constexpr auto kJobSpinCount = 64u;
+
+// A range is split into this many jobs per thread, so a thread finishing early steals from slow ones.
+constexpr auto kJobsPerThread = 4u;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+thread_local const JobSystem *t_job_system = nullptr;
+thread_local uint32_t t_worker_index = 0;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+
+JobDeque::JobDeque()
+: _jobs(std::make_unique<std::atomic<Job *>[]>(kJobDequeCapacity)) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool JobDeque::Push(Job *job) {
+    auto bottom = _bottom.load(std::memory_order_relaxed);
+    auto top = _top.load(std::memory_order_acquire);
+    if (bottom - top >= static_cast<int64_t>(kJobDequeCapacity)) {
+        return false;
+    }
+
+    _jobs[bottom & (kJobDequeCapacity - 1)].store(job, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    _bottom.store(bottom + 1, std::memory_order_relaxed);
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Job *JobDeque::Pop() {
+    auto bottom = _bottom.load(std::memory_order_relaxed) - 1;
+    _bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto top = _top.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+        _bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    auto job = _jobs[bottom & (kJobDequeCapacity - 1)].load(std::memory_order_relaxed);
+    if (top == bottom) {
+        // The last job, a thief may be taking it at the same time.
+        if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            job = nullptr;
+        }
+        _bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Job *JobDeque::Steal() {
+    auto top = _top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto bottom = _bottom.load(std::memory_order_acquire);
+    if (top >= bottom) {
+        return nullptr;
+    }
+
+    auto job = _jobs[top & (kJobDequeCapacity - 1)].load(std::memory_order_relaxed);
+    if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return job;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+JobSystem::JobSystem(uint32_t thread_count) {
+    if (!thread_count) {
+        thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    for (auto i = 0u; i != thread_count; ++i) {
+        _workers.push_back(std::make_unique<Worker>());
+    }
+
+    // Workers steal from each other, so every worker exists before any starts.
+    for (auto i = 0u; i != thread_count; ++i) {
+        _threads.emplace_back(&JobSystem::Work, this, i);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard lock(_mutex);
+        _stop = true;
+    }
+    _condition.notify_all();
+
+    for (auto &thread : _threads) {
+        thread.join();
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void JobSystem::Run(std::function<void()> function, JobCounter *counter) {
+    if (counter) {
+        counter->_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    Push(new Job{std::move(function), counter});
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void JobSystem::Run(std::function<void()> function, JobCounter *counter, JobCounter &dependency) {
+    if (counter) {
+        counter->_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    auto job = new Job{std::move(function), counter};
+    {
+        std::lock_guard lock(dependency._mutex);
+        if (dependency._count.load(std::memory_order_relaxed)) {
+            dependency._continuations.push_back(job);
+            return;
+        }
+    }
+    Push(job);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void JobSystem::Wait(const JobCounter &counter) {
+    auto index = GetWorkerIndex();
+    while (!counter.IsDone()) {
+        if (auto job = Take(index)) {
+            Execute(job);
+            _helped_count.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    // The last job may still hold a lock of a counter.
+    std::lock_guard lock(counter._mutex);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t grain_size,
+                            const std::function<void(uint32_t, uint32_t)> &function) {
+    if (!count) {
+        return;
+    }
+
+    auto split_count = (GetThreadCount() + 1) * kJobsPerThread;
+    auto job_size = std::max({(count + split_count - 1) / split_count, grain_size, 1u});
+
+    // A job can't throw on a worker, so an exception is kept and thrown on the calling thread.
+    std::mutex mutex;
+    std::exception_ptr exception;
+    auto run = [&](uint32_t begin, uint32_t end) {
+        try {
+            function(begin, end);
+        }
+        catch (...) {
+            std::lock_guard lock(mutex);
+            if (!exception) {
+                exception = std::current_exception();
+            }
+        }
+    };
+
+    JobCounter counter;
+    for (auto begin = job_size; begin < count; begin += std::min(job_size, count - begin)) {
+        auto end = begin + std::min(job_size, count - begin);
+        Run([&run, begin, end]() { run(begin, end); }, &counter);
+    }
+
+    run(0, std::min(job_size, count));
+    Wait(counter);
+
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+JobStatistics JobSystem::GetStatistics() const {
+    JobStatistics statistics;
+    for (auto &worker : _workers) {
+        statistics.executed_count += worker->executed_count.load(std::memory_order_relaxed);
+        statistics.stolen_count += worker->stolen_count.load(std::memory_order_relaxed);
+    }
+    statistics.helped_count = _helped_count.load(std::memory_order_relaxed);
+    statistics.executed_count += statistics.helped_count;
+    return statistics;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void JobSystem::ResetStatistics() {
+    for (auto &worker : _workers) {
+        worker->executed_count.store(0, std::memory_order_relaxed);
+        worker->stolen_count.store(0, std::memory_order_relaxed);
+    }
+    _helped_count.store(0, std::memory_order_relaxed);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void JobSystem::Push(Job *job) {
+    // Counted first, so a worker seeing no queued job before it sleeps is woken up below.
+    _queued_count.fetch_add(1, std::memory_order_seq_cst);
+
+    auto index = GetWorkerIndex();
+    if (index == _workers.size() || !_workers[index]->deque.Push(job)) {
+        std::lock_guard lock(_mutex);
+        _jobs.push_back(job);
+    }
+
+    if (_sleeping_count.load(std::memory_order_seq_cst)) {
+        // A worker checks queued jobs under a lock before it sleeps, so it either sees this job or gets notified.
+        { std::lock_guard lock(_mutex); }
+        _condition.notify_one();
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Job *JobSystem::Take(uint32_t index) {
+    if (!_queued_count.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+
+    auto worker_count = static_cast<uint32_t>(_workers.size());
+    if (index != worker_count) {
+        if (auto job = _workers[index]->deque.Pop()) {
+            _queued_count.fetch_sub(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+
+    {
+        std::lock_guard lock(_mutex);
+        if (!_jobs.empty()) {
+            auto job = _jobs.front();
+            _jobs.pop_front();
+            _queued_count.fetch_sub(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+
+    // Victims start after the calling worker, so thieves spread over workers instead of piling on the first one.
+    for (auto i = 1u; i <= worker_count; ++i) {
+        auto victim = (index + i) % (worker_count + 1);
+        if (victim == worker_count) {
+            continue;
+        }
+
+        if (auto job = _workers[victim]->deque.Steal()) {
+            _queued_count.fetch_sub(1, std::memory_order_relaxed);
+            if (index != worker_count) {
+                _workers[index]->stolen_count.fetch_add(1, std::memory_order_relaxed);
+            }
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void JobSystem::Execute(Job *job) {
+    job->function();
+
+    if (auto counter = job->counter) {
+        std::vector<Job *> continuations;
+        {
+            std::lock_guard lock(counter->_mutex);
+            if (counter->_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                continuations.swap(counter->_continuations);
+            }
+        }
+
+        for (auto continuation : continuations) {
+            Push(continuation);
+        }
+    }
+    delete job;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void JobSystem::Work(uint32_t index) {
+    t_job_system = this;
+    t_worker_index = index;
+
+    auto &worker = *_workers[index];
+    while (true) {
+        if (auto job = Take(index)) {
+            Execute(job);
+            worker.executed_count.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
+        auto queued = false;
+        for (auto i = 0u; i != kJobSpinCount && !queued; ++i) {
+            std::this_thread::yield();
+            queued = _queued_count.load(std::memory_order_relaxed);
+        }
+        if (queued) {
+            continue;
+        }
+
+        _sleeping_count.fetch_add(1, std::memory_order_seq_cst);
+        std::unique_lock lock(_mutex);
+        _condition.wait(lock, [this]() { return _stop || _queued_count.load(std::memory_order_seq_cst); });
+        _sleeping_count.fetch_sub(1, std::memory_order_relaxed);
+        if (_stop && !_queued_count.load(std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+uint32_t JobSystem::GetWorkerIndex() const {
+    return t_job_system == this ? t_worker_index : static_cast<uint32_t>(_workers.size());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,98 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "lod.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// A level which removes fewer triangles than this isn't worth its indices.
+constexpr auto kMinLodReduction = 0.9f;
+
+// A viewer inside a bounding sphere is treated as this close to an object.
+constexpr auto kMinLodDistance = 1e-3f;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+
+LodChain BuildLodChain(const Mesh &mesh, uint32_t max_level_count, float reduction) {
+    LodChain chain;
+    chain.indices = mesh.indices;
+    chain.levels.push_back({0, static_cast<uint32_t>(mesh.indices.size()), 0.0f});
+
+    std::vector<uint32_t> indices = mesh.indices;
+    auto error = 0.0f;
+
+    while (chain.levels.size() < std::min(max_level_count, kMaxLodCount)) {
+        auto target_index_count = static_cast<size_t>(static_cast<float>(indices.size() / 3) * reduction) * 3;
+        auto result = SimplifyMesh(mesh, indices, target_index_count);
+        if (result.indices.empty() ||
+            static_cast<float>(result.indices.size()) > static_cast<float>(indices.size()) * kMinLodReduction) {
+            break;
+        }
+
+        // An error is measured from the previous level, so errors of levels add up.
+        error += result.error;
+        indices = std::move(result.indices);
+        OptimizeVertexCache(indices, mesh.vertices.size());
+
+        chain.levels.push_back({static_cast<uint32_t>(chain.indices.size()), static_cast<uint32_t>(indices.size()),
+                                error});
+        chain.indices.insert(chain.indices.end(), indices.begin(), indices.end());
+    }
+
+    return chain;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+LodView MakeLodView(const std::array<float, 3> &position, float fov, float viewport_height, float threshold) {
+    LodView view;
+    view.position = position;
+    view.pixel_scale = viewport_height / (2.0f * std::tan(fov * 0.5f));
+    view.threshold = threshold;
+    return view;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+uint32_t SelectLod(const LodView &view, const LodObject &object, const LodChain &chain) {
+    auto dx = object.center[0] - view.position[0];
+    auto dy = object.center[1] - view.position[1];
+    auto dz = object.center[2] - view.position[2];
+    auto distance = std::max(std::sqrt(dx * dx + dy * dy + dz * dz) - object.radius, kMinLodDistance);
+
+    // An error is accepted if error * scale * pixel_scale / distance <= threshold.
+    auto max_error = view.threshold * distance / (view.pixel_scale * object.scale);
+
+    auto level = static_cast<uint32_t>(chain.levels.size()) - 1;
+    while (level && chain.levels[level].error > max_error) {
+        --level;
+    }
+    return level;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void SelectLods(const LodView &view, std::span<const LodObject> objects, std::span<const LodChain> chains,
+                std::span<uint8_t> levels) {
+    for (auto i = size_t(0); i != objects.size(); ++i) {
+        levels[i] = static_cast<uint8_t>(SelectLod(view, objects[i], chains[objects[i].chain]));
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,1035 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "mesh.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+
+#include "file_view.h"
+#include "frustum.h"
+#include "job_system.h"
+#include "mesh_optimizer.h"
+#include "vector3.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Small files are parsed on one thread, splitting them costs more than it saves.
+constexpr auto kObjMinChunkSize = 1u << 20;
+constexpr auto kObjChunksPerThread = 4u;
+
+// A parallel loop splits work into tasks of this many items at least.
+constexpr auto kMinTaskSize = 1u << 14;
+
+constexpr auto kGlbMagic = 0x46546c67u;
+constexpr auto kGlbVersion = 2u;
+constexpr auto kGlbJsonChunk = 0x4e4f534au;
+constexpr auto kGlbBinaryChunk = 0x004e4942u;
+constexpr auto kGltfTriangles = 4u;
+constexpr auto kGltfUnsignedByte = 5121u;
+constexpr auto kGltfUnsignedShort = 5123u;
+constexpr auto kGltfUnsignedInt = 5125u;
+constexpr auto kGltfFloat = 5126u;
+
+constexpr auto kMaxUInt16VertexCount = 1u << 16;
+constexpr auto kInvalidIndex = ~0u;
+constexpr auto kMissingIndex = std::numeric_limits<int32_t>::min();
+
+//----------------------------------------------------------------------------------------------------------------------
+
+using Vector2 = std::array<float, 2>;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr Matrix4 kIdentity = {1.0f, 0.0f, 0.0f, 0.0f,
+                               0.0f, 1.0f, 0.0f, 0.0f,
+                               0.0f, 0.0f, 1.0f, 0.0f,
+                               0.0f, 0.0f, 0.0f, 1.0f};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Vector3 TransformPoint(const Matrix4 &m, const Vector3 &p) {
+    return {m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12],
+            m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13],
+            m[2] * p[0] + m[6] * p[1] + m[10] * p[2] + m[14]};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Transform a normal with the cofactor of the upper 3x3 matrix, it keeps normals perpendicular under any scale.
+Vector3 TransformNormal(const Matrix4 &m, const Vector3 &n) {
+    Vector3 x = {m[0], m[1], m[2]};
+    Vector3 y = {m[4], m[5], m[6]};
+    Vector3 z = {m[8], m[9], m[10]};
+    auto cx = Cross(y, z);
+    auto cy = Cross(z, x);
+    auto cz = Cross(x, y);
+    return Normalize({cx[0] * n[0] + cy[0] * n[1] + cz[0] * n[2],
+                      cx[1] * n[0] + cy[1] * n[1] + cz[1] * n[2],
+                      cx[2] * n[0] + cy[2] * n[1] + cz[2] * n[2]});
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+MeshVertex MakeMeshVertex(const Vector3 &position, const Vector3 &normal, const Vector2 &tex_coord) {
+    return MeshLayout::MakeVertex(position, {normal[0], normal[1], normal[2], 0.0f}, tex_coord);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Accumulate area weighted face normals of triangles into their vertices.
+void AccumulateNormals(std::span<const Vector3> positions, std::span<const uint32_t> indices,
+                       std::span<Vector3> normals) {
+    for (auto i = 0u; i + 2 < indices.size(); i += 3) {
+        auto &p0 = positions[indices[i + 0]];
+        auto normal = Cross(Subtract(positions[indices[i + 1]], p0), Subtract(positions[indices[i + 2]], p0));
+        for (auto j = 0u; j != 3; ++j) {
+            for (auto k = 0u; k != 3; ++k) {
+                normals[indices[i + j]][k] += normal[k];
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void SkipSpaces(const char *&cursor, const char *end) {
+    while (cursor != end && IsSpace(*cursor)) {
+        ++cursor;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void SkipLine(const char *&cursor, const char *end) {
+    cursor = static_cast<const char*>(std::memchr(cursor, '\n', end - cursor));
+    cursor = cursor ? cursor + 1 : end;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool IsDigit(const char *cursor, const char *end) {
+    return cursor != end && *cursor >= '0' && *cursor <= '9';
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Parse a decimal number in place. Digits beyond the precision of a double are only counted to the exponent.
+float ParseFloat(const char *&cursor, const char *end) {
+    static constexpr double kPowers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                         1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    SkipSpaces(cursor, end);
+
+    auto negative = false;
+    if (cursor != end && (*cursor == '-' || *cursor == '+')) {
+        negative = *cursor++ == '-';
+    }
+
+    auto mantissa = uint64_t(0);
+    auto exponent = 0;
+    auto digit_count = 0;
+
+    for (; IsDigit(cursor, end); ++cursor, ++digit_count) {
+        if (mantissa < 1000000000000000000ull) {
+            mantissa = mantissa * 10 + (*cursor - '0');
+        } else {
+            ++exponent;
+        }
+    }
+
+    if (cursor != end && *cursor == '.') {
+        for (++cursor; IsDigit(cursor, end); ++cursor, ++digit_count) {
+            if (mantissa < 1000000000000000000ull) {
+                mantissa = mantissa * 10 + (*cursor - '0');
+                --exponent;
+            }
+        }
+    }
+
+    if (!digit_count) {
+        throw std::runtime_error("a number is expected");
+    }
+
+    if (cursor != end && (*cursor == 'e' || *cursor == 'E')) {
+        ++cursor;
+        auto negative_exponent = false;
+        if (cursor != end && (*cursor == '-' || *cursor == '+')) {
+            negative_exponent = *cursor++ == '-';
+        }
+
+        auto value = 0;
+        for (; IsDigit(cursor, end); ++cursor) {
+            value = std::min(value * 10 + (*cursor - '0'), 1000);
+        }
+        exponent += negative_exponent ? -value : value;
+    }
+
+    auto value = static_cast<double>(mantissa);
+    if (exponent < 0) {
+        value = -exponent <= 22 ? value / kPowers[-exponent] : value * std::pow(10.0, exponent);
+    } else if (exponent > 0) {
+        value = exponent <= 22 ? value * kPowers[exponent] : value * std::pow(10.0, exponent);
+    }
+
+    return static_cast<float>(negative ? -value : value);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int32_t ParseInt(const char *&cursor, const char *end) {
+    auto negative = false;
+    if (cursor != end && (*cursor == '-' || *cursor == '+')) {
+        negative = *cursor++ == '-';
+    }
+
+    if (!IsDigit(cursor, end)) {
+        throw std::runtime_error("an index is expected");
+    }
+
+    auto value = int64_t(0);
+    for (; IsDigit(cursor, end); ++cursor) {
+        value = std::min<int64_t>(value * 10 + (*cursor - '0'), std::numeric_limits<int32_t>::max());
+    }
+
+    return static_cast<int32_t>(negative ? -value : value);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A corner of a face refers to attributes by indices from 0, or kMissingIndex. An index from the end of attributes
+//! can't be resolved until the number of attributes in previous chunks is known, so it is relative to a chunk.
+struct ObjCorner {
+    std::array<int32_t, 3> indices = {kMissingIndex, kMissingIndex, kMissingIndex};
+    uint8_t relative_mask = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct ObjChunk {
+    std::vector<Vector3> positions;
+    std::vector<Vector2> tex_coords;
+    std::vector<Vector3> normals;
+    std::vector<ObjCorner> corners;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+ObjCorner ParseObjCorner(const char *&cursor, const char *end, const std::array<size_t, 3> &counts) {
+    ObjCorner corner;
+
+    for (auto i = 0u; i != 3; ++i) {
+        // A texture coordinate is omitted as in "1//1".
+        if (i && (cursor == end || *cursor != '/')) {
+            break;
+        }
+        if (i) {
+            ++cursor;
+        }
+        if (i == 1 && cursor != end && *cursor == '/') {
+            continue;
+        }
+
+        auto index = ParseInt(cursor, end);
+        if (index > 0) {
+            corner.indices[i] = index - 1;
+        } else if (index < 0) {
+            corner.indices[i] = static_cast<int32_t>(counts[i]) + index;
+            corner.relative_mask |= 1u << i;
+        } else {
+            throw std::runtime_error("an index is zero");
+        }
+    }
+
+    return corner;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+ObjChunk ParseObjChunk(std::string_view text) {
+    ObjChunk chunk;
+    std::vector<ObjCorner> polygon;
+
+    auto cursor = text.data();
+    auto end = text.data() + text.size();
+
+    while (cursor != end) {
+        SkipSpaces(cursor, end);
+        if (cursor == end) {
+            break;
+        }
+
+        if (cursor[0] == 'v' && end - cursor > 1 && IsSpace(cursor[1])) {
+            cursor += 1;
+            auto x = ParseFloat(cursor, end);
+            auto y = ParseFloat(cursor, end);
+            auto z = ParseFloat(cursor, end);
+            chunk.positions.push_back({x, y, z});
+        } else if (cursor[0] == 'v' && end - cursor > 2 && cursor[1] == 't' && IsSpace(cursor[2])) {
+            cursor += 2;
+            auto u = ParseFloat(cursor, end);
+            auto v = ParseFloat(cursor, end);
+            // OBJ puts the origin of texture coordinates at the bottom left.
+            chunk.tex_coords.push_back({u, 1.0f - v});
+        } else if (cursor[0] == 'v' && end - cursor > 2 && cursor[1] == 'n' && IsSpace(cursor[2])) {
+            cursor += 2;
+            auto x = ParseFloat(cursor, end);
+            auto y = ParseFloat(cursor, end);
+            auto z = ParseFloat(cursor, end);
+            chunk.normals.push_back({x, y, z});
+        } else if (cursor[0] == 'f' && end - cursor > 1 && IsSpace(cursor[1])) {
+            cursor += 1;
+            polygon.clear();
+
+            std::array<size_t, 3> counts = {chunk.positions.size(), chunk.tex_coords.size(), chunk.normals.size()};
+            for (SkipSpaces(cursor, end); cursor != end && *cursor != '\n'; SkipSpaces(cursor, end)) {
+                polygon.push_back(ParseObjCorner(cursor, end, counts));
+            }
+
+            // Triangulate a polygon as a fan.
+            for (auto i = size_t(2); i < polygon.size(); ++i) {
+                chunk.corners.push_back(polygon[0]);
+                chunk.corners.push_back(polygon[i - 1]);
+                chunk.corners.push_back(polygon[i]);
+            }
+        }
+
+        // Comments, groups, materials and the rest of a line are skipped.
+        SkipLine(cursor, end);
+    }
+
+    return chunk;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Mesh LoadObj(JobSystem &job_system, std::string_view text) {
+    // Split text into chunks at line boundaries.
+    auto chunk_count = std::clamp<size_t>(text.size() / kObjMinChunkSize, 1,
+                                          (job_system.GetThreadCount() + 1) * kObjChunksPerThread);
+
+    std::vector<std::string_view> chunk_texts;
+    for (auto begin = size_t(0); begin < text.size();) {
+        auto end = std::min(begin + text.size() / chunk_count + 1, text.size());
+        end = std::min(text.find('\n', end), text.size());
+        end = end == text.size() ? end : end + 1;
+
+        chunk_texts.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
+
+    std::vector<ObjChunk> chunks(chunk_texts.size());
+    job_system.ParallelFor(static_cast<uint32_t>(chunks.size()), 1, [&](uint32_t begin, uint32_t end) {
+        for (auto i = begin; i != end; ++i) {
+            chunks[i] = ParseObjChunk(chunk_texts[i]);
+        }
+    });
+
+    // Merge attributes and resolve indices relative to chunks.
+    std::vector<Vector3> positions;
+    std::vector<Vector2> tex_coords;
+    std::vector<Vector3> normals;
+    std::vector<ObjCorner> corners;
+
+    for (auto &chunk : chunks) {
+        std::array<int64_t, 3> bases = {static_cast<int64_t>(positions.size()),
+                                        static_cast<int64_t>(tex_coords.size()),
+                                        static_cast<int64_t>(normals.size())};
+
+        for (auto &corner : chunk.corners) {
+            for (auto i = 0u; i != 3; ++i) {
+                if (corner.relative_mask & (1u << i)) {
+                    corner.indices[i] = static_cast<int32_t>(bases[i] + corner.indices[i]);
+                }
+            }
+        }
+
+        positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+        tex_coords.insert(tex_coords.end(), chunk.tex_coords.begin(), chunk.tex_coords.end());
+        normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+        corners.insert(corners.end(), chunk.corners.begin(), chunk.corners.end());
+        chunk = {};
+    }
+
+    // Every distinct combination of attributes is a vertex, the combinations of a position are chained.
+    std::array<size_t, 3> counts = {positions.size(), tex_coords.size(), normals.size()};
+    std::vector<uint32_t> first_vertices(positions.size(), kInvalidIndex);
+    std::vector<uint32_t> next_vertices;
+    std::vector<ObjCorner> vertex_corners;
+
+    Mesh mesh;
+    mesh.indices.reserve(corners.size());
+
+    for (auto &corner : corners) {
+        for (auto i = 0u; i != 3; ++i) {
+            auto index = corner.indices[i];
+            if ((i == 0 || index != kMissingIndex) && (index < 0 || static_cast<size_t>(index) >= counts[i])) {
+                throw std::runtime_error("an index is out of range");
+            }
+        }
+
+        auto &first_vertex = first_vertices[corner.indices[0]];
+        auto vertex = first_vertex;
+        while (vertex != kInvalidIndex && vertex_corners[vertex].indices != corner.indices) {
+            vertex = next_vertices[vertex];
+        }
+
+        if (vertex == kInvalidIndex) {
+            vertex = static_cast<uint32_t>(vertex_corners.size());
+            vertex_corners.push_back(corner);
+            next_vertices.push_back(first_vertex);
+            first_vertex = vertex;
+        }
+
+        mesh.indices.push_back(vertex);
+    }
+
+    // Smooth normals are generated by positions when a vertex doesn't have a normal.
+    std::vector<Vector3> position_normals;
+    auto has_missing_normal = std::any_of(vertex_corners.begin(), vertex_corners.end(), [](const ObjCorner &corner) {
+        return corner.indices[2] == kMissingIndex;
+    });
+
+    if (has_missing_normal) {
+        std::vector<uint32_t> position_indices(mesh.indices.size());
+        for (auto i = size_t(0); i != mesh.indices.size(); ++i) {
+            position_indices[i] = vertex_corners[mesh.indices[i]].indices[0];
+        }
+
+        position_normals.resize(positions.size(), {0.0f, 0.0f, 0.0f});
+        AccumulateNormals(positions, position_indices, position_normals);
+    }
+
+    mesh.vertices.resize(vertex_corners.size());
+    auto vertex_count = static_cast<uint32_t>(vertex_corners.size());
+    job_system.ParallelFor(vertex_count, kMinTaskSize, [&](uint32_t begin, uint32_t end) {
+        for (auto i = begin; i != end; ++i) {
+            auto &indices = vertex_corners[i].indices;
+            auto normal = indices[2] != kMissingIndex ? normals[indices[2]] : position_normals[indices[0]];
+            auto tex_coord = indices[1] != kMissingIndex ? tex_coords[indices[1]] : Vector2{0.0f, 0.0f};
+            mesh.vertices[i] = MakeMeshVertex(positions[indices[0]], Normalize(normal), tex_coord);
+        }
+    });
+
+    return mesh;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A view of a JSON value in text. Values are found by scanning text on demand, nothing is copied.
+class JsonValue {
+public:
+    JsonValue() = default;
+
+    explicit JsonValue(std::string_view text) :
+    _text(text) {
+    }
+
+    //! Retrieve a member of an object.
+    JsonValue operator[](std::string_view key) const {
+        JsonValue result;
+        ForEach('{', '}', [&](std::string_view member_key, JsonValue value) {
+            if (member_key == key) {
+                result = value;
+                return false;
+            }
+            return true;
+        });
+        return result;
+    }
+
+    //! Retrieve an element of an array.
+    JsonValue operator[](size_t index) const {
+        JsonValue result;
+        ForEach('[', ']', [&](std::string_view, JsonValue value) {
+            if (!index--) {
+                result = value;
+                return false;
+            }
+            return true;
+        });
+        return result;
+    }
+
+    //! Retrieve the number of elements of an array.
+    [[nodiscard]]
+    size_t GetSize() const {
+        auto size = size_t(0);
+        ForEach('[', ']', [&](std::string_view, JsonValue) {
+            ++size;
+            return true;
+        });
+        return size;
+    }
+
+    [[nodiscard]]
+    double GetNumber(double default_value = 0.0) const {
+        if (!IsValid()) {
+            return default_value;
+        }
+
+        auto cursor = _text.data();
+        return ParseFloat(cursor, _text.data() + _text.size());
+    }
+
+    [[nodiscard]]
+    bool GetBool(bool default_value = false) const {
+        return IsValid() ? _text == "true" : default_value;
+    }
+
+    //! Retrieve a string without resolving escapes.
+    [[nodiscard]]
+    std::string_view GetString() const {
+        return _text.size() >= 2 && _text.front() == '"' ? _text.substr(1, _text.size() - 2) : std::string_view();
+    }
+
+    [[nodiscard]]
+    inline bool IsValid() const {
+        return !_text.empty();
+    }
+
+private:
+    static size_t SkipSpaces(std::string_view text, size_t position) {
+        while (position < text.size() && text[position] && std::strchr(" \t\r\n", text[position])) {
+            ++position;
+        }
+        return position;
+    }
+
+    //! Find the end of a value starts at a position.
+    static size_t SkipValue(std::string_view text, size_t position) {
+        auto depth = 0;
+        do {
+            if (position >= text.size()) {
+                throw std::runtime_error("JSON is truncated");
+            }
+
+            auto c = text[position];
+            if (c == '"') {
+                for (++position; position < text.size() && text[position] != '"'; ++position) {
+                    position += text[position] == '\\';
+                }
+                ++position;
+            } else if (c == '{' || c == '[') {
+                ++depth;
+                ++position;
+            } else if (c == '}' || c == ']') {
+                --depth;
+                ++position;
+            } else if (depth) {
+                ++position;
+            } else {
+                while (position < text.size() && !std::strchr(",}] \t\r\n", text[position])) {
+                    ++position;
+                }
+            }
+        } while (depth > 0);
+
+        return position;
+    }
+
+    //! Visit members or elements until a function returns false.
+    template<typename F>
+    void ForEach(char open, char close, F &&function) const {
+        if (_text.empty() || _text.front() != open) {
+            return;
+        }
+
+        auto position = SkipSpaces(_text, 1);
+        while (position < _text.size() && _text[position] != close) {
+            std::string_view key;
+            if (open == '{') {
+                auto key_end = SkipValue(_text, position);
+                key = _text.substr(position + 1, key_end - position - 2);
+                position = SkipSpaces(_text, key_end);
+                if (position >= _text.size() || _text[position] != ':') {
+                    throw std::runtime_error("JSON is malformed");
+                }
+                position = SkipSpaces(_text, position + 1);
+            }
+
+            auto value_end = SkipValue(_text, position);
+            if (!function(key, JsonValue(_text.substr(position, value_end - position)))) {
+                return;
+            }
+
+            position = SkipSpaces(_text, value_end);
+            if (position < _text.size() && _text[position] == ',') {
+                position = SkipSpaces(_text, position + 1);
+            }
+        }
+    }
+
+private:
+    std::string_view _text;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct GltfAccessor {
+    const std::byte *data = nullptr;
+    size_t count = 0;
+    size_t stride = 0;
+    uint32_t component_type = 0;
+    uint32_t component_count = 0;
+    bool normalized = false;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+uint32_t GetComponentSize(uint32_t component_type) {
+    switch (component_type) {
+        case kGltfUnsignedByte:
+            return 1;
+        case kGltfUnsignedShort:
+            return 2;
+        case kGltfUnsignedInt:
+        case kGltfFloat:
+            return 4;
+        default:
+            throw std::runtime_error(fmt::format("a component type {} isn't supported", component_type));
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+GltfAccessor GetAccessor(const JsonValue &json, std::span<const std::byte> binary, const JsonValue &index) {
+    auto accessor = json["accessors"][static_cast<size_t>(index.GetNumber())];
+    if (!accessor.IsValid() || accessor["sparse"].IsValid()) {
+        throw std::runtime_error("an accessor isn't supported");
+    }
+
+    auto buffer_view = json["bufferViews"][static_cast<size_t>(accessor["bufferView"].GetNumber(-1.0))];
+    if (!buffer_view.IsValid() || static_cast<size_t>(buffer_view["buffer"].GetNumber()) != 0 ||
+        json["buffers"][0]["uri"].IsValid()) {
+        throw std::runtime_error("only an embedded buffer is supported");
+    }
+
+    auto type = accessor["type"].GetString();
+    GltfAccessor result;
+    result.count = static_cast<size_t>(accessor["count"].GetNumber());
+    result.component_type = static_cast<uint32_t>(accessor["componentType"].GetNumber());
+    result.component_count = type == "SCALAR" ? 1 : type == "VEC2" ? 2 : type == "VEC3" ? 3 : type == "VEC4" ? 4 : 0;
+    result.normalized = accessor["normalized"].GetBool();
+
+    auto element_size = GetComponentSize(result.component_type) * result.component_count;
+    auto offset = static_cast<size_t>(buffer_view["byteOffset"].GetNumber() + accessor["byteOffset"].GetNumber());
+    result.stride = static_cast<size_t>(buffer_view["byteStride"].GetNumber(element_size));
+    result.data = binary.data() + offset;
+
+    if (!element_size || (result.count && offset + result.stride * (result.count - 1) + element_size > binary.size())) {
+        throw std::runtime_error("an accessor is out of range");
+    }
+
+    return result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+float ReadComponent(const GltfAccessor &accessor, size_t index, uint32_t component) {
+    auto data = accessor.data + index * accessor.stride;
+
+    switch (accessor.component_type) {
+        case kGltfUnsignedByte: {
+            auto value = static_cast<float>(std::to_integer<uint8_t>(data[component]));
+            return accessor.normalized ? value / 255.0f : value;
+        }
+        case kGltfUnsignedShort: {
+            uint16_t value;
+            std::memcpy(&value, data + component * sizeof(value), sizeof(value));
+            return accessor.normalized ? value / 65535.0f : value;
+        }
+        case kGltfUnsignedInt: {
+            uint32_t value;
+            std::memcpy(&value, data + component * sizeof(value), sizeof(value));
+            return static_cast<float>(value);
+        }
+        default: {
+            float value;
+            std::memcpy(&value, data + component * sizeof(value), sizeof(value));
+            return value;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+uint32_t ReadIndex(const GltfAccessor &accessor, size_t index) {
+    auto data = accessor.data + index * accessor.stride;
+
+    switch (accessor.component_type) {
+        case kGltfUnsignedByte:
+            return std::to_integer<uint32_t>(data[0]);
+        case kGltfUnsignedShort: {
+            uint16_t value;
+            std::memcpy(&value, data, sizeof(value));
+            return value;
+        }
+        case kGltfUnsignedInt: {
+            uint32_t value;
+            std::memcpy(&value, data, sizeof(value));
+            return value;
+        }
+        default:
+            throw std::runtime_error("an index type isn't supported");
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Matrix4 GetNodeTransform(const JsonValue &node) {
+    Matrix4 transform = kIdentity;
+
+    if (auto matrix = node["matrix"]; matrix.IsValid()) {
+        for (auto i = 0u; i != 16; ++i) {
+            transform[i] = static_cast<float>(matrix[i].GetNumber());
+        }
+        return transform;
+    }
+
+    auto translation = node["translation"];
+    auto rotation = node["rotation"];
+    auto scale = node["scale"];
+
+    auto x = static_cast<float>(rotation[0].GetNumber(0.0));
+    auto y = static_cast<float>(rotation[1].GetNumber(0.0));
+    auto z = static_cast<float>(rotation[2].GetNumber(0.0));
+    auto w = static_cast<float>(rotation[3].GetNumber(1.0));
+
+    // A translation, rotation and scale are composed as T * R * S.
+    Matrix4 rotation_matrix = {1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w), 0.0f,
+                               2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w), 0.0f,
+                               2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y), 0.0f,
+                               0.0f, 0.0f, 0.0f, 1.0f};
+
+    for (auto column = 0u; column != 3; ++column) {
+        auto s = static_cast<float>(scale[column].GetNumber(1.0));
+        for (auto row = 0u; row != 3; ++row) {
+            transform[column * 4 + row] = rotation_matrix[column * 4 + row] * s;
+        }
+        transform[12 + column] = static_cast<float>(translation[column].GetNumber(0.0));
+    }
+
+    return transform;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct GltfPrimitive {
+    JsonValue primitive;
+    Matrix4 transform = kIdentity;
+    size_t vertex_offset = 0;
+    size_t index_offset = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void CollectPrimitives(const JsonValue &json, size_t mesh_index, const Matrix4 &transform,
+                       std::vector<GltfPrimitive> &primitives) {
+    auto mesh_primitives = json["meshes"][mesh_index]["primitives"];
+    for (auto i = size_t(0); i != mesh_primitives.GetSize(); ++i) {
+        auto primitive = mesh_primitives[i];
+        if (static_cast<uint32_t>(primitive["mode"].GetNumber(kGltfTriangles)) == kGltfTriangles) {
+            primitives.push_back({primitive, transform});
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void CollectNodePrimitives(const JsonValue &json, size_t node_index, const Matrix4 &parent_transform,
+                           uint32_t depth, std::vector<GltfPrimitive> &primitives) {
+    // Nodes form a tree, a deep chain means a cycle in a broken file.
+    if (depth > 64) {
+        throw std::runtime_error("nodes are too deep");
+    }
+
+    auto node = json["nodes"][node_index];
+    auto transform = Multiply(parent_transform, GetNodeTransform(node));
+
+    if (auto mesh = node["mesh"]; mesh.IsValid()) {
+        CollectPrimitives(json, static_cast<size_t>(mesh.GetNumber()), transform, primitives);
+    }
+
+    auto children = node["children"];
+    for (auto i = size_t(0); i != children.GetSize(); ++i) {
+        CollectNodePrimitives(json, static_cast<size_t>(children[i].GetNumber()), transform, depth + 1, primitives);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void DecodePrimitive(const JsonValue &json, std::span<const std::byte> binary, const GltfPrimitive &primitive,
+                     Mesh &mesh) {
+    auto attributes = primitive.primitive["attributes"];
+    auto positions = GetAccessor(json, binary, attributes["POSITION"]);
+    if (positions.component_type != kGltfFloat || positions.component_count != 3) {
+        throw std::runtime_error("positions must be floats");
+    }
+
+    std::vector<Vector3> transformed_positions(positions.count);
+    for (auto i = size_t(0); i != positions.count; ++i) {
+        Vector3 position = {ReadComponent(positions, i, 0), ReadComponent(positions, i, 1),
+                            ReadComponent(positions, i, 2)};
+        transformed_positions[i] = TransformPoint(primitive.transform, position);
+    }
+
+    auto indices = std::span(mesh.indices).subspan(primitive.index_offset);
+    if (auto index_accessor = primitive.primitive["indices"]; index_accessor.IsValid()) {
+        auto accessor = GetAccessor(json, binary, index_accessor);
+        for (auto i = size_t(0); i != accessor.count; ++i) {
+            auto index = ReadIndex(accessor, i);
+            if (index >= positions.count) {
+                throw std::runtime_error("an index is out of range");
+            }
+            indices[i] = index;
+        }
+        indices = indices.first(accessor.count);
+    } else {
+        for (auto i = size_t(0); i != positions.count; ++i) {
+            indices[i] = static_cast<uint32_t>(i);
+        }
+        indices = indices.first(positions.count);
+    }
+
+    // Normals are generated from triangles when a primitive doesn't have them.
+    std::vector<Vector3> normals(positions.count, {0.0f, 0.0f, 0.0f});
+    if (auto normal_accessor = attributes["NORMAL"]; normal_accessor.IsValid()) {
+        auto accessor = GetAccessor(json, binary, normal_accessor);
+        for (auto i = size_t(0); i != std::min(accessor.count, positions.count); ++i) {
+            normals[i] = TransformNormal(primitive.transform, {ReadComponent(accessor, i, 0),
+                                                               ReadComponent(accessor, i, 1),
+                                                               ReadComponent(accessor, i, 2)});
+        }
+    } else {
+        AccumulateNormals(transformed_positions, indices, normals);
+    }
+
+    std::vector<Vector2> tex_coords(positions.count, {0.0f, 0.0f});
+    if (auto tex_coord_accessor = attributes["TEXCOORD_0"]; tex_coord_accessor.IsValid()) {
+        auto accessor = GetAccessor(json, binary, tex_coord_accessor);
+        for (auto i = size_t(0); i != std::min(accessor.count, positions.count); ++i) {
+            tex_coords[i] = {ReadComponent(accessor, i, 0), ReadComponent(accessor, i, 1)};
+        }
+    }
+
+    // Indices of a primitive are made relative to the whole mesh.
+    for (auto &index : indices) {
+        index += static_cast<uint32_t>(primitive.vertex_offset);
+    }
+
+    for (auto i = size_t(0); i != positions.count; ++i) {
+        mesh.vertices[primitive.vertex_offset + i] = MakeMeshVertex(transformed_positions[i], Normalize(normals[i]),
+                                                                    tex_coords[i]);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+uint32_t ReadUInt32(std::span<const std::byte> bytes, size_t offset) {
+    if (offset + sizeof(uint32_t) > bytes.size()) {
+        throw std::runtime_error("it is truncated");
+    }
+
+    uint32_t value;
+    std::memcpy(&value, bytes.data() + offset, sizeof(value));
+    return value;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Mesh LoadGlb(JobSystem &job_system, std::span<const std::byte> bytes) {
+    if (ReadUInt32(bytes, 0) != kGlbMagic || ReadUInt32(bytes, 4) != kGlbVersion) {
+        throw std::runtime_error("the format is unknown");
+    }
+
+    // Chunks are a JSON chunk and an optional binary chunk.
+    std::string_view text;
+    std::span<const std::byte> binary;
+    for (auto offset = size_t(12); offset < std::min<size_t>(ReadUInt32(bytes, 8), bytes.size());) {
+        auto size = ReadUInt32(bytes, offset);
+        auto type = ReadUInt32(bytes, offset + 4);
+        if (offset + 8 + size > bytes.size()) {
+            throw std::runtime_error("it is truncated");
+        }
+
+        auto data = bytes.subspan(offset + 8, size);
+        if (type == kGlbJsonChunk) {
+            text = {reinterpret_cast<const char*>(data.data()), data.size()};
+        } else if (type == kGlbBinaryChunk && binary.empty()) {
+            binary = data;
+        }
+        offset += 8 + ((size + 3) & ~size_t(3));
+    }
+
+    auto json = JsonValue(text.substr(std::min(text.find('{'), text.size())));
+    if (!json.IsValid()) {
+        throw std::runtime_error("JSON is missing");
+    }
+
+    // Primitives are collected from the default scene, or from every mesh when there is no scene.
+    std::vector<GltfPrimitive> primitives;
+    auto scene = json["scenes"][static_cast<size_t>(json["scene"].GetNumber())];
+    if (scene.IsValid()) {
+        auto nodes = scene["nodes"];
+        for (auto i = size_t(0); i != nodes.GetSize(); ++i) {
+            CollectNodePrimitives(json, static_cast<size_t>(nodes[i].GetNumber()), kIdentity, 0, primitives);
+        }
+    } else {
+        for (auto i = size_t(0); i != json["meshes"].GetSize(); ++i) {
+            CollectPrimitives(json, i, kIdentity, primitives);
+        }
+    }
+
+    // Ranges of primitives are reserved up front, so primitives are decoded in parallel.
+    Mesh mesh;
+    auto vertex_count = size_t(0);
+    auto index_count = size_t(0);
+    for (auto &primitive : primitives) {
+        auto attributes = primitive.primitive["attributes"];
+        auto count = static_cast<size_t>(json["accessors"][static_cast<size_t>(attributes["POSITION"].GetNumber())]
+                                             ["count"].GetNumber());
+
+        primitive.vertex_offset = vertex_count;
+        primitive.index_offset = index_count;
+        vertex_count += count;
+
+        auto indices = primitive.primitive["indices"];
+        index_count += indices.IsValid() ?
+                       static_cast<size_t>(json["accessors"][static_cast<size_t>(indices.GetNumber())]["count"]
+                                               .GetNumber()) :
+                       count;
+    }
+
+    if (vertex_count > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("it has too many vertices");
+    }
+
+    mesh.vertices.resize(vertex_count);
+    mesh.indices.resize(index_count);
+
+    job_system.ParallelFor(static_cast<uint32_t>(primitives.size()), 1, [&](uint32_t begin, uint32_t end) {
+        for (auto i = begin; i != end; ++i) {
+            DecodePrimitive(json, binary, primitives[i], mesh);
+        }
+    });
+
+    return mesh;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+
+MeshIndexFormat GetIndexFormat(const Mesh &mesh) {
+    return mesh.vertices.size() <= kMaxUInt16VertexCount ? MeshIndexFormat::kUInt16 : MeshIndexFormat::kUInt32;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+uint32_t GetIndexSize(MeshIndexFormat format) {
+    return format == MeshIndexFormat::kUInt16 ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::vector<std::byte> PackIndices(const Mesh &mesh, MeshIndexFormat format) {
+    std::vector<std::byte> data(mesh.indices.size() * GetIndexSize(format));
+
+    if (format == MeshIndexFormat::kUInt32) {
+        std::memcpy(data.data(), mesh.indices.data(), data.size());
+        return data;
+    }
+
+    if (mesh.vertices.size() > kMaxUInt16VertexCount) {
+        throw std::runtime_error(fmt::format("Fail to pack indices, {} vertices can't be addressed by 16 bits.",
+                                             mesh.vertices.size()));
+    }
+
+    auto indices = reinterpret_cast<uint16_t*>(data.data());
+    for (auto i = size_t(0); i != mesh.indices.size(); ++i) {
+        indices[i] = static_cast<uint16_t>(mesh.indices[i]);
+    }
+
+    return data;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+MeshLoader::MeshLoader(JobSystem *job_system) :
+_job_system(job_system) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Mesh MeshLoader::Load(const std::filesystem::path &path, bool optimize) {
+    _statistics = {};
+    auto start_time = std::chrono::steady_clock::now();
+
+    FileView file(path);
+
+    auto extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+
+    Mesh mesh;
+    try {
+        if (extension == ".obj") {
+            mesh = LoadObj(*_job_system, file.GetString());
+        } else if (extension == ".glb") {
+            mesh = LoadGlb(*_job_system, file.GetBytes());
+        } else {
+            throw std::runtime_error("the format is unknown");
+        }
+
+        if (mesh.indices.size() % 3) {
+            throw std::runtime_error("the number of indices isn't a multiple of 3");
+        }
+    }
+    catch (const std::exception &exception) {
+        throw std::runtime_error(fmt::format("Fail to load a mesh {}, {}.", path.string(), exception.what()));
+    }
+
+    auto parse_time = std::chrono::steady_clock::now();
+    _statistics.parse_time = parse_time - start_time;
+    _statistics.acmr_before = AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+    _statistics.fetch_ratio_before = AnalyzeVertexFetch(mesh.indices, mesh.vertices.size(), MeshLayout::kStride);
+
+    if (optimize) {
+        OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+        OptimizeOverdraw(mesh.indices, mesh.vertices);
+        OptimizeVertexFetch(mesh);
+    }
+
+    _statistics.vertex_count = mesh.vertices.size();
+    _statistics.triangle_count = mesh.indices.size() / 3;
+    _statistics.acmr_after = AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+    _statistics.fetch_ratio_after = AnalyzeVertexFetch(mesh.indices, mesh.vertices.size(), MeshLayout::kStride);
+    _statistics.optimize_time = std::chrono::steady_clock::now() - parse_time;
+
+    return mesh;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
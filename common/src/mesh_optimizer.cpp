@@ -0,0 +1,422 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "vector3.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Vertex scores are computed for a larger cache than the one analyzed, which finds better orders in practice.
+constexpr auto kScoreCacheSize = 32u;
+constexpr auto kScoreValenceSize = 32u;
+constexpr auto kLastTriangleScore = 0.75f;
+constexpr auto kCacheDecayPower = 1.5f;
+constexpr auto kValenceBoostScale = 2.0f;
+constexpr auto kValenceBoostPower = 0.5f;
+
+// The size of a cache which is used to analyze vertex fetch.
+constexpr auto kVertexFetchCacheSize = 4096u;
+
+constexpr auto kInvalidIndex = ~0u;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct VertexScoreTable {
+    std::array<float, kScoreCacheSize + 1> cache = {};
+    std::array<float, kScoreValenceSize + 1> valence = {};
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+const VertexScoreTable &GetVertexScoreTable() {
+    static const auto kTable = []() {
+        VertexScoreTable table;
+
+        // The last entry is for a vertex which isn't in a cache.
+        for (auto i = 0u; i != kScoreCacheSize; ++i) {
+            if (i < 3) {
+                table.cache[i] = kLastTriangleScore;
+            } else {
+                auto scale = 1.0f / static_cast<float>(kScoreCacheSize - 3);
+                table.cache[i] = std::pow(1.0f - static_cast<float>(i - 3) * scale, kCacheDecayPower);
+            }
+        }
+
+        // Vertices with fewer triangles left are preferred so lone triangles don't remain until the end.
+        for (auto i = 1u; i <= kScoreValenceSize; ++i) {
+            table.valence[i] = kValenceBoostScale * std::pow(static_cast<float>(i), -kValenceBoostPower);
+        }
+
+        return table;
+    }();
+
+    return kTable;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+float GetVertexScore(const VertexScoreTable &table, uint32_t cache_position, uint32_t live_count) {
+    if (!live_count) {
+        return -1.0f;
+    }
+
+    return table.cache[std::min(cache_position, kScoreCacheSize)] +
+           table.valence[std::min(live_count, kScoreValenceSize)];
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A FIFO cache which is simulated with timestamps, a vertex is in a cache if it was added recently enough.
+class FifoCache {
+public:
+    FifoCache(size_t entry_count, uint32_t cache_size) :
+    _timestamps(entry_count, 0),
+    _cache_size(cache_size),
+    _timestamp(cache_size + 1) {
+    }
+
+    //! Touch an entry.
+    //! \return True if an entry is missed.
+    bool Touch(uint32_t entry) {
+        if (_timestamp - _timestamps[entry] > _cache_size) {
+            _timestamps[entry] = _timestamp++;
+            return true;
+        }
+        return false;
+    }
+
+    //! Evict every entry.
+    void Reset() {
+        _timestamp += _cache_size + 1;
+    }
+
+private:
+    std::vector<uint32_t> _timestamps;
+    uint32_t _cache_size = 0;
+    uint32_t _timestamp = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void OptimizeVertexCache(std::span<uint32_t> indices, size_t vertex_count) {
+    auto triangle_count = static_cast<uint32_t>(indices.size() / 3);
+    if (!triangle_count) {
+        return;
+    }
+
+    auto &table = GetVertexScoreTable();
+
+    // Build adjacency, the live triangles of a vertex are kept at the front of its range.
+    std::vector<uint32_t> live_counts(vertex_count, 0);
+    for (auto i = 0u; i != triangle_count * 3; ++i) {
+        ++live_counts[indices[i]];
+    }
+
+    std::vector<uint32_t> offsets(vertex_count + 1, 0);
+    std::partial_sum(live_counts.begin(), live_counts.end(), offsets.begin() + 1);
+
+    std::vector<uint32_t> adjacency(triangle_count * 3);
+    {
+        auto cursors = offsets;
+        for (auto i = 0u; i != triangle_count * 3; ++i) {
+            adjacency[cursors[indices[i]]++] = i / 3;
+        }
+    }
+
+    std::vector<float> vertex_scores(vertex_count);
+    for (auto i = 0u; i != vertex_count; ++i) {
+        vertex_scores[i] = GetVertexScore(table, kScoreCacheSize, live_counts[i]);
+    }
+
+    std::vector<float> triangle_scores(triangle_count);
+    for (auto i = 0u; i != triangle_count; ++i) {
+        triangle_scores[i] = vertex_scores[indices[i * 3 + 0]] +
+                             vertex_scores[indices[i * 3 + 1]] +
+                             vertex_scores[indices[i * 3 + 2]];
+    }
+
+    std::vector<bool> emitted(triangle_count, false);
+    std::vector<uint32_t> result;
+    result.reserve(triangle_count * 3);
+
+    std::array<uint32_t, kScoreCacheSize + 3> cache = {};
+    std::array<uint32_t, kScoreCacheSize + 3> next_cache = {};
+    auto cache_count = 0u;
+
+    auto best_triangle = 0u;
+    auto input_cursor = 0u;
+
+    for (auto i = 0u; i != triangle_count; ++i) {
+        // Continue from the input order when no triangle around a cache is left.
+        if (best_triangle == kInvalidIndex) {
+            while (emitted[input_cursor]) {
+                ++input_cursor;
+            }
+            best_triangle = input_cursor;
+        }
+
+        auto triangle = best_triangle;
+        std::array<uint32_t, 3> corners = {indices[triangle * 3 + 0], indices[triangle * 3 + 1],
+                                           indices[triangle * 3 + 2]};
+        result.insert(result.end(), corners.begin(), corners.end());
+        emitted[triangle] = true;
+
+        // Remove an emitted triangle from the live triangles of its vertices.
+        for (auto vertex : corners) {
+            auto begin = adjacency.begin() + offsets[vertex];
+            auto end = begin + live_counts[vertex];
+            std::iter_swap(std::find(begin, end, triangle), end - 1);
+            --live_counts[vertex];
+        }
+
+        // Move vertices of an emitted triangle to the front of a cache.
+        auto next_cache_count = 0u;
+        for (auto vertex : corners) {
+            next_cache[next_cache_count++] = vertex;
+        }
+        for (auto j = 0u; j != cache_count; ++j) {
+            auto vertex = cache[j];
+            if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2]) {
+                next_cache[next_cache_count++] = vertex;
+            }
+        }
+
+        // Update scores of vertices in a cache, including ones pushed out of it.
+        for (auto j = 0u; j != next_cache_count; ++j) {
+            auto vertex = next_cache[j];
+            auto cache_position = std::min(j, kScoreCacheSize);
+
+            auto score = GetVertexScore(table, cache_position, live_counts[vertex]);
+            auto delta = score - vertex_scores[vertex];
+            vertex_scores[vertex] = score;
+
+            auto begin = offsets[vertex];
+            for (auto k = begin; k != begin + live_counts[vertex]; ++k) {
+                triangle_scores[adjacency[k]] += delta;
+            }
+        }
+
+        // The next triangle is the best one around a cache.
+        best_triangle = kInvalidIndex;
+        auto best_score = 0.0f;
+
+        for (auto j = 0u; j != std::min(next_cache_count, kScoreCacheSize); ++j) {
+            auto vertex = next_cache[j];
+            auto begin = offsets[vertex];
+            for (auto k = begin; k != begin + live_counts[vertex]; ++k) {
+                auto adjacent = adjacency[k];
+                if (triangle_scores[adjacent] > best_score) {
+                    best_triangle = adjacent;
+                    best_score = triangle_scores[adjacent];
+                }
+            }
+        }
+
+        cache_count = std::min(next_cache_count, kScoreCacheSize);
+        std::copy_n(next_cache.begin(), cache_count, cache.begin());
+    }
+
+    std::copy(result.begin(), result.end(), indices.begin());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void OptimizeOverdraw(std::span<uint32_t> indices, std::span<const MeshVertex> vertices, float threshold) {
+    auto triangle_count = static_cast<uint32_t>(indices.size() / 3);
+    if (!triangle_count) {
+        return;
+    }
+
+    FifoCache cache(vertices.size(), kVertexCacheSize);
+    auto touch = [&](uint32_t triangle) {
+        return cache.Touch(indices[triangle * 3 + 0]) +
+               cache.Touch(indices[triangle * 3 + 1]) +
+               cache.Touch(indices[triangle * 3 + 2]);
+    };
+
+    // A hard boundary is where a triangle shares no vertex with a cache, a cluster after it can be moved freely.
+    std::vector<uint32_t> hard_boundaries;
+    for (auto i = 0u; i != triangle_count; ++i) {
+        if (touch(i) == 3) {
+            hard_boundaries.push_back(i);
+        }
+    }
+    hard_boundaries.push_back(triangle_count);
+
+    // Split hard clusters further where the cache efficiency of a split is close enough to the whole cluster.
+    std::vector<uint32_t> boundaries;
+    for (auto i = 0u; i + 1 < hard_boundaries.size(); ++i) {
+        auto begin = hard_boundaries[i];
+        auto end = hard_boundaries[i + 1];
+
+        cache.Reset();
+        auto cluster_misses = 0u;
+        for (auto j = begin; j != end; ++j) {
+            cluster_misses += touch(j);
+        }
+        auto cluster_acmr = static_cast<float>(cluster_misses) / static_cast<float>(end - begin);
+
+        cache.Reset();
+        boundaries.push_back(begin);
+        auto start = begin;
+        auto misses = 0u;
+        for (auto j = begin; j != end; ++j) {
+            misses += touch(j);
+
+            auto acmr = static_cast<float>(misses) / static_cast<float>(j + 1 - start);
+            if (j + 1 != end && acmr <= cluster_acmr * threshold) {
+                cache.Reset();
+                boundaries.push_back(j + 1);
+                start = j + 1;
+                misses = 0;
+            }
+        }
+    }
+    boundaries.push_back(triangle_count);
+
+    // Sort clusters by how much they face away from the center of a mesh.
+    auto get_position = [&](uint32_t index) {
+        return MeshLayout::Get<Position>(vertices[index]);
+    };
+
+    auto cluster_count = boundaries.size() - 1;
+    std::vector<std::array<float, 3>> centroids(cluster_count, {0.0f, 0.0f, 0.0f});
+    std::vector<std::array<float, 3>> normals(cluster_count, {0.0f, 0.0f, 0.0f});
+    std::array<float, 3> mesh_centroid = {0.0f, 0.0f, 0.0f};
+    auto mesh_area = 0.0f;
+
+    for (auto i = 0u; i != cluster_count; ++i) {
+        auto cluster_area = 0.0f;
+        for (auto j = boundaries[i]; j != boundaries[i + 1]; ++j) {
+            auto p0 = get_position(indices[j * 3 + 0]);
+            auto p1 = get_position(indices[j * 3 + 1]);
+            auto p2 = get_position(indices[j * 3 + 2]);
+            auto normal = Cross(Subtract(p1, p0), Subtract(p2, p0));
+            auto area = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+            for (auto k = 0u; k != 3; ++k) {
+                centroids[i][k] += (p0[k] + p1[k] + p2[k]) * (area / 3.0f);
+                normals[i][k] += normal[k];
+            }
+            cluster_area += area;
+        }
+
+        for (auto k = 0u; k != 3; ++k) {
+            mesh_centroid[k] += centroids[i][k];
+            centroids[i][k] /= std::max(cluster_area, std::numeric_limits<float>::min());
+        }
+        mesh_area += cluster_area;
+    }
+
+    for (auto k = 0u; k != 3; ++k) {
+        mesh_centroid[k] /= std::max(mesh_area, std::numeric_limits<float>::min());
+    }
+
+    std::vector<float> keys(cluster_count);
+    for (auto i = 0u; i != cluster_count; ++i) {
+        auto &normal = normals[i];
+        auto length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        auto direction = Subtract(centroids[i], mesh_centroid);
+        keys[i] = (direction[0] * normal[0] + direction[1] * normal[1] + direction[2] * normal[2]) /
+                  std::max(length, std::numeric_limits<float>::min());
+    }
+
+    std::vector<uint32_t> order(cluster_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return keys[a] > keys[b];
+    });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (auto cluster : order) {
+        result.insert(result.end(), indices.begin() + boundaries[cluster] * 3,
+                      indices.begin() + boundaries[cluster + 1] * 3);
+    }
+
+    std::copy(result.begin(), result.end(), indices.begin());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void OptimizeVertexFetch(Mesh &mesh) {
+    std::vector<uint32_t> remap(mesh.vertices.size(), kInvalidIndex);
+    std::vector<MeshVertex> vertices;
+    vertices.reserve(mesh.vertices.size());
+
+    for (auto &index : mesh.indices) {
+        if (remap[index] == kInvalidIndex) {
+            remap[index] = static_cast<uint32_t>(vertices.size());
+            vertices.push_back(mesh.vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    mesh.vertices = std::move(vertices);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+float AnalyzeVertexCache(std::span<const uint32_t> indices, size_t vertex_count, uint32_t cache_size) {
+    if (indices.size() < 3) {
+        return 0.0f;
+    }
+
+    FifoCache cache(vertex_count, cache_size);
+    auto miss_count = 0u;
+    for (auto index : indices) {
+        miss_count += cache.Touch(index);
+    }
+
+    return static_cast<float>(miss_count) / static_cast<float>(indices.size() / 3);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+float AnalyzeVertexFetch(std::span<const uint32_t> indices, size_t vertex_count, uint32_t stride) {
+    auto line_count = (vertex_count * stride + kVertexFetchLineSize - 1) / kVertexFetchLineSize;
+    FifoCache cache(line_count, kVertexFetchCacheSize / kVertexFetchLineSize);
+
+    std::vector<bool> used(vertex_count, false);
+    auto used_count = 0ull;
+    auto fetched_line_count = 0ull;
+
+    for (auto index : indices) {
+        if (!used[index]) {
+            used[index] = true;
+            ++used_count;
+        }
+
+        auto offset = static_cast<uint64_t>(index) * stride;
+        for (auto line = offset / kVertexFetchLineSize; line <= (offset + stride - 1) / kVertexFetchLineSize; ++line) {
+            fetched_line_count += cache.Touch(static_cast<uint32_t>(line));
+        }
+    }
+
+    if (!used_count) {
+        return 0.0f;
+    }
+
+    return static_cast<float>(fetched_line_count * kVertexFetchLineSize) /
+           static_cast<float>(used_count * stride);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,401 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "mesh_simplifier.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+
+#include "vector3.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Planes through border edges weigh more than triangles so borders stay in place.
+constexpr auto kBorderWeight = 10.0;
+
+constexpr auto kInvalidIndex = ~0u;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A quadric measures the sum of squared distances to planes, weighted by the area the planes came from.
+struct Quadric {
+    double a00 = 0.0, a11 = 0.0, a22 = 0.0;
+    double a01 = 0.0, a02 = 0.0, a12 = 0.0;
+    double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+    double c = 0.0;
+    double weight = 0.0;
+
+    void AddPlane(const Vector3 &normal, double distance, double plane_weight) {
+        double n0 = normal[0], n1 = normal[1], n2 = normal[2];
+        a00 += n0 * n0 * plane_weight;
+        a11 += n1 * n1 * plane_weight;
+        a22 += n2 * n2 * plane_weight;
+        a01 += n0 * n1 * plane_weight;
+        a02 += n0 * n2 * plane_weight;
+        a12 += n1 * n2 * plane_weight;
+        b0 += n0 * distance * plane_weight;
+        b1 += n1 * distance * plane_weight;
+        b2 += n2 * distance * plane_weight;
+        c += distance * distance * plane_weight;
+        weight += plane_weight;
+    }
+
+    Quadric &operator+=(const Quadric &other) {
+        a00 += other.a00;
+        a11 += other.a11;
+        a22 += other.a22;
+        a01 += other.a01;
+        a02 += other.a02;
+        a12 += other.a12;
+        b0 += other.b0;
+        b1 += other.b1;
+        b2 += other.b2;
+        c += other.c;
+        weight += other.weight;
+        return *this;
+    }
+
+    [[nodiscard]]
+    double Evaluate(const Vector3 &p) const {
+        double x = p[0], y = p[1], z = p[2];
+        return a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+               2.0 * (b0 * x + b1 * y + b2 * z) + c;
+    }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+enum class VertexKind : uint8_t {
+    kManifold,
+    kBorder,
+    kLocked
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct Collapse {
+    uint32_t from = 0;
+    uint32_t to = 0;
+    float error = 0.0f;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Triangles around every position, rebuilt when triangles change.
+struct Adjacency {
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> triangles;
+
+    void Build(std::span<const uint32_t> corners, size_t position_count) {
+        offsets.assign(position_count + 1, 0);
+        for (auto corner : corners) {
+            ++offsets[corner + 1];
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        triangles.resize(corners.size());
+        auto cursors = std::vector<uint32_t>(offsets.begin(), offsets.end() - 1);
+        for (auto i = 0u; i != corners.size(); ++i) {
+            triangles[cursors[corners[i]]++] = i / 3;
+        }
+    }
+
+    [[nodiscard]]
+    std::span<const uint32_t> Get(uint32_t position) const {
+        return std::span(triangles).subspan(offsets[position], offsets[position + 1] - offsets[position]);
+    }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Count triangles around a position which have the edge from a position to another.
+uint32_t CountEdges(const Adjacency &adjacency, std::span<const uint32_t> corners, uint32_t from, uint32_t to) {
+    auto count = 0u;
+    for (auto triangle : adjacency.Get(from)) {
+        for (auto i = 0u; i != 3; ++i) {
+            count += corners[triangle * 3 + i] == from && corners[triangle * 3 + (i + 1) % 3] == to;
+        }
+    }
+    return count;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+
+MeshSimplifyResult SimplifyMesh(const Mesh &mesh, std::span<const uint32_t> indices, size_t target_index_count,
+                                float target_error) {
+    MeshSimplifyResult result;
+    result.indices.assign(indices.begin(), indices.end());
+
+    // Vertices at the same position, which differ in other attributes, are one position of the topology.
+    auto vertex_count = mesh.vertices.size();
+    std::vector<Vector3> vertex_positions(vertex_count);
+    for (auto i = size_t(0); i != vertex_count; ++i) {
+        vertex_positions[i] = MeshLayout::Get<Position>(mesh.vertices[i]);
+    }
+
+    std::vector<uint32_t> order(vertex_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return std::tie(vertex_positions[a], a) < std::tie(vertex_positions[b], b);
+    });
+
+    std::vector<uint32_t> position_indices(vertex_count);
+    std::vector<Vector3> positions;
+    for (auto i = size_t(0); i != vertex_count; ++i) {
+        if (!i || vertex_positions[order[i]] != vertex_positions[order[i - 1]]) {
+            positions.push_back(vertex_positions[order[i]]);
+        }
+        position_indices[order[i]] = static_cast<uint32_t>(positions.size() - 1);
+    }
+
+    // A position with many used vertices is on a seam, moving it would tear attributes apart.
+    std::vector<uint32_t> wedges(positions.size(), kInvalidIndex);
+    std::vector<VertexKind> kinds(positions.size(), VertexKind::kManifold);
+    for (auto index : indices) {
+        auto &wedge = wedges[position_indices[index]];
+        if (wedge != kInvalidIndex && wedge != index) {
+            kinds[position_indices[index]] = VertexKind::kLocked;
+        }
+        wedge = index;
+    }
+
+    std::vector<uint32_t> corners(indices.size());
+    for (auto i = size_t(0); i != indices.size(); ++i) {
+        corners[i] = position_indices[indices[i]];
+    }
+
+    Adjacency adjacency;
+    adjacency.Build(corners, positions.size());
+
+    // Classify borders and lock non manifold edges.
+    std::vector<uint32_t> border_counts(positions.size(), 0);
+    for (auto i = size_t(0); i != corners.size(); ++i) {
+        auto from = corners[i];
+        auto to = corners[i - i % 3 + (i + 1) % 3];
+        if (CountEdges(adjacency, corners, from, to) > 1) {
+            kinds[from] = kinds[to] = VertexKind::kLocked;
+        } else if (!CountEdges(adjacency, corners, to, from)) {
+            ++border_counts[from];
+            ++border_counts[to];
+        }
+    }
+
+    for (auto i = size_t(0); i != positions.size(); ++i) {
+        if (kinds[i] == VertexKind::kManifold && border_counts[i]) {
+            kinds[i] = border_counts[i] == 2 ? VertexKind::kBorder : VertexKind::kLocked;
+        }
+    }
+
+    // Quadrics are planes of triangles, and planes perpendicular to triangles through their border edges.
+    std::vector<Quadric> quadrics(positions.size());
+    for (auto i = size_t(0); i + 2 < corners.size(); i += 3) {
+        auto &p0 = positions[corners[i + 0]];
+        auto normal = Cross(Subtract(positions[corners[i + 1]], p0), Subtract(positions[corners[i + 2]], p0));
+        auto length = std::sqrt(Dot<double>(normal, normal));
+        if (length <= 0.0) {
+            continue;
+        }
+
+        Vector3 unit = {static_cast<float>(normal[0] / length), static_cast<float>(normal[1] / length),
+                        static_cast<float>(normal[2] / length)};
+        for (auto j = 0u; j != 3; ++j) {
+            quadrics[corners[i + j]].AddPlane(unit, -Dot<double>(unit, p0), length * 0.5);
+        }
+
+        for (auto j = 0u; j != 3; ++j) {
+            auto from = corners[i + j];
+            auto to = corners[i + (j + 1) % 3];
+            if (CountEdges(adjacency, corners, to, from)) {
+                continue;
+            }
+
+            auto edge = Subtract(positions[to], positions[from]);
+            auto edge_length_squared = Dot<double>(edge, edge);
+            auto edge_normal = Cross(edge, unit);
+            auto edge_normal_length = std::sqrt(Dot<double>(edge_normal, edge_normal));
+            if (edge_normal_length <= 0.0) {
+                continue;
+            }
+
+            Vector3 plane = {static_cast<float>(edge_normal[0] / edge_normal_length),
+                             static_cast<float>(edge_normal[1] / edge_normal_length),
+                             static_cast<float>(edge_normal[2] / edge_normal_length)};
+            auto distance = -Dot<double>(plane, positions[from]);
+            quadrics[from].AddPlane(plane, distance, edge_length_squared * kBorderWeight);
+            quadrics[to].AddPlane(plane, distance, edge_length_squared * kBorderWeight);
+        }
+    }
+
+    auto get_error = [&](uint32_t from, uint32_t to) {
+        auto &target = positions[to];
+        auto weight = quadrics[from].weight + quadrics[to].weight;
+        auto value = quadrics[from].Evaluate(target) + quadrics[to].Evaluate(target);
+        return weight > 0.0 ? static_cast<float>(std::sqrt(std::max(value, 0.0) / weight)) : 0.0f;
+    };
+
+    auto can_collapse = [&](uint32_t from, uint32_t to) {
+        switch (kinds[from]) {
+            case VertexKind::kManifold:
+                return true;
+            case VertexKind::kBorder:
+                // A border vertex only slides along its border.
+                return kinds[to] != VertexKind::kManifold &&
+                       (!CountEdges(adjacency, corners, from, to) || !CountEdges(adjacency, corners, to, from));
+            default:
+                return false;
+        }
+    };
+
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> remap(positions.size());
+    std::vector<bool> locked(positions.size());
+
+    // Collapse edges in passes, each vertex is touched once per pass so errors and flips are checked on fresh data.
+    while (corners.size() > target_index_count) {
+        collapses.clear();
+        for (auto i = size_t(0); i != corners.size(); ++i) {
+            auto a = corners[i];
+            auto b = corners[i - i % 3 + (i + 1) % 3];
+
+            // An interior edge is seen from both of its triangles.
+            if (a > b && CountEdges(adjacency, corners, b, a)) {
+                continue;
+            }
+
+            auto ab = can_collapse(a, b) ? get_error(a, b) : std::numeric_limits<float>::max();
+            auto ba = can_collapse(b, a) ? get_error(b, a) : std::numeric_limits<float>::max();
+            if (ab != std::numeric_limits<float>::max() || ba != std::numeric_limits<float>::max()) {
+                collapses.push_back(ab <= ba ? Collapse{a, b, ab} : Collapse{b, a, ba});
+            }
+        }
+
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) {
+            return std::tie(a.error, a.from, a.to) < std::tie(b.error, b.from, b.to);
+        });
+
+        std::iota(remap.begin(), remap.end(), 0);
+        std::fill(locked.begin(), locked.end(), false);
+
+        auto removed_count = size_t(0);
+        auto collapse_count = 0u;
+        auto removable_count = (corners.size() - target_index_count + 2) / 3;
+
+        for (auto &collapse : collapses) {
+            if (collapse.error > target_error || removed_count >= removable_count) {
+                break;
+            }
+
+            if (locked[collapse.from] || locked[collapse.to]) {
+                continue;
+            }
+
+            // Reject a collapse which flips a triangle around the vertex being removed.
+            auto flipped = false;
+            auto triangle_count = 0u;
+            for (auto triangle : adjacency.Get(collapse.from)) {
+                auto triangle_corners = std::span(corners).subspan(triangle * 3, 3);
+                if (std::find(triangle_corners.begin(), triangle_corners.end(), collapse.to) !=
+                    triangle_corners.end()) {
+                    ++triangle_count;
+                    continue;
+                }
+
+                std::array<Vector3, 3> before;
+                std::array<Vector3, 3> after;
+                for (auto j = 0u; j != 3; ++j) {
+                    before[j] = positions[triangle_corners[j]];
+                    after[j] = triangle_corners[j] == collapse.from ? positions[collapse.to] : before[j];
+                }
+
+                auto normal_before = Cross(Subtract(before[1], before[0]), Subtract(before[2], before[0]));
+                auto normal_after = Cross(Subtract(after[1], after[0]), Subtract(after[2], after[0]));
+                auto length_squared = Dot<double>(normal_before, normal_before) *
+                                      Dot<double>(normal_after, normal_after);
+                if (Dot<double>(normal_before, normal_after) <= 0.25 * std::sqrt(length_squared)) {
+                    flipped = true;
+                    break;
+                }
+            }
+
+            if (flipped) {
+                continue;
+            }
+
+            // Lock the neighborhood, triangles around it are changed by the collapse.
+            for (auto triangle : adjacency.Get(collapse.from)) {
+                for (auto j = 0u; j != 3; ++j) {
+                    locked[corners[triangle * 3 + j]] = true;
+                }
+            }
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to] += quadrics[collapse.from];
+            removed_count += triangle_count;
+            result.error = std::max(result.error, collapse.error);
+            ++collapse_count;
+        }
+
+        if (!collapse_count) {
+            break;
+        }
+
+        // The only vertex of a removed position is replaced with the vertex of the target in the same triangle.
+        std::vector<uint32_t> vertex_remap(vertex_count, kInvalidIndex);
+        for (auto i = size_t(0); i != corners.size(); ++i) {
+            auto from = corners[i];
+            if (remap[from] == from) {
+                continue;
+            }
+
+            auto triangle = i - i % 3;
+            for (auto j = 0u; j != 3; ++j) {
+                if (corners[triangle + j] == remap[from]) {
+                    vertex_remap[result.indices[i]] = result.indices[triangle + j];
+                }
+            }
+        }
+
+        auto count = size_t(0);
+        for (auto i = size_t(0); i + 2 < corners.size(); i += 3) {
+            std::array<uint32_t, 3> triangle_corners;
+            std::array<uint32_t, 3> triangle_indices;
+            for (auto j = 0u; j != 3; ++j) {
+                triangle_corners[j] = remap[corners[i + j]];
+                auto vertex = result.indices[i + j];
+                triangle_indices[j] = vertex_remap[vertex] != kInvalidIndex ? vertex_remap[vertex] : vertex;
+            }
+
+            // Triangles around a collapsed edge become degenerate.
+            if (triangle_corners[0] == triangle_corners[1] || triangle_corners[1] == triangle_corners[2] ||
+                triangle_corners[2] == triangle_corners[0]) {
+                continue;
+            }
+
+            for (auto j = 0u; j != 3; ++j) {
+                corners[count] = triangle_corners[j];
+                result.indices[count] = triangle_indices[j];
+                ++count;
+            }
+        }
+
+        corners.resize(count);
+        result.indices.resize(count);
+        adjacency.Build(corners, positions.size());
+    }
+
+    return result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
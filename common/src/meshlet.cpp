@@ -0,0 +1,297 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "meshlet.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+
+#include "vector3.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// A cone wider than this can't cull a meshlet from any position worth the test.
+constexpr auto kMinConeDot = 0.1f;
+
+constexpr auto kInvalidIndex = ~0u;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Compute a bounding sphere with Ritter's algorithm, it is within 5% of the smallest sphere in practice.
+std::pair<Vector3, float> ComputeBoundingSphere(std::span<const Vector3> points) {
+    auto find_farthest = [&](const Vector3 &from) {
+        auto farthest = points[0];
+        auto farthest_distance = 0.0f;
+        for (auto &point : points) {
+            auto offset = Subtract(point, from);
+            auto distance = Dot(offset, offset);
+            if (distance > farthest_distance) {
+                farthest = point;
+                farthest_distance = distance;
+            }
+        }
+        return farthest;
+    };
+
+    auto a = find_farthest(points[0]);
+    auto b = find_farthest(a);
+
+    Vector3 center = {(a[0] + b[0]) * 0.5f, (a[1] + b[1]) * 0.5f, (a[2] + b[2]) * 0.5f};
+    auto offset = Subtract(b, a);
+    auto radius = std::sqrt(Dot(offset, offset)) * 0.5f;
+
+    // Grow a sphere to cover points outside of it.
+    for (auto &point : points) {
+        auto offset = Subtract(point, center);
+        auto distance = std::sqrt(Dot(offset, offset));
+        if (distance > radius) {
+            auto shift = (distance - radius) * 0.5f / distance;
+            for (auto k = 0u; k != 3; ++k) {
+                center[k] += offset[k] * shift;
+            }
+            radius = (radius + distance) * 0.5f;
+        }
+    }
+
+    return {center, radius};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+MeshletBounds ComputeBounds(const Mesh &mesh, std::span<const uint32_t> vertices,
+                            std::span<const uint8_t> triangles) {
+    std::vector<Vector3> positions(vertices.size());
+    for (auto i = size_t(0); i != vertices.size(); ++i) {
+        positions[i] = MeshLayout::Get<Position>(mesh.vertices[vertices[i]]);
+    }
+
+    MeshletBounds bounds;
+    std::tie(bounds.center, bounds.radius) = ComputeBoundingSphere(positions);
+    bounds.cone_apex = bounds.center;
+
+    // Normals of degenerate triangles are skipped.
+    std::vector<Vector3> normals;
+    std::vector<Vector3> origins;
+    for (auto i = size_t(0); i + 2 < triangles.size(); i += 3) {
+        auto &p0 = positions[triangles[i + 0]];
+        auto normal = Cross(Subtract(positions[triangles[i + 1]], p0), Subtract(positions[triangles[i + 2]], p0));
+        auto length = std::sqrt(Dot(normal, normal));
+        if (length > std::numeric_limits<float>::min()) {
+            normals.push_back({normal[0] / length, normal[1] / length, normal[2] / length});
+            origins.push_back(p0);
+        }
+    }
+
+    Vector3 axis = {0.0f, 0.0f, 0.0f};
+    for (auto &normal : normals) {
+        for (auto k = 0u; k != 3; ++k) {
+            axis[k] += normal[k];
+        }
+    }
+
+    auto length = std::sqrt(Dot(axis, axis));
+    if (length <= std::numeric_limits<float>::min()) {
+        return bounds;
+    }
+
+    for (auto &value : axis) {
+        value /= length;
+    }
+
+    auto min_dot = 1.0f;
+    for (auto &normal : normals) {
+        min_dot = std::min(min_dot, Dot(axis, normal));
+    }
+
+    if (min_dot <= kMinConeDot) {
+        return bounds;
+    }
+
+    // Move an apex back along the axis until every triangle plane faces away from a viewer behind it.
+    auto max_t = 0.0f;
+    for (auto i = size_t(0); i != normals.size(); ++i) {
+        auto t = Dot(Subtract(bounds.center, origins[i]), normals[i]) / Dot(axis, normals[i]);
+        max_t = std::max(max_t, t);
+    }
+
+    for (auto k = 0u; k != 3; ++k) {
+        bounds.cone_apex[k] = bounds.center[k] - axis[k] * max_t;
+    }
+    bounds.cone_axis = axis;
+    bounds.cone_cutoff = std::sqrt(1.0f - min_dot * min_dot);
+
+    return bounds;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+
+MeshletSet BuildMeshlets(const Mesh &mesh, uint32_t max_vertex_count, uint32_t max_triangle_count) {
+    if (max_vertex_count < 3 || max_vertex_count > 256 || !max_triangle_count) {
+        throw std::runtime_error(fmt::format("Fail to build meshlets: {} vertices and {} triangles are invalid.",
+                                             max_vertex_count, max_triangle_count));
+    }
+
+    auto &indices = mesh.indices;
+    auto triangle_count = static_cast<uint32_t>(indices.size() / 3);
+    auto vertex_count = mesh.vertices.size();
+
+    // Build adjacency, the triangles which aren't added yet are kept at the front of the range of a vertex.
+    std::vector<uint32_t> live_counts(vertex_count, 0);
+    for (auto i = 0u; i != triangle_count * 3; ++i) {
+        ++live_counts[indices[i]];
+    }
+
+    std::vector<uint32_t> offsets(vertex_count + 1, 0);
+    std::partial_sum(live_counts.begin(), live_counts.end(), offsets.begin() + 1);
+
+    std::vector<uint32_t> adjacency(triangle_count * 3);
+    {
+        auto cursors = offsets;
+        for (auto i = 0u; i != triangle_count * 3; ++i) {
+            adjacency[cursors[indices[i]]++] = i / 3;
+        }
+    }
+
+    MeshletSet meshlet_set;
+    std::vector<bool> added(triangle_count, false);
+    std::vector<uint32_t> local_indices(vertex_count, kInvalidIndex);
+    std::vector<uint32_t> vertices;
+    std::vector<uint8_t> triangles;
+    auto input_cursor = 0u;
+
+    auto flush = [&]() {
+        Meshlet meshlet;
+        meshlet.vertex_offset = static_cast<uint32_t>(meshlet_set.vertices.size());
+        meshlet.triangle_offset = static_cast<uint32_t>(meshlet_set.triangles.size());
+        meshlet.vertex_count = static_cast<uint32_t>(vertices.size());
+        meshlet.triangle_count = static_cast<uint32_t>(triangles.size() / 3);
+        meshlet_set.meshlets.push_back(meshlet);
+        meshlet_set.bounds.push_back(ComputeBounds(mesh, vertices, triangles));
+        meshlet_set.vertices.insert(meshlet_set.vertices.end(), vertices.begin(), vertices.end());
+        meshlet_set.triangles.insert(meshlet_set.triangles.end(), triangles.begin(), triangles.end());
+
+        for (auto vertex : vertices) {
+            local_indices[vertex] = kInvalidIndex;
+        }
+        vertices.clear();
+        triangles.clear();
+    };
+
+    auto count_new_vertices = [&](uint32_t triangle) {
+        return (local_indices[indices[triangle * 3 + 0]] == kInvalidIndex) +
+               (local_indices[indices[triangle * 3 + 1]] == kInvalidIndex) +
+               (local_indices[indices[triangle * 3 + 2]] == kInvalidIndex);
+    };
+
+    for (auto i = 0u; i != triangle_count; ++i) {
+        // Find the triangle adds the fewest vertices among triangles sharing a vertex with a meshlet.
+        auto best_triangle = kInvalidIndex;
+        auto best_count = 3u;
+
+        for (auto j = 0u; j != vertices.size() && best_count; ++j) {
+            auto begin = offsets[vertices[j]];
+            for (auto k = begin; k != begin + live_counts[vertices[j]]; ++k) {
+                auto count = static_cast<uint32_t>(count_new_vertices(adjacency[k]));
+                if (count < best_count || best_triangle == kInvalidIndex) {
+                    best_triangle = adjacency[k];
+                    best_count = count;
+                    if (!best_count) {
+                        break;
+                    }
+                }
+            }
+        }
+
+        // Continue from the input order when a meshlet is disconnected from the rest.
+        if (best_triangle == kInvalidIndex) {
+            while (added[input_cursor]) {
+                ++input_cursor;
+            }
+            best_triangle = input_cursor;
+            best_count = count_new_vertices(best_triangle);
+        }
+
+        if (vertices.size() + best_count > max_vertex_count || triangles.size() / 3 == max_triangle_count) {
+            flush();
+        }
+
+        for (auto j = 0u; j != 3; ++j) {
+            auto vertex = indices[best_triangle * 3 + j];
+            if (local_indices[vertex] == kInvalidIndex) {
+                local_indices[vertex] = static_cast<uint32_t>(vertices.size());
+                vertices.push_back(vertex);
+            }
+            triangles.push_back(static_cast<uint8_t>(local_indices[vertex]));
+
+            auto begin = adjacency.begin() + offsets[vertex];
+            auto end = begin + live_counts[vertex];
+            std::iter_swap(std::find(begin, end, best_triangle), end - 1);
+            --live_counts[vertex];
+        }
+        added[best_triangle] = true;
+    }
+
+    if (!triangles.empty()) {
+        flush();
+    }
+
+    return meshlet_set;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+MeshletCullStatistics CullMeshlets(const MeshletSet &meshlet_set, const Matrix4 &view, const Matrix4 &projection,
+                                   std::vector<uint32_t> &indices) {
+    auto frustum = MakeFrustum(Multiply(projection, view));
+    auto view_position = GetViewPosition(view);
+
+    MeshletCullStatistics statistics;
+    statistics.meshlet_count = static_cast<uint32_t>(meshlet_set.meshlets.size());
+    indices.clear();
+
+    for (auto i = size_t(0); i != meshlet_set.meshlets.size(); ++i) {
+        auto &meshlet = meshlet_set.meshlets[i];
+        auto &bounds = meshlet_set.bounds[i];
+        statistics.triangle_count += meshlet.triangle_count;
+
+        if (!IsVisible(frustum, bounds.center, bounds.radius)) {
+            ++statistics.frustum_culled_count;
+            continue;
+        }
+
+        if (bounds.cone_cutoff < 1.0f) {
+            auto direction = Subtract(bounds.cone_apex, view_position);
+            auto distance = std::sqrt(Dot(direction, direction));
+            if (Dot(direction, bounds.cone_axis) >= bounds.cone_cutoff * distance) {
+                ++statistics.backface_culled_count;
+                continue;
+            }
+        }
+
+        auto vertices = meshlet_set.vertices.data() + meshlet.vertex_offset;
+        auto triangles = meshlet_set.triangles.data() + meshlet.triangle_offset;
+        for (auto j = 0u; j != meshlet.triangle_count * 3; ++j) {
+            indices.push_back(vertices[triangles[j]]);
+        }
+        statistics.visible_triangle_count += meshlet.triangle_count;
+    }
+
+    return statistics;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,78 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "metal_command_encoder.h"
+
+#include <type_traits>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+static_assert(static_cast<MTLPrimitiveType>(CommandPrimitiveType::kTriangleStrip) == MTLPrimitiveTypeTriangleStrip);
+static_assert(static_cast<MTLIndexType>(CommandIndexType::kUInt32) == MTLIndexTypeUInt32);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void EncodeCommands(const CommandRecorder &recorder, const MetalCommandResources &resources,
+                    id<MTLRenderCommandEncoder> encoder) {
+    recorder.Replay([&](const auto &command) {
+        using Command = std::decay_t<decltype(command)>;
+
+        if constexpr (std::is_same_v<Command, SetPipelineCommand>) {
+            [encoder setRenderPipelineState:resources.pipelines[command.pipeline]];
+        } else if constexpr (std::is_same_v<Command, SetBufferCommand>) {
+            if (command.stage == CommandStage::kVertex) {
+                [encoder setVertexBuffer:resources.buffers[command.buffer] offset:command.offset
+                                 atIndex:command.index];
+            } else {
+                [encoder setFragmentBuffer:resources.buffers[command.buffer] offset:command.offset
+                                   atIndex:command.index];
+            }
+        } else if constexpr (std::is_same_v<Command, SetBytesCommand>) {
+            if (command.stage == CommandStage::kVertex) {
+                [encoder setVertexBytes:GetBytes(command) length:command.size atIndex:command.index];
+            } else {
+                [encoder setFragmentBytes:GetBytes(command) length:command.size atIndex:command.index];
+            }
+        } else if constexpr (std::is_same_v<Command, DrawCommand>) {
+            [encoder drawPrimitives:static_cast<MTLPrimitiveType>(command.primitive_type)
+                        vertexStart:command.vertex_start vertexCount:command.vertex_count
+                      instanceCount:command.instance_count baseInstance:command.base_instance];
+        } else if constexpr (std::is_same_v<Command, DrawIndexedCommand>) {
+            [encoder drawIndexedPrimitives:static_cast<MTLPrimitiveType>(command.primitive_type)
+                                indexCount:command.index_count
+                                 indexType:static_cast<MTLIndexType>(command.index_type)
+                               indexBuffer:resources.buffers[command.index_buffer]
+                         indexBufferOffset:command.index_offset instanceCount:command.instance_count
+                                baseVertex:command.base_vertex baseInstance:command.base_instance];
+        }
+    });
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void EncodeCommandStream(const CommandStream &stream, const MetalCommandResources &resources,
+                         id<MTLCommandBuffer> command_buffer, MTLRenderPassDescriptor *descriptor,
+                         JobSystem &job_system) {
+    auto parallel_encoder = [command_buffer parallelRenderCommandEncoderWithDescriptor:descriptor];
+
+    // Encoders execute in the order they are created, not in the order they are encoded.
+    std::vector<id<MTLRenderCommandEncoder>> encoders(stream.GetRecorderCount());
+    for (auto &encoder : encoders) {
+        encoder = [parallel_encoder renderCommandEncoder];
+    }
+
+    job_system.ParallelFor(stream.GetRecorderCount(), 1, [&](uint32_t begin, uint32_t end) {
+        for (auto i = begin; i != end; ++i) {
+            @autoreleasepool {
+                EncodeCommands(stream.GetRecorder(i), resources, encoders[i]);
+                [encoders[i] endEncoding];
+            }
+        }
+    });
+
+    [parallel_encoder endEncoding];
+}
+
+//----------------------------------------------------------------------------------------------------------------------
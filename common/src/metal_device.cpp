@@ -0,0 +1,159 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "metal_device.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+MetalSwapchain::MetalSwapchain(id<MTLDevice> device, uint32_t image_count) :
+_device(device),
+_image_count(image_count) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void MetalSwapchain::BindToLayer(CAMetalLayer *layer) {
+    _layer = layer;
+    _layer.device = _device;
+    _layer.maximumDrawableCount = _image_count;
+    _layer.pixelFormat = kMetalLayerPixelFormat;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void MetalSwapchain::Resize(const Resolution &resolution) {
+    _resolution = resolution;
+
+    // Resize a layer drawable size.
+    _layer.drawableSize = CGSizeMake(GetWidth(resolution), GetHeight(resolution));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void MetalSwapchain::AcquireNextImage() {
+    _drawable = [_layer nextDrawable];
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void MetalSwapchain::ReleaseImage() {
+    _drawable = nil;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Resolution MetalSwapchain::GetResolution() const {
+    return _resolution;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+uint32_t MetalSwapchain::GetImageCount() const {
+    return _image_count;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+MetalDevice::MetalDevice(uint32_t frame_count, uint32_t drawable_count) {
+    InitDevice();
+    InitCommandQueue();
+    InitSemaphore(frame_count);
+    _swapchain = std::make_unique<MetalSwapchain>(_device, drawable_count);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void MetalDevice::WaitForFrame() {
+    // Wait until the command buffer has completed its work.
+    dispatch_semaphore_wait(_semaphore, DISPATCH_TIME_FOREVER);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void MetalDevice::BeginFrame() {
+    // Acquire a next drawable.
+    _swapchain->AcquireNextImage();
+
+    _command_buffer = [_command_queue commandBuffer];
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void MetalDevice::EndFrame() {
+    // Schedule a drawable presentation.
+    [_command_buffer presentDrawable:_swapchain->GetDrawable()];
+    _swapchain->ReleaseImage();
+
+    // Signal a semaphore after the command buffer has processed.
+    __weak dispatch_semaphore_t semaphore = _semaphore;
+    auto gpu_time = _gpu_time;
+    [_command_buffer addCompletedHandler:^(id<MTLCommandBuffer> commandBuffer) {
+        gpu_time->store(commandBuffer.GPUEndTime - commandBuffer.GPUStartTime, std::memory_order_relaxed);
+        dispatch_semaphore_signal(semaphore);
+    }];
+
+    // Commit a command buffer.
+    [_command_buffer commit];
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void MetalDevice::WaitIdle() {
+    // Command buffers complete in order so waiting for the last one is enough.
+    [_command_buffer waitUntilCompleted];
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Backend MetalDevice::GetBackend() const {
+    return Backend::kMetal;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::string MetalDevice::GetName() const {
+    return _device.name.UTF8String;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Swapchain* MetalDevice::GetSwapchain() {
+    return _swapchain.get();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::chrono::duration<double> MetalDevice::GetGpuTime() const {
+    return std::chrono::duration<double>(_gpu_time->load(std::memory_order_relaxed));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void MetalDevice::InitDevice() {
+    _device = MTLCreateSystemDefaultDevice();
+    if (!_device) {
+        throw std::runtime_error("Fail to create a device.");
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void MetalDevice::InitCommandQueue() {
+    _command_queue = [_device newCommandQueue];
+    if (!_command_queue) {
+        throw std::runtime_error("Fail to create a command queue.");
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void MetalDevice::InitSemaphore(uint32_t frame_count) {
+    _semaphore = dispatch_semaphore_create(frame_count);
+    if (!_semaphore) {
+        throw std::runtime_error("Fail to create a semaphore");
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,161 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "example.h"
+
+#include <imgui_impl_osx.h>
+#include <imgui_impl_metal.h>
+
+#include "window.h"
+#include "metal_shader_compiler.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Example::BindToWindow(Window *window) {
+    _layer = (CAMetalLayer*)[window->GetView() layer];
+
+    // Present a swapchain to a layer.
+    if (_metal_device) {
+        _metal_device->GetMetalSwapchain()->BindToLayer(_layer);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Example::RecordDrawImGuiCommands(MTLRenderPassDescriptor *descriptor, id<MTLRenderCommandEncoder> encoder) {
+    if (_metal_device && !_scaled_texture) {
+        ImGui_ImplMetal_NewFrame(descriptor);
+        ImGui_ImplMetal_RenderDrawData(&_snapshots.GetReadBuffer().draw_data, _command_buffer, encoder);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+id<MTLFunction> Example::LoadShader(const std::filesystem::path &file_path, const std::string &entrypoint,
+                                    const ShaderMacros &macros) {
+    if (!_shader_cache) {
+        return nil;
+    }
+
+    auto library = std::static_pointer_cast<MetalShaderLibrary>(_shader_cache->GetLibrary(file_path, macros));
+    return library->GetFunction(entrypoint);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Example::InitMetalDevice(const Arguments &arguments) {
+    auto metal_device = std::make_unique<MetalDevice>(_frames_in_flight, kMetalLayerDrawableCount);
+    _metal_device = metal_device.get();
+    _device = metal_device->GetDevice();
+    _command_queue = metal_device->GetCommandQueue();
+    _render_device = std::move(metal_device);
+
+    // Uniforms are written by the CPU and read by the GPU in place.
+    _uniform_buffer = [_device newBufferWithLength:kDefaultUniformFrameSize * _frame_count
+                                           options:MTLResourceStorageModeShared];
+    if (!_uniform_buffer) {
+        throw std::runtime_error("Fail to create a uniform buffer.");
+    }
+
+    auto compiler = std::make_unique<MetalShaderCompiler>(_device, !arguments.shader_cache_directory.empty());
+    _shader_cache = std::make_unique<ShaderCache>(std::move(compiler), arguments.shader_cache_directory);
+
+    auto factory = std::make_unique<MetalPipelineFactory>(_device, _shader_cache.get());
+    _pipeline_cache = std::make_unique<PipelineCache>(std::move(factory), &_job_system);
+
+    _upload_queue = std::make_unique<UploadQueue>(_device, _command_queue);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Example::InitMetalImGui() {
+    ImGui_ImplMetal_Init(_device);
+    ImGui_ImplOSX_Init();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Example::TermMetalImGui() {
+    ImGui_ImplMetal_Shutdown();
+    ImGui_ImplOSX_Shutdown();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Example::BeginMetalImGuiPass() {
+    ImGui_ImplOSX_NewFrame(nullptr);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Example::BeginMetalFrame() {
+    _command_buffer = _metal_device->GetCommandBuffer();
+    _drawable = _metal_device->GetMetalSwapchain()->GetDrawable();
+    _color_texture = _scaled_texture ? _scaled_texture : _drawable.texture;
+
+    // Copy pending uploads before an example renders with them.
+    _upload_queue->Flush(_command_buffer);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Example::EndMetalFrame() {
+    if (_scaled_texture) {
+        RecordUpscaleCommands();
+    }
+    _color_texture = nil;
+    _drawable = nil;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Example::ResizeMetalTargets(const Resolution &resolution, const Resolution &render_resolution) {
+    // A drawable stays at a window resolution, a scaled texture is upscaled into it.
+    if (resolution != _display_resolution) {
+        _render_device->GetSwapchain()->Resize(resolution);
+    }
+
+    _scaled_texture = nil;
+    if (render_resolution == resolution) {
+        return;
+    }
+
+    auto descriptor = [MTLTextureDescriptor texture2DDescriptorWithPixelFormat:kMetalLayerPixelFormat
+                                                                         width:GetWidth(render_resolution)
+                                                                        height:GetHeight(render_resolution)
+                                                                     mipmapped:NO];
+    descriptor.usage = MTLTextureUsageRenderTarget | MTLTextureUsageShaderRead;
+    descriptor.storageMode = MTLStorageModePrivate;
+
+    _scaled_texture = [_device newTextureWithDescriptor:descriptor];
+    if (!_scaled_texture) {
+        throw std::runtime_error("Fail to create a scaled texture.");
+    }
+
+    // An upscaler is created once a frame renders at a scaled resolution.
+    if (!_upscaler) {
+        _upscaler = std::make_unique<MetalUpscaler>(_device, kMetalLayerPixelFormat);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Example::RecordUpscaleCommands() {
+    auto descriptor = [MTLRenderPassDescriptor new];
+    descriptor.colorAttachments[0].texture = _drawable.texture;
+    descriptor.colorAttachments[0].loadAction = MTLLoadActionDontCare;
+    descriptor.colorAttachments[0].storeAction = MTLStoreActionStore;
+
+    auto encoder = [_command_buffer renderCommandEncoderWithDescriptor:descriptor];
+    _upscaler->Encode(encoder, _scaled_texture);
+
+    // Draw ImGui at a window resolution.
+    ImGui_ImplMetal_NewFrame(descriptor);
+    ImGui_ImplMetal_RenderDrawData(&_snapshots.GetReadBuffer().draw_data, _command_buffer, encoder);
+
+    [encoder endEncoding];
+}
+
+//----------------------------------------------------------------------------------------------------------------------
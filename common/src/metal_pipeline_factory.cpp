@@ -0,0 +1,69 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "metal_pipeline_factory.h"
+
+#include <fmt/format.h>
+
+#include "metal_shader_compiler.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+MetalPipelineState::MetalPipelineState(id<MTLRenderPipelineState> pipeline_state) :
+_pipeline_state(pipeline_state) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+MetalPipelineFactory::MetalPipelineFactory(id<MTLDevice> device, ShaderCache *shader_cache) :
+_device(device),
+_shader_cache(shader_cache) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::shared_ptr<PipelineState> MetalPipelineFactory::Create(const PipelineDescriptor &descriptor) {
+    @autoreleasepool {
+        auto vertex_descriptor = [MTLVertexDescriptor new];
+        for (auto i = 0; i != descriptor.attributes.size(); ++i) {
+            auto &attribute = descriptor.attributes[i];
+            vertex_descriptor.attributes[i].format = static_cast<MTLVertexFormat>(attribute.format);
+            vertex_descriptor.attributes[i].offset = attribute.offset;
+            vertex_descriptor.attributes[i].bufferIndex = attribute.buffer_index;
+        }
+        for (auto i = 0; i != descriptor.layouts.size(); ++i) {
+            auto &layout = descriptor.layouts[i];
+            vertex_descriptor.layouts[i].stride = layout.stride;
+            vertex_descriptor.layouts[i].stepFunction = static_cast<MTLVertexStepFunction>(layout.step_function);
+            vertex_descriptor.layouts[i].stepRate = layout.step_rate;
+        }
+
+        // Every entrypoint comes from a library is compiled once.
+        auto library = std::static_pointer_cast<MetalShaderLibrary>(
+            _shader_cache->GetLibrary(descriptor.shader_path, descriptor.macros));
+
+        auto pipeline_descriptor = [MTLRenderPipelineDescriptor new];
+        pipeline_descriptor.vertexFunction = library->GetFunction(descriptor.vertex_entrypoint);
+        pipeline_descriptor.fragmentFunction = library->GetFunction(descriptor.fragment_entrypoint);
+        pipeline_descriptor.vertexDescriptor = vertex_descriptor;
+        pipeline_descriptor.rasterSampleCount = descriptor.sample_count;
+        for (auto i = 0; i != descriptor.color_formats.size(); ++i) {
+            pipeline_descriptor.colorAttachments[i].pixelFormat = static_cast<MTLPixelFormat>(descriptor.color_formats[i]);
+        }
+        pipeline_descriptor.depthAttachmentPixelFormat = static_cast<MTLPixelFormat>(descriptor.depth_format);
+        pipeline_descriptor.inputPrimitiveTopology = MTLPrimitiveTopologyClassTriangle;
+
+        NSError *error;
+        auto pipeline_state = [_device newRenderPipelineStateWithDescriptor:pipeline_descriptor error:&error];
+        if (!pipeline_state) {
+            throw std::runtime_error(fmt::format("Fail to create a pipeline state: {}",
+                                                 error.description.UTF8String));
+        }
+
+        return std::make_shared<MetalPipelineState>(pipeline_state);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
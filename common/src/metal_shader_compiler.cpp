@@ -0,0 +1,173 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "metal_shader_compiler.h"
+
+#include <fmt/format.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cerrno>
+#include <fstream>
+
+#include "file_view.h"
+#include "hash.h"
+#include "utility.h"
+
+extern char **environ;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Run a program and wait for it. Arguments are passed as they are without a shell, so they can't inject commands.
+//! \param arguments A program name, it is searched in PATH, and its arguments.
+//! \return True if a program exits successfully.
+bool RunProcess(const std::vector<std::string> &arguments) {
+    std::vector<char*> argv;
+    for (auto &argument : arguments) {
+        argv.push_back(const_cast<char*>(argument.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    // Diagnostics of a failed compile are dropped, the runtime compiler reports them.
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    pid_t pid;
+    auto result = posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (result != 0) {
+        return false;
+    }
+
+    int status = 0;
+    while (waitpid(pid, &status, 0) == -1) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+
+MetalShaderLibrary::MetalShaderLibrary(id<MTLLibrary> library) :
+_library(library) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+id<MTLFunction> MetalShaderLibrary::GetFunction(const std::string &entrypoint) const {
+    auto function = [_library newFunctionWithName:@(entrypoint.data())];
+    if (!function) {
+        throw std::runtime_error(fmt::format("Fail to create a {} function.", entrypoint));
+    }
+    return function;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+MetalShaderCompiler::MetalShaderCompiler(id<MTLDevice> device, bool use_toolchain) :
+_device(device),
+_use_toolchain(use_toolchain) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::string MetalShaderCompiler::GetIdentifier() const {
+    return fmt::format("{}/{}", _device.name.UTF8String,
+                       NSProcessInfo.processInfo.operatingSystemVersionString.UTF8String);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+ShaderCompileResult MetalShaderCompiler::Compile(std::string_view source, const ShaderMacros &macros) {
+    if (_use_toolchain) {
+        if (auto binary = CompileWithToolchain(source, macros); !binary.empty()) {
+            return {Load(binary), std::move(binary)};
+        }
+    }
+
+    // Fall back to the runtime compiler, its library can't be stored.
+    auto options = [MTLCompileOptions new];
+    auto preprocessor_macros = [NSMutableDictionary<NSString*, NSObject*> new];
+    for (auto &[name, value] : macros) {
+        preprocessor_macros[@(name.data())] = @(value.data());
+    }
+    options.preprocessorMacros = preprocessor_macros;
+
+    NSError* error;
+    auto library = [_device newLibraryWithSource:MakeString(source) options:options error:&error];
+    if (!library) {
+        throw std::runtime_error(fmt::format("Fail to create a library: {}.", error.description.UTF8String));
+    }
+
+    return {std::make_shared<MetalShaderLibrary>(library), {}};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::shared_ptr<ShaderLibrary> MetalShaderCompiler::Load(std::span<const std::byte> binary) {
+    auto data = dispatch_data_create(binary.data(), binary.size(), nullptr, DISPATCH_DATA_DESTRUCTOR_DEFAULT);
+
+    NSError* error;
+    auto library = [_device newLibraryWithData:data error:&error];
+    if (!library) {
+        throw std::runtime_error(fmt::format("Fail to load a library: {}.", error.description.UTF8String));
+    }
+
+    return std::make_shared<MetalShaderLibrary>(library);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::vector<std::byte> MetalShaderCompiler::CompileWithToolchain(std::string_view source,
+                                                                 const ShaderMacros &macros) {
+    // Sources with different macros and processes compiling the same source don't share files.
+    auto key = HashWithSize(source);
+    for (auto &[name, value] : macros) {
+        key = HashWithSize(value, HashWithSize(name, key));
+    }
+    auto base_path = std::filesystem::temp_directory_path() / fmt::format("metal_{}_{:016x}", getpid(), key);
+    auto source_path = base_path;
+    source_path += ".metal";
+    auto binary_path = base_path;
+    binary_path += ".metallib";
+
+    // The toolchain only compiles files.
+    {
+        std::ofstream fout(source_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        fout.write(source.data(), static_cast<std::streamsize>(source.size()));
+    }
+
+    std::vector<std::string> arguments = {"xcrun", "-sdk", "macosx", "metal"};
+    for (auto &[name, value] : macros) {
+        arguments.push_back(fmt::format("-D{}={}", name, value));
+    }
+    arguments.insert(arguments.end(), {"-o", binary_path.string(), source_path.string()});
+
+    std::vector<std::byte> binary;
+    if (RunProcess(arguments)) {
+        FileView content(binary_path);
+        binary.assign(content.GetBytes().begin(), content.GetBytes().end());
+    }
+
+    std::error_code error;
+    std::filesystem::remove(source_path, error);
+    std::filesystem::remove(binary_path, error);
+
+    return binary;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,88 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "metal_upscaler.h"
+
+#include <fmt/format.h>
+#include <stdexcept>
+
+#include "utility.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// A triangle covers a render target, so there is no vertex buffer.
+constexpr auto kUpscaleShaderSource = R"(
+#include <metal_stdlib>
+
+using namespace metal;
+
+struct Output {
+    float4 position [[position]];
+    float2 uv;
+};
+
+vertex Output VSMain(uint vertex_id [[vertex_id]]) {
+    Output output;
+    output.uv = float2((vertex_id << 1) & 2, vertex_id & 2);
+    output.position = float4(output.uv * float2(2.0, -2.0) + float2(-1.0, 1.0), 0.0, 1.0);
+    return output;
+}
+
+fragment float4 FSMain(Output input [[stage_in]], texture2d<float> texture [[texture(0)]],
+                       sampler texture_sampler [[sampler(0)]]) {
+    return texture.sample(texture_sampler, input.uv);
+}
+)";
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+
+MetalUpscaler::MetalUpscaler(id<MTLDevice> device, MTLPixelFormat pixel_format) {
+    NSError* error;
+    auto library = [device newLibraryWithSource:MakeString(kUpscaleShaderSource) options:nil error:&error];
+    if (!library) {
+        throw std::runtime_error(fmt::format("Fail to create an upscale library: {}.", error.description.UTF8String));
+    }
+
+    auto descriptor = [MTLRenderPipelineDescriptor new];
+    descriptor.vertexFunction = [library newFunctionWithName:@"VSMain"];
+    descriptor.fragmentFunction = [library newFunctionWithName:@"FSMain"];
+    descriptor.colorAttachments[0].pixelFormat = pixel_format;
+
+    _pipeline_state = [device newRenderPipelineStateWithDescriptor:descriptor error:&error];
+    if (!_pipeline_state) {
+        throw std::runtime_error(fmt::format("Fail to create an upscale pipeline state: {}.",
+                                             error.description.UTF8String));
+    }
+
+    auto sampler_descriptor = [MTLSamplerDescriptor new];
+    sampler_descriptor.minFilter = MTLSamplerMinMagFilterLinear;
+    sampler_descriptor.magFilter = MTLSamplerMinMagFilterLinear;
+    sampler_descriptor.sAddressMode = MTLSamplerAddressModeClampToEdge;
+    sampler_descriptor.tAddressMode = MTLSamplerAddressModeClampToEdge;
+
+    _sampler_state = [device newSamplerStateWithDescriptor:sampler_descriptor];
+    if (!_sampler_state) {
+        throw std::runtime_error("Fail to create an upscale sampler state.");
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void MetalUpscaler::Encode(id<MTLRenderCommandEncoder> encoder, id<MTLTexture> texture) {
+    [encoder setRenderPipelineState:_pipeline_state];
+    [encoder setFragmentTexture:texture atIndex:0];
+    [encoder setFragmentSamplerState:_sampler_state atIndex:0];
+    [encoder drawPrimitives:MTLPrimitiveTypeTriangle vertexStart:0 vertexCount:3];
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,98 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "null_device.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+NullSwapchain::NullSwapchain(uint32_t image_count) :
+_image_count(image_count) {
+    if (!_image_count) {
+        throw std::runtime_error("Fail to create a swapchain without images.");
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void NullSwapchain::Resize(const Resolution &resolution) {
+    _resolution = resolution;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void NullSwapchain::AcquireNextImage() {
+    _image_index = (_image_index + 1) % _image_count;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Resolution NullSwapchain::GetResolution() const {
+    return _resolution;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+uint32_t NullSwapchain::GetImageCount() const {
+    return _image_count;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+NullDevice::NullDevice(uint32_t frame_count, uint32_t image_count) :
+_semaphore(frame_count),
+_swapchain(image_count) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void NullDevice::WaitForFrame() {
+    _semaphore.acquire();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void NullDevice::BeginFrame() {
+    _swapchain.AcquireNextImage();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void NullDevice::EndFrame() {
+    ++_submit_count;
+
+    // Signal a semaphore as the frame has nothing to execute.
+    _semaphore.release();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void NullDevice::WaitIdle() {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Backend NullDevice::GetBackend() const {
+    return Backend::kNull;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::string NullDevice::GetName() const {
+    return "Null Device";
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Swapchain* NullDevice::GetSwapchain() {
+    return &_swapchain;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::chrono::duration<double> NullDevice::GetGpuTime() const {
+    return std::chrono::duration<double>::zero();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,534 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "occlusion_culler.h"
+
+#include <algorithm>
+#include <bit>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Triangles of occluders are set up in chunks of this many triangles, one chunk per task.
+constexpr auto kSetupChunkSize = 1024u;
+
+// Boxes are tested in chunks of this many boxes, one chunk per task.
+constexpr auto kCullChunkSize = 4096u;
+
+// A box stops being refined to finer levels of a pyramid when it would cover more texels than this.
+constexpr auto kMaxQueryTexelCount = 64u;
+
+// A corner of a box closer than this to the plane of a viewer is treated as crossing the near plane.
+constexpr auto kMinClipW = 1e-5f;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Four lanes map to a SSE or a NEON register on both GCC and Clang.
+using Float4 = float __attribute__((vector_size(16)));
+using Int4 = int32_t __attribute__((vector_size(16)));
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline auto Splat(float value) {
+    return Float4{value, value, value, value};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline auto Transform(const Matrix4 &matrix, const std::array<float, 3> &position) {
+    std::array<float, 4> result;
+    for (auto row = 0u; row != 4; ++row) {
+        result[row] = matrix[row] * position[0] + matrix[4 + row] * position[1] + matrix[8 + row] * position[2] +
+                      matrix[12 + row];
+    }
+    return result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline auto Lerp(const std::array<float, 4> &v0, const std::array<float, 4> &v1, float t) {
+    std::array<float, 4> result;
+    for (auto i = 0u; i != 4; ++i) {
+        result[i] = v0[i] + (v1[i] - v0[i]) * t;
+    }
+    return result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+
+OcclusionCuller::OcclusionCuller(JobSystem *job_system, uint32_t width, uint32_t height)
+: _width(width)
+, _height(height)
+, _stride((width + 3) & ~3u)
+, _job_system(job_system) {
+    if (!width || !height) {
+        throw std::runtime_error(fmt::format("Fail to create an occlusion culler of {}x{}.", width, height));
+    }
+
+    // Rows are padded to a multiple of four pixels, so a row is rasterized four pixels at once without a tail.
+    _depths.assign(static_cast<size_t>(_stride) * _height, 1.0f);
+
+    while (true) {
+        OcclusionDepthLevel level;
+        level.width = _levels.empty() ? _width : std::max((_levels.back().width + 1) / 2, 1u);
+        level.height = _levels.empty() ? _height : std::max((_levels.back().height + 1) / 2, 1u);
+        level.min_depths.assign(static_cast<size_t>(level.width) * level.height, 1.0f);
+        level.max_depths.assign(static_cast<size_t>(level.width) * level.height, 1.0f);
+        _levels.push_back(std::move(level));
+
+        if (_levels.back().width == 1 && _levels.back().height == 1) {
+            break;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+OcclusionCuller::~OcclusionCuller() {
+    _job_system->Wait(_counter);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void OcclusionCuller::Begin(const Matrix4 &view_projection) {
+    _view_projection = view_projection;
+    _occluders.clear();
+    _statistics = {};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void OcclusionCuller::AddOccluder(std::span<const std::array<float, 3>> positions, std::span<const uint32_t> indices,
+                                  const Matrix4 &model) {
+    // Indices are checked here because tasks have nowhere to report an error.
+    for (auto index : indices) {
+        if (index >= positions.size()) {
+            throw std::runtime_error(fmt::format("Fail to add an occluder, an index {} is out of {} positions.",
+                                                 index, positions.size()));
+        }
+    }
+
+    _occluders.push_back({positions, indices, Multiply(_view_projection, model)});
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::future<void> OcclusionCuller::Render() {
+    _render_start_time = std::chrono::steady_clock::now();
+    _promise = {};
+    auto future = _promise.get_future();
+
+    _triangle_offsets.assign(1, 0);
+    for (auto &occluder : _occluders) {
+        _triangle_offsets.push_back(_triangle_offsets.back() + occluder.indices.size() / 3);
+    }
+
+    _statistics.occluder_count = static_cast<uint32_t>(_occluders.size());
+    _statistics.triangle_count = _triangle_offsets.back();
+
+    auto chunk_count = static_cast<uint32_t>((_triangle_offsets.back() + kSetupChunkSize - 1) / kSetupChunkSize);
+    _chunk_triangles.resize(chunk_count);
+    if (!chunk_count) {
+        SubmitBands();
+        return future;
+    }
+
+    // The last task of a stage starts the next stage, so no thread waits in the middle.
+    _pending_count = chunk_count;
+    for (auto chunk = 0u; chunk != chunk_count; ++chunk) {
+        _job_system->Run([this, chunk]() {
+            SetupChunk(chunk);
+            if (--_pending_count == 0) {
+                SubmitBands();
+            }
+        }, &_counter);
+    }
+
+    return future;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool OcclusionCuller::IsVisible(const std::array<float, 3> &min, const std::array<float, 3> &max) const {
+    auto min_x = FLT_MAX;
+    auto min_y = FLT_MAX;
+    auto max_x = -FLT_MAX;
+    auto max_y = -FLT_MAX;
+    auto min_depth = FLT_MAX;
+
+    for (auto i = 0u; i != 8; ++i) {
+        auto position = Transform(_view_projection, {i & 1 ? max[0] : min[0],
+                                                     i & 2 ? max[1] : min[1],
+                                                     i & 4 ? max[2] : min[2]});
+
+        // A box crossing the near plane covers the viewer, so it can't be behind anything.
+        if (position[3] < kMinClipW || position[2] < 0.0f) {
+            return true;
+        }
+
+        auto inv_w = 1.0f / position[3];
+        min_x = std::min(min_x, position[0] * inv_w);
+        min_y = std::min(min_y, position[1] * inv_w);
+        max_x = std::max(max_x, position[0] * inv_w);
+        max_y = std::max(max_y, position[1] * inv_w);
+        min_depth = std::min(min_depth, position[2] * inv_w);
+    }
+
+    // Calculate a rectangle in pixels where the origin is the top left corner. Coordinates are clamped near the view
+    // volume first, so ones of a box close to the plane of a viewer don't overflow. A rectangle grows by a pixel as
+    // occluders cover pixels by their centers and may cover up to half a pixel more than they are.
+    min_x = std::clamp(min_x, -2.0f, 2.0f);
+    min_y = std::clamp(min_y, -2.0f, 2.0f);
+    max_x = std::clamp(max_x, -2.0f, 2.0f);
+    max_y = std::clamp(max_y, -2.0f, 2.0f);
+    auto x0 = std::max(static_cast<int32_t>(std::floor((min_x * 0.5f + 0.5f) * _width)) - 1, 0);
+    auto y0 = std::max(static_cast<int32_t>(std::floor((0.5f - max_y * 0.5f) * _height)) - 1, 0);
+    auto x1 = std::min(static_cast<int32_t>(std::floor((max_x * 0.5f + 0.5f) * _width)) + 1,
+                       static_cast<int32_t>(_width) - 1);
+    auto y1 = std::min(static_cast<int32_t>(std::floor((0.5f - min_y * 0.5f) * _height)) + 1,
+                       static_cast<int32_t>(_height) - 1);
+
+    // Leave a box outside of the view volume to frustum culling.
+    if (x0 > x1 || y0 > y1 || min_depth > 1.0f) {
+        return true;
+    }
+
+    // Start from the level where a rectangle covers a few texels.
+    auto level = 0u;
+    while (level + 1 < _levels.size() && std::max(x1 - x0, y1 - y0) >> level > 1) {
+        ++level;
+    }
+
+    while (true) {
+        auto &depth_level = _levels[level];
+        auto is_occluded = true;
+        for (auto y = y0 >> level; y <= y1 >> level; ++y) {
+            for (auto x = x0 >> level; x <= x1 >> level; ++x) {
+                auto index = static_cast<size_t>(y) * depth_level.width + x;
+
+                // A box in front of every occluder of a texel is visible there.
+                if (min_depth <= depth_level.min_depths[index]) {
+                    return true;
+                }
+                is_occluded &= min_depth > depth_level.max_depths[index];
+            }
+        }
+
+        if (is_occluded) {
+            return false;
+        }
+
+        // Refine a box partially behind occluders at a finer level.
+        if (!level) {
+            return true;
+        }
+        --level;
+
+        auto texel_count = ((x1 >> level) - (x0 >> level) + 1) * ((y1 >> level) - (y0 >> level) + 1);
+        if (texel_count > static_cast<int32_t>(kMaxQueryTexelCount)) {
+            return true;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void OcclusionCuller::Cull(const BoundingBoxes &boxes, std::span<const uint32_t> candidates,
+                           std::vector<uint32_t> &visible) {
+    auto start_time = std::chrono::steady_clock::now();
+
+    // Every chunk writes visible indices to its own range, which are compacted afterwards.
+    visible.resize(candidates.size());
+    auto chunk_count = (candidates.size() + kCullChunkSize - 1) / kCullChunkSize;
+    _chunk_counts.assign(chunk_count, 0);
+
+    auto cull_chunk = [&, data = visible.data()](size_t chunk) {
+        auto begin = chunk * kCullChunkSize;
+        auto end = std::min(begin + kCullChunkSize, candidates.size());
+        auto count = size_t(0);
+        for (auto i = begin; i != end; ++i) {
+            auto index = candidates[i];
+            data[begin + count] = index;
+            count += IsVisible({boxes.min_x[index], boxes.min_y[index], boxes.min_z[index]},
+                               {boxes.max_x[index], boxes.max_y[index], boxes.max_z[index]});
+        }
+        _chunk_counts[chunk] = count;
+    };
+
+    // The calling thread culls chunks as well instead of waiting idle.
+    _job_system->ParallelFor(static_cast<uint32_t>(chunk_count), 1, [&cull_chunk](uint32_t begin, uint32_t end) {
+        for (auto chunk = begin; chunk != end; ++chunk) {
+            cull_chunk(chunk);
+        }
+    });
+
+    auto visible_count = size_t(0);
+    for (auto chunk = size_t(0); chunk != chunk_count; ++chunk) {
+        auto source = visible.data() + chunk * kCullChunkSize;
+        if (source != visible.data() + visible_count) {
+            std::memmove(visible.data() + visible_count, source, _chunk_counts[chunk] * sizeof(uint32_t));
+        }
+        visible_count += _chunk_counts[chunk];
+    }
+    visible.resize(visible_count);
+
+    _statistics.tested_count += candidates.size();
+    _statistics.occluded_count += candidates.size() - visible_count;
+    _statistics.cull_time += std::chrono::steady_clock::now() - start_time;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void OcclusionCuller::SetupChunk(uint32_t chunk) {
+    auto &triangles = _chunk_triangles[chunk];
+    triangles.clear();
+
+    auto begin = static_cast<uint64_t>(chunk) * kSetupChunkSize;
+    auto end = std::min(begin + kSetupChunkSize, _triangle_offsets.back());
+    auto occluder_index = std::upper_bound(_triangle_offsets.begin(), _triangle_offsets.end(), begin) -
+                          _triangle_offsets.begin() - 1;
+
+    for (auto i = begin; i != end; ++i) {
+        while (i >= _triangle_offsets[occluder_index + 1]) {
+            ++occluder_index;
+        }
+
+        auto &occluder = _occluders[occluder_index];
+        auto first = (i - _triangle_offsets[occluder_index]) * 3;
+        SetupTriangle({Transform(occluder.model_view_projection, occluder.positions[occluder.indices[first]]),
+                       Transform(occluder.model_view_projection, occluder.positions[occluder.indices[first + 1]]),
+                       Transform(occluder.model_view_projection, occluder.positions[occluder.indices[first + 2]])},
+                      triangles);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void OcclusionCuller::SetupTriangle(const std::array<std::array<float, 4>, 3> &vertices,
+                                    std::vector<Triangle> &triangles) const {
+    // Reject a triangle is outside of any side of the view volume.
+    for (auto axis = 0; axis != 2; ++axis) {
+        if (std::all_of(vertices.begin(), vertices.end(), [axis](auto &v) { return v[axis] > v[3]; }) ||
+            std::all_of(vertices.begin(), vertices.end(), [axis](auto &v) { return v[axis] < -v[3]; })) {
+            return;
+        }
+    }
+    if (std::all_of(vertices.begin(), vertices.end(), [](auto &v) { return v[2] > v[3]; })) {
+        return;
+    }
+
+    // Accept a triangle is in front of the near plane as it is.
+    if (std::all_of(vertices.begin(), vertices.end(), [](auto &v) { return v[2] >= 0.0f; })) {
+        SetupScreenTriangle({&vertices[0], &vertices[1], &vertices[2]}, triangles);
+        return;
+    }
+
+    // Clip a triangle to the near plane, z >= 0 in Metal clip space.
+    std::array<float, 4> polygon[4];
+    auto polygon_size = 0;
+    for (auto i = 0; i != 3; ++i) {
+        auto &curr = vertices[i];
+        auto &next = vertices[(i + 1) % 3];
+        if (curr[2] >= 0.0f) {
+            polygon[polygon_size++] = curr;
+        }
+        if ((curr[2] >= 0.0f) != (next[2] >= 0.0f)) {
+            polygon[polygon_size++] = Lerp(curr, next, curr[2] / (curr[2] - next[2]));
+        }
+    }
+
+    // Triangulate a clipped polygon as a fan.
+    for (auto i = 1; i + 1 < polygon_size; ++i) {
+        SetupScreenTriangle({&polygon[0], &polygon[i], &polygon[i + 1]}, triangles);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void OcclusionCuller::SetupScreenTriangle(const std::array<const std::array<float, 4> *, 3> &vertices,
+                                          std::vector<Triangle> &triangles) const {
+    const auto kWidth = static_cast<float>(_width);
+    const auto kHeight = static_cast<float>(_height);
+
+    Triangle triangle;
+    float x[3], y[3], z[3];
+    for (auto i = 0; i != 3; ++i) {
+        auto &position = *vertices[i];
+        if (position[3] <= 0.0f) {
+            return;
+        }
+
+        // Transform to the viewport where the origin is the top left corner.
+        auto inv_w = 1.0f / position[3];
+        x[i] = (position[0] * inv_w * 0.5f + 0.5f) * kWidth;
+        y[i] = (0.5f - position[1] * inv_w * 0.5f) * kHeight;
+        z[i] = position[2] * inv_w;
+    }
+
+    // Build an edge function opposite to each vertex.
+    for (auto i = 0; i != 3; ++i) {
+        auto j = (i + 1) % 3;
+        auto k = (i + 2) % 3;
+        triangle.a[i] = y[j] - y[k];
+        triangle.b[i] = x[k] - x[j];
+        triangle.c[i] = x[j] * y[k] - x[k] * y[j];
+    }
+
+    auto area = triangle.c[0] + triangle.c[1] + triangle.c[2];
+    if (std::abs(area) < FLT_EPSILON) {
+        return;
+    }
+
+    // Accept both windings so a covered pixel always has positive edge functions.
+    if (area < 0.0f) {
+        for (auto i = 0; i != 3; ++i) {
+            triangle.a[i] = -triangle.a[i];
+            triangle.b[i] = -triangle.b[i];
+            triangle.c[i] = -triangle.c[i];
+        }
+        area = -area;
+    }
+
+    // Follow the top left rule so pixels on edges shared by triangles of an occluder are covered without a gap.
+    for (auto i = 0; i != 3; ++i) {
+        auto is_left = triangle.a[i] > 0.0f;
+        auto is_top = triangle.a[i] == 0.0f && triangle.b[i] > 0.0f;
+        triangle.bias[i] = is_left || is_top ? 0.0f : FLT_MIN;
+    }
+
+    // Depth is linear in screen space, and it is biased to the farthest corner of a pixel.
+    auto inv_area = 1.0f / area;
+    for (auto i = 0; i != 3; ++i) {
+        triangle.depth_plane[0] += z[i] * triangle.a[i] * inv_area;
+        triangle.depth_plane[1] += z[i] * triangle.b[i] * inv_area;
+        triangle.depth_plane[2] += z[i] * triangle.c[i] * inv_area;
+    }
+    triangle.depth_plane[2] += 0.5f * (std::abs(triangle.depth_plane[0]) + std::abs(triangle.depth_plane[1]));
+
+    // Calculate a bounding box in pixels.
+    triangle.min_x = std::max(static_cast<int32_t>(std::floor(*std::min_element(x, x + 3))), 0);
+    triangle.min_y = std::max(static_cast<int32_t>(std::floor(*std::min_element(y, y + 3))), 0);
+    triangle.max_x = std::min(static_cast<int32_t>(std::ceil(*std::max_element(x, x + 3))),
+                              static_cast<int32_t>(_width) - 1);
+    triangle.max_y = std::min(static_cast<int32_t>(std::ceil(*std::max_element(y, y + 3))),
+                              static_cast<int32_t>(_height) - 1);
+    if (triangle.min_x > triangle.max_x || triangle.min_y > triangle.max_y) {
+        return;
+    }
+
+    triangles.push_back(triangle);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void OcclusionCuller::SubmitBands() {
+    auto band_count = (_height + kOcclusionBandHeight - 1) / kOcclusionBandHeight;
+
+    _pending_count = band_count;
+    for (auto band = 0u; band != band_count; ++band) {
+        _job_system->Run([this, band]() {
+            RasterizeBand(band);
+            if (--_pending_count == 0) {
+                BuildPyramid();
+
+                for (auto &triangles : _chunk_triangles) {
+                    _statistics.rasterized_triangle_count += triangles.size();
+                }
+                _statistics.render_time = std::chrono::steady_clock::now() - _render_start_time;
+                _promise.set_value();
+            }
+        }, &_counter);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void OcclusionCuller::RasterizeBand(uint32_t band) {
+    const auto kBandMinY = static_cast<int32_t>(band * kOcclusionBandHeight);
+    const auto kBandMaxY = static_cast<int32_t>(std::min((band + 1) * kOcclusionBandHeight, _height)) - 1;
+    const auto kLaneOffsets = Float4{0.5f, 1.5f, 2.5f, 3.5f};
+
+    std::fill(_depths.begin() + static_cast<size_t>(kBandMinY) * _stride,
+              _depths.begin() + static_cast<size_t>(kBandMaxY + 1) * _stride, 1.0f);
+
+    for (auto &triangles : _chunk_triangles) {
+        for (auto &triangle : triangles) {
+            auto min_y = std::max(triangle.min_y, kBandMinY);
+            auto max_y = std::min(triangle.max_y, kBandMaxY);
+
+            for (auto y = min_y; y <= max_y; ++y) {
+                auto py = Splat(y + 0.5f);
+                auto row = _depths.data() + static_cast<size_t>(y) * _stride;
+                for (auto x = triangle.min_x & ~3; x <= triangle.max_x; x += 4) {
+                    auto px = Splat(static_cast<float>(x)) + kLaneOffsets;
+
+                    // Evaluate edge functions of four pixels at once.
+                    auto e0 = triangle.a[0] * px + triangle.b[0] * py + triangle.c[0];
+                    auto e1 = triangle.a[1] * px + triangle.b[1] * py + triangle.c[1];
+                    auto e2 = triangle.a[2] * px + triangle.b[2] * py + triangle.c[2];
+                    auto mask = (e0 >= triangle.bias[0]) & (e1 >= triangle.bias[1]) & (e2 >= triangle.bias[2]);
+                    if (!(mask[0] | mask[1] | mask[2] | mask[3])) {
+                        continue;
+                    }
+
+                    auto depth = triangle.depth_plane[0] * px + triangle.depth_plane[1] * py +
+                                 triangle.depth_plane[2];
+
+                    // Keep the nearest depth of covered pixels.
+                    Float4 depths;
+                    std::memcpy(&depths, row + x, sizeof(depths));
+                    mask &= depth < depths;
+                    auto bits = (std::bit_cast<Int4>(depth) & mask) | (std::bit_cast<Int4>(depths) & ~mask);
+                    std::memcpy(row + x, &bits, sizeof(bits));
+                }
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void OcclusionCuller::BuildPyramid() {
+    auto &first = _levels[0];
+    for (auto y = 0u; y != _height; ++y) {
+        auto row = _depths.begin() + static_cast<size_t>(y) * _stride;
+        std::copy(row, row + _width, first.min_depths.begin() + static_cast<size_t>(y) * _width);
+        std::copy(row, row + _width, first.max_depths.begin() + static_cast<size_t>(y) * _width);
+    }
+
+    for (auto i = 1u; i != _levels.size(); ++i) {
+        auto &src = _levels[i - 1];
+        auto &dst = _levels[i];
+        for (auto y = 0u; y != dst.height; ++y) {
+            // A texel at the edge of an odd level covers a single row or column.
+            auto y0 = static_cast<size_t>(y * 2) * src.width;
+            auto y1 = static_cast<size_t>(std::min(y * 2 + 1, src.height - 1)) * src.width;
+            for (auto x = 0u; x != dst.width; ++x) {
+                auto x0 = x * 2;
+                auto x1 = std::min(x * 2 + 1, src.width - 1);
+                auto index = static_cast<size_t>(y) * dst.width + x;
+                dst.min_depths[index] = std::min({src.min_depths[y0 + x0], src.min_depths[y0 + x1],
+                                                  src.min_depths[y1 + x0], src.min_depths[y1 + x1]});
+                dst.max_depths[index] = std::max({src.max_depths[y0 + x0], src.max_depths[y0 + x1],
+                                                  src.max_depths[y1 + x0], src.max_depths[y1 + x1]});
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
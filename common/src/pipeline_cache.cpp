@@ -0,0 +1,146 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "pipeline_cache.h"
+
+#include <fmt/format.h>
+
+#include "hash.h"
+
+using namespace std::chrono_literals;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+PipelineCache::PipelineCache(std::unique_ptr<PipelineFactory> factory, JobSystem *job_system) :
+_factory(std::move(factory)),
+_job_system(job_system) {
+    if (!_factory) {
+        throw std::runtime_error("Fail to create a pipeline cache without a factory.");
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+PipelineCache::~PipelineCache() {
+    // Jobs use a factory, so they must be done before it is destroyed.
+    _job_system->Wait(_counter);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+PipelineFuture PipelineCache::GetPipelineState(const PipelineDescriptor &descriptor) {
+    auto key = ComputeKey(descriptor);
+
+    std::lock_guard lock(_mutex);
+    ++_statistics.request_count;
+
+    if (auto iter = _futures.find(key); iter != _futures.end()) {
+        ++_statistics.hit_count;
+        return iter->second;
+    }
+
+    // Create a pipeline state on a job, a failure is rethrown from the future.
+    auto future = _job_system->Submit([this, descriptor]() {
+        return _factory->Create(descriptor);
+    }, &_counter).share();
+    ++_statistics.create_count;
+
+    _futures.emplace(key, future);
+    _descriptors.emplace(key, descriptor);
+    return future;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void PipelineCache::WarmUp(std::span<const PipelineDescriptor> descriptors) {
+    for (auto &descriptor : descriptors) {
+        GetPipelineState(descriptor);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void PipelineCache::Reload(const std::filesystem::path &shader_path) {
+    std::error_code error;
+    auto path = std::filesystem::weakly_canonical(shader_path, error);
+
+    std::lock_guard lock(_mutex);
+    for (auto &[key, descriptor] : _descriptors) {
+        if (std::filesystem::weakly_canonical(descriptor.shader_path, error) != path) {
+            continue;
+        }
+
+        // A newer reload replaces a pending one.
+        _reloads[key] = _job_system->Submit([this, descriptor]() {
+            return _factory->Create(descriptor);
+        }, &_counter).share();
+        ++_statistics.reload_count;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+PipelineReloadResult PipelineCache::CommitReloads() {
+    PipelineReloadResult result;
+
+    std::lock_guard lock(_mutex);
+    for (auto iter = _reloads.begin(); iter != _reloads.end();) {
+        auto &[key, future] = *iter;
+        if (future.wait_for(0s) != std::future_status::ready) {
+            ++iter;
+            continue;
+        }
+
+        try {
+            future.get();
+            _futures[key] = future;
+            ++result.swap_count;
+        }
+        catch (const std::exception &exception) {
+            ++_statistics.reload_failure_count;
+            result.errors.push_back(fmt::format("Fail to reload {}: {}", _descriptors[key].shader_path.string(),
+                                                exception.what()));
+        }
+        iter = _reloads.erase(iter);
+    }
+
+    return result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+uint64_t PipelineCache::ComputeKey(const PipelineDescriptor &descriptor) {
+    // Hash sizes so different splits of the same values never collide.
+    auto key = HashWithSize(descriptor.shader_path.string());
+    key = HashWithSize(descriptor.vertex_entrypoint, key);
+    key = HashWithSize(descriptor.fragment_entrypoint, key);
+    key = HashCombine(key, descriptor.macros.size());
+    for (auto &[name, value] : descriptor.macros) {
+        key = HashWithSize(value, HashWithSize(name, key));
+    }
+    key = HashCombine(key, descriptor.attributes.size());
+    for (auto &attribute : descriptor.attributes) {
+        key = HashCombine(key, attribute);
+    }
+    key = HashCombine(key, descriptor.layouts.size());
+    for (auto &layout : descriptor.layouts) {
+        key = HashCombine(key, layout);
+    }
+    key = HashCombine(key, descriptor.color_formats.size());
+    for (auto &format : descriptor.color_formats) {
+        key = HashCombine(key, format);
+    }
+    key = HashCombine(key, descriptor.depth_format);
+    return HashCombine(key, descriptor.sample_count);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+PipelineCacheStatistics PipelineCache::GetStatistics() const {
+    std::lock_guard lock(_mutex);
+    return _statistics;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,349 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "rasterizer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <stdexcept>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Four lanes map to a SSE or a NEON register on both GCC and Clang.
+using SimdFloat4 = float __attribute__((vector_size(16)));
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline auto Splat(float value) {
+    return SimdFloat4{value, value, value, value};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline auto PackColor(const RasterColor &color) {
+    auto Quantize = [](float value) {
+        return static_cast<uint32_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    };
+
+    // Pack in BGRA8 order to match a layer pixel format.
+    return (Quantize(color[3]) << 24) | (Quantize(color[0]) << 16) | (Quantize(color[1]) << 8) | Quantize(color[2]);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+inline auto Lerp(const RasterVertex &v0, const RasterVertex &v1, float t) {
+    RasterVertex vertex;
+    for (auto i = 0; i != 4; ++i) {
+        vertex.position[i] = v0.position[i] + (v1.position[i] - v0.position[i]) * t;
+    }
+    for (auto i = 0; i != kRasterMaxVaryingCount; ++i) {
+        vertex.varyings[i] = v0.varyings[i] + (v1.varyings[i] - v0.varyings[i]) * t;
+    }
+    return vertex;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void RasterTarget::Resize(uint32_t width, uint32_t height) {
+    _width = width;
+    _height = height;
+    _pixels.resize(static_cast<size_t>(width) * height);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void RasterTarget::Clear(const RasterColor &color) {
+    std::fill(_pixels.begin(), _pixels.end(), PackColor(color));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Rasterizer::Rasterizer(JobSystem *job_system) :
+_job_system(job_system) {
+    _statistics.thread_count = GetThreadCount();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Rasterizer::DrawIndexed(RasterTarget &target, const RasterPipeline &pipeline,
+                             std::span<const uint16_t> indices) {
+    DrawIndexed<uint16_t>(target, pipeline, indices);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Rasterizer::DrawIndexed(RasterTarget &target, const RasterPipeline &pipeline,
+                             std::span<const uint32_t> indices) {
+    DrawIndexed<uint32_t>(target, pipeline, indices);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Rasterizer::ResetStatistics() {
+    _statistics = {};
+    _statistics.thread_count = GetThreadCount();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template<typename T>
+void Rasterizer::DrawIndexed(RasterTarget &target, const RasterPipeline &pipeline, std::span<const T> indices) {
+    if (pipeline.varying_count > kRasterMaxVaryingCount) {
+        throw std::runtime_error("Fail to draw: too many varyings.");
+    }
+
+    if (indices.size() < 3 || !target.GetWidth() || !target.GetHeight()) {
+        return;
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+
+    // Shade every vertex once.
+    ShadeVertices(pipeline, *std::max_element(indices.begin(), indices.end()) + 1);
+
+    // Clip and set up triangles.
+    _triangles.clear();
+    for (auto i = size_t(0); i + 2 < indices.size(); i += 3) {
+        SetupTriangle(target, pipeline, _vertices[indices[i]], _vertices[indices[i + 1]], _vertices[indices[i + 2]]);
+    }
+
+    // Bin triangles into tiles.
+    BinTriangles(target);
+
+    // Rasterize tiles in parallel. Each tile is owned by a job so pixels are written in submission order.
+    std::atomic<uint64_t> pixel_count = 0;
+    _job_system->ParallelFor(_tile_count_x * _tile_count_y, 1, [&](uint32_t begin, uint32_t end) {
+        for (auto tile_index = begin; tile_index != end; ++tile_index) {
+            pixel_count += RasterizeTile(target, pipeline, tile_index);
+        }
+    });
+
+    ++_statistics.draw_count;
+    _statistics.triangle_count += indices.size() / 3;
+    _statistics.pixel_count += pixel_count;
+    _statistics.elapsed_time += std::chrono::steady_clock::now() - start_time;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Rasterizer::ShadeVertices(const RasterPipeline &pipeline, uint32_t vertex_count) {
+    constexpr auto kBatchSize = 1024u;
+
+    _vertices.resize(vertex_count);
+    _job_system->ParallelFor(vertex_count, kBatchSize, [&](uint32_t begin, uint32_t end) {
+        for (auto i = begin; i != end; ++i) {
+            pipeline.vertex_shader(i, _vertices[i]);
+        }
+    });
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Rasterizer::SetupTriangle(const RasterTarget &target, const RasterPipeline &pipeline,
+                               const RasterVertex &v0, const RasterVertex &v1, const RasterVertex &v2) {
+    const RasterVertex *vertices[3] = {&v0, &v1, &v2};
+
+    // Reject a triangle is outside of any side of the view volume.
+    for (auto axis = 0; axis != 2; ++axis) {
+        if (std::all_of(vertices, vertices + 3, [axis](auto v) { return v->position[axis] > v->position[3]; }) ||
+            std::all_of(vertices, vertices + 3, [axis](auto v) { return v->position[axis] < -v->position[3]; })) {
+            return;
+        }
+    }
+
+    // Accept a triangle is in front of the near plane as it is.
+    if (std::all_of(vertices, vertices + 3, [](auto v) { return v->position[2] >= 0.0f; })) {
+        SetupScreenTriangle(target, pipeline, {&v0, &v1, &v2});
+        return;
+    }
+
+    // Clip a triangle to the near plane, z >= 0 in Metal clip space.
+    RasterVertex polygon[4];
+    auto polygon_size = 0;
+    for (auto i = 0; i != 3; ++i) {
+        auto &curr = *vertices[i];
+        auto &next = *vertices[(i + 1) % 3];
+        if (curr.position[2] >= 0.0f) {
+            polygon[polygon_size++] = curr;
+        }
+        if ((curr.position[2] >= 0.0f) != (next.position[2] >= 0.0f)) {
+            auto t = curr.position[2] / (curr.position[2] - next.position[2]);
+            polygon[polygon_size++] = Lerp(curr, next, t);
+        }
+    }
+
+    // Triangulate a clipped polygon as a fan.
+    for (auto i = 1; i + 1 < polygon_size; ++i) {
+        SetupScreenTriangle(target, pipeline, {&polygon[0], &polygon[i], &polygon[i + 1]});
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Rasterizer::SetupScreenTriangle(const RasterTarget &target, const RasterPipeline &pipeline,
+                                     const std::array<const RasterVertex*, 3> &vertices) {
+    const auto kWidth = static_cast<float>(target.GetWidth());
+    const auto kHeight = static_cast<float>(target.GetHeight());
+
+    Triangle triangle;
+    float x[3], y[3];
+    for (auto i = 0; i != 3; ++i) {
+        auto &position = vertices[i]->position;
+        if (position[3] <= 0.0f) {
+            return;
+        }
+
+        // Transform to the viewport where the origin is the top left corner.
+        triangle.inv_w[i] = 1.0f / position[3];
+        x[i] = (position[0] * triangle.inv_w[i] * 0.5f + 0.5f) * kWidth;
+        y[i] = (0.5f - position[1] * triangle.inv_w[i] * 0.5f) * kHeight;
+
+        // Premultiply varyings for perspective correct interpolation.
+        for (auto j = 0u; j != pipeline.varying_count; ++j) {
+            triangle.varyings[i][j] = vertices[i]->varyings[j] * triangle.inv_w[i];
+        }
+    }
+
+    // Build an edge function opposite to each vertex.
+    for (auto i = 0; i != 3; ++i) {
+        auto j = (i + 1) % 3;
+        auto k = (i + 2) % 3;
+        triangle.a[i] = y[j] - y[k];
+        triangle.b[i] = x[k] - x[j];
+        triangle.c[i] = x[j] * y[k] - x[k] * y[j];
+    }
+
+    auto area = triangle.c[0] + triangle.c[1] + triangle.c[2];
+    if (std::abs(area) < FLT_EPSILON) {
+        return;
+    }
+
+    // Accept both windings so a covered pixel always has positive edge functions.
+    if (area < 0.0f) {
+        for (auto i = 0; i != 3; ++i) {
+            triangle.a[i] = -triangle.a[i];
+            triangle.b[i] = -triangle.b[i];
+            triangle.c[i] = -triangle.c[i];
+        }
+        area = -area;
+    }
+    triangle.inv_area = 1.0f / area;
+
+    // Follow the top left rule so shared edges are covered exactly once.
+    for (auto i = 0; i != 3; ++i) {
+        auto is_left = triangle.a[i] > 0.0f;
+        auto is_top = triangle.a[i] == 0.0f && triangle.b[i] > 0.0f;
+        triangle.bias[i] = is_left || is_top ? 0.0f : FLT_MIN;
+    }
+
+    // Calculate a bounding box in pixels.
+    triangle.min_x = std::max(static_cast<int32_t>(std::floor(*std::min_element(x, x + 3))), 0);
+    triangle.min_y = std::max(static_cast<int32_t>(std::floor(*std::min_element(y, y + 3))), 0);
+    triangle.max_x = std::min(static_cast<int32_t>(std::ceil(*std::max_element(x, x + 3))),
+                              static_cast<int32_t>(target.GetWidth()) - 1);
+    triangle.max_y = std::min(static_cast<int32_t>(std::ceil(*std::max_element(y, y + 3))),
+                              static_cast<int32_t>(target.GetHeight()) - 1);
+    if (triangle.min_x > triangle.max_x || triangle.min_y > triangle.max_y) {
+        return;
+    }
+
+    _triangles.push_back(triangle);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void Rasterizer::BinTriangles(const RasterTarget &target) {
+    _tile_count_x = (target.GetWidth() + kRasterTileSize - 1) / kRasterTileSize;
+    _tile_count_y = (target.GetHeight() + kRasterTileSize - 1) / kRasterTileSize;
+
+    _bins.resize(_tile_count_x * _tile_count_y);
+    for (auto &bin : _bins) {
+        bin.clear();
+    }
+
+    for (auto i = 0u; i != _triangles.size(); ++i) {
+        auto &triangle = _triangles[i];
+        for (auto y = triangle.min_y / kRasterTileSize; y <= triangle.max_y / kRasterTileSize; ++y) {
+            for (auto x = triangle.min_x / kRasterTileSize; x <= triangle.max_x / kRasterTileSize; ++x) {
+                _bins[y * _tile_count_x + x].push_back(i);
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+uint64_t Rasterizer::RasterizeTile(RasterTarget &target, const RasterPipeline &pipeline, uint32_t tile_index) {
+    const auto kTileX = static_cast<int32_t>((tile_index % _tile_count_x) * kRasterTileSize);
+    const auto kTileY = static_cast<int32_t>((tile_index / _tile_count_x) * kRasterTileSize);
+    const auto kLaneOffsets = SimdFloat4{0.5f, 1.5f, 2.5f, 3.5f};
+
+    auto pixels = target.GetPixels();
+    auto pixel_count = uint64_t(0);
+    float varyings[kRasterMaxVaryingCount] = {};
+    SimdFloat4 lane_varyings[kRasterMaxVaryingCount];
+
+    for (auto triangle_index : _bins[tile_index]) {
+        auto &triangle = _triangles[triangle_index];
+        auto min_x = std::max(triangle.min_x, kTileX);
+        auto min_y = std::max(triangle.min_y, kTileY);
+        auto max_x = std::min(triangle.max_x, kTileX + static_cast<int32_t>(kRasterTileSize) - 1);
+        auto max_y = std::min(triangle.max_y, kTileY + static_cast<int32_t>(kRasterTileSize) - 1);
+
+        for (auto y = min_y; y <= max_y; ++y) {
+            auto py = Splat(y + 0.5f);
+            for (auto x = min_x; x <= max_x; x += 4) {
+                auto px = Splat(static_cast<float>(x)) + kLaneOffsets;
+
+                // Evaluate edge functions of four pixels at once.
+                auto e0 = triangle.a[0] * px + triangle.b[0] * py + triangle.c[0];
+                auto e1 = triangle.a[1] * px + triangle.b[1] * py + triangle.c[1];
+                auto e2 = triangle.a[2] * px + triangle.b[2] * py + triangle.c[2];
+                auto mask = (e0 >= triangle.bias[0]) & (e1 >= triangle.bias[1]) & (e2 >= triangle.bias[2]) &
+                            (px < static_cast<float>(max_x + 1));
+                if (!(mask[0] | mask[1] | mask[2] | mask[3])) {
+                    continue;
+                }
+
+                // Interpolate attributes with perspective correction.
+                auto b0 = e0 * triangle.inv_area;
+                auto b1 = e1 * triangle.inv_area;
+                auto b2 = e2 * triangle.inv_area;
+                auto w = 1.0f / (b0 * triangle.inv_w[0] + b1 * triangle.inv_w[1] + b2 * triangle.inv_w[2]);
+                for (auto i = 0u; i != pipeline.varying_count; ++i) {
+                    lane_varyings[i] = (b0 * triangle.varyings[0][i] +
+                                        b1 * triangle.varyings[1][i] +
+                                        b2 * triangle.varyings[2][i]) * w;
+                }
+
+                // Shade covered pixels.
+                auto row = pixels.data() + static_cast<size_t>(y) * target.GetWidth();
+                for (auto lane = 0; lane != 4; ++lane) {
+                    if (mask[lane]) {
+                        for (auto i = 0u; i != pipeline.varying_count; ++i) {
+                            varyings[i] = lane_varyings[i][lane];
+                        }
+                        row[x + lane] = PackColor(pipeline.fragment_shader(varyings));
+                        ++pixel_count;
+                    }
+                }
+            }
+        }
+    }
+
+    return pixel_count;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,178 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "shader_cache.h"
+
+#include <fmt/format.h>
+#include <fstream>
+
+#include "asset_archive.h"
+#include "file_view.h"
+#include "hash.h"
+#include "utility.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+ShaderCache::ShaderCache(std::unique_ptr<ShaderCompiler> compiler, const std::filesystem::path &directory) :
+_compiler(std::move(compiler)),
+_directory(directory) {
+    if (!_compiler) {
+        throw std::runtime_error("Fail to create a shader cache without a compiler.");
+    }
+    _compiler_identifier = _compiler->GetIdentifier();
+
+    if (!_directory.empty()) {
+        std::filesystem::create_directories(_directory);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void ShaderCache::MountArchive(const AssetArchive *archive, const std::filesystem::path &directory) {
+    _archive = archive;
+    _archive_directory = directory.lexically_normal();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::shared_ptr<ShaderLibrary> ShaderCache::GetLibrary(const std::filesystem::path &path, const ShaderMacros &macros) {
+    if (_archive) {
+        auto name = path.lexically_normal().lexically_relative(_archive_directory).generic_string();
+        if (auto source = _archive->Find(name)) {
+            return GetLibraryFromSource({reinterpret_cast<const char*>(source->data()), source->size()}, macros);
+        }
+    }
+
+    FileView source(path);
+    return GetLibraryFromSource(source.GetString(), macros);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::shared_ptr<ShaderLibrary> ShaderCache::GetLibraryFromSource(std::string_view source,
+                                                                 const ShaderMacros &macros) {
+    auto key = ComputeKey(source, macros);
+
+    // Claim a key under a lock, a library of a claimed key is loaded or compiled once by the first caller.
+    std::promise<std::shared_ptr<ShaderLibrary>> promise;
+    {
+        std::unique_lock lock(_mutex);
+        if (auto iter = _libraries.find(key); iter != _libraries.end()) {
+            ++_statistics.memory_hit_count;
+            auto library = iter->second;
+            lock.unlock();
+            return library.get();
+        }
+        _libraries.emplace(key, promise.get_future().share());
+    }
+
+    // Load or compile without a lock, so other keys aren't blocked behind it.
+    try {
+        auto library = LoadBinary(key);
+        if (library) {
+            std::lock_guard lock(_mutex);
+            ++_statistics.disk_hit_count;
+        } else {
+            auto result = _compiler->Compile(source, macros);
+            if (!result.library) {
+                throw std::runtime_error(fmt::format("Fail to compile a library {:016x}.", key));
+            }
+            StoreBinary(key, result.binary);
+            library = std::move(result.library);
+
+            std::lock_guard lock(_mutex);
+            ++_statistics.compile_count;
+        }
+
+        promise.set_value(library);
+        return library;
+    }
+    catch (...) {
+        // Forget a failed key so a fixed source is compiled again, callers waiting for it fail too.
+        {
+            std::lock_guard lock(_mutex);
+            _libraries.erase(key);
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+uint64_t ShaderCache::ComputeKey(std::string_view source, const ShaderMacros &macros) const {
+    auto key = HashWithSize(_compiler_identifier);
+    for (auto &[name, value] : macros) {
+        key = HashWithSize(value, HashWithSize(name, key));
+    }
+    return HashWithSize(source, key);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void ShaderCache::Clear() {
+    std::lock_guard lock(_mutex);
+    _libraries.clear();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+ShaderCacheStatistics ShaderCache::GetStatistics() const {
+    std::lock_guard lock(_mutex);
+    return _statistics;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::filesystem::path ShaderCache::BuildBinaryPath(uint64_t key) const {
+    return _directory / fmt::format("{:016x}.bin", key);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::shared_ptr<ShaderLibrary> ShaderCache::LoadBinary(uint64_t key) {
+    if (_directory.empty()) {
+        return nullptr;
+    }
+
+    auto path = BuildBinaryPath(key);
+    if (!std::filesystem::exists(path)) {
+        return nullptr;
+    }
+
+    // Treat a broken binary as a miss, it will be overwritten.
+    try {
+        FileView binary(path);
+        return _compiler->Load(binary.GetBytes());
+    }
+    catch (const std::exception &) {
+        return nullptr;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void ShaderCache::StoreBinary(uint64_t key, std::span<const std::byte> binary) {
+    if (_directory.empty() || binary.empty()) {
+        return;
+    }
+
+    // Write to a temporary file and rename it so readers never see a partial binary.
+    auto path = BuildBinaryPath(key);
+    auto temp_path = path;
+    temp_path += ".tmp";
+
+    std::ofstream fout(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!fout.is_open()) {
+        return;
+    }
+    fout.write(reinterpret_cast<const char*>(binary.data()), static_cast<std::streamsize>(binary.size()));
+    fout.close();
+
+    std::error_code error;
+    std::filesystem::rename(temp_path, path, error);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
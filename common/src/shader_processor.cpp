@@ -0,0 +1,166 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "shader_processor.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <stdexcept>
+
+#include "file_view.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr auto kShaderSourceProcessorIdentifier = "shader_source/1";
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Replace comments with spaces while keeping line breaks and literals.
+inline auto StripComments(std::string_view source) {
+    std::string output;
+    output.reserve(source.size());
+
+    for (size_t i = 0; i < source.size(); ++i) {
+        auto c = source[i];
+        auto next = i + 1 < source.size() ? source[i + 1] : '\0';
+
+        if (c == '/' && next == '/') {
+            i = std::min(source.find('\n', i), source.size()) - 1;
+            output += ' ';
+        } else if (c == '/' && next == '*') {
+            auto end = std::min(source.find("*/", i + 2), source.size());
+            output += ' ';
+            output.append(std::count(source.begin() + i, source.begin() + end, '\n'), '\n');
+            i = std::min(end + 1, source.size());
+        } else if (c == '"' || c == '\'') {
+            auto begin = i;
+            for (++i; i < source.size() && source[i] != c && source[i] != '\n'; ++i) {
+                if (source[i] == '\\') {
+                    ++i;
+                }
+            }
+            output.append(source.substr(begin, i - begin + 1));
+        } else {
+            output += c;
+        }
+    }
+
+    return output;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Retrieve the rest of a preprocessor directive after '#', or nothing if a line isn't a directive.
+inline std::string_view FindDirective(std::string_view line) {
+    constexpr std::string_view kWhitespaces = " \t";
+
+    line.remove_prefix(std::min(line.find_first_not_of(kWhitespaces), line.size()));
+    if (!line.starts_with('#')) {
+        return {};
+    }
+    line.remove_prefix(1);
+    line.remove_prefix(std::min(line.find_first_not_of(kWhitespaces), line.size()));
+    return line;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Query whether a line is #pragma once.
+inline auto IsPragmaOnce(std::string_view line) {
+    auto directive = FindDirective(line);
+    return directive.starts_with("pragma") && directive.find("once") != std::string_view::npos;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Retrieve a file name of a local include directive.
+inline std::string_view FindLocalInclude(std::string_view line) {
+    auto directive = FindDirective(line);
+    if (!directive.starts_with("include")) {
+        return {};
+    }
+    directive.remove_prefix(7);
+    directive.remove_prefix(std::min(directive.find_first_not_of(" \t"), directive.size()));
+    if (!directive.starts_with('"')) {
+        return {};
+    }
+
+    auto end = directive.find('"', 1);
+    return end == std::string_view::npos ? std::string_view() : directive.substr(1, end - 1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::string ShaderSourceProcessor::GetIdentifier() const {
+    return kShaderSourceProcessorIdentifier;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+bool ShaderSourceProcessor::Accept(const std::filesystem::path &path) const {
+    return path.extension() == ".metal";
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+AssetCookResult ShaderSourceProcessor::Process(const std::filesystem::path &path,
+                                               std::span<const std::byte> source) const {
+    AssetCookResult result;
+    std::vector<std::filesystem::path> stack = {path.lexically_normal()};
+
+    std::string output;
+    Preprocess(path, {reinterpret_cast<const char*>(source.data()), source.size()}, output, stack, result);
+
+    auto bytes = std::as_bytes(std::span(output));
+    result.data.assign(bytes.begin(), bytes.end());
+    return result;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void ShaderSourceProcessor::Preprocess(const std::filesystem::path &path, std::string_view source,
+                                       std::string &output, std::vector<std::filesystem::path> &stack,
+                                       AssetCookResult &result) const {
+    auto stripped = StripComments(source);
+
+    std::string_view lines = stripped;
+    while (!lines.empty()) {
+        auto end = std::min(lines.find('\n'), lines.size());
+        auto line = lines.substr(0, end);
+        lines.remove_prefix(std::min(end + 1, lines.size()));
+
+        line = line.substr(0, line.find_last_not_of(" \t\r") + 1);
+        if (line.empty() || IsPragmaOnce(line)) {
+            continue;
+        }
+
+        // A system include is resolved by a runtime compiler.
+        auto include = FindLocalInclude(line);
+        if (include.empty()) {
+            output.append(line);
+            output += '\n';
+            continue;
+        }
+
+        auto include_path = (path.parent_path() / include).lexically_normal();
+        if (std::find(stack.begin(), stack.end(), include_path) != stack.end()) {
+            throw std::runtime_error(fmt::format("Fail to include {}, it includes itself.", include_path.string()));
+        }
+
+        // Inline a file once like #pragma once, a directive in a main file only makes a compiler warn.
+        if (std::find(result.dependencies.begin(), result.dependencies.end(), include_path) !=
+            result.dependencies.end()) {
+            continue;
+        }
+        result.dependencies.push_back(include_path);
+
+        FileView view(include_path);
+        stack.push_back(include_path);
+        Preprocess(include_path, view.GetString(), output, stack, result);
+        stack.pop_back();
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,116 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "software_command_executor.h"
+
+#include <fmt/format.h>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+namespace {
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Check a draw can be rasterized, a rasterizer draws a single instance of triangles.
+void CheckDraw(CommandPrimitiveType primitive_type, uint32_t instance_count) {
+    if (primitive_type != CommandPrimitiveType::kTriangle) {
+        throw std::runtime_error(fmt::format("Fail to execute a draw of primitive type {}, only triangles are "
+                                             "rasterized.", static_cast<uint32_t>(primitive_type)));
+    }
+
+    if (instance_count != 1) {
+        throw std::runtime_error(fmt::format("Fail to execute a draw of {} instances, only a single instance is "
+                                             "rasterized.", instance_count));
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+template<typename T>
+std::span<const T> GetIndices(std::span<const std::byte> buffer, uint32_t offset, uint32_t count) {
+    if (offset + count * sizeof(T) > buffer.size()) {
+        throw std::runtime_error(fmt::format("Fail to execute a draw of {} indices at {}, a buffer is {} bytes.",
+                                             count, offset, buffer.size()));
+    }
+
+    return {reinterpret_cast<const T *>(buffer.data() + offset), count};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+
+SoftwareCommandExecutor::SoftwareCommandExecutor(Rasterizer *rasterizer) :
+_rasterizer(rasterizer) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void SoftwareCommandExecutor::Execute(const CommandStream &stream, const SoftwareCommandResources &resources,
+                                      RasterTarget &target) {
+    // Tiles of a draw are rasterized in parallel, so recorders are executed one by one in order.
+    for (auto i = 0u; i != stream.GetRecorderCount(); ++i) {
+        Execute(stream.GetRecorder(i), resources, target);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void SoftwareCommandExecutor::Execute(const CommandRecorder &recorder, const SoftwareCommandResources &resources,
+                                      RasterTarget &target) {
+    const RasterPipeline *pipeline = nullptr;
+    _bindings = {};
+
+    recorder.Replay([&](const auto &command) {
+        using Command = std::decay_t<decltype(command)>;
+
+        if constexpr (std::is_same_v<Command, SetPipelineCommand>) {
+            pipeline = resources.pipelines[command.pipeline];
+        } else if constexpr (std::is_same_v<Command, SetBufferCommand>) {
+            _bindings[static_cast<size_t>(command.stage)][command.index] =
+                resources.buffers[command.buffer].data() + command.offset;
+        } else if constexpr (std::is_same_v<Command, SetBytesCommand>) {
+            _bindings[static_cast<size_t>(command.stage)][command.index] = GetBytes(command);
+        } else if constexpr (std::is_same_v<Command, DrawCommand>) {
+            CheckDraw(command.primitive_type, command.instance_count);
+
+            _indices.resize(command.vertex_count);
+            std::iota(_indices.begin(), _indices.end(), command.vertex_start);
+            _rasterizer->DrawIndexed(target, *pipeline, std::span<const uint32_t>(_indices));
+        } else if constexpr (std::is_same_v<Command, DrawIndexedCommand>) {
+            CheckDraw(command.primitive_type, command.instance_count);
+
+            auto &buffer = resources.buffers[command.index_buffer];
+            if (command.base_vertex == 0 && command.index_type == CommandIndexType::kUInt16) {
+                _rasterizer->DrawIndexed(target, *pipeline,
+                                         GetIndices<uint16_t>(buffer, command.index_offset, command.index_count));
+            } else if (command.base_vertex == 0) {
+                _rasterizer->DrawIndexed(target, *pipeline,
+                                         GetIndices<uint32_t>(buffer, command.index_offset, command.index_count));
+            } else {
+                // A rasterizer doesn't offset indices, they are offset into a copy.
+                _indices.resize(command.index_count);
+                auto copy = [&](auto indices) {
+                    for (auto i = 0u; i != command.index_count; ++i) {
+                        _indices[i] = static_cast<uint32_t>(static_cast<int64_t>(indices[i]) + command.base_vertex);
+                    }
+                };
+                if (command.index_type == CommandIndexType::kUInt16) {
+                    copy(GetIndices<uint16_t>(buffer, command.index_offset, command.index_count));
+                } else {
+                    copy(GetIndices<uint32_t>(buffer, command.index_offset, command.index_count));
+                }
+                _rasterizer->DrawIndexed(target, *pipeline, std::span<const uint32_t>(_indices));
+            }
+        }
+    });
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,102 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "software_device.h"
+
+#include <fmt/format.h>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+SoftwareSwapchain::SoftwareSwapchain(uint32_t image_count) :
+_images(image_count) {
+    if (_images.empty()) {
+        throw std::runtime_error("Fail to create a swapchain without images.");
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void SoftwareSwapchain::Resize(const Resolution &resolution) {
+    _resolution = resolution;
+    for (auto &image : _images) {
+        image.Resize(GetWidth(resolution), GetHeight(resolution));
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void SoftwareSwapchain::AcquireNextImage() {
+    _image_index = (_image_index + 1) % _images.size();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Resolution SoftwareSwapchain::GetResolution() const {
+    return _resolution;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+uint32_t SoftwareSwapchain::GetImageCount() const {
+    return _images.size();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+SoftwareDevice::SoftwareDevice(uint32_t frame_count, uint32_t image_count, JobSystem *job_system) :
+_semaphore(frame_count),
+_swapchain(image_count),
+_rasterizer(job_system),
+_command_executor(&_rasterizer) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void SoftwareDevice::WaitForFrame() {
+    _semaphore.acquire();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void SoftwareDevice::BeginFrame() {
+    _swapchain.AcquireNextImage();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void SoftwareDevice::EndFrame() {
+    _semaphore.release();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void SoftwareDevice::WaitIdle() {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Backend SoftwareDevice::GetBackend() const {
+    return Backend::kSoftware;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::string SoftwareDevice::GetName() const {
+    return fmt::format("Software Rasterizer ({} threads)", _rasterizer.GetThreadCount());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Swapchain* SoftwareDevice::GetSwapchain() {
+    return &_swapchain;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::chrono::duration<double> SoftwareDevice::GetGpuTime() const {
+    return std::chrono::duration<double>::zero();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
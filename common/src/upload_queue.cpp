@@ -0,0 +1,159 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "upload_queue.h"
+
+#include <cstring>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+UploadQueue::UploadQueue(id<MTLDevice> device, id<MTLCommandQueue> command_queue, uint64_t size) :
+_device(device),
+_command_queue(command_queue),
+_staging_buffer([device newBufferWithLength:size
+                                    options:MTLResourceStorageModeShared | MTLResourceCPUCacheModeWriteCombined]),
+_ring(_staging_buffer.contents, size),
+_fence_state(std::make_shared<FenceState>()) {
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void UploadQueue::Upload(id<MTLBuffer> buffer, uint64_t offset, const void *data, uint64_t size) {
+    auto [source, source_offset] = Stage(data, size);
+
+    Copy copy;
+    copy.source = source;
+    copy.source_offset = source_offset;
+    copy.size = size;
+    copy.buffer = buffer;
+    copy.offset = offset;
+    _copies.push_back(copy);
+    ++_statistics.copy_count;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void UploadQueue::Upload(id<MTLTexture> texture, uint32_t level, uint32_t slice, MTLRegion region, const void *data,
+                         uint64_t bytes_per_row, uint64_t bytes_per_image) {
+    // Bytes per image are zero for a 2D texture, an image is as high as a region then.
+    auto image_size = bytes_per_image ? bytes_per_image : bytes_per_row * region.size.height;
+    auto [source, source_offset] = Stage(data, image_size * region.size.depth);
+
+    Copy copy;
+    copy.source = source;
+    copy.source_offset = source_offset;
+    copy.texture = texture;
+    copy.level = level;
+    copy.slice = slice;
+    copy.region = region;
+    copy.bytes_per_row = bytes_per_row;
+    copy.bytes_per_image = bytes_per_image;
+    _copies.push_back(copy);
+    ++_statistics.copy_count;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void UploadQueue::Flush(id<MTLCommandBuffer> command_buffer) {
+    if (_copies.empty()) {
+        return;
+    }
+
+    auto encoder = [command_buffer blitCommandEncoder];
+    for (auto &copy : _copies) {
+        if (copy.buffer) {
+            [encoder copyFromBuffer:copy.source sourceOffset:copy.source_offset
+                           toBuffer:copy.buffer destinationOffset:copy.offset size:copy.size];
+        } else {
+            [encoder copyFromBuffer:copy.source sourceOffset:copy.source_offset
+                  sourceBytesPerRow:copy.bytes_per_row sourceBytesPerImage:copy.bytes_per_image
+                         sourceSize:copy.region.size toTexture:copy.texture destinationSlice:copy.slice
+                   destinationLevel:copy.level destinationOrigin:copy.region.origin];
+        }
+    }
+    [encoder endEncoding];
+    _copies.clear();
+
+    // Staging memory of copies is released when the command buffer has completed.
+    auto fence = ++_fence;
+    _ring.Submit(fence);
+
+    auto fence_state = _fence_state;
+    [command_buffer addCompletedHandler:^(id<MTLCommandBuffer> commandBuffer) {
+        Signal(*fence_state, fence);
+    }];
+    ++_statistics.flush_count;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void UploadQueue::Submit() {
+    if (_copies.empty()) {
+        return;
+    }
+
+    auto command_buffer = [_command_queue commandBuffer];
+    Flush(command_buffer);
+    [command_buffer commit];
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::pair<id<MTLBuffer>, uint64_t> UploadQueue::Stage(const void *data, uint64_t size) {
+    _ring.Retire(GetCompletedFence());
+
+    auto allocation = _ring.Allocate(size);
+    if (!allocation && size <= _ring.GetSize()) {
+        ++_statistics.stall_count;
+
+        // Wait for command buffers were committed before, they complete in order.
+        auto command_buffer = [_command_queue commandBuffer];
+        auto flushed = !_copies.empty();
+        Flush(command_buffer);
+        [command_buffer commit];
+        [command_buffer waitUntilCompleted];
+
+        // A completed handler may run after waiting returns.
+        if (flushed) {
+            Signal(*_fence_state, _fence);
+        }
+        _ring.Retire(GetCompletedFence());
+        allocation = _ring.Allocate(size);
+    }
+
+    // Data larger than a ring, or memory held by a command buffer isn't committed yet, gets its own buffer.
+    if (!allocation) {
+        ++_statistics.dedicated_count;
+        return {[_device newBufferWithBytes:data length:size options:MTLResourceStorageModeShared], 0};
+    }
+
+    std::memcpy(allocation->data, data, size);
+    return {_staging_buffer, allocation->offset};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+uint64_t UploadQueue::GetCompletedFence() const {
+    std::lock_guard lock(_fence_state->mutex);
+    return _fence_state->completed;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void UploadQueue::Signal(FenceState &fence_state, uint64_t fence) {
+    std::lock_guard lock(fence_state.mutex);
+    if (fence <= fence_state.completed) {
+        return;
+    }
+
+    // Advance the completed fence over every signaled fence after it.
+    fence_state.signaled.insert(fence);
+    while (!fence_state.signaled.empty() && *fence_state.signaled.begin() == fence_state.completed + 1) {
+        fence_state.signaled.erase(fence_state.signaled.begin());
+        ++fence_state.completed;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,77 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include "upload_ring.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <stdexcept>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+UploadRing::UploadRing(void *data, uint64_t size, uint64_t alignment) :
+_data(static_cast<std::byte*>(data)),
+_size(size & ~(alignment - 1)),
+_alignment(alignment) {
+    if (!alignment || (alignment & (alignment - 1))) {
+        throw std::runtime_error(fmt::format("Fail to create an upload ring: {} isn't a power of two.", alignment));
+    }
+
+    if (!_data || !_size) {
+        throw std::runtime_error("Fail to create an upload ring: no memory.");
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::optional<UploadRingAllocation> UploadRing::Allocate(uint64_t size) {
+    auto position = (_head + _alignment - 1) & ~(_alignment - 1);
+
+    // Skip the rest of memory if an allocation doesn't fit before the end.
+    auto offset = position % _size;
+    if (offset + size > _size) {
+        position += _size - offset;
+        offset = 0;
+    }
+
+    // Nothing is live in an empty ring, so skipped memory isn't held by anything.
+    if (_head == _tail) {
+        _tail = position;
+    }
+
+    if (position + size - _tail > _size) {
+        return std::nullopt;
+    }
+
+    _head = position + size;
+    _peak_size = std::max(_peak_size, GetUsedSize());
+
+    return UploadRingAllocation{_data + offset, offset};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void UploadRing::Submit(uint64_t fence) {
+    if (!_batches.empty() && fence <= _batches.back().fence) {
+        throw std::runtime_error(fmt::format("Fail to submit an upload batch: fence {} doesn't increase.", fence));
+    }
+
+    // An empty batch has nothing to release.
+    auto begin = _batches.empty() ? _tail : _batches.back().end;
+    if (_head != begin) {
+        _batches.push_back({fence, _head});
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void UploadRing::Retire(uint64_t completed_fence) {
+    while (!_batches.empty() && _batches.front().fence <= completed_fence) {
+        _tail = _batches.front().end;
+        _batches.pop_front();
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -4,29 +4,27 @@
 //
 
 #include "utility.h"
+#include "file_view.h"
 
 #include <fmt/format.h>
-#include <fstream>
 
 //----------------------------------------------------------------------------------------------------------------------
 
 std::string ReadFile(const std::filesystem::path &path) {
-    std::basic_ifstream<char> fin(path, std::ios::in | std::ios::binary);
-    if (!fin.is_open()) {
-        throw std::runtime_error(fmt::format("Fail to open {}.", path.string()));
-    }
-    return std::string(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+    return std::string(FileView(path).GetString());
 }
 
 //----------------------------------------------------------------------------------------------------------------------
 
+#ifdef __OBJC__
+
 id<MTLFunction> CompileShader(id<MTLDevice> device, const std::filesystem::path &file_path,
                               const std::string &entrypoint) {
-    auto source = ReadFile(file_path);
+    FileView source(file_path);
 
     // Create a library.
     NSError* error;
-    auto library = [device newLibraryWithSource:@(source.data()) options:nullptr error:&error];
+    auto library = [device newLibraryWithSource:MakeString(source.GetString()) options:nullptr error:&error];
     if (error) {
         throw std::runtime_error(fmt::format("Fail to create a library: {}.", error.description.UTF8String));
     }
@@ -40,4 +38,6 @@ id<MTLFunction> CompileShader(id<MTLDevice> device, const std::filesystem::path
     return function;
 }
 
+#endif
+
 //----------------------------------------------------------------------------------------------------------------------
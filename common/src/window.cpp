@@ -37,7 +37,7 @@ static CVReturn DisplayLinkOutputCallback(CVDisplayLinkRef displayLink,
         auto view = (__bridge View *)displayLinkContext;
         auto example = view->example;
         if (example) {
-            example->Update();
+            // The simulation thread updates frames, a display link only renders them.
             example->Render();
         }
     }
@@ -69,7 +69,14 @@ static CVReturn DisplayLinkOutputCallback(CVDisplayLinkRef displayLink,
 - (void)setFrameSize:(NSSize)size {
     [super setFrameSize:size];
     if (example) {
-        example->Resize({size.width, size.height});
+        example->Resize({size.width, size.height}, self.inLiveResize);
+    }
+}
+
+- (void)viewDidEndLiveResize {
+    [super viewDidEndLiveResize];
+    if (example) {
+        example->Resize({self.bounds.size.width, self.bounds.size.height});
     }
 }
 
@@ -91,70 +98,83 @@ static CVReturn DisplayLinkOutputCallback(CVDisplayLinkRef displayLink,
 }
 
 - (void)mouseMoved:(NSEvent *)event {
-    ImGui_ImplOSX_HandleEvent(event, self);
+    [self HandleEvent:event];
     if (example) {
-        example->OnMouseMove(event, [self GetMousePoint:event]);
+        auto point = [self GetMousePoint:event];
+        example->OnMouseMove(point.x, point.y);
     }
 }
 
 - (void)mouseDown:(NSEvent *)event {
-    ImGui_ImplOSX_HandleEvent(event, self);
+    [self HandleEvent:event];
     if (example) {
-        example->OnMouseButtonDown(event, [self GetMousePoint:event]);
+        auto point = [self GetMousePoint:event];
+        example->OnMouseButtonDown(point.x, point.y);
     }
 }
 
 - (void)rightMouseDown:(NSEvent *)event {
-    ImGui_ImplOSX_HandleEvent(event, self);
+    [self HandleEvent:event];
 }
 
 - (void)otherMouseDown:(NSEvent *)event {
-    ImGui_ImplOSX_HandleEvent(event, self);
+    [self HandleEvent:event];
 }
 
 - (void)mouseUp:(NSEvent *)event {
-    ImGui_ImplOSX_HandleEvent(event, self);
+    [self HandleEvent:event];
     if (example) {
-        example->OnMouseButtonDown(event, [self GetMousePoint:event]);
+        auto point = [self GetMousePoint:event];
+        example->OnMouseButtonUp(point.x, point.y);
     }
 }
 
 - (void)rightMouseUp:(NSEvent *)event {
-    ImGui_ImplOSX_HandleEvent(event, self);
+    [self HandleEvent:event];
 }
 
 - (void)otherMouseUp:(NSEvent *)event {
-    ImGui_ImplOSX_HandleEvent(event, self);
+    [self HandleEvent:event];
 }
 
 - (void)mouseDragged:(NSEvent *)event {
-    ImGui_ImplOSX_HandleEvent(event, self);
+    [self HandleEvent:event];
     if (example) {
-        example->OnMouseMove(event, [self GetMousePoint:event]);
+        auto point = [self GetMousePoint:event];
+        example->OnMouseMove(point.x, point.y, true);
     }
 }
 
 - (void)rightMouseDragged:(NSEvent *)event {
-    ImGui_ImplOSX_HandleEvent(event, self);
+    [self HandleEvent:event];
 }
 
 - (void)otherMouseDragged:(NSEvent *)event {
-    ImGui_ImplOSX_HandleEvent(event, self);
+    [self HandleEvent:event];
 }
 
 - (void)scrollWheel:(NSEvent *)event {
-    ImGui_ImplOSX_HandleEvent(event, self);
+    [self HandleEvent:event];
     if (example) {
         example->OnMouseWheel(-[event deltaY]);
     }
 }
 
 - (void)keyDown:(NSEvent*)event {
-    ImGui_ImplOSX_HandleEvent(event, self);
+    [self HandleEvent:event];
 }
 
 - (void)keyUp:(NSEvent*)event {
+    [self HandleEvent:event];
+}
+
+- (void)HandleEvent:(NSEvent *)event {
     ImGui_ImplOSX_HandleEvent(event, self);
+
+    // Any event may change ImGui, so an idle example renders a frame.
+    if (example) {
+        example->Invalidate();
+    }
 }
 
 - (CGDirectDisplayID)GetDirectDisplayID {
@@ -187,6 +207,7 @@ void Window::MainLoop(Example *example) {
     example->Init();
     example->Resize(GetResolution());
 
+    example->StartSimulation();
     _view->example = example;
     [NSApp run];
 }
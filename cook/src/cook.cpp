@@ -0,0 +1,52 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <fmt/format.h>
+#include <common/asset_cooker.h>
+#include <common/job_system.h>
+#include <common/shader_processor.h>
+#include <iostream>
+#include <string>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    if (argc != 3 && !(argc == 5 && std::string(argv[3]) == "--threads")) {
+        std::cerr << fmt::format("Usage: {} <asset directory> <output directory> [--threads <count>]", argv[0])
+                  << std::endl;
+        return 1;
+    }
+
+    try {
+        std::filesystem::path output_directory = argv[2];
+
+        // The database is kept next to the output so it is never packed with cooked assets.
+        auto database_path = output_directory.lexically_normal();
+        if (!database_path.has_filename()) {
+            database_path = database_path.parent_path();
+        }
+        database_path += ".cook";
+
+        JobSystem job_system(argc == 5 ? std::stoul(argv[4]) : 0);
+        AssetCooker cooker(&job_system);
+        cooker.AddProcessor(std::make_unique<ShaderSourceProcessor>());
+
+        auto statistics = cooker.Cook(argv[1], output_directory, database_path);
+        for (auto &error : statistics.errors) {
+            std::cerr << error << std::endl;
+        }
+        std::cout << fmt::format("Cooked {}, skipped {}, removed {}, failed {} assets in {:.3f} ms.",
+                                 statistics.cooked_count, statistics.skipped_count, statistics.removed_count,
+                                 statistics.failed_count, statistics.elapsed_time.count() * 1000.0) << std::endl;
+
+        return statistics.failed_count ? 1 : 0;
+    }
+    catch (const std::exception &exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
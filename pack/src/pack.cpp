@@ -0,0 +1,32 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <fmt/format.h>
+#include <common/asset_archive.h>
+#include <iostream>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        std::cerr << fmt::format("Usage: {} <asset directory> <archive>", argv[0]) << std::endl;
+        return 1;
+    }
+
+    try {
+        AssetArchiveWriter writer;
+        writer.AddDirectory(argv[1]);
+        writer.Write(argv[2]);
+        std::cout << fmt::format("Packed {} assets into {}.", writer.GetCount(), argv[2]) << std::endl;
+    }
+    catch (const std::exception &exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -3,20 +3,19 @@
 // See "LICENSE" for license information.
 //
 
-#include <common/window.h>
 #include <common/example.h>
-#include <iostream>
+#include <common/vector_math.h>
 
 //----------------------------------------------------------------------------------------------------------------------
 
-const auto kLightSteelBlue = MTLClearColorMake(0.69, 0.77, 0.87, 1.0);
+const auto kLightSteelBlue = simd_make_float4(0.69f, 0.77f, 0.87f, 1.0f);
 
 //----------------------------------------------------------------------------------------------------------------------
 
 class Template : public Example {
 public:
-    Template() :
-        Example("Template") {
+    explicit Template(const Arguments &arguments) :
+        Example("Template", arguments) {
     }
 
 protected:
@@ -27,6 +26,7 @@ protected:
     }
 
     void OnResize(const Resolution &resolution) override {
+#ifdef __OBJC__
         // Update a viewport.
         _viewport.width = static_cast<double>(GetWidth(resolution));
         _viewport.height = static_cast<double>(GetHeight(resolution));
@@ -34,17 +34,31 @@ protected:
         // Update a scissor rect.
         _scissor_rect.width = GetWidth(resolution);
         _scissor_rect.height = GetHeight(resolution);
+#endif
     }
 
     void OnUpdate(uint32_t index) override {
     }
 
     void OnRender(uint32_t index) override {
+        if (_software_device) {
+            auto &image = _software_device->GetSoftwareSwapchain()->GetImage();
+            image.Clear({kLightSteelBlue.x, kLightSteelBlue.y, kLightSteelBlue.z, kLightSteelBlue.w});
+            return;
+        }
+
+        // A null device has no image to clear.
+        if (!_metal_device) {
+            return;
+        }
+
+#ifdef __OBJC__
         auto desc = [MTLRenderPassDescriptor new];
-        desc.colorAttachments[0].texture = _drawable.texture;
+        desc.colorAttachments[0].texture = _color_texture;
         desc.colorAttachments[0].loadAction = MTLLoadActionClear;
         desc.colorAttachments[0].storeAction = MTLStoreActionStore;
-        desc.colorAttachments[0].clearColor = kLightSteelBlue;
+        desc.colorAttachments[0].clearColor = MTLClearColorMake(kLightSteelBlue.x, kLightSteelBlue.y,
+                                                                kLightSteelBlue.z, kLightSteelBlue.w);
 
         auto encoder = [_command_buffer renderCommandEncoderWithDescriptor:desc];
         [encoder setViewport:_viewport];
@@ -53,26 +67,20 @@ protected:
         RecordDrawImGuiCommands(desc, encoder);
 
         [encoder endEncoding];
+#endif
     }
 
 private:
+#ifdef __OBJC__
     MTLViewport _viewport = {0.0, 0.0, 0.0, 0.0, 0.0, 1.0};
     MTLScissorRect _scissor_rect = {0, 0, 0, 0};
+#endif
 };
 
 //----------------------------------------------------------------------------------------------------------------------
 
 int main(int argc, char *argv[]) {
-    @autoreleasepool {
-        try {
-            auto example = std::make_unique<Template>();
-            Window::GetInstance()->MainLoop(example.get());
-        }
-        catch (const std::exception &exception) {
-            std::cerr << exception.what() << std::endl;
-        }
-    }
-    return 0;
+    return RunExample<Template>(argc, argv);
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,228 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/asset_archive.h>
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+#include "test.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Query whether a function throws std::runtime_error.
+template<typename F>
+bool Throws(F &&function) {
+    try {
+        function();
+    }
+    catch (const std::runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Retrieve a directory archives of tests are written to.
+std::filesystem::path GetTestDirectory() {
+    return std::filesystem::temp_directory_path() / "asset_archive_test";
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Make bytes of a string.
+std::vector<std::byte> MakeBytes(std::string_view text) {
+    auto data = reinterpret_cast<const std::byte *>(text.data());
+    return {data, data + text.size()};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Read a whole file.
+std::vector<std::byte> ReadBytes(const std::filesystem::path &path) {
+    std::ifstream fin(path, std::ios::in | std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+    auto data = reinterpret_cast<const std::byte *>(bytes.data());
+    return {data, data + bytes.size()};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Write a whole file.
+void WriteBytes(const std::filesystem::path &path, std::span<const std::byte> bytes) {
+    std::ofstream fout(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    fout.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestRoundTrip() {
+    auto directory = GetTestDirectory();
+
+    // Assets of odd sizes, an empty one and binary data, added out of order.
+    std::vector<std::pair<std::string, std::vector<std::byte>>> assets = {
+        {"textures/checker.raw", std::vector<std::byte>(1021, std::byte(0xa5))},
+        {"empty.txt", {}},
+        {"shaders/pass_through.metal", MakeBytes("vertex VSMain() {}")},
+        {"a", MakeBytes("x")}
+    };
+    for (auto i = 0u; i != 500; ++i) {
+        assets.emplace_back(fmt::format("meshes/mesh_{}.bin", i),
+                            std::vector<std::byte>(i, static_cast<std::byte>(i)));
+    }
+
+    AssetArchiveWriter writer;
+    for (auto &[name, data] : assets) {
+        writer.Add(name, data);
+    }
+    CHECK(writer.GetCount() == assets.size());
+
+    auto path = directory / "round_trip.pak";
+    writer.Write(path);
+    CHECK(!std::filesystem::exists(directory / "round_trip.pak.tmp"));
+
+    // Every asset is found by its name with the same content.
+    AssetArchive archive(path);
+    CHECK(archive.GetCount() == assets.size());
+    for (auto &[name, data] : assets) {
+        auto bytes = archive.Find(name);
+        CHECK(bytes.has_value());
+        CHECK(std::equal(bytes->begin(), bytes->end(), data.begin(), data.end()));
+        CHECK(archive.Contains(name));
+    }
+    CHECK(archive.GetString("shaders/pass_through.metal") == "vertex VSMain() {}");
+    CHECK(archive.GetBytes("empty.txt").empty());
+
+    // Blobs and the index are aligned, and the index is sorted by hashes for a binary search.
+    auto bytes = ReadBytes(path);
+    AssetArchiveHeader header;
+    std::copy_n(bytes.data(), sizeof(header), reinterpret_cast<std::byte *>(&header));
+    CHECK(header.entry_count == assets.size());
+    CHECK(header.index_offset % kAssetArchiveAlignment == 0);
+
+    std::vector<AssetArchiveEntry> entries(header.entry_count);
+    std::copy_n(bytes.data() + header.index_offset, entries.size() * sizeof(AssetArchiveEntry),
+                reinterpret_cast<std::byte *>(entries.data()));
+    for (auto &entry : entries) {
+        CHECK(entry.data_offset % kAssetArchiveAlignment == 0);
+    }
+    CHECK(std::is_sorted(entries.begin(), entries.end(), [](auto &lhs, auto &rhs) {
+        return lhs.hash < rhs.hash;
+    }));
+
+    // The same assets make the same archive whatever order they are added in.
+    std::reverse(assets.begin(), assets.end());
+    AssetArchiveWriter reversed_writer;
+    for (auto &[name, data] : assets) {
+        reversed_writer.Add(name, data);
+    }
+    auto reversed_path = directory / "reversed.pak";
+    reversed_writer.Write(reversed_path);
+    CHECK(ReadBytes(reversed_path) == bytes);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestMissingName() {
+    auto directory = GetTestDirectory();
+
+    AssetArchiveWriter writer;
+    writer.Add("shaders/shader.metal", MakeBytes("kernel"));
+    auto path = directory / "missing.pak";
+    writer.Write(path);
+
+    // A prefix, a different case or a name of another directory isn't a match.
+    AssetArchive archive(path);
+    for (auto name : {"shaders/shader", "Shaders/shader.metal", "shader.metal", ""}) {
+        CHECK(!archive.Find(name));
+        CHECK(!archive.Contains(name));
+        CHECK(Throws([&archive, name]() { auto bytes = archive.GetBytes(name); }));
+    }
+
+    // A name can't be added twice.
+    writer.Add("shaders/shader.metal", MakeBytes("fragment"));
+    CHECK(Throws([&writer, &directory]() { writer.Write(directory / "duplicate.pak"); }));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestCorruptHeader() {
+    auto directory = GetTestDirectory();
+
+    AssetArchiveWriter writer;
+    writer.Add("a.txt", MakeBytes("alpha"));
+    writer.Add("b.txt", MakeBytes("bravo"));
+    auto path = directory / "valid.pak";
+    writer.Write(path);
+    auto bytes = ReadBytes(path);
+
+    AssetArchiveHeader header;
+    std::copy_n(bytes.data(), sizeof(header), reinterpret_cast<std::byte *>(&header));
+
+    // Every archive is rejected on load rather than read out of bounds later.
+    auto corrupt_path = directory / "corrupt.pak";
+    auto Load = [&corrupt_path](std::span<const std::byte> corrupt_bytes) {
+        WriteBytes(corrupt_path, corrupt_bytes);
+        return Throws([&corrupt_path]() { AssetArchive archive(corrupt_path); });
+    };
+    auto LoadWithHeader = [&bytes, &Load](const AssetArchiveHeader &corrupt_header) {
+        auto corrupt_bytes = bytes;
+        std::copy_n(reinterpret_cast<const std::byte *>(&corrupt_header), sizeof(corrupt_header),
+                    corrupt_bytes.data());
+        return Load(corrupt_bytes);
+    };
+
+    CHECK(!Load(bytes));
+    CHECK(Load(std::span(bytes).first(sizeof(header) - 1)));
+
+    auto corrupt_header = header;
+    corrupt_header.magic = 0;
+    CHECK(LoadWithHeader(corrupt_header));
+
+    corrupt_header = header;
+    corrupt_header.version = kAssetArchiveVersion + 1;
+    CHECK(LoadWithHeader(corrupt_header));
+
+    corrupt_header = header;
+    corrupt_header.entry_count = 1000;
+    CHECK(LoadWithHeader(corrupt_header));
+
+    corrupt_header = header;
+    corrupt_header.index_offset = bytes.size();
+    CHECK(LoadWithHeader(corrupt_header));
+
+    corrupt_header = header;
+    corrupt_header.index_offset += 1;
+    CHECK(LoadWithHeader(corrupt_header));
+
+    corrupt_header = header;
+    corrupt_header.names_offset = bytes.size() + 1;
+    CHECK(LoadWithHeader(corrupt_header));
+
+    // An entry pointing past the end is rejected too.
+    auto corrupt_bytes = bytes;
+    AssetArchiveEntry entry;
+    std::copy_n(bytes.data() + header.index_offset, sizeof(entry), reinterpret_cast<std::byte *>(&entry));
+    entry.data_size = bytes.size();
+    std::copy_n(reinterpret_cast<const std::byte *>(&entry), sizeof(entry), corrupt_bytes.data() + header.index_offset);
+    CHECK(Load(corrupt_bytes));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    std::filesystem::remove_all(GetTestDirectory());
+    std::filesystem::create_directories(GetTestDirectory());
+
+    RUN(TestRoundTrip);
+    RUN(TestMissingName);
+    RUN(TestCorruptHeader);
+
+    std::filesystem::remove_all(GetTestDirectory());
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,199 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/asset_cooker.h>
+#include <common/file_view.h>
+#include <common/shader_processor.h>
+#include <atomic>
+#include <fstream>
+#include <stdexcept>
+
+#include "test.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A shader processor counts shaders it processes.
+class CountingShaderProcessor : public ShaderSourceProcessor {
+public:
+    //! Constructor.
+    //! \param process_count A counter is incremented for every processed shader.
+    explicit CountingShaderProcessor(std::atomic<uint32_t> *process_count) :
+        _process_count(process_count) {
+    }
+
+    AssetCookResult Process(const std::filesystem::path &path, std::span<const std::byte> source) const override {
+        ++*_process_count;
+        return ShaderSourceProcessor::Process(path, source);
+    }
+
+private:
+    std::atomic<uint32_t> *_process_count = nullptr;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A temporary source directory, an output directory and a database of a cook.
+struct CookDirectories {
+    std::filesystem::path source;
+    std::filesystem::path output;
+    std::filesystem::path database;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Make empty directories of a test in a temporary directory.
+CookDirectories MakeCookDirectories(const std::string &name) {
+    auto root = std::filesystem::temp_directory_path() / "asset_cooker_test" / name;
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root / "asset");
+    return {root / "asset", root / "cooked", root / "cooked.cook"};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Write a whole file.
+void WriteFile(const std::filesystem::path &path, const std::string &content) {
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream fout(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    fout << content;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Read a whole file.
+std::string ReadFile(const std::filesystem::path &path) {
+    FileView view(path);
+    return std::string(view.GetString());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Write sources of a test, two shaders include a shared header and a texture is copied as is.
+void WriteSources(const std::filesystem::path &directory) {
+    WriteFile(directory / "shaders" / "common.h", "float4 Tint() { return float4(1.0); }\n");
+    WriteFile(directory / "shaders" / "lit.metal", "#include \"common.h\"\nfragment float4 Lit() { return Tint(); }\n");
+    WriteFile(directory / "shaders" / "unlit.metal", "// Unlit.\nfragment float4 Unlit() { return 0.0; }\n");
+    WriteFile(directory / "textures" / "checker.raw", std::string(300, 'x'));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestUnchangedInputsSkipped() {
+    auto directories = MakeCookDirectories("unchanged");
+    WriteSources(directories.source);
+
+    JobSystem job_system(2);
+    std::atomic<uint32_t> process_count = 0;
+    AssetCooker cooker(&job_system);
+    cooker.AddProcessor(std::make_unique<CountingShaderProcessor>(&process_count));
+
+    // Everything is cooked the first time, shaders are processed and other assets are copied.
+    auto statistics = cooker.Cook(directories.source, directories.output, directories.database);
+    CHECK(statistics.cooked_count == 4);
+    CHECK(statistics.skipped_count == 0);
+    CHECK(statistics.failed_count == 0);
+    CHECK(process_count == 2);
+    CHECK(ReadFile(directories.output / "shaders" / "lit.metal").find("Tint() { return") != std::string::npos);
+    CHECK(ReadFile(directories.output / "shaders" / "unlit.metal").find("// Unlit.") == std::string::npos);
+    CHECK(ReadFile(directories.output / "textures" / "checker.raw") == std::string(300, 'x'));
+
+    // Nothing is cooked again while inputs stay the same, even by another cooker.
+    for (auto i = 0; i != 3; ++i) {
+        AssetCooker next_cooker(&job_system);
+        next_cooker.AddProcessor(std::make_unique<CountingShaderProcessor>(&process_count));
+        statistics = next_cooker.Cook(directories.source, directories.output, directories.database);
+        CHECK(statistics.cooked_count == 0);
+        CHECK(statistics.skipped_count == 4);
+        CHECK(process_count == 2);
+    }
+
+    // A source with the same content rewritten is still skipped, keys depend on content rather than time.
+    WriteSources(directories.source);
+    statistics = cooker.Cook(directories.source, directories.output, directories.database);
+    CHECK(statistics.cooked_count == 0);
+
+    // A deleted output is cooked again.
+    std::filesystem::remove(directories.output / "textures" / "checker.raw");
+    statistics = cooker.Cook(directories.source, directories.output, directories.database);
+    CHECK(statistics.cooked_count == 1);
+    CHECK(std::filesystem::exists(directories.output / "textures" / "checker.raw"));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestChangedDependencyRebuilt() {
+    auto directories = MakeCookDirectories("dependency");
+    WriteSources(directories.source);
+
+    JobSystem job_system(2);
+    std::atomic<uint32_t> process_count = 0;
+    AssetCooker cooker(&job_system);
+    cooker.AddProcessor(std::make_unique<CountingShaderProcessor>(&process_count));
+    cooker.Cook(directories.source, directories.output, directories.database);
+    process_count = 0;
+
+    // A changed header cooks the shader including it and the header itself, not the other shader.
+    WriteFile(directories.source / "shaders" / "common.h", "float4 Tint() { return float4(0.5); }\n");
+    auto statistics = cooker.Cook(directories.source, directories.output, directories.database);
+    CHECK(statistics.cooked_count == 2);
+    CHECK(statistics.skipped_count == 2);
+    CHECK(process_count == 1);
+    CHECK(ReadFile(directories.output / "shaders" / "lit.metal").find("float4(0.5)") != std::string::npos);
+
+    // A changed shader cooks only itself.
+    WriteFile(directories.source / "shaders" / "unlit.metal", "fragment float4 Unlit() { return 1.0; }\n");
+    statistics = cooker.Cook(directories.source, directories.output, directories.database);
+    CHECK(statistics.cooked_count == 1);
+    CHECK(process_count == 2);
+
+    // A removed dependency fails the shader including it, and it is retried on the next cook.
+    std::filesystem::remove(directories.source / "shaders" / "common.h");
+    statistics = cooker.Cook(directories.source, directories.output, directories.database);
+    CHECK(statistics.failed_count == 1);
+    CHECK(statistics.errors.size() == 1);
+    CHECK(statistics.removed_count == 1);
+    CHECK(!std::filesystem::exists(directories.output / "shaders" / "common.h"));
+
+    WriteFile(directories.source / "shaders" / "common.h", "float4 Tint() { return float4(0.25); }\n");
+    statistics = cooker.Cook(directories.source, directories.output, directories.database);
+    CHECK(statistics.failed_count == 0);
+    CHECK(statistics.cooked_count == 2);
+    CHECK(ReadFile(directories.output / "shaders" / "lit.metal").find("float4(0.25)") != std::string::npos);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestChangedProcessorRebuilt() {
+    auto directories = MakeCookDirectories("processor");
+    WriteSources(directories.source);
+
+    JobSystem job_system(2);
+    std::atomic<uint32_t> process_count = 0;
+    {
+        AssetCooker cooker(&job_system);
+        cooker.Cook(directories.source, directories.output, directories.database);
+    }
+
+    // Shaders copied as is are cooked again once a processor handles them.
+    AssetCooker cooker(&job_system);
+    cooker.AddProcessor(std::make_unique<CountingShaderProcessor>(&process_count));
+    auto statistics = cooker.Cook(directories.source, directories.output, directories.database);
+    CHECK(statistics.cooked_count == 2);
+    CHECK(statistics.skipped_count == 2);
+    CHECK(process_count == 2);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    RUN(TestUnchangedInputsSkipped);
+    RUN(TestChangedDependencyRebuilt);
+    RUN(TestChangedProcessorRebuilt);
+
+    std::filesystem::remove_all(std::filesystem::temp_directory_path() / "asset_cooker_test");
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,48 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+#include "test.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Query whether a benchmark runs at small sizes, CTest passes "--quick" so checks run without the full cost.
+//! \param argc The number of arguments.
+//! \param argv Arguments.
+//! \return True if "--quick" is passed.
+inline bool IsQuick(int argc, char *argv[]) {
+    for (auto i = 1; i < argc; ++i) {
+        if (std::string_view(argv[i]) == "--quick") {
+            return true;
+        }
+    }
+    return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Measure the average time of a function.
+//! \param repeat_count The number of runs.
+//! \param function A function.
+//! \return The average time in milliseconds.
+template<typename F>
+inline double Measure(uint32_t repeat_count, F &&function) {
+    auto start_time = std::chrono::steady_clock::now();
+    for (auto i = 0u; i != repeat_count; ++i) {
+        function();
+    }
+    std::chrono::duration<double, std::milli> elapsed_time = std::chrono::steady_clock::now() - start_time;
+    return elapsed_time.count() / repeat_count;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,198 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/bvh.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include "bench.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+using Triangle = std::array<std::array<float, 3>, 3>;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Scatter small triangles in a cube, like a scene of many objects.
+std::vector<Triangle> MakeTriangles(size_t count, std::mt19937 &generator) {
+    std::uniform_real_distribution<float> position_distribution(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> offset_distribution(-1.0f, 1.0f);
+
+    std::vector<Triangle> triangles(count);
+    for (auto &triangle : triangles) {
+        std::array<float, 3> center = {position_distribution(generator), position_distribution(generator),
+                                       position_distribution(generator)};
+        for (auto &position : triangle) {
+            for (auto i = 0u; i != 3; ++i) {
+                position[i] = center[i] + offset_distribution(generator);
+            }
+        }
+    }
+    return triangles;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+std::vector<Aabb> MakeBounds(const std::vector<Triangle> &triangles) {
+    std::vector<Aabb> bounds(triangles.size());
+    for (auto i = size_t(0); i != triangles.size(); ++i) {
+        for (auto &position : triangles[i]) {
+            for (auto j = 0u; j != 3; ++j) {
+                bounds[i].min[j] = std::min(bounds[i].min[j], position[j]);
+                bounds[i].max[j] = std::max(bounds[i].max[j], position[j]);
+            }
+        }
+    }
+    return bounds;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Make rays from outside of a cube towards points inside of it, so most of them pass through many triangles.
+std::vector<Ray> MakeRays(size_t count, std::mt19937 &generator) {
+    std::uniform_real_distribution<float> target_distribution(-50.0f, 50.0f);
+    std::uniform_real_distribution<float> origin_distribution(-150.0f, 150.0f);
+
+    std::vector<Ray> rays(count);
+    for (auto &ray : rays) {
+        ray.origin = {origin_distribution(generator), origin_distribution(generator), -150.0f};
+        std::array<float, 3> direction = {target_distribution(generator) - ray.origin[0],
+                                          target_distribution(generator) - ray.origin[1],
+                                          target_distribution(generator) - ray.origin[2]};
+        auto length = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] +
+                                direction[2] * direction[2]);
+        ray.direction = {direction[0] / length, direction[1] / length, direction[2] / length};
+    }
+    return rays;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Test every triangle, it is the baseline.
+BvhHit IntersectBruteForce(const std::vector<Triangle> &triangles, const Ray &ray) {
+    BvhHit hit;
+    for (auto i = size_t(0); i != triangles.size(); ++i) {
+        auto distance = IntersectTriangle(ray, triangles[i][0], triangles[i][1], triangles[i][2]);
+        if (distance < hit.distance) {
+            hit.primitive = static_cast<uint32_t>(i);
+            hit.distance = distance;
+        }
+    }
+    return hit;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Find every overlapped bounds, it is the baseline.
+std::vector<uint32_t> QueryBruteForce(const std::vector<Aabb> &bounds, const Aabb &box) {
+    std::vector<uint32_t> primitives;
+    for (auto i = size_t(0); i != bounds.size(); ++i) {
+        auto overlapped = true;
+        for (auto j = 0u; j != 3; ++j) {
+            overlapped &= bounds[i].min[j] <= box.max[j] && box.min[j] <= bounds[i].max[j];
+        }
+        if (overlapped) {
+            primitives.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    return primitives;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    auto quick = IsQuick(argc, argv);
+    const auto kRepeatCount = quick ? 1u : 5u;
+    const auto kRayCount = quick ? 100u : 1000u;
+    const auto kBoxCount = quick ? 100u : 1000u;
+
+    std::vector<size_t> counts = {1000, 10000};
+    if (!quick) {
+        counts.push_back(100000);
+        counts.push_back(1000000);
+    }
+
+    JobSystem job_system;
+    fmt::print("{:>10} {:>8} {:>12} {:>14} {:>14} {:>14} {:>14}\n", "triangles", "nodes", "build (ms)",
+               "ray (us)", "brute (us)", "query (us)", "brute (us)");
+    for (auto count : counts) {
+        std::mt19937 generator(11);
+        auto triangles = MakeTriangles(count, generator);
+        auto bounds = MakeBounds(triangles);
+        auto rays = MakeRays(kRayCount, generator);
+
+        Bvh bvh(&job_system);
+        auto build_time = Measure(kRepeatCount, [&bvh, &bounds]() {
+            bvh.Build(bounds);
+        });
+
+        auto intersect = [&triangles](uint32_t primitive, const Ray &ray) {
+            auto &triangle = triangles[primitive];
+            return IntersectTriangle(ray, triangle[0], triangle[1], triangle[2]);
+        };
+
+        // A tree finds the nearest hit the baseline does for every ray.
+        std::vector<BvhHit> hits(rays.size());
+        auto ray_time = Measure(kRepeatCount, [&]() {
+            for (auto i = size_t(0); i != rays.size(); ++i) {
+                hits[i] = bvh.Intersect(rays[i], std::numeric_limits<float>::infinity(), intersect);
+            }
+        });
+
+        std::vector<BvhHit> expected_hits(rays.size());
+        auto brute_ray_time = Measure(1, [&]() {
+            for (auto i = size_t(0); i != rays.size(); ++i) {
+                expected_hits[i] = IntersectBruteForce(triangles, rays[i]);
+            }
+        });
+
+        auto hit_count = 0u;
+        for (auto i = size_t(0); i != rays.size(); ++i) {
+            CHECK(hits[i].distance == expected_hits[i].distance);
+            // Triangles at the same distance are both nearest.
+            CHECK(hits[i].primitive == expected_hits[i].primitive ||
+                  intersect(hits[i].primitive, rays[i]) == expected_hits[i].distance);
+            hit_count += hits[i].primitive != kBvhNoHit;
+        }
+        CHECK(hit_count);
+
+        // A tree finds the bounds the baseline does for every box.
+        std::uniform_real_distribution<float> box_distribution(-100.0f, 100.0f);
+        std::vector<Aabb> boxes(kBoxCount);
+        for (auto &box : boxes) {
+            box.min = {box_distribution(generator), box_distribution(generator), box_distribution(generator)};
+            box.max = {box.min[0] + 5.0f, box.min[1] + 5.0f, box.min[2] + 5.0f};
+        }
+
+        std::vector<uint32_t> primitives;
+        auto query_time = Measure(kRepeatCount, [&]() {
+            for (auto &box : boxes) {
+                bvh.Query(box, primitives);
+            }
+        });
+
+        std::vector<std::vector<uint32_t>> expected_primitives(boxes.size());
+        auto brute_query_time = Measure(1, [&]() {
+            for (auto i = size_t(0); i != boxes.size(); ++i) {
+                expected_primitives[i] = QueryBruteForce(bounds, boxes[i]);
+            }
+        });
+
+        for (auto i = size_t(0); i != boxes.size(); ++i) {
+            bvh.Query(boxes[i], primitives);
+            std::sort(primitives.begin(), primitives.end());
+            CHECK(primitives == expected_primitives[i]);
+        }
+
+        fmt::print("{:>10} {:>8} {:>12.3f} {:>14.3f} {:>14.3f} {:>14.3f} {:>14.3f}\n", count,
+                   bvh.GetStatistics().node_count, build_time, ray_time * 1000.0 / rays.size(),
+                   brute_ray_time * 1000.0 / rays.size(), query_time * 1000.0 / boxes.size(),
+                   brute_query_time * 1000.0 / boxes.size());
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
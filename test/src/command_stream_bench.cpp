@@ -0,0 +1,120 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/command_stream.h>
+#include <common/job_system.h>
+#include <array>
+#include <type_traits>
+
+#include "bench.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr auto kBatchSize = 1024u;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Record draws of objects like a scene does, every draw sets its state and transforms.
+void RecordDraws(CommandRecorder &recorder, uint32_t begin, uint32_t end) {
+    for (auto i = begin; i != end; ++i) {
+        std::array<float, 16> transforms = {};
+        transforms[0] = transforms[5] = transforms[10] = transforms[15] = 1.0f;
+        transforms[12] = static_cast<float>(i);
+
+        recorder.SetPipeline(i % 8);
+        recorder.SetBuffer(CommandStage::kVertex, 0, i % 64);
+        recorder.SetBuffer(CommandStage::kVertex, 1, 64, i * 256);
+        recorder.SetBytes(CommandStage::kVertex, 2, transforms);
+        recorder.DrawIndexed(CommandPrimitiveType::kTriangle, 36, CommandIndexType::kUInt16, 65, i * 72);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Hash every field of replayed commands, streams of the same commands in the same order hash the same.
+template<typename T>
+uint64_t HashCommands(const T &commands) {
+    uint64_t hash = 14695981039346656037ull;
+    auto combine = [&hash](uint64_t value) {
+        hash = (hash ^ value) * 1099511628211ull;
+    };
+
+    commands.Replay([&](const auto &command) {
+        using Command = std::decay_t<decltype(command)>;
+
+        combine(static_cast<uint64_t>(command.header.type));
+        if constexpr (std::is_same_v<Command, SetPipelineCommand>) {
+            combine(command.pipeline);
+        } else if constexpr (std::is_same_v<Command, SetBufferCommand>) {
+            combine(command.index);
+            combine(command.buffer);
+            combine(command.offset);
+        } else if constexpr (std::is_same_v<Command, SetBytesCommand>) {
+            auto bytes = GetBytes(command);
+            for (auto i = 0u; i != command.size; ++i) {
+                combine(static_cast<uint64_t>(bytes[i]));
+            }
+        } else if constexpr (std::is_same_v<Command, DrawIndexedCommand>) {
+            combine(command.index_count);
+            combine(command.index_offset);
+        }
+    });
+    return hash;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    auto quick = IsQuick(argc, argv);
+    const auto kRepeatCount = quick ? 2u : 20u;
+
+    std::vector<uint32_t> counts = {1000, 10000};
+    if (!quick) {
+        counts.push_back(100000);
+        counts.push_back(1000000);
+    }
+
+    JobSystem job_system;
+    fmt::print("{} threads.\n", job_system.GetThreadCount());
+    fmt::print("{:>10} {:>10} {:>10} {:>14} {:>14} {:>14} {:>10}\n", "draws", "commands", "MB", "single (ms)",
+               "parallel (ms)", "replay (ms)", "ns/draw");
+    for (auto count : counts) {
+        // Recording reuses chunks of the previous frame, like every frame after the first one.
+        CommandRecorder recorder;
+        auto single_time = Measure(kRepeatCount, [&]() {
+            recorder.Reset();
+            RecordDraws(recorder, 0, count);
+        });
+
+        CommandStream stream;
+        auto parallel_time = Measure(kRepeatCount, [&]() {
+            stream.Reset();
+            stream.Record(job_system, count, kBatchSize, RecordDraws);
+        });
+
+        auto command_count = 0u;
+        auto replay_time = Measure(kRepeatCount, [&]() {
+            command_count = 0;
+            stream.Replay([&command_count](const auto &) {
+                ++command_count;
+            });
+        });
+
+        // Recorders in parallel record what a single recorder does, in the same order.
+        auto statistics = stream.GetStatistics();
+        CHECK(statistics.recorder_count == (count + kBatchSize - 1) / kBatchSize);
+        CHECK(statistics.command_count == recorder.GetCommandCount());
+        CHECK(statistics.byte_size == recorder.GetByteSize());
+        CHECK(command_count == count * 5);
+        CHECK(HashCommands(stream) == HashCommands(recorder));
+
+        fmt::print("{:>10} {:>10} {:>10.2f} {:>14.3f} {:>14.3f} {:>14.3f} {:>10.1f}\n", count,
+                   statistics.command_count, statistics.byte_size / 1048576.0, single_time, parallel_time,
+                   replay_time, parallel_time * 1e6 / count);
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,145 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/draw_queue.h>
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+#include "bench.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr auto kPipelineCount = 16u;
+constexpr auto kMaterialCount = 256u;
+constexpr auto kMeshCount = 64u;
+constexpr auto kBatchSize = 1024u;
+
+// Handles of buffers, a buffer per mesh and a buffer per material.
+constexpr auto kMeshBufferHandle = 0u;
+constexpr auto kMaterialBufferHandle = kMeshCount;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct Object {
+    uint32_t material = 0;
+    uint32_t mesh = 0;
+    float depth = 0.0f;
+    std::array<float, 16> transforms = {};
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Scatter objects of a scene in the order they are found, not in the order they are drawn best.
+std::vector<Object> MakeObjects(uint32_t count) {
+    std::mt19937 generator(17);
+    std::uniform_int_distribution<uint32_t> material_distribution(0, kMaterialCount - 1);
+    std::uniform_int_distribution<uint32_t> mesh_distribution(0, kMeshCount - 1);
+    std::uniform_real_distribution<float> depth_distribution(0.0f, 1.0f);
+
+    std::vector<Object> objects(count);
+    for (auto i = 0u; i != count; ++i) {
+        auto &object = objects[i];
+        object.material = material_distribution(generator);
+        object.mesh = mesh_distribution(generator);
+        object.depth = depth_distribution(generator);
+        object.transforms[0] = object.transforms[5] = object.transforms[10] = object.transforms[15] = 1.0f;
+        object.transforms[12] = static_cast<float>(i);
+    }
+    return objects;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Submit a draw per object, every draw asks for its pipeline, buffers and transforms.
+void SubmitObjects(const std::vector<Object> &objects, DrawQueue &queue) {
+    queue.Reset();
+    for (auto &object : objects) {
+        DrawPacket packet;
+        packet.pipeline = object.material % kPipelineCount;
+        packet.material = object.material;
+        packet.depth = object.depth;
+        packet.bindings[0] = {CommandStage::kVertex, 0, kMeshBufferHandle + object.mesh, 0};
+        packet.bindings[1] = {CommandStage::kFragment, 0, kMaterialBufferHandle + object.material, 0};
+        packet.binding_count = 2;
+        packet.index_buffer = kMeshBufferHandle + object.mesh;
+        packet.count = 36;
+        queue.Submit(packet, CommandStage::kVertex, 1, object.transforms.data(), sizeof(object.transforms));
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    auto quick = IsQuick(argc, argv);
+    const auto kRepeatCount = quick ? 2u : 20u;
+
+    std::vector<uint32_t> counts = {1000, 10000};
+    if (!quick) {
+        counts.push_back(100000);
+        counts.push_back(1000000);
+    }
+
+    JobSystem job_system;
+    fmt::print("{:>10} {:>10} {:>10} {:>10} {:>12} {:>12} {:>12} {:>12}\n", "draws", "requested", "unsorted",
+               "sorted", "submit (ms)", "radix (ms)", "std (ms)", "emit (ms)");
+    for (auto count : counts) {
+        auto objects = MakeObjects(count);
+        DrawQueue queue;
+        CommandStream stream;
+
+        // State changes are counted as draws come, then as they are sorted.
+        SubmitObjects(objects, queue);
+        stream.Reset();
+        queue.Emit(stream, job_system, kBatchSize);
+        auto unsorted_statistics = queue.GetStatistics();
+
+        auto submit_time = Measure(kRepeatCount, [&]() {
+            SubmitObjects(objects, queue);
+        });
+
+        auto radix_time = Measure(kRepeatCount, [&]() {
+            queue.Sort();
+        });
+
+        auto emit_time = Measure(kRepeatCount, [&]() {
+            stream.Reset();
+            queue.Emit(stream, job_system, kBatchSize);
+        });
+        auto sorted_statistics = queue.GetStatistics();
+
+        // A radix sort orders keys like a stable comparison sort does.
+        std::vector<uint64_t> keys(count);
+        for (auto i = 0u; i != count; ++i) {
+            keys[i] = MakeDrawKey(0, objects[i].material % kPipelineCount, objects[i].material, objects[i].depth);
+        }
+
+        std::vector<uint32_t> order;
+        RadixSort(keys, order);
+
+        std::vector<uint32_t> expected_order(count);
+        auto std_time = Measure(kRepeatCount, [&]() {
+            std::iota(expected_order.begin(), expected_order.end(), 0u);
+            std::stable_sort(expected_order.begin(), expected_order.end(), [&keys](uint32_t a, uint32_t b) {
+                return keys[a] < keys[b];
+            });
+        });
+        CHECK(order == expected_order);
+
+        // Sorting drops state changes and every recorded one is counted.
+        CHECK(unsorted_statistics.requested_state_count == count * 4);
+        CHECK(sorted_statistics.requested_state_count == unsorted_statistics.requested_state_count);
+        CHECK(unsorted_statistics.emitted_state_count <= unsorted_statistics.requested_state_count);
+        CHECK(sorted_statistics.emitted_state_count < unsorted_statistics.emitted_state_count);
+        CHECK(stream.GetStatistics().command_count == sorted_statistics.emitted_state_count + count);
+
+        fmt::print("{:>10} {:>10} {:>10} {:>10} {:>12.3f} {:>12.3f} {:>12.3f} {:>12.3f}\n", count,
+                   sorted_statistics.requested_state_count, unsorted_statistics.emitted_state_count,
+                   sorted_statistics.emitted_state_count, submit_time, radix_time, std_time, emit_time);
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,152 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/dynamic_resolution.h>
+#include <random>
+#include <stdexcept>
+
+#include "test.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+using Seconds = std::chrono::duration<double>;
+using Milliseconds = std::chrono::duration<double, std::milli>;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A frame costs a fixed time and a time proportional to pixels, like a fill bound scene.
+struct FrameModel {
+    Milliseconds fixed_time = Milliseconds(2.0);
+    //! A time of pixels at the full resolution.
+    Milliseconds pixel_time = Milliseconds(10.0);
+
+    [[nodiscard]]
+    Seconds GetFrameTime(float scale) const {
+        return fixed_time + pixel_time * static_cast<double>(scale * scale);
+    }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Feed frames of a model at the current scale, with relative noise of a frame time.
+//! \return The number of scale changes.
+uint64_t RunTrace(DynamicResolution &controller, const FrameModel &model, uint32_t frame_count, double noise = 0.0) {
+    std::mt19937 generator(19);
+    std::uniform_real_distribution<double> noise_distribution(-noise, noise);
+
+    auto change_count = controller.GetStatistics().change_count;
+    for (auto i = 0u; i != frame_count; ++i) {
+        auto frame_time = model.GetFrameTime(controller.GetScale()) * (1.0 + noise_distribution(generator));
+        controller.Update(frame_time, Seconds::zero());
+
+        CHECK(controller.GetScale() >= controller.GetSettings().min_scale);
+        CHECK(controller.GetScale() <= controller.GetSettings().max_scale);
+    }
+    return controller.GetStatistics().change_count - change_count;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestConvergence() {
+    DynamicResolution controller;
+    auto &settings = controller.GetSettings();
+
+    // A scene 60% over a budget at the full resolution settles within a few windows, under a budget.
+    FrameModel model;
+    model.pixel_time = Milliseconds(24.0);
+    RunTrace(controller, model, settings.window_size * 8);
+    CHECK(controller.GetScale() < 1.0f);
+    CHECK(model.GetFrameTime(controller.GetScale()) <= settings.budget * settings.lower_threshold);
+
+    // It stays there.
+    auto scale = controller.GetScale();
+    CHECK(RunTrace(controller, model, settings.window_size * 50) == 0);
+    CHECK(controller.GetScale() == scale);
+
+    // A lighter scene raises a scale back to the full resolution.
+    model.pixel_time = Milliseconds(5.0);
+    RunTrace(controller, model, settings.window_size * 8);
+    CHECK(controller.GetScale() == settings.max_scale);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestHysteresis() {
+    DynamicResolution controller;
+    auto &settings = controller.GetSettings();
+
+    // A frame time between the thresholds holds a scale, even with noise.
+    FrameModel model;
+    model.fixed_time = Milliseconds(0.0);
+    model.pixel_time = settings.budget * ((settings.raise_threshold + settings.lower_threshold) * 0.5);
+    CHECK(RunTrace(controller, model, settings.window_size * 100, 0.05) == 0);
+    CHECK(controller.GetScale() == settings.max_scale);
+
+    // Noise around a settled scale doesn't make it oscillate.
+    model.fixed_time = Milliseconds(2.0);
+    model.pixel_time = Milliseconds(24.0);
+    RunTrace(controller, model, settings.window_size * 8);
+    CHECK(RunTrace(controller, model, settings.window_size * 100, 0.05) == 0);
+
+    // A window of frames is averaged before anything changes.
+    DynamicResolution slow_controller;
+    for (auto i = 1u; i != settings.window_size; ++i) {
+        CHECK(!slow_controller.Update(settings.budget * 4.0, Seconds::zero()));
+    }
+    CHECK(slow_controller.Update(settings.budget * 4.0, Seconds::zero()));
+    CHECK(slow_controller.GetScale() < settings.max_scale);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestClamping() {
+    DynamicResolutionSettings settings;
+    settings.min_scale = 0.25f;
+    settings.max_scale = 0.75f;
+    DynamicResolution controller(settings);
+    CHECK(controller.GetScale() == settings.max_scale);
+
+    // A scene far over a budget stops at the minimum scale.
+    FrameModel model;
+    model.pixel_time = Milliseconds(1000.0);
+    RunTrace(controller, model, settings.window_size * 20);
+    CHECK(controller.GetScale() == settings.min_scale);
+    CHECK(controller.Scale({1, 1}) == Resolution(1, 1));
+    CHECK(controller.Scale({1920, 1080}) == Resolution(480, 270));
+
+    // A scene far under a budget stops at the maximum scale.
+    model.fixed_time = Milliseconds(0.0);
+    model.pixel_time = Milliseconds(0.1);
+    RunTrace(controller, model, settings.window_size * 20);
+    CHECK(controller.GetScale() == settings.max_scale);
+
+    // GPU time bounds a frame as well as CPU time.
+    for (auto i = 0u; i != settings.window_size * 20; ++i) {
+        controller.Update(Milliseconds(1.0), Milliseconds(1000.0));
+    }
+    CHECK(controller.GetScale() == settings.min_scale);
+
+    // Settings without a valid range are rejected.
+    settings.min_scale = 1.0f;
+    auto thrown = false;
+    try {
+        DynamicResolution invalid_controller(settings);
+    }
+    catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    RUN(TestConvergence);
+    RUN(TestHysteresis);
+    RUN(TestClamping);
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
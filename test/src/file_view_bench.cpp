@@ -0,0 +1,88 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/file_view.h>
+#include <common/utility.h>
+#include <fstream>
+#include <iterator>
+#include <random>
+
+#include "bench.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! ReadFile before FileView, it is the baseline.
+std::string ReadFileWithStream(const std::filesystem::path &path) {
+    std::basic_ifstream<char> fin(path, std::ios::in | std::ios::binary);
+    if (!fin.is_open()) {
+        throw std::runtime_error(fmt::format("Fail to open {}.", path.string()));
+    }
+    return std::string(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Write a file of random characters.
+std::string WriteFile(const std::filesystem::path &path, size_t size) {
+    std::mt19937 generator(7);
+    std::uniform_int_distribution<int> distribution('a', 'z');
+
+    std::string content(size, '\0');
+    for (auto &character : content) {
+        character = static_cast<char>(distribution(generator));
+    }
+
+    std::ofstream fout(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    fout.write(content.data(), static_cast<std::streamsize>(content.size()));
+    return content;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    auto quick = IsQuick(argc, argv);
+    const auto kRepeatCount = quick ? 2u : 20u;
+
+    std::vector<size_t> sizes = {4 * 1024, 256 * 1024};
+    if (!quick) {
+        sizes.push_back(8 * 1024 * 1024);
+    }
+
+    auto path = std::filesystem::temp_directory_path() / "file_view_bench.txt";
+    fmt::print("{:>10} {:>14} {:>14} {:>14}\n", "size", "stream (ms)", "ReadFile (ms)", "FileView (ms)");
+    for (auto size : sizes) {
+        auto content = WriteFile(path, size);
+
+        // Every way reads the same content.
+        CHECK(ReadFileWithStream(path) == content);
+        CHECK(ReadFile(path) == content);
+        CHECK(FileView(path).GetString() == content);
+
+        auto stream_time = Measure(kRepeatCount, [&path]() {
+            CHECK(!ReadFileWithStream(path).empty());
+        });
+        auto read_file_time = Measure(kRepeatCount, [&path]() {
+            CHECK(!ReadFile(path).empty());
+        });
+
+        // A view is used without a copy, every page is touched so a mapping is paid for.
+        auto file_view_time = Measure(kRepeatCount, [&path]() {
+            FileView view(path);
+            auto bytes = view.GetBytes();
+            auto sum = 0u;
+            for (auto i = size_t(0); i < bytes.size(); i += 4096) {
+                sum += static_cast<uint32_t>(bytes[i]);
+            }
+            CHECK(sum);
+        });
+
+        fmt::print("{:>10} {:>14.3f} {:>14.3f} {:>14.3f}\n", size, stream_time, read_file_time, file_view_time);
+    }
+
+    std::filesystem::remove(path);
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,135 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/file_watcher.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "test.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// How long a change may take to be reported before a test fails.
+constexpr auto kChangeTimeout = std::chrono::seconds(5);
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Make an empty directory of a test in a temporary directory.
+std::filesystem::path MakeTestDirectory(const std::string &name) {
+    auto directory = std::filesystem::temp_directory_path() / "file_watcher_test" / name;
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    return std::filesystem::canonical(directory);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Write a whole file.
+void WriteFile(const std::filesystem::path &path, const std::string &content) {
+    std::ofstream fout(path, std::ios::out | std::ios::trunc);
+    fout << content;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Wait until a watching thread is ready, it watches directories once it starts.
+void WaitForWatch() {
+    std::this_thread::sleep_for(kFileWatcherInterval * 2);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Poll a watcher until every expected file is reported or a timeout expires.
+//! \return Every reported file, once however many polls report it.
+std::vector<std::filesystem::path> WaitForChanges(FileWatcher &watcher,
+                                                  const std::vector<std::filesystem::path> &expected) {
+    std::vector<std::filesystem::path> changes;
+    auto end_time = std::chrono::steady_clock::now() + kChangeTimeout;
+    while (std::chrono::steady_clock::now() < end_time) {
+        for (auto &path : watcher.Poll()) {
+            if (std::find(changes.begin(), changes.end(), path) == changes.end()) {
+                changes.push_back(path);
+            }
+        }
+
+        auto found = std::all_of(expected.begin(), expected.end(), [&changes](auto &path) {
+            return std::find(changes.begin(), changes.end(), path) != changes.end();
+        });
+        if (found) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return changes;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestChangeDetection() {
+    auto directory = MakeTestDirectory("detection");
+    WriteFile(directory / "existing.txt", "existing");
+
+    FileWatcher watcher(directory);
+    CHECK(watcher.GetDirectory() == directory);
+    WaitForWatch();
+
+    // A written file is reported, a file nobody touches isn't.
+    WriteFile(directory / "shader.metal", "kernel");
+    auto changes = WaitForChanges(watcher, {directory / "shader.metal"});
+    CHECK(changes == std::vector<std::filesystem::path>({directory / "shader.metal"}));
+
+    // A file written in a subdirectory created after a watcher is reported too.
+    std::filesystem::create_directories(directory / "shaders");
+    WaitForWatch();
+    WriteFile(directory / "shaders" / "common.h", "header");
+    changes = WaitForChanges(watcher, {directory / "shaders" / "common.h"});
+    CHECK(std::find(changes.begin(), changes.end(), directory / "shaders" / "common.h") != changes.end());
+
+    // An editor saving by renaming a temporary file reports the renamed file.
+    WriteFile(directory / "existing.txt.swp", "saved");
+    std::filesystem::rename(directory / "existing.txt.swp", directory / "existing.txt");
+    changes = WaitForChanges(watcher, {directory / "existing.txt"});
+    CHECK(std::find(changes.begin(), changes.end(), directory / "existing.txt") != changes.end());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestDebounce() {
+    auto directory = MakeTestDirectory("debounce");
+    FileWatcher watcher(directory);
+    WaitForWatch();
+
+    // Writes between polls are reported once per file.
+    for (auto i = 0; i != 10; ++i) {
+        WriteFile(directory / "a.txt", std::to_string(i));
+        WriteFile(directory / "b.txt", std::to_string(i));
+    }
+    std::this_thread::sleep_for(kFileWatcherInterval * 3);
+    auto changes = watcher.Poll();
+    CHECK(changes == std::vector<std::filesystem::path>({directory / "a.txt", directory / "b.txt"}));
+
+    // A poll consumes changes, nothing is reported until a file is written again.
+    std::this_thread::sleep_for(kFileWatcherInterval * 3);
+    CHECK(watcher.Poll().empty());
+
+    WriteFile(directory / "a.txt", "again");
+    changes = WaitForChanges(watcher, {directory / "a.txt"});
+    CHECK(changes == std::vector<std::filesystem::path>({directory / "a.txt"}));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    RUN(TestChangeDetection);
+    RUN(TestDebounce);
+
+    std::filesystem::remove_all(std::filesystem::temp_directory_path() / "file_watcher_test");
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
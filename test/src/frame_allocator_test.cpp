@@ -0,0 +1,190 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/frame_allocator.h>
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+#include <vector>
+
+#include "test.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Query whether a function throws std::runtime_error.
+template<typename F>
+bool Throws(F &&function) {
+    try {
+        function();
+    }
+    catch (const std::runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestAlignedOffsets() {
+    constexpr auto kFrameSize = 4096u;
+    std::vector<std::byte> memory(kFrameSize * 2);
+    FrameAllocator allocator(memory.data(), kFrameSize, 2);
+    allocator.Reset(1);
+
+    // Every allocation starts at an aligned offset in the region of the frame, whatever the size of the previous one.
+    auto previous_end = uint64_t(kFrameSize);
+    for (auto size : {1u, 17u, 256u, 3u, 255u}) {
+        auto allocation = allocator.Allocate(size);
+        CHECK(allocation.offset % kUniformAlignment == 0);
+        CHECK(allocation.offset >= previous_end);
+        CHECK(allocation.offset - previous_end < kUniformAlignment);
+        CHECK(allocation.data == memory.data() + allocation.offset);
+        previous_end = allocation.offset + size;
+    }
+    CHECK(allocator.GetUsedSize() == previous_end - kFrameSize);
+
+    // An object is constructed in place.
+    struct Uniforms {
+        float values[5];
+    };
+    auto uniforms = allocator.Allocate<Uniforms>();
+    CHECK(uniforms.offset % kUniformAlignment == 0);
+    CHECK(reinterpret_cast<std::byte *>(uniforms.data) == memory.data() + uniforms.offset);
+
+    // A smaller alignment packs allocations closer, and a frame size is rounded down to it.
+    FrameAllocator packed_allocator(memory.data(), 1000, 2, 16);
+    CHECK(packed_allocator.GetFrameSize() == 992);
+    packed_allocator.Reset(0);
+    CHECK(packed_allocator.Allocate(1).offset == 0);
+    CHECK(packed_allocator.Allocate(1).offset == 16);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestFrameIsolation() {
+    constexpr auto kFrameSize = 8192u;
+    constexpr auto kAllocationCount = 7u;
+
+    for (auto frames_in_flight = 1u; frames_in_flight <= 4; ++frames_in_flight) {
+        // Like Example, the simulation thread writes a frame ahead of frames in flight.
+        auto frame_count = frames_in_flight + 1;
+        std::vector<std::byte> memory(kFrameSize * frame_count);
+        FrameAllocator allocator(memory.data(), kFrameSize, frame_count);
+
+        struct Allocation {
+            FrameAllocation<std::byte> allocation;
+            uint64_t size = 0;
+            std::byte value = std::byte(0);
+        };
+        std::deque<std::vector<Allocation>> live_frames;
+
+        for (auto frame = 0u; frame != frame_count * 5; ++frame) {
+            auto frame_index = frame % frame_count;
+            allocator.Reset(frame_index);
+            CHECK(allocator.GetUsedSize() == 0);
+
+            // Fill allocations of a frame with a value of its own.
+            std::vector<Allocation> allocations;
+            for (auto i = 0u; i != kAllocationCount; ++i) {
+                Allocation allocation;
+                allocation.size = 64 + i * 97;
+                allocation.allocation = allocator.Allocate(allocation.size);
+                allocation.value = static_cast<std::byte>(frame * kAllocationCount + i);
+                std::fill_n(allocation.allocation.data, allocation.size, allocation.value);
+
+                // An allocation stays in the region of a frame.
+                CHECK(allocation.allocation.offset >= uint64_t(kFrameSize) * frame_index);
+                CHECK(allocation.allocation.offset + allocation.size <= uint64_t(kFrameSize) * (frame_index + 1));
+                allocations.push_back(allocation);
+            }
+            live_frames.push_back(std::move(allocations));
+
+            // Frames still in flight keep their uniforms while later frames are written.
+            if (live_frames.size() > frame_count) {
+                live_frames.pop_front();
+            }
+            for (auto &allocations : live_frames) {
+                for (auto &allocation : allocations) {
+                    auto data = allocation.allocation.data;
+                    CHECK(std::all_of(data, data + allocation.size, [&allocation](auto value) {
+                        return value == allocation.value;
+                    }));
+                }
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestReuseAfterWrap() {
+    constexpr auto kFrameSize = 4096u;
+    constexpr auto kFrameCount = 3u;
+    std::vector<std::byte> memory(kFrameSize * kFrameCount);
+    FrameAllocator allocator(memory.data(), kFrameSize, kFrameCount);
+
+    // The same allocations of a frame get the same offsets every time its region comes around again.
+    std::vector<std::vector<uint64_t>> first_offsets(kFrameCount);
+    for (auto frame = 0u; frame != kFrameCount * 4; ++frame) {
+        auto frame_index = frame % kFrameCount;
+        allocator.Reset(frame_index);
+
+        std::vector<uint64_t> offsets;
+        for (auto size : {100u, 300u, 1000u}) {
+            offsets.push_back(allocator.Allocate(size).offset);
+        }
+        if (frame < kFrameCount) {
+            first_offsets[frame_index] = offsets;
+        }
+        CHECK(offsets == first_offsets[frame_index]);
+        CHECK(offsets.front() == uint64_t(kFrameSize) * frame_index);
+    }
+
+    // A frame region can be filled up again once it is reset.
+    allocator.Reset(0);
+    allocator.Allocate(kFrameSize);
+    CHECK(allocator.GetUsedSize() == kFrameSize);
+    allocator.Reset(0);
+    CHECK(allocator.GetUsedSize() == 0);
+    CHECK(allocator.Allocate(kFrameSize).offset == 0);
+    CHECK(allocator.GetPeakSize() == kFrameSize);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestOverflow() {
+    constexpr auto kFrameSize = 1024u;
+    std::vector<std::byte> memory(kFrameSize * 2);
+    FrameAllocator allocator(memory.data(), kFrameSize, 2);
+    allocator.Reset(0);
+
+    // An allocation doesn't spill into the region of the next frame.
+    CHECK(Throws([&allocator]() { allocator.Allocate(kFrameSize + 1); }));
+    allocator.Allocate(kFrameSize - kUniformAlignment);
+    CHECK(Throws([&allocator]() { allocator.Allocate(kUniformAlignment + 1); }));
+
+    // A failed allocation leaves an allocator as it was.
+    CHECK(allocator.GetUsedSize() == kFrameSize - kUniformAlignment);
+    CHECK(allocator.Allocate(kUniformAlignment).offset == kFrameSize - kUniformAlignment);
+    CHECK(Throws([&allocator]() { allocator.Allocate(1); }));
+
+    // Invalid frames and arguments are rejected.
+    CHECK(Throws([&allocator]() { allocator.Reset(2); }));
+    CHECK(Throws([&memory]() { FrameAllocator(memory.data(), kFrameSize, 2, 100); }));
+    CHECK(Throws([&memory]() { FrameAllocator(memory.data(), kFrameSize, 0); }));
+    CHECK(Throws([]() { FrameAllocator(nullptr, kFrameSize, 2); }));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    RUN(TestAlignedOffsets);
+    RUN(TestFrameIsolation);
+    RUN(TestReuseAfterWrap);
+    RUN(TestOverflow);
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,106 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/camera.h>
+#include <common/frustum_culler.h>
+#include <algorithm>
+#include <random>
+
+#include "bench.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Make a frustum of the default camera looking at objects from outside of them.
+Frustum MakeCameraFrustum() {
+    Camera camera;
+    camera.SetAspectRatio(16.0f / 9.0f);
+    camera.SetRadius(150.0f);
+    return MakeFrustum(Multiply(ConvertToMatrix4(camera.GetProjection()), ConvertToMatrix4(camera.GetView())));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    auto quick = IsQuick(argc, argv);
+    const auto kRepeatCount = quick ? 2u : 20u;
+
+    std::vector<size_t> counts = {10000, 100000};
+    if (!quick) {
+        counts.push_back(1000000);
+    }
+
+    auto frustum = MakeCameraFrustum();
+    JobSystem job_system;
+    FrustumCuller culler(&job_system);
+
+    fmt::print("{:>10} {:>10} {:>12} {:>12} {:>14} {:>14}\n", "objects", "visible", "scalar (ms)", "SIMD (ms)",
+               "threaded (ms)", "boxes (ms)");
+    for (auto count : counts) {
+        std::mt19937 generator(5);
+        std::uniform_real_distribution<float> position_distribution(-100.0f, 100.0f);
+        std::uniform_real_distribution<float> radius_distribution(0.1f, 2.0f);
+
+        BoundingSpheres spheres;
+        BoundingBoxes boxes;
+        for (auto i = size_t(0); i != count; ++i) {
+            std::array<float, 3> center = {position_distribution(generator), position_distribution(generator),
+                                           position_distribution(generator)};
+            auto radius = radius_distribution(generator);
+            spheres.Add(center, radius);
+            boxes.Add({center[0] - radius, center[1] - radius, center[2] - radius},
+                      {center[0] + radius, center[1] + radius, center[2] + radius});
+        }
+
+        // A reference tests spheres one by one.
+        std::vector<uint32_t> expected;
+        for (auto i = size_t(0); i != count; ++i) {
+            std::array<float, 3> center = {spheres.center_x[i], spheres.center_y[i], spheres.center_z[i]};
+            if (IsVisible(frustum, center, spheres.radius[i])) {
+                expected.push_back(static_cast<uint32_t>(i));
+            }
+        }
+        CHECK(!expected.empty() && expected.size() != count);
+
+        // Scalar and SIMD culling find the same spheres as the reference, in the same order.
+        std::vector<uint32_t> visible(count);
+        auto cull = [&](FrustumCullMode mode) {
+            visible.resize(count);
+            visible.resize(CullSpheres(frustum, spheres, 0, count, mode, visible.data()));
+        };
+
+        auto scalar_time = Measure(kRepeatCount, [&]() {
+            cull(FrustumCullMode::kScalar);
+        });
+        CHECK(visible == expected);
+
+        auto simd_time = Measure(kRepeatCount, [&]() {
+            cull(FrustumCullMode::kSimd);
+        });
+        CHECK(visible == expected);
+
+        auto threaded_time = Measure(kRepeatCount, [&]() {
+            culler.Cull(frustum, spheres, visible);
+        });
+        CHECK(visible == expected);
+
+        // Boxes are culled the same in both modes, a box around a sphere is visible if a sphere is.
+        std::vector<uint32_t> scalar_boxes(count);
+        scalar_boxes.resize(CullBoxes(frustum, boxes, 0, count, FrustumCullMode::kScalar, scalar_boxes.data()));
+        CHECK(std::includes(scalar_boxes.begin(), scalar_boxes.end(), expected.begin(), expected.end()));
+
+        std::vector<uint32_t> simd_boxes(count);
+        auto box_time = Measure(kRepeatCount, [&]() {
+            simd_boxes.resize(count);
+            simd_boxes.resize(CullBoxes(frustum, boxes, 0, count, FrustumCullMode::kSimd, simd_boxes.data()));
+        });
+        CHECK(simd_boxes == scalar_boxes);
+
+        fmt::print("{:>10} {:>10} {:>12.3f} {:>12.3f} {:>14.3f} {:>14.3f}\n", count, expected.size(), scalar_time,
+                   simd_time, threaded_time, box_time);
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,149 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/example.h>
+#include <atomic>
+#include <thread>
+
+#include "test.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+using namespace std::chrono_literals;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! An example counts frames it updates and resizes it handles.
+class IdleExample : public Example {
+public:
+    explicit IdleExample(const Arguments &arguments) :
+        Example("Idle", arguments) {
+    }
+
+    std::atomic<uint64_t> update_count = 0;
+    uint64_t resize_count = 0;
+
+protected:
+    void OnInit() override {
+    }
+
+    void OnTerm() override {
+    }
+
+    void OnResize(const Resolution &resolution) override {
+        ++resize_count;
+    }
+
+    void OnUpdate(uint32_t index) override {
+        ++update_count;
+    }
+
+    void OnRender(uint32_t index) override {
+    }
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Arguments MakeArguments(bool idle) {
+    Arguments arguments;
+    arguments.backend = Backend::kNull;
+    arguments.idle = idle;
+    return arguments;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Render at every display refresh for a while, like a display link.
+//! \return The number of refreshes.
+uint32_t Refresh(Example &example, std::chrono::steady_clock::duration duration) {
+    auto refresh_count = 0u;
+    auto end_time = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end_time) {
+        example.Render();
+        ++refresh_count;
+        std::this_thread::sleep_for(1ms);
+    }
+    return refresh_count;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Render at every display refresh until a frame is rendered.
+//! \return Time until a frame is rendered.
+std::chrono::steady_clock::duration RefreshUntilRendered(Example &example) {
+    auto start_time = std::chrono::steady_clock::now();
+    auto rendered_count = example.GetFrameStatistics().rendered_count;
+    while (example.GetFrameStatistics().rendered_count == rendered_count) {
+        example.Render();
+        std::this_thread::sleep_for(1ms);
+    }
+    return std::chrono::steady_clock::now() - start_time;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestBusy() {
+    IdleExample example(MakeArguments(false));
+    example.Init();
+    example.Resize({640, 360});
+    example.StartSimulation();
+
+    // An example which isn't idle renders a frame at every refresh.
+    auto refresh_count = Refresh(example, 100ms);
+    auto statistics = example.GetFrameStatistics();
+    CHECK(statistics.rendered_count == refresh_count);
+    CHECK(statistics.skipped_count == 0);
+
+    example.Term();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestIdle() {
+    IdleExample example(MakeArguments(true));
+    example.Init();
+    example.Resize({640, 360});
+    example.StartSimulation();
+
+    // The first frames are rendered until a scene settles.
+    Refresh(example, 200ms);
+    auto statistics = example.GetFrameStatistics();
+    CHECK(statistics.rendered_count);
+    CHECK(example.resize_count == 1);
+
+    // Nothing changes, so refreshes are skipped, but a keep-alive frame is still updated and rendered every interval.
+    auto update_count = example.update_count.load();
+    auto refresh_count = Refresh(example, kIdleKeepAliveInterval * 2 + 200ms);
+    auto idle_statistics = example.GetFrameStatistics();
+    auto rendered_count = idle_statistics.rendered_count - statistics.rendered_count;
+    auto skipped_count = idle_statistics.skipped_count - statistics.skipped_count;
+    CHECK(rendered_count >= 1 && rendered_count <= 4);
+    // A frame may be updated on one side of the window and rendered on the other.
+    auto updated_count = example.update_count - update_count;
+    CHECK(updated_count <= rendered_count + 1 && rendered_count <= updated_count + 1);
+    CHECK(skipped_count + rendered_count <= refresh_count);
+    CHECK(skipped_count > rendered_count * 10);
+
+    // A request or a resize renders a frame without waiting for a keep-alive frame.
+    example.Invalidate();
+    CHECK(RefreshUntilRendered(example) < kIdleKeepAliveInterval);
+
+    Refresh(example, 100ms);
+    example.Resize({800, 600});
+    CHECK(RefreshUntilRendered(example) < kIdleKeepAliveInterval);
+    CHECK(example.resize_count == 2);
+
+    example.Term();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    RUN(TestBusy);
+    RUN(TestIdle);
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
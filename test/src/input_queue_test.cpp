@@ -0,0 +1,153 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/input_queue.h>
+#include <thread>
+
+#include "test.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr auto kEventCount = 1000000u;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Make an event of a sequence, buttons alternate so no event is coalesced with the previous one.
+InputEvent MakeButtonEvent(uint32_t sequence) {
+    InputEvent event;
+    event.type = sequence % 2 ? InputEventType::kMouseButtonUp : InputEventType::kMouseButtonDown;
+    event.x = static_cast<float>(sequence % 4096);
+    event.y = static_cast<float>(sequence / 4096);
+    return event;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Retrieve a sequence of an event made by MakeButtonEvent.
+uint32_t GetSequence(const InputEvent &event) {
+    return static_cast<uint32_t>(event.y) * 4096 + static_cast<uint32_t>(event.x);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestOrderBelowCapacity() {
+    InputQueue queue;
+
+    // A full queue keeps every event.
+    for (auto i = 0u; i != kInputQueueCapacity; ++i) {
+        CHECK(queue.Push(MakeButtonEvent(i)));
+    }
+
+    std::vector<InputEvent> events;
+    queue.Drain(events);
+    CHECK(events.size() == kInputQueueCapacity);
+    for (auto i = 0u; i != kInputQueueCapacity; ++i) {
+        CHECK(events[i].type == MakeButtonEvent(i).type);
+        CHECK(GetSequence(events[i]) == i);
+    }
+    CHECK(queue.GetStatistics().dropped_count == 0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestOverflow() {
+    InputQueue queue;
+
+    // Events beyond capacity are dropped, the oldest ones are kept.
+    for (auto i = 0u; i != kInputQueueCapacity + 10; ++i) {
+        CHECK(queue.Push(MakeButtonEvent(i)) == (i < kInputQueueCapacity));
+    }
+    CHECK(queue.GetStatistics().dropped_count == 10);
+
+    std::vector<InputEvent> events;
+    queue.Drain(events);
+    CHECK(events.size() == kInputQueueCapacity);
+    CHECK(GetSequence(events.back()) == kInputQueueCapacity - 1);
+
+    // A drained queue accepts events again.
+    CHECK(queue.Push(MakeButtonEvent(0)));
+    events.clear();
+    queue.Drain(events);
+    CHECK(events.size() == 1);
+
+    auto statistics = queue.GetStatistics();
+    CHECK(statistics.event_count == kInputQueueCapacity + 1);
+    CHECK(statistics.dropped_count == 10);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestCoalescing() {
+    InputQueue queue;
+
+    // Moves become the last one and wheels their sum, but not across other events.
+    queue.Push({InputEventType::kMouseMove, 1.0f, 1.0f});
+    queue.Push({InputEventType::kMouseMove, 2.0f, 2.0f});
+    queue.Push({InputEventType::kMouseButtonDown, 2.0f, 2.0f});
+    queue.Push({InputEventType::kMouseDrag, 3.0f, 3.0f});
+    queue.Push({InputEventType::kMouseDrag, 4.0f, 4.0f});
+    queue.Push({InputEventType::kMouseWheel, 0.0f, 0.0f, 1.0f});
+    queue.Push({InputEventType::kMouseWheel, 0.0f, 0.0f, 2.0f});
+
+    std::vector<InputEvent> events;
+    queue.Drain(events);
+    CHECK(events.size() == 4);
+    CHECK(events[0].type == InputEventType::kMouseMove && events[0].x == 2.0f);
+    CHECK(events[1].type == InputEventType::kMouseButtonDown);
+    CHECK(events[2].type == InputEventType::kMouseDrag && events[2].x == 4.0f);
+    CHECK(events[3].type == InputEventType::kMouseWheel && events[3].delta == 3.0f);
+    CHECK(queue.GetStatistics().coalesced_count == 3);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestProducerConsumer() {
+    InputQueue queue;
+
+    // A producer retries an event a full queue drops, so a consumer gets every event in order.
+    uint64_t retry_count = 0;
+    std::thread producer([&queue, &retry_count]() {
+        for (auto i = 0u; i != kEventCount; ++i) {
+            while (!queue.Push(MakeButtonEvent(i))) {
+                ++retry_count;
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    std::vector<InputEvent> events;
+    auto sequence = 0u;
+    while (sequence != kEventCount) {
+        events.clear();
+        queue.Drain(events);
+        CHECK(events.size() <= kInputQueueCapacity);
+        for (auto &event : events) {
+            CHECK(event.type == MakeButtonEvent(sequence).type);
+            CHECK(GetSequence(event) == sequence);
+            ++sequence;
+        }
+        if (events.empty()) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+
+    auto statistics = queue.GetStatistics();
+    CHECK(statistics.event_count == kEventCount);
+    CHECK(statistics.coalesced_count == 0);
+    CHECK(statistics.dropped_count == retry_count);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    RUN(TestOrderBelowCapacity);
+    RUN(TestOverflow);
+    RUN(TestCoalescing);
+    RUN(TestProducerConsumer);
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
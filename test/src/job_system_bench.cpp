@@ -0,0 +1,107 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/bvh.h>
+#include <common/camera.h>
+#include <common/frustum_culler.h>
+#include <common/job_system.h>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <thread>
+
+#include "bench.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Make a frustum of the default camera looking at objects from outside of them.
+Frustum MakeCameraFrustum() {
+    Camera camera;
+    camera.SetAspectRatio(16.0f / 9.0f);
+    camera.SetRadius(150.0f);
+    return MakeFrustum(Multiply(ConvertToMatrix4(camera.GetProjection()), ConvertToMatrix4(camera.GetView())));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    auto quick = IsQuick(argc, argv);
+    const auto kRepeatCount = quick ? 2u : 10u;
+    const auto kObjectCount = quick ? 100000u : 1000000u;
+
+    // Workers double up to the number of cores, two at least so stealing is exercised.
+    std::vector<uint32_t> thread_counts = {1};
+    while (thread_counts.back() < std::max(std::thread::hardware_concurrency(), 2u)) {
+        thread_counts.push_back(thread_counts.back() * 2);
+    }
+
+    std::mt19937 generator(13);
+    std::uniform_real_distribution<float> position_distribution(-100.0f, 100.0f);
+    std::uniform_real_distribution<float> size_distribution(0.1f, 2.0f);
+
+    BoundingSpheres spheres;
+    std::vector<Aabb> bounds(kObjectCount);
+    for (auto &box : bounds) {
+        std::array<float, 3> center = {position_distribution(generator), position_distribution(generator),
+                                       position_distribution(generator)};
+        auto size = size_distribution(generator);
+        spheres.Add(center, size);
+        box.min = {center[0] - size, center[1] - size, center[2] - size};
+        box.max = {center[0] + size, center[1] + size, center[2] + size};
+    }
+    auto frustum = MakeCameraFrustum();
+
+    fmt::print("{} cores.\n", std::thread::hardware_concurrency());
+    fmt::print("{:>8} {:>14} {:>14} {:>14}\n", "workers", "compute (ms)", "cull (ms)", "BVH (ms)");
+
+    auto first_sum = 0.0;
+    std::vector<uint32_t> first_visible;
+    auto first_node_count = 0u;
+    for (auto thread_count : thread_counts) {
+        JobSystem job_system(thread_count);
+
+        // A compute bound loop scales with cores unless splitting or stealing costs too much.
+        std::vector<double> sums(kObjectCount);
+        auto compute_time = Measure(kRepeatCount, [&]() {
+            job_system.ParallelFor(kObjectCount, 1024, [&sums](uint32_t begin, uint32_t end) {
+                for (auto i = begin; i != end; ++i) {
+                    auto value = static_cast<double>(i);
+                    for (auto j = 0u; j != 16; ++j) {
+                        value = std::sqrt(value + j);
+                    }
+                    sums[i] = value;
+                }
+            });
+        });
+
+        FrustumCuller culler(&job_system);
+        std::vector<uint32_t> visible;
+        auto cull_time = Measure(kRepeatCount, [&]() {
+            culler.Cull(frustum, spheres, visible);
+        });
+
+        Bvh bvh(&job_system);
+        auto bvh_time = Measure(kRepeatCount, [&]() {
+            bvh.Build(bounds);
+        });
+
+        // Results don't depend on the number of workers.
+        auto sum = std::accumulate(sums.begin(), sums.end(), 0.0);
+        if (thread_count == thread_counts.front()) {
+            first_sum = sum;
+            first_visible = visible;
+            first_node_count = bvh.GetStatistics().node_count;
+        }
+        CHECK(sum == first_sum);
+        CHECK(visible == first_visible);
+        CHECK(bvh.GetStatistics().node_count == first_node_count);
+
+        fmt::print("{:>8} {:>14.3f} {:>14.3f} {:>14.3f}\n", thread_count, compute_time, cull_time, bvh_time);
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,110 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/job_system.h>
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+
+#include "test.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestParallelForCoversRange() {
+    JobSystem job_system(4);
+
+    std::vector<std::atomic<uint32_t>> visits(100000);
+    job_system.ParallelFor(static_cast<uint32_t>(visits.size()), 64, [&visits](uint32_t begin, uint32_t end) {
+        for (auto i = begin; i != end; ++i) {
+            ++visits[i];
+        }
+    });
+
+    for (auto &visit : visits) {
+        CHECK(visit == 1);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestParallelForRethrows() {
+    JobSystem job_system(4);
+
+    // Every job runs even if one throws, and the exception reaches the caller.
+    std::atomic<uint32_t> item_count = 0;
+    auto thrown = false;
+    try {
+        job_system.ParallelFor(1000, 1, [&item_count](uint32_t begin, uint32_t end) {
+            item_count += end - begin;
+            if (begin <= 500 && 500 < end) {
+                throw std::runtime_error("Fail to process an item.");
+            }
+        });
+    }
+    catch (const std::runtime_error &) {
+        thrown = true;
+    }
+
+    CHECK(thrown);
+    CHECK(item_count == 1000);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestNestedParallelFor() {
+    // A job waiting for jobs it spawned runs them, so nesting never deadlocks even with one worker.
+    JobSystem job_system(1);
+
+    std::vector<uint64_t> sums(16);
+    job_system.ParallelFor(static_cast<uint32_t>(sums.size()), 1, [&](uint32_t begin, uint32_t end) {
+        for (auto i = begin; i != end; ++i) {
+            std::vector<uint64_t> values(1000);
+            job_system.ParallelFor(static_cast<uint32_t>(values.size()), 1, [&](uint32_t value_begin,
+                                                                                uint32_t value_end) {
+                for (auto j = value_begin; j != value_end; ++j) {
+                    values[j] = j * i;
+                }
+            });
+            sums[i] = std::accumulate(values.begin(), values.end(), uint64_t(0));
+        }
+    });
+
+    for (auto i = size_t(0); i != sums.size(); ++i) {
+        CHECK(sums[i] == 499500 * i);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestSubmit() {
+    JobSystem job_system(2);
+
+    JobCounter counter;
+    auto value = job_system.Submit([]() { return 42; }, &counter);
+    auto error = job_system.Submit([]() -> int { throw std::runtime_error("Fail to compute."); }, &counter);
+    job_system.Wait(counter);
+
+    CHECK(value.get() == 42);
+    auto thrown = false;
+    try {
+        error.get();
+    }
+    catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    RUN(TestParallelForCoversRange);
+    RUN(TestParallelForRethrows);
+    RUN(TestNestedParallelFor);
+    RUN(TestSubmit);
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,121 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/lod.h>
+#include <cmath>
+#include <random>
+
+#include "bench.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Make a grid of a smooth height field, it can be simplified with small errors like a scanned surface.
+Mesh MakeGrid(uint32_t size) {
+    Mesh mesh;
+    for (auto y = 0u; y != size; ++y) {
+        for (auto x = 0u; x != size; ++x) {
+            auto u = static_cast<float>(x) / static_cast<float>(size - 1);
+            auto v = static_cast<float>(y) / static_cast<float>(size - 1);
+            auto height = 0.1f * std::sin(u * 6.0f) * std::cos(v * 4.0f);
+            mesh.vertices.push_back(MeshLayout::MakeVertex({u, v, height}, {0.0f, 0.0f, 1.0f, 0.0f}, {u, v}));
+        }
+    }
+
+    for (auto y = 0u; y != size - 1; ++y) {
+        for (auto x = 0u; x != size - 1; ++x) {
+            auto i = y * size + x;
+            mesh.indices.insert(mesh.indices.end(), {i, i + 1, i + size, i + 1, i + size + 1, i + size});
+        }
+    }
+    return mesh;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Check levels get coarser and their errors grow.
+void CheckChain(const Mesh &mesh, const LodChain &chain) {
+    CHECK(chain.levels.size() > 1);
+    CHECK(chain.levels[0].index_count == mesh.indices.size());
+    for (auto i = size_t(1); i < chain.levels.size(); ++i) {
+        CHECK(chain.levels[i].index_count < chain.levels[i - 1].index_count);
+        CHECK(chain.levels[i].error >= chain.levels[i - 1].error);
+        CHECK(chain.levels[i].index_offset + chain.levels[i].index_count <= chain.indices.size());
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    auto quick = IsQuick(argc, argv);
+    const auto kRepeatCount = quick ? 1u : 5u;
+
+    std::vector<uint32_t> grid_sizes = {32, 64};
+    if (!quick) {
+        grid_sizes.push_back(128);
+        grid_sizes.push_back(256);
+    }
+
+    // Build chains of meshes at several sizes, objects refer to any of them.
+    fmt::print("{:>10} {:>8} {:>14}\n", "triangles", "levels", "build (ms)");
+    std::vector<LodChain> chains;
+    for (auto grid_size : grid_sizes) {
+        auto mesh = MakeGrid(grid_size);
+        LodChain chain;
+        auto build_time = Measure(kRepeatCount, [&mesh, &chain]() {
+            chain = BuildLodChain(mesh);
+        });
+        CheckChain(mesh, chain);
+
+        fmt::print("{:>10} {:>8} {:>14.3f}\n", mesh.indices.size() / 3, chain.levels.size(), build_time);
+        chains.push_back(std::move(chain));
+    }
+
+    // Scatter objects around a viewer, so every level is selected by some of them.
+    auto object_count = quick ? 10000u : 100000u;
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<float> position_distribution(-1000.0f, 1000.0f);
+    std::uniform_real_distribution<float> scale_distribution(10.0f, 100.0f);
+    std::uniform_int_distribution<uint32_t> chain_distribution(0, static_cast<uint32_t>(chains.size()) - 1);
+
+    std::vector<LodObject> objects(object_count);
+    for (auto &object : objects) {
+        object.center = {position_distribution(generator), position_distribution(generator),
+                         position_distribution(generator)};
+        object.scale = scale_distribution(generator);
+        object.radius = object.scale;
+        object.chain = chain_distribution(generator);
+    }
+
+    auto view = MakeLodView({0.0f, 0.0f, 0.0f}, 1.0f, 1080.0f);
+    std::vector<uint8_t> levels(objects.size());
+    auto select_time = Measure(kRepeatCount * 20, [&]() {
+        SelectLods(view, objects, chains, levels);
+    });
+
+    // A batch selects what selecting one by one does, and farther objects don't get finer levels.
+    std::array<uint32_t, kMaxLodCount> histogram = {};
+    for (auto i = size_t(0); i != objects.size(); ++i) {
+        auto &chain = chains[objects[i].chain];
+        CHECK(levels[i] == SelectLod(view, objects[i], chain));
+        CHECK(levels[i] < chain.levels.size());
+        ++histogram[levels[i]];
+
+        auto far_object = objects[i];
+        far_object.center = {far_object.center[0] * 2.0f, far_object.center[1] * 2.0f, far_object.center[2] * 2.0f};
+        CHECK(SelectLod(view, far_object, chain) >= levels[i]);
+    }
+    CHECK(histogram[0] != objects.size());
+
+    fmt::print("Selection of {} objects: {:.3f} ms, {:.1f} ns per object.\n", objects.size(), select_time,
+               select_time * 1e6 / static_cast<double>(objects.size()));
+    for (auto i = 0u; i != kMaxLodCount; ++i) {
+        if (histogram[i]) {
+            fmt::print("Level {}: {} objects.\n", i, histogram[i]);
+        }
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,356 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/mesh.h>
+#include <common/mesh_optimizer.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "test.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Query whether a function throws std::runtime_error.
+template<typename F>
+bool Throws(F &&function) {
+    try {
+        function();
+    }
+    catch (const std::runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Retrieve a directory meshes of tests are written to.
+std::filesystem::path GetTestDirectory() {
+    return std::filesystem::temp_directory_path() / "mesh_test";
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Write a whole file.
+void WriteFile(const std::filesystem::path &path, std::string_view content) {
+    std::ofstream fout(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    fout.write(content.data(), static_cast<std::streamsize>(content.size()));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Write a mesh to a file and load it without optimization.
+Mesh LoadMesh(JobSystem &job_system, const std::string &name, std::string_view content) {
+    auto path = GetTestDirectory() / name;
+    WriteFile(path, content);
+    MeshLoader loader(&job_system);
+    return loader.Load(path, false);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Retrieve a position of a corner of a mesh.
+Float3::Values GetPosition(const Mesh &mesh, size_t corner) {
+    return MeshLayout::Get<Position>(mesh.vertices[mesh.indices[corner]]);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Make a grid of quads, each quad is two triangles.
+Mesh MakeGrid(uint32_t size) {
+    Mesh mesh;
+    for (auto y = 0u; y <= size; ++y) {
+        for (auto x = 0u; x <= size; ++x) {
+            auto position = Float3::Values({static_cast<float>(x), static_cast<float>(y), 0.0f});
+            mesh.vertices.push_back(MeshLayout::MakeVertex(position, {0.0f, 0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}));
+        }
+    }
+
+    for (auto y = 0u; y != size; ++y) {
+        for (auto x = 0u; x != size; ++x) {
+            auto i = y * (size + 1) + x;
+            auto j = i + size + 1;
+            mesh.indices.insert(mesh.indices.end(), {i, i + 1, j + 1, i, j + 1, j});
+        }
+    }
+    return mesh;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Retrieve triangles of a mesh in a canonical order, each rotated to start at its smallest index.
+std::vector<std::array<uint32_t, 3>> GetSortedTriangles(std::span<const uint32_t> indices) {
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (auto i = size_t(0); i + 2 < indices.size(); i += 3) {
+        std::array<uint32_t, 3> triangle = {indices[i], indices[i + 1], indices[i + 2]};
+        std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+        triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestObjCorners() {
+    JobSystem job_system(2);
+
+    // Positions with normals and without texture coordinates.
+    auto mesh = LoadMesh(job_system, "normal.obj", "v 0 0 0\nv 1 0 0\nv 0 1 0\nvn 0 0 -1\nf 1//1 2//1 3//1\n");
+    CHECK(mesh.vertices.size() == 3);
+    CHECK(mesh.indices == std::vector<uint32_t>({0, 1, 2}));
+    CHECK(GetPosition(mesh, 1) == Float3::Values({1.0f, 0.0f, 0.0f}));
+    CHECK(MeshLayout::Get<Normal>(mesh.vertices[0]) == Snorm8x4::Values({0.0f, 0.0f, -1.0f, 0.0f}));
+    CHECK(MeshLayout::Get<TexCoord>(mesh.vertices[0]) == Half2::Values({0.0f, 0.0f}));
+
+    // Texture coordinates are flipped to a top left origin, and missing normals are generated from triangles.
+    mesh = LoadMesh(job_system, "tex_coord.obj", "v 0 0 0\nv 1 0 0\nv 0 1 0\nvt 0.25 0.25\nf 1/1 2/1 3/1\n");
+    CHECK(MeshLayout::Get<TexCoord>(mesh.vertices[2]) == Half2::Values({0.25f, 0.75f}));
+    CHECK(MeshLayout::Get<Normal>(mesh.vertices[2]) == Snorm8x4::Values({0.0f, 0.0f, 1.0f, 0.0f}));
+
+    // A polygon is triangulated as a fan, and corners sharing attributes share a vertex.
+    mesh = LoadMesh(job_system, "fan.obj", "v 0 0 0\nv 1 0 0\nv 2 1 0\nv 1 2 0\nv 0 1 0\nf 1 2 3 4 5\nf 1 2 3\n");
+    CHECK(mesh.vertices.size() == 5);
+    CHECK(mesh.indices == std::vector<uint32_t>({0, 1, 2, 0, 2, 3, 0, 3, 4, 0, 1, 2}));
+
+    // The same position with another normal is another vertex.
+    mesh = LoadMesh(job_system, "split.obj", "v 0 0 0\nv 1 0 0\nv 0 1 0\nvn 0 0 1\nvn 0 0 -1\n"
+                                             "f 1//1 2//1 3//1\nf 1//2 3//2 2//2\n");
+    CHECK(mesh.vertices.size() == 6);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestObjErrors() {
+    JobSystem job_system(2);
+
+    // Indices out of range, zero indices and references to attributes that don't exist are rejected.
+    for (auto face : {"f 1 2 4\n", "f 0 1 2\n", "f -4 1 2\n", "f 1/1 2/1 3/1\n", "f 1//2 2//1 3//1\n", "f 1 2 x\n"}) {
+        auto content = std::string("v 0 0 0\nv 1 0 0\nv 0 1 0\nvn 0 0 1\n") + face;
+        CHECK(Throws([&job_system, &content]() { LoadMesh(job_system, "error.obj", content); }));
+    }
+
+    // A missing file and an unknown extension are rejected too.
+    MeshLoader loader(&job_system);
+    CHECK(Throws([&loader]() { loader.Load(GetTestDirectory() / "missing.obj"); }));
+    WriteFile(GetTestDirectory() / "mesh.ply", "ply\n");
+    CHECK(Throws([&loader]() { loader.Load(GetTestDirectory() / "mesh.ply"); }));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestObjChunks() {
+    // A file over a few megabytes is parsed in chunks. Every face refers to a quad written long before it by
+    // indices from the end, so faces after a chunk boundary refer to positions of previous chunks.
+    constexpr auto kQuadCount = 40000u;
+    constexpr auto kFaceDelay = 1000u;
+    constexpr std::array<std::array<uint32_t, 2>, 4> kCorners = {{{0, 0}, {1, 0}, {1, 1}, {0, 1}}};
+
+    std::string relative_text;
+    std::string absolute_text;
+    auto position_count = 0u;
+    auto WriteFace = [&](uint32_t quad) {
+        relative_text += "f";
+        absolute_text += "f";
+        for (auto corner = 0u; corner != 4; ++corner) {
+            auto index = quad * 4 + corner;
+            relative_text += fmt::format(" {}", static_cast<int32_t>(index) - static_cast<int32_t>(position_count));
+            absolute_text += fmt::format(" {}", index + 1);
+        }
+        relative_text += "\n";
+        absolute_text += "\n";
+    };
+
+    for (auto quad = 0u; quad != kQuadCount; ++quad) {
+        for (auto &corner : kCorners) {
+            auto line = fmt::format("v {} {} {}\n", quad % 200 + corner[0], quad / 200 + corner[1], quad % 7);
+            relative_text += line;
+            absolute_text += line;
+            ++position_count;
+        }
+        if (quad >= kFaceDelay) {
+            WriteFace(quad - kFaceDelay);
+        }
+    }
+    for (auto quad = kQuadCount - kFaceDelay; quad != kQuadCount; ++quad) {
+        WriteFace(quad);
+    }
+    CHECK(relative_text.size() > (2u << 20));
+
+    JobSystem job_system(3);
+    auto relative_mesh = LoadMesh(job_system, "relative.obj", relative_text);
+    auto absolute_mesh = LoadMesh(job_system, "absolute.obj", absolute_text);
+    CHECK(relative_mesh.indices == absolute_mesh.indices);
+    CHECK(relative_mesh.indices.size() == kQuadCount * 6);
+
+    // Every quad is two triangles of its own positions in order.
+    constexpr std::array<uint32_t, 6> kFan = {0, 1, 2, 0, 2, 3};
+    for (auto quad = 0u; quad != kQuadCount; ++quad) {
+        for (auto i = 0u; i != kFan.size(); ++i) {
+            auto &corner = kCorners[kFan[i]];
+            auto expected = Float3::Values({static_cast<float>(quad % 200 + corner[0]),
+                                            static_cast<float>(quad / 200 + corner[1]),
+                                            static_cast<float>(quad % 7)});
+            CHECK(GetPosition(relative_mesh, quad * 6 + i) == expected);
+            CHECK(GetPosition(absolute_mesh, quad * 6 + i) == expected);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Make a binary glTF file of a quad, drawn by a translated node and by a child of a scaled node.
+std::string MakeGlb() {
+    std::array<float, 12> positions = {0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+    std::array<float, 8> tex_coords = {0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f};
+    std::array<uint16_t, 6> indices = {0, 1, 2, 0, 2, 3};
+
+    std::string binary(sizeof(positions) + sizeof(tex_coords) + sizeof(indices), '\0');
+    std::memcpy(binary.data(), positions.data(), sizeof(positions));
+    std::memcpy(binary.data() + sizeof(positions), tex_coords.data(), sizeof(tex_coords));
+    std::memcpy(binary.data() + sizeof(positions) + sizeof(tex_coords), indices.data(), sizeof(indices));
+
+    auto json = fmt::format(R"({{
+        "asset": {{"version": "2.0"}},
+        "scene": 0,
+        "scenes": [{{"nodes": [0, 1]}}],
+        "nodes": [{{"mesh": 0, "translation": [10, 0, 0]}}, {{"children": [2], "scale": [2, 2, 2]}}, {{"mesh": 0}}],
+        "meshes": [{{"primitives": [{{"attributes": {{"POSITION": 0, "TEXCOORD_0": 1}}, "indices": 2}}]}}],
+        "buffers": [{{"byteLength": {}}}],
+        "bufferViews": [{{"buffer": 0, "byteOffset": 0, "byteLength": 48}},
+                        {{"buffer": 0, "byteOffset": 48, "byteLength": 32}},
+                        {{"buffer": 0, "byteOffset": 80, "byteLength": 12}}],
+        "accessors": [{{"bufferView": 0, "componentType": 5126, "count": 4, "type": "VEC3"}},
+                      {{"bufferView": 1, "componentType": 5126, "count": 4, "type": "VEC2"}},
+                      {{"bufferView": 2, "componentType": 5123, "count": 6, "type": "SCALAR"}}]
+    }})", binary.size());
+
+    // Chunks are padded to 4 bytes, JSON with spaces and binary data with zeros.
+    json.resize((json.size() + 3) & ~size_t(3), ' ');
+    binary.resize((binary.size() + 3) & ~size_t(3), '\0');
+
+    auto AppendUInt32 = [](std::string &text, uint32_t value) {
+        text.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    };
+
+    std::string glb;
+    AppendUInt32(glb, 0x46546c67u);
+    AppendUInt32(glb, 2);
+    AppendUInt32(glb, static_cast<uint32_t>(12 + 8 + json.size() + 8 + binary.size()));
+    AppendUInt32(glb, static_cast<uint32_t>(json.size()));
+    AppendUInt32(glb, 0x4e4f534au);
+    glb += json;
+    AppendUInt32(glb, static_cast<uint32_t>(binary.size()));
+    AppendUInt32(glb, 0x004e4942u);
+    glb += binary;
+    return glb;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestGlb() {
+    JobSystem job_system(2);
+    auto glb = MakeGlb();
+    auto mesh = LoadMesh(job_system, "quad.glb", glb);
+
+    // Every node drawing the quad adds its own vertices and indices relative to them.
+    CHECK(mesh.vertices.size() == 8);
+    CHECK(mesh.indices == std::vector<uint32_t>({0, 1, 2, 0, 2, 3, 4, 5, 6, 4, 6, 7}));
+    CHECK(GetPosition(mesh, 2) == Float3::Values({11.0f, 1.0f, 0.0f}));
+    CHECK(GetPosition(mesh, 8) == Float3::Values({2.0f, 2.0f, 0.0f}));
+    CHECK(MeshLayout::Get<TexCoord>(mesh.vertices[6]) == Half2::Values({1.0f, 1.0f}));
+
+    // Normals are generated from triangles without a NORMAL attribute.
+    for (auto &vertex : mesh.vertices) {
+        CHECK(MeshLayout::Get<Normal>(vertex) == Snorm8x4::Values({0.0f, 0.0f, 1.0f, 0.0f}));
+    }
+
+    // A truncated file and a file of another format are rejected.
+    CHECK(Throws([&job_system, &glb]() { LoadMesh(job_system, "truncated.glb", glb.substr(0, glb.size() - 16)); }));
+    CHECK(Throws([&job_system, &glb]() { LoadMesh(job_system, "magic.glb", "GLTF" + glb.substr(4)); }));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestOptimizeVertexCache() {
+    // A grid with triangles in random order reuses few transformed vertices.
+    auto mesh = MakeGrid(64);
+    std::vector<std::array<uint32_t, 3>> triangles(mesh.indices.size() / 3);
+    std::memcpy(triangles.data(), mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(1));
+    std::memcpy(mesh.indices.data(), triangles.data(), mesh.indices.size() * sizeof(uint32_t));
+
+    auto original_triangles = GetSortedTriangles(mesh.indices);
+    auto acmr_before = AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+    OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+    auto acmr_after = AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+
+    // Triangles are reordered, not changed, and most vertices are transformed once.
+    CHECK(GetSortedTriangles(mesh.indices) == original_triangles);
+    CHECK(acmr_before > 2.0f);
+    CHECK(acmr_after < 0.8f);
+
+    // Overdraw optimization keeps triangles and most of the cache efficiency.
+    OptimizeOverdraw(mesh.indices, mesh.vertices);
+    CHECK(GetSortedTriangles(mesh.indices) == original_triangles);
+    CHECK(AnalyzeVertexCache(mesh.indices, mesh.vertices.size()) <= acmr_after * kOverdrawThreshold + 0.05f);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestOptimizeVertexFetch() {
+    // Every other quad of a grid keeps its first triangle, in reverse order, so many vertices aren't used.
+    auto grid = MakeGrid(8);
+    Mesh mesh;
+    mesh.vertices = grid.vertices;
+    for (auto quad = grid.indices.size() / 6; quad >= 2; quad -= 2) {
+        auto first = grid.indices.begin() + static_cast<ptrdiff_t>((quad - 2) * 6);
+        mesh.indices.insert(mesh.indices.end(), first, first + 3);
+    }
+
+    std::vector<bool> used(mesh.vertices.size(), false);
+    std::vector<Float3::Values> positions;
+    for (auto i = size_t(0); i != mesh.indices.size(); ++i) {
+        used[mesh.indices[i]] = true;
+        positions.push_back(GetPosition(mesh, i));
+    }
+    auto fetch_before = AnalyzeVertexFetch(mesh.indices, mesh.vertices.size(), MeshLayout::kStride);
+
+    OptimizeVertexFetch(mesh);
+
+    // Unused vertices are dropped, vertices are in the order of first use, and corners keep their positions.
+    CHECK(mesh.vertices.size() == static_cast<size_t>(std::count(used.begin(), used.end(), true)));
+    CHECK(mesh.vertices.size() < grid.vertices.size());
+    auto next_vertex = 0u;
+    for (auto i = size_t(0); i != mesh.indices.size(); ++i) {
+        CHECK(mesh.indices[i] <= next_vertex);
+        next_vertex = std::max(next_vertex, mesh.indices[i] + 1);
+        CHECK(GetPosition(mesh, i) == positions[i]);
+    }
+    CHECK(AnalyzeVertexFetch(mesh.indices, mesh.vertices.size(), MeshLayout::kStride) <= fetch_before);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    std::filesystem::remove_all(GetTestDirectory());
+    std::filesystem::create_directories(GetTestDirectory());
+
+    RUN(TestObjCorners);
+    RUN(TestObjErrors);
+    RUN(TestObjChunks);
+    RUN(TestGlb);
+    RUN(TestOptimizeVertexCache);
+    RUN(TestOptimizeVertexFetch);
+
+    std::filesystem::remove_all(GetTestDirectory());
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
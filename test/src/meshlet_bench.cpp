@@ -0,0 +1,128 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/meshlet.h>
+#include <common/mesh_optimizer.h>
+#include <common/vector3.h>
+#include <cmath>
+#include <numbers>
+
+#include "bench.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Make a unit sphere of rings and segments with triangles facing outward.
+Mesh MakeSphere(uint32_t ring_count, uint32_t segment_count) {
+    Mesh mesh;
+    std::vector<Vector3> positions;
+    for (auto ring = 0u; ring <= ring_count; ++ring) {
+        auto theta = std::numbers::pi_v<float> * static_cast<float>(ring) / static_cast<float>(ring_count);
+        for (auto segment = 0u; segment <= segment_count; ++segment) {
+            auto phi = 2.0f * std::numbers::pi_v<float> * static_cast<float>(segment) /
+                       static_cast<float>(segment_count);
+            Vector3 position = {std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)};
+            positions.push_back(position);
+            mesh.vertices.push_back(MeshLayout::MakeVertex(position, {position[0], position[1], position[2], 0.0f},
+                                                           {0.0f, 0.0f}));
+        }
+    }
+
+    for (auto ring = 0u; ring != ring_count; ++ring) {
+        for (auto segment = 0u; segment != segment_count; ++segment) {
+            auto a = ring * (segment_count + 1) + segment;
+            auto b = a + segment_count + 1;
+            for (auto triangle : {std::array<uint32_t, 3>{a, b, b + 1}, std::array<uint32_t, 3>{a, b + 1, a + 1}}) {
+                // Turn a triangle facing inward around, triangles at poles have no area and are kept.
+                auto &p0 = positions[triangle[0]];
+                auto normal = Cross(Subtract(positions[triangle[1]], p0), Subtract(positions[triangle[2]], p0));
+                if (Dot(normal, p0) < 0.0f) {
+                    std::swap(triangle[1], triangle[2]);
+                }
+                mesh.indices.insert(mesh.indices.end(), triangle.begin(), triangle.end());
+            }
+        }
+    }
+
+    OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+    return mesh;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Make a left handed view matrix looking from an eye at the origin, like Camera.
+Matrix4 MakeView(const Vector3 &eye) {
+    auto z = Normalize(Subtract({0.0f, 0.0f, 0.0f}, eye));
+    auto x = Normalize(Cross({0.0f, 1.0f, 0.0f}, z));
+    auto y = Cross(z, x);
+    return {x[0], y[0], z[0], 0.0f,
+            x[1], y[1], z[1], 0.0f,
+            x[2], y[2], z[2], 0.0f,
+            -Dot(x, eye), -Dot(y, eye), -Dot(z, eye), 1.0f};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Make a perspective projection of a square view with a depth from 0 to 1, like Camera.
+Matrix4 MakeProjection(float fov, float near, float far) {
+    auto y = 1.0f / std::tan(fov * 0.5f);
+    auto z = far / (far - near);
+    return {y, 0.0f, 0.0f, 0.0f,
+            0.0f, y, 0.0f, 0.0f,
+            0.0f, 0.0f, z, 1.0f,
+            0.0f, 0.0f, -near * z, 0.0f};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    auto quick = IsQuick(argc, argv);
+    const auto kRepeatCount = quick ? 2u : 10u;
+
+    std::vector<uint32_t> ring_counts = {64, 256};
+    if (!quick) {
+        ring_counts.push_back(1024);
+    }
+
+    // A camera sees the whole sphere from outside, and another one close to it sees a part of it.
+    auto projection = MakeProjection(1.0f, 0.1f, 100.0f);
+    std::array<std::pair<const char *, Matrix4>, 2> views = {std::pair("far", MakeView({0.0f, 1.0f, -4.0f})),
+                                                             std::pair("near", MakeView({0.0f, 0.2f, -1.5f}))};
+
+    fmt::print("{:>10} {:>9} {:>11} {:>16} {:>6} {:>10} {:>13} {:>14} {:>12}\n", "triangles", "meshlets",
+               "build (ms)", "triangles (M/s)", "view", "cull (ms)", "frustum (%)", "backface (%)", "visible (%)");
+    for (auto ring_count : ring_counts) {
+        auto mesh = MakeSphere(ring_count, ring_count * 2);
+        auto triangle_count = mesh.indices.size() / 3;
+
+        MeshletSet meshlet_set;
+        auto build_time = Measure(kRepeatCount, [&]() {
+            meshlet_set = BuildMeshlets(mesh);
+        });
+
+        for (auto &[name, view] : views) {
+            std::vector<uint32_t> indices;
+            MeshletCullStatistics statistics;
+            auto cull_time = Measure(kRepeatCount, [&]() {
+                statistics = CullMeshlets(meshlet_set, view, projection, indices);
+            });
+
+            // Cones cull some of meshlets on the far side of a sphere, and visible meshlets are drawn whole.
+            CHECK(statistics.backface_culled_count > 0);
+            CHECK(statistics.visible_triangle_count < triangle_count);
+            CHECK(indices.size() == statistics.visible_triangle_count * 3);
+
+            auto meshlet_count = static_cast<double>(statistics.meshlet_count);
+            fmt::print("{:>10} {:>9} {:>11.3f} {:>16.2f} {:>6} {:>10.3f} {:>13.1f} {:>14.1f} {:>12.1f}\n",
+                       triangle_count, meshlet_set.meshlets.size(), build_time,
+                       static_cast<double>(triangle_count) / build_time / 1e3, name, cull_time,
+                       statistics.frustum_culled_count / meshlet_count * 100.0,
+                       statistics.backface_culled_count / meshlet_count * 100.0,
+                       static_cast<double>(statistics.visible_triangle_count) / triangle_count * 100.0);
+        }
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,269 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/meshlet.h>
+#include <common/mesh_optimizer.h>
+#include <common/vector3.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "test.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Query whether a function throws std::runtime_error.
+template<typename F>
+bool Throws(F &&function) {
+    try {
+        function();
+    }
+    catch (const std::runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Make a grid of quads facing +Z, each quad is two triangles. Heights of a bumpy grid vary across it.
+Mesh MakeGrid(uint32_t size, bool bumpy) {
+    Mesh mesh;
+    for (auto y = 0u; y <= size; ++y) {
+        for (auto x = 0u; x <= size; ++x) {
+            auto z = bumpy ? std::sin(static_cast<float>(x) * 0.7f) * std::cos(static_cast<float>(y) * 0.3f) : 0.0f;
+            auto position = Float3::Values({static_cast<float>(x), static_cast<float>(y), z});
+            mesh.vertices.push_back(MeshLayout::MakeVertex(position, {0.0f, 0.0f, 1.0f, 0.0f}, {0.0f, 0.0f}));
+        }
+    }
+
+    for (auto y = 0u; y != size; ++y) {
+        for (auto x = 0u; x != size; ++x) {
+            auto i = y * (size + 1) + x;
+            auto j = i + size + 1;
+            mesh.indices.insert(mesh.indices.end(), {i, i + 1, j + 1, i, j + 1, j});
+        }
+    }
+    OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+    return mesh;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Make a left handed view matrix looking from an eye at a focus, like Camera.
+Matrix4 MakeView(const Vector3 &eye, const Vector3 &focus) {
+    auto z = Normalize(Subtract(focus, eye));
+    auto x = Normalize(Cross({0.0f, 1.0f, 0.0f}, z));
+    auto y = Cross(z, x);
+    return {x[0], y[0], z[0], 0.0f,
+            x[1], y[1], z[1], 0.0f,
+            x[2], y[2], z[2], 0.0f,
+            -Dot(x, eye), -Dot(y, eye), -Dot(z, eye), 1.0f};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Make a perspective projection of a square view with a depth from 0 to 1, like Camera.
+Matrix4 MakeProjection(float fov, float near, float far) {
+    auto y = 1.0f / std::tan(fov * 0.5f);
+    auto z = far / (far - near);
+    return {y, 0.0f, 0.0f, 0.0f,
+            0.0f, y, 0.0f, 0.0f,
+            0.0f, 0.0f, z, 1.0f,
+            0.0f, 0.0f, -near * z, 0.0f};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Retrieve triangles of meshlets as indices into vertices of a mesh, sorted.
+std::vector<std::array<uint32_t, 3>> GetSortedTriangles(const MeshletSet &meshlet_set) {
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for (auto &meshlet : meshlet_set.meshlets) {
+        auto vertices = meshlet_set.vertices.data() + meshlet.vertex_offset;
+        auto local_indices = meshlet_set.triangles.data() + meshlet.triangle_offset;
+        for (auto i = 0u; i != meshlet.triangle_count; ++i) {
+            triangles.push_back({vertices[local_indices[i * 3 + 0]], vertices[local_indices[i * 3 + 1]],
+                                 vertices[local_indices[i * 3 + 2]]});
+        }
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Check meshlets are within limits and cover every triangle of a mesh once.
+void CheckMeshlets(const Mesh &mesh, const MeshletSet &meshlet_set, uint32_t max_vertex_count,
+                   uint32_t max_triangle_count) {
+    CHECK(meshlet_set.bounds.size() == meshlet_set.meshlets.size());
+
+    auto vertex_offset = 0u;
+    auto triangle_offset = 0u;
+    for (auto &meshlet : meshlet_set.meshlets) {
+        CHECK(meshlet.vertex_count && meshlet.vertex_count <= max_vertex_count);
+        CHECK(meshlet.triangle_count && meshlet.triangle_count <= max_triangle_count);
+
+        // Meshlets are packed one after another.
+        CHECK(meshlet.vertex_offset == vertex_offset);
+        CHECK(meshlet.triangle_offset == triangle_offset);
+        vertex_offset += meshlet.vertex_count;
+        triangle_offset += meshlet.triangle_count * 3;
+
+        // Vertices of a meshlet are distinct and every one of them is used.
+        std::vector<uint32_t> vertices(meshlet_set.vertices.begin() + meshlet.vertex_offset,
+                                       meshlet_set.vertices.begin() + meshlet.vertex_offset + meshlet.vertex_count);
+        std::sort(vertices.begin(), vertices.end());
+        CHECK(std::adjacent_find(vertices.begin(), vertices.end()) == vertices.end());
+
+        std::vector<bool> used(meshlet.vertex_count, false);
+        for (auto i = 0u; i != meshlet.triangle_count * 3; ++i) {
+            auto local_index = meshlet_set.triangles[meshlet.triangle_offset + i];
+            CHECK(local_index < meshlet.vertex_count);
+            used[local_index] = true;
+        }
+        CHECK(std::all_of(used.begin(), used.end(), [](auto value) { return value; }));
+    }
+    CHECK(vertex_offset == meshlet_set.vertices.size());
+    CHECK(triangle_offset == meshlet_set.triangles.size());
+
+    std::vector<std::array<uint32_t, 3>> triangles(mesh.indices.size() / 3);
+    for (auto i = size_t(0); i != triangles.size(); ++i) {
+        triangles[i] = {mesh.indices[i * 3 + 0], mesh.indices[i * 3 + 1], mesh.indices[i * 3 + 2]};
+    }
+    std::sort(triangles.begin(), triangles.end());
+    CHECK(GetSortedTriangles(meshlet_set) == triangles);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestLimits() {
+    auto mesh = MakeGrid(48, true);
+
+    // The default limits, and limits small enough that triangles or vertices run out first.
+    auto meshlet_set = BuildMeshlets(mesh);
+    CheckMeshlets(mesh, meshlet_set, kMeshletMaxVertexCount, kMeshletMaxTriangleCount);
+    CHECK(std::any_of(meshlet_set.meshlets.begin(), meshlet_set.meshlets.end(), [](auto &meshlet) {
+        return meshlet.vertex_count == kMeshletMaxVertexCount || meshlet.triangle_count == kMeshletMaxTriangleCount;
+    }));
+
+    for (auto [max_vertex_count, max_triangle_count] : {std::pair(3u, 1u), std::pair(16u, 124u),
+                                                        std::pair(256u, 8u), std::pair(256u, 512u)}) {
+        meshlet_set = BuildMeshlets(mesh, max_vertex_count, max_triangle_count);
+        CheckMeshlets(mesh, meshlet_set, max_vertex_count, max_triangle_count);
+    }
+
+    // A meshlet of a grid shares most of its vertices, so meshlets are nearly full.
+    meshlet_set = BuildMeshlets(mesh);
+    auto triangle_count = mesh.indices.size() / 3;
+    CHECK(meshlet_set.meshlets.size() * kMeshletMaxTriangleCount < triangle_count * 2);
+
+    // Limits a local index can't address are rejected.
+    CHECK(Throws([&mesh]() { BuildMeshlets(mesh, 2, 124); }));
+    CHECK(Throws([&mesh]() { BuildMeshlets(mesh, 257, 124); }));
+    CHECK(Throws([&mesh]() { BuildMeshlets(mesh, 64, 0); }));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestDeterminism() {
+    auto mesh = MakeGrid(40, true);
+    auto meshlet_set = BuildMeshlets(mesh);
+
+    // The same mesh makes the same meshlets.
+    for (auto i = 0; i != 3; ++i) {
+        auto next_meshlet_set = BuildMeshlets(mesh);
+        CHECK(next_meshlet_set.vertices == meshlet_set.vertices);
+        CHECK(next_meshlet_set.triangles == meshlet_set.triangles);
+        CHECK(next_meshlet_set.meshlets.size() == meshlet_set.meshlets.size());
+        for (auto j = size_t(0); j != meshlet_set.meshlets.size(); ++j) {
+            auto &meshlet = meshlet_set.meshlets[j];
+            auto &next_meshlet = next_meshlet_set.meshlets[j];
+            CHECK(next_meshlet.vertex_count == meshlet.vertex_count);
+            CHECK(next_meshlet.triangle_count == meshlet.triangle_count);
+
+            auto &bounds = meshlet_set.bounds[j];
+            auto &next_bounds = next_meshlet_set.bounds[j];
+            CHECK(next_bounds.center == bounds.center && next_bounds.radius == bounds.radius);
+            CHECK(next_bounds.cone_apex == bounds.cone_apex && next_bounds.cone_axis == bounds.cone_axis);
+            CHECK(next_bounds.cone_cutoff == bounds.cone_cutoff);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestBoundingSpheres() {
+    auto mesh = MakeGrid(40, true);
+
+    for (auto max_vertex_count : {3u, 16u, 64u, 256u}) {
+        auto meshlet_set = BuildMeshlets(mesh, max_vertex_count, kMeshletMaxTriangleCount);
+
+        // Every vertex of a meshlet is inside its sphere, up to rounding.
+        for (auto i = size_t(0); i != meshlet_set.meshlets.size(); ++i) {
+            auto &meshlet = meshlet_set.meshlets[i];
+            auto &bounds = meshlet_set.bounds[i];
+            for (auto j = 0u; j != meshlet.vertex_count; ++j) {
+                auto vertex = meshlet_set.vertices[meshlet.vertex_offset + j];
+                auto position = MeshLayout::Get<Position>(mesh.vertices[vertex]);
+                auto offset = Subtract(position, bounds.center);
+                CHECK(std::sqrt(Dot(offset, offset)) <= bounds.radius * 1.0001f + 1e-5f);
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestConeCulling() {
+    // A flat patch facing +Z around (8, 8, 0).
+    auto mesh = MakeGrid(16, false);
+    auto meshlet_set = BuildMeshlets(mesh);
+    auto triangle_count = mesh.indices.size() / 3;
+    for (auto &bounds : meshlet_set.bounds) {
+        CHECK(bounds.cone_cutoff < 1.0f);
+        CHECK(std::abs(bounds.cone_axis[2] - 1.0f) < 1e-5f);
+    }
+
+    auto projection = MakeProjection(1.5f, 0.1f, 100.0f);
+    Vector3 center = {8.0f, 8.0f, 0.0f};
+    std::vector<uint32_t> indices;
+
+    // A camera in front of the patch sees every triangle of it.
+    auto statistics = CullMeshlets(meshlet_set, MakeView({8.0f, 8.0f, 20.0f}, center), projection, indices);
+    CHECK(statistics.meshlet_count == meshlet_set.meshlets.size());
+    CHECK(statistics.frustum_culled_count == 0);
+    CHECK(statistics.backface_culled_count == 0);
+    CHECK(statistics.visible_triangle_count == triangle_count);
+    CHECK(indices.size() == triangle_count * 3);
+
+    // A camera at a grazing angle in front of the patch sees it too.
+    statistics = CullMeshlets(meshlet_set, MakeView({30.0f, 8.0f, 0.5f}, center), projection, indices);
+    CHECK(statistics.backface_culled_count == 0);
+
+    // A camera behind the patch culls every meshlet of it as back faces, not by the frustum.
+    statistics = CullMeshlets(meshlet_set, MakeView({8.0f, 8.0f, -20.0f}, center), projection, indices);
+    CHECK(statistics.frustum_culled_count == 0);
+    CHECK(statistics.backface_culled_count == meshlet_set.meshlets.size());
+    CHECK(statistics.visible_triangle_count == 0);
+    CHECK(statistics.triangle_count == triangle_count);
+    CHECK(indices.empty());
+
+    // A camera looking away from the patch culls it by the frustum.
+    statistics = CullMeshlets(meshlet_set, MakeView({8.0f, 8.0f, 20.0f}, {8.0f, 8.0f, 40.0f}), projection, indices);
+    CHECK(statistics.frustum_culled_count == meshlet_set.meshlets.size());
+    CHECK(indices.empty());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    RUN(TestLimits);
+    RUN(TestDeterminism);
+    RUN(TestBoundingSpheres);
+    RUN(TestConeCulling);
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,251 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/occlusion_culler.h>
+#include <common/vector3.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <thread>
+
+#include "test.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr Matrix4 kIdentity = {1.0f, 0.0f, 0.0f, 0.0f,
+                               0.0f, 1.0f, 0.0f, 0.0f,
+                               0.0f, 0.0f, 1.0f, 0.0f,
+                               0.0f, 0.0f, 0.0f, 1.0f};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Make a view projection matrix of a camera at (0, 0, -10) looking down +Z, like Camera.
+Matrix4 MakeViewProjection() {
+    // A left handed view moves the eye to the origin, and a perspective projection maps depth from 0 to 1.
+    Matrix4 view = kIdentity;
+    view[14] = 10.0f;
+
+    constexpr auto kNear = 0.5f;
+    constexpr auto kFar = 100.0f;
+    auto y = 1.0f / std::tan(0.5f);
+    auto z = kFar / (kFar - kNear);
+    Matrix4 projection = {y * 0.5f, 0.0f, 0.0f, 0.0f,
+                          0.0f, y, 0.0f, 0.0f,
+                          0.0f, 0.0f, z, 1.0f,
+                          0.0f, 0.0f, -kNear * z, 0.0f};
+    return Multiply(projection, view);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! An occluder of a grid of quads in the XY plane, its heights along Z vary when it is bumpy.
+struct GridOccluder {
+    std::vector<std::array<float, 3>> positions;
+    std::vector<uint32_t> indices;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+GridOccluder MakeGridOccluder(uint32_t size, float min, float max, bool bumpy) {
+    GridOccluder occluder;
+    for (auto y = 0u; y <= size; ++y) {
+        for (auto x = 0u; x <= size; ++x) {
+            auto u = static_cast<float>(x) / size;
+            auto v = static_cast<float>(y) / size;
+            auto z = bumpy ? std::sin(u * 9.0f) * std::cos(v * 5.0f) * 2.0f : 0.0f;
+            occluder.positions.push_back({min + (max - min) * u, min + (max - min) * v, z});
+        }
+    }
+
+    for (auto y = 0u; y != size; ++y) {
+        for (auto x = 0u; x != size; ++x) {
+            auto i = y * (size + 1) + x;
+            auto j = i + size + 1;
+            occluder.indices.insert(occluder.indices.end(), {i, i + 1, j + 1, i, j + 1, j});
+        }
+    }
+    return occluder;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Make a model matrix of a translation.
+Matrix4 MakeTranslation(float x, float y, float z) {
+    auto model = kIdentity;
+    model[12] = x;
+    model[13] = y;
+    model[14] = z;
+    return model;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestOccludedBox() {
+    JobSystem job_system(2);
+    OcclusionCuller culler(&job_system);
+
+    // A quad from -3 to 3 at Z = 0 in front of a camera.
+    auto quad = MakeGridOccluder(1, -3.0f, 3.0f, false);
+    culler.Begin(MakeViewProjection());
+    culler.AddOccluder(quad.positions, quad.indices, kIdentity);
+    culler.Render().wait();
+
+    auto &statistics = culler.GetStatistics();
+    CHECK(statistics.occluder_count == 1);
+    CHECK(statistics.triangle_count == 2);
+    CHECK(statistics.rasterized_triangle_count == 2);
+
+    // A box behind the quad is hidden, a box beside it, in front of it or peeking out of it isn't.
+    BoundingBoxes boxes;
+    boxes.Add({-1.0f, -1.0f, 5.0f}, {1.0f, 1.0f, 6.0f});
+    boxes.Add({6.0f, -1.0f, 5.0f}, {7.0f, 1.0f, 6.0f});
+    boxes.Add({-1.0f, -1.0f, -2.0f}, {1.0f, 1.0f, -1.0f});
+    boxes.Add({2.0f, -1.0f, 5.0f}, {5.0f, 1.0f, 6.0f});
+    boxes.Add({-2.5f, -2.5f, 0.5f}, {2.5f, 2.5f, 30.0f});
+    boxes.Add({-1.0f, -1.0f, -11.0f}, {1.0f, 1.0f, 6.0f});
+
+    CHECK(!culler.IsVisible({-1.0f, -1.0f, 5.0f}, {1.0f, 1.0f, 6.0f}));
+    CHECK(culler.IsVisible({6.0f, -1.0f, 5.0f}, {7.0f, 1.0f, 6.0f}));
+
+    std::vector<uint32_t> candidates = {0, 1, 2, 3, 4, 5};
+    std::vector<uint32_t> visible;
+    culler.Cull(boxes, candidates, visible);
+    CHECK(visible == std::vector<uint32_t>({1, 2, 3, 5}));
+    CHECK(statistics.tested_count == 6);
+    CHECK(statistics.occluded_count == 2);
+
+    // The same box is visible once the quad moves out of the way.
+    culler.Begin(MakeViewProjection());
+    culler.AddOccluder(quad.positions, quad.indices, MakeTranslation(20.0f, 0.0f, 0.0f));
+    culler.Render().wait();
+    CHECK(culler.IsVisible({-1.0f, -1.0f, 5.0f}, {1.0f, 1.0f, 6.0f}));
+
+    // Nothing is hidden without occluders.
+    culler.Begin(MakeViewProjection());
+    culler.Render().wait();
+    culler.Cull(boxes, candidates, visible);
+    CHECK(visible == candidates);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Check levels of a pyramid of a culler have the nearest and farthest depths of texels of the depth buffer below.
+void CheckPyramid(const OcclusionCuller &culler) {
+    auto &depths = culler.GetDepthLevel(0);
+    CHECK(depths.min_depths == depths.max_depths);
+    CHECK(culler.GetDepthLevel(culler.GetDepthLevelCount() - 1).width == 1);
+    CHECK(culler.GetDepthLevel(culler.GetDepthLevelCount() - 1).height == 1);
+
+    for (auto level = 1u; level != culler.GetDepthLevelCount(); ++level) {
+        auto &depth_level = culler.GetDepthLevel(level);
+        CHECK(depth_level.width == std::max((culler.GetDepthLevel(level - 1).width + 1) / 2, 1u));
+        CHECK(depth_level.height == std::max((culler.GetDepthLevel(level - 1).height + 1) / 2, 1u));
+
+        for (auto y = 0u; y != depth_level.height; ++y) {
+            for (auto x = 0u; x != depth_level.width; ++x) {
+                auto min_depth = 1.0f;
+                auto max_depth = 0.0f;
+                for (auto y0 = y << level; y0 < std::min((y + 1) << level, depths.height); ++y0) {
+                    for (auto x0 = x << level; x0 < std::min((x + 1) << level, depths.width); ++x0) {
+                        min_depth = std::min(min_depth, depths.min_depths[y0 * depths.width + x0]);
+                        max_depth = std::max(max_depth, depths.max_depths[y0 * depths.width + x0]);
+                    }
+                }
+                CHECK(depth_level.min_depths[y * depth_level.width + x] == min_depth);
+                CHECK(depth_level.max_depths[y * depth_level.width + x] == max_depth);
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestPyramid() {
+    JobSystem job_system(2);
+
+    // Bumpy occluders at several depths in front of a flat backdrop, and odd sizes have texels at edges covering less.
+    auto grid = MakeGridOccluder(16, -2.0f, 2.0f, true);
+    auto backdrop = MakeGridOccluder(1, -200.0f, 200.0f, false);
+    for (auto [width, height] : {std::pair(kOcclusionDepthWidth, kOcclusionDepthHeight), std::pair(100u, 37u),
+                                 std::pair(1u, 1u), std::pair(3u, 70u)}) {
+        OcclusionCuller culler(&job_system, width, height);
+        culler.Begin(MakeViewProjection());
+        culler.AddOccluder(grid.positions, grid.indices, MakeTranslation(-3.0f, 0.0f, 5.0f));
+        culler.AddOccluder(grid.positions, grid.indices, MakeTranslation(2.0f, 1.0f, 20.0f));
+        culler.AddOccluder(backdrop.positions, backdrop.indices, MakeTranslation(0.0f, 0.0f, 60.0f));
+        culler.Render().wait();
+
+        auto &depths = culler.GetDepthLevel(0).min_depths;
+        CHECK(std::all_of(depths.begin(), depths.end(), [](auto depth) { return depth >= 0.0f && depth <= 1.0f; }));
+        CHECK(std::any_of(depths.begin(), depths.end(), [](auto depth) { return depth < 1.0f; }));
+        CheckPyramid(culler);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestThreadCountIndependence() {
+    // Occluders of several setup chunks, and boxes of several cull chunks.
+    auto grid = MakeGridOccluder(48, -4.0f, 4.0f, true);
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<float> position_distribution(-12.0f, 12.0f);
+    std::uniform_real_distribution<float> depth_distribution(-5.0f, 40.0f);
+    std::uniform_real_distribution<float> size_distribution(0.1f, 2.0f);
+
+    BoundingBoxes boxes;
+    std::vector<uint32_t> candidates;
+    for (auto i = 0u; i != 20000; ++i) {
+        std::array<float, 3> min = {position_distribution(generator), position_distribution(generator),
+                                    depth_distribution(generator)};
+        boxes.Add(min, {min[0] + size_distribution(generator), min[1] + size_distribution(generator),
+                        min[2] + size_distribution(generator)});
+        candidates.push_back(i);
+    }
+
+    // Depth buffers, pyramids and visible boxes don't depend on the number of workers.
+    std::vector<float> first_depths;
+    std::vector<uint32_t> first_visible;
+    for (auto thread_count : {1u, 2u, std::max(std::thread::hardware_concurrency(), 4u)}) {
+        JobSystem job_system(thread_count);
+        OcclusionCuller culler(&job_system);
+        culler.Begin(MakeViewProjection());
+        for (auto i = 0; i != 3; ++i) {
+            auto model = MakeTranslation(i * 5.0f - 5.0f, i * 2.0f - 2.0f, i * 6.0f);
+            culler.AddOccluder(grid.positions, grid.indices, model);
+        }
+        culler.Render().wait();
+        CHECK(culler.GetStatistics().triangle_count > 4 * 1024);
+        CheckPyramid(culler);
+
+        std::vector<uint32_t> visible;
+        culler.Cull(boxes, candidates, visible);
+
+        std::vector<float> depths;
+        for (auto level = 0u; level != culler.GetDepthLevelCount(); ++level) {
+            auto &depth_level = culler.GetDepthLevel(level);
+            depths.insert(depths.end(), depth_level.min_depths.begin(), depth_level.min_depths.end());
+            depths.insert(depths.end(), depth_level.max_depths.begin(), depth_level.max_depths.end());
+        }
+
+        if (first_depths.empty()) {
+            first_depths = depths;
+            first_visible = visible;
+            CHECK(!visible.empty() && visible.size() != candidates.size());
+        }
+        CHECK(depths == first_depths);
+        CHECK(visible == first_visible);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    RUN(TestOccludedBox);
+    RUN(TestPyramid);
+    RUN(TestThreadCountIndependence);
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,145 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/job_system.h>
+#include <common/pipeline_cache.h>
+#include <common/shader_cache.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "test.h"
+
+using namespace std::chrono_literals;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class FakeLibrary : public ShaderLibrary {
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A compiler records how many compiles overlap.
+class FakeCompiler : public ShaderCompiler {
+public:
+    [[nodiscard]]
+    std::string GetIdentifier() const override {
+        return "fake";
+    }
+
+    ShaderCompileResult Compile(std::string_view source, const ShaderMacros &macros) override {
+        auto active_count = ++_active_count;
+        auto max_active_count = max_overlap.load();
+        while (active_count > max_active_count && !max_overlap.compare_exchange_weak(max_active_count, active_count)) {
+        }
+
+        ++compile_count;
+        std::this_thread::sleep_for(50ms);
+        --_active_count;
+        return {std::make_shared<FakeLibrary>(), {}};
+    }
+
+    std::shared_ptr<ShaderLibrary> Load(std::span<const std::byte> binary) override {
+        return nullptr;
+    }
+
+    std::atomic<uint32_t> compile_count = 0;
+    std::atomic<uint32_t> max_overlap = 0;
+
+private:
+    std::atomic<uint32_t> _active_count = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class FakePipelineState : public PipelineState {
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A factory compiles the shader of a descriptor through a shader cache, like the Metal one.
+class FakePipelineFactory : public PipelineFactory {
+public:
+    explicit FakePipelineFactory(ShaderCache *shader_cache) :
+    _shader_cache(shader_cache) {
+    }
+
+    std::shared_ptr<PipelineState> Create(const PipelineDescriptor &descriptor) override {
+        _shader_cache->GetLibraryFromSource(descriptor.shader_path.string(), descriptor.macros);
+        return std::make_shared<FakePipelineState>();
+    }
+
+private:
+    ShaderCache *_shader_cache = nullptr;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+PipelineDescriptor MakeDescriptor(const std::string &shader_path, const std::string &vertex_entrypoint,
+                                  const std::string &fragment_entrypoint) {
+    PipelineDescriptor descriptor;
+    descriptor.shader_path = shader_path;
+    descriptor.vertex_entrypoint = vertex_entrypoint;
+    descriptor.fragment_entrypoint = fragment_entrypoint;
+    return descriptor;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestKeySeparatesStrings() {
+    // Characters moved between a path and entrypoints make different keys.
+    CHECK(PipelineCache::ComputeKey(MakeDescriptor("ab", "c", "d")) !=
+          PipelineCache::ComputeKey(MakeDescriptor("a", "bc", "d")));
+    CHECK(PipelineCache::ComputeKey(MakeDescriptor("a", "bc", "d")) !=
+          PipelineCache::ComputeKey(MakeDescriptor("a", "b", "cd")));
+
+    auto a = MakeDescriptor("a", "b", "c");
+    auto b = a;
+    a.macros = {{"AB", "C"}};
+    b.macros = {{"A", "BC"}};
+    CHECK(PipelineCache::ComputeKey(a) != PipelineCache::ComputeKey(b));
+    CHECK(PipelineCache::ComputeKey(a) == PipelineCache::ComputeKey(a));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestWarmUpCompilesInParallel() {
+    auto compiler = std::make_unique<FakeCompiler>();
+    auto fake_compiler = compiler.get();
+    ShaderCache shader_cache(std::move(compiler));
+    JobSystem job_system(4);
+    PipelineCache pipeline_cache(std::make_unique<FakePipelineFactory>(&shader_cache), &job_system);
+
+    // Shaders of different files compile at the same time, and entrypoints of a file share a compile.
+    std::vector<PipelineDescriptor> descriptors;
+    for (auto i = 0; i != 4; ++i) {
+        descriptors.push_back(MakeDescriptor(fmt::format("shader_{}", i), "VSMain", "FSMain"));
+        descriptors.push_back(MakeDescriptor(fmt::format("shader_{}", i), "VSMain", "FSOther"));
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    pipeline_cache.WarmUp(descriptors);
+    for (auto &descriptor : descriptors) {
+        CHECK(pipeline_cache.GetPipelineState(descriptor).get());
+    }
+    auto elapsed_time = std::chrono::steady_clock::now() - start_time;
+
+    CHECK(fake_compiler->compile_count == 4);
+    CHECK(fake_compiler->max_overlap > 1);
+    fmt::print("Warm up of {} pipelines: {} compiles, {} at most in parallel, {:.1f} ms.\n", descriptors.size(),
+               fake_compiler->compile_count.load(), fake_compiler->max_overlap.load(),
+               std::chrono::duration<double, std::milli>(elapsed_time).count());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    RUN(TestKeySeparatesStrings);
+    RUN(TestWarmUpCompilesInParallel);
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
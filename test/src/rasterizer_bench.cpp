@@ -0,0 +1,101 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/rasterizer.h>
+#include <algorithm>
+#include <thread>
+
+#include "bench.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A scene of a grid of small triangles over a target, like a tessellated mesh.
+struct GridScene {
+    std::vector<std::array<float, 4>> positions;
+    std::vector<uint32_t> indices;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Make a grid of quads in clip space, each quad is two triangles.
+GridScene MakeGridScene(uint32_t column_count, uint32_t row_count) {
+    GridScene scene;
+    for (auto y = 0u; y <= row_count; ++y) {
+        for (auto x = 0u; x <= column_count; ++x) {
+            scene.positions.push_back({static_cast<float>(x) / column_count * 2.0f - 1.0f,
+                                       static_cast<float>(y) / row_count * 2.0f - 1.0f, 0.5f, 1.0f});
+        }
+    }
+
+    for (auto y = 0u; y != row_count; ++y) {
+        for (auto x = 0u; x != column_count; ++x) {
+            auto i = y * (column_count + 1) + x;
+            auto j = i + column_count + 1;
+            scene.indices.insert(scene.indices.end(), {i, i + 1, j + 1, i, j + 1, j});
+        }
+    }
+    return scene;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    auto quick = IsQuick(argc, argv);
+    const auto kRepeatCount = quick ? 2u : 20u;
+    const auto kWidth = quick ? 480u : 1920u;
+    const auto kHeight = quick ? 270u : 1080u;
+
+    // Workers double up to the number of cores, two at least so tiles are split.
+    std::vector<uint32_t> thread_counts = {1};
+    while (thread_counts.back() < std::max(std::thread::hardware_concurrency(), 2u)) {
+        thread_counts.push_back(thread_counts.back() * 2);
+    }
+
+    auto scene = MakeGridScene(kWidth / 8, kHeight / 8);
+
+    RasterPipeline pipeline;
+    pipeline.varying_count = 2;
+    pipeline.vertex_shader = [&scene](uint32_t index, RasterVertex &output) {
+        output.position = scene.positions[index];
+        output.varyings[0] = output.position[0] * 0.5f + 0.5f;
+        output.varyings[1] = output.position[1] * 0.5f + 0.5f;
+    };
+    pipeline.fragment_shader = [](const float *varyings) {
+        return RasterColor{varyings[0], varyings[1], 0.5f, 1.0f};
+    };
+
+    fmt::print("{} cores, {}x{}, {} triangles.\n", std::thread::hardware_concurrency(), kWidth, kHeight,
+               scene.indices.size() / 3);
+    fmt::print("{:>8} {:>12} {:>18} {:>16}\n", "workers", "draw (ms)", "triangles (M/s)", "pixels (M/s)");
+
+    std::vector<uint32_t> first_pixels;
+    for (auto thread_count : thread_counts) {
+        JobSystem job_system(thread_count);
+        Rasterizer rasterizer(&job_system);
+
+        RasterTarget target;
+        target.Resize(kWidth, kHeight);
+        auto draw_time = Measure(kRepeatCount, [&]() {
+            target.Clear({0.0f, 0.0f, 0.0f, 1.0f});
+            rasterizer.DrawIndexed(target, pipeline, std::span<const uint32_t>(scene.indices));
+        });
+
+        // A grid covers every pixel once, and images don't depend on the number of workers.
+        auto &statistics = rasterizer.GetStatistics();
+        CHECK(statistics.pixel_count == static_cast<uint64_t>(kWidth) * kHeight * kRepeatCount);
+
+        std::vector<uint32_t> pixels(target.GetPixels().begin(), target.GetPixels().end());
+        if (first_pixels.empty()) {
+            first_pixels = pixels;
+        }
+        CHECK(pixels == first_pixels);
+
+        fmt::print("{:>8} {:>12.3f} {:>18.2f} {:>16.2f}\n", thread_count, draw_time,
+                   statistics.GetTrianglesPerSecond() / 1e6, statistics.GetPixelsPerSecond() / 1e6);
+    }
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,262 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/rasterizer.h>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <thread>
+
+#include "test.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A vertex with a clip space position and a color.
+struct ColorVertex {
+    std::array<float, 4> position;
+    RasterColor color;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Make a pipeline passes through positions and interpolates colors of vertices.
+RasterPipeline MakeColorPipeline(const std::vector<ColorVertex> &vertices) {
+    RasterPipeline pipeline;
+    pipeline.varying_count = 4;
+    pipeline.vertex_shader = [&vertices](uint32_t index, RasterVertex &output) {
+        output.position = vertices[index].position;
+        std::copy(vertices[index].color.begin(), vertices[index].color.end(), output.varyings.begin());
+    };
+    pipeline.fragment_shader = [](const float *varyings) {
+        return RasterColor{varyings[0], varyings[1], varyings[2], varyings[3]};
+    };
+    return pipeline;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Unpack a channel of a BGRA8 pixel.
+//! \param pixel A pixel.
+//! \param channel A channel, 0 is red and 3 is alpha.
+//! \return A value from 0 to 255.
+int32_t GetChannel(uint32_t pixel, uint32_t channel) {
+    constexpr uint32_t kShifts[4] = {16, 8, 0, 24};
+    return static_cast<int32_t>((pixel >> kShifts[channel]) & 0xff);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Transform a clip space position to a viewport where the origin is the top left corner.
+std::array<double, 2> ToViewport(const std::array<float, 4> &position, uint32_t width, uint32_t height) {
+    return {(position[0] / position[3] * 0.5 + 0.5) * width, (0.5 - position[1] / position[3] * 0.5) * height};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Compute barycentric coordinates of a point in a triangle in the viewport.
+std::array<double, 3> GetBarycentrics(const std::array<std::array<double, 2>, 3> &p, double x, double y) {
+    auto Edge = [](const std::array<double, 2> &a, const std::array<double, 2> &b, double x, double y) {
+        return (b[0] - a[0]) * (y - a[1]) - (b[1] - a[1]) * (x - a[0]);
+    };
+
+    auto area = Edge(p[0], p[1], p[2][0], p[2][1]);
+    return {Edge(p[1], p[2], x, y) / area, Edge(p[2], p[0], x, y) / area, Edge(p[0], p[1], x, y) / area};
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Check a triangle covers pixels whose centers are inside of it, and colors are perspective correct.
+void CheckTriangle(const RasterTarget &target, const std::vector<ColorVertex> &vertices, uint64_t pixel_count) {
+    const auto kWidth = target.GetWidth();
+    const auto kHeight = target.GetHeight();
+    const auto kEpsilon = 1e-3;
+
+    std::array<std::array<double, 2>, 3> p;
+    for (auto i = 0; i != 3; ++i) {
+        p[i] = ToViewport(vertices[i].position, kWidth, kHeight);
+    }
+
+    auto inside_count = uint64_t(0);
+    auto edge_count = uint64_t(0);
+    auto pixels = target.GetPixels();
+    for (auto y = 0u; y != kHeight; ++y) {
+        for (auto x = 0u; x != kWidth; ++x) {
+            auto pixel = pixels[y * kWidth + x];
+            auto b = GetBarycentrics(p, x + 0.5, y + 0.5);
+            auto min_b = std::min({b[0], b[1], b[2]});
+
+            // A pixel center on an edge belongs to one side by the top left rule, it isn't checked here.
+            if (std::abs(min_b) * std::max(kWidth, kHeight) < kEpsilon) {
+                ++edge_count;
+                continue;
+            }
+
+            if (min_b < 0.0) {
+                CHECK(pixel == 0);
+                continue;
+            }
+            ++inside_count;
+
+            // Interpolate in clip space, varyings are divided by w and the sum is divided by interpolated 1 / w.
+            auto inv_w = 0.0;
+            for (auto i = 0; i != 3; ++i) {
+                inv_w += b[i] / vertices[i].position[3];
+            }
+            for (auto channel = 0u; channel != 4; ++channel) {
+                auto value = 0.0;
+                for (auto i = 0; i != 3; ++i) {
+                    value += b[i] * vertices[i].color[channel] / vertices[i].position[3];
+                }
+                auto expected = static_cast<int32_t>(std::clamp(value / inv_w, 0.0, 1.0) * 255.0 + 0.5);
+                CHECK(std::abs(GetChannel(pixel, channel) - expected) <= 1);
+            }
+        }
+    }
+
+    CHECK(inside_count > 0);
+    CHECK(pixel_count >= inside_count && pixel_count <= inside_count + edge_count);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestTriangle() {
+    JobSystem job_system(2);
+    Rasterizer rasterizer(&job_system);
+
+    // A triangle spans tiles and ends inside of a group of four pixels.
+    RasterTarget target;
+    target.Resize(203, 150);
+    target.Clear({0.0f, 0.0f, 0.0f, 0.0f});
+
+    std::vector<ColorVertex> vertices = {
+        {{-0.9f, -0.8f, 0.5f, 1.0f}, {1.0f, 0.0f, 0.0f, 1.0f}},
+        {{0.7f, -0.6f, 0.5f, 1.0f}, {0.0f, 1.0f, 0.0f, 1.0f}},
+        {{-0.2f, 0.85f, 0.5f, 1.0f}, {0.0f, 0.0f, 1.0f, 1.0f}}
+    };
+    auto pipeline = MakeColorPipeline(vertices);
+    std::vector<uint16_t> indices = {0, 1, 2};
+    rasterizer.DrawIndexed(target, pipeline, std::span<const uint16_t>(indices));
+
+    auto &statistics = rasterizer.GetStatistics();
+    CHECK(statistics.draw_count == 1);
+    CHECK(statistics.triangle_count == 1);
+    CheckTriangle(target, vertices, statistics.pixel_count);
+
+    // The other winding covers the same pixels.
+    RasterTarget reversed_target;
+    reversed_target.Resize(target.GetWidth(), target.GetHeight());
+    reversed_target.Clear({0.0f, 0.0f, 0.0f, 0.0f});
+    std::vector<uint16_t> reversed_indices = {0, 2, 1};
+    rasterizer.DrawIndexed(reversed_target, pipeline, std::span<const uint16_t>(reversed_indices));
+    for (auto i = size_t(0); i != target.GetPixels().size(); ++i) {
+        CHECK((target.GetPixels()[i] != 0) == (reversed_target.GetPixels()[i] != 0));
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestPerspectiveCorrection() {
+    JobSystem job_system(2);
+    Rasterizer rasterizer(&job_system);
+
+    RasterTarget target;
+    target.Resize(128, 128);
+    target.Clear({0.0f, 0.0f, 0.0f, 0.0f});
+
+    // Vertices at different depths, colors are interpolated linearly in 3D rather than on screen.
+    std::vector<ColorVertex> vertices = {
+        {{-0.8f, -0.8f, 0.5f, 1.0f}, {1.0f, 0.0f, 0.0f, 1.0f}},
+        {{3.2f, -3.2f, 2.0f, 4.0f}, {0.0f, 1.0f, 0.0f, 1.0f}},
+        {{0.0f, 1.6f, 1.0f, 2.0f}, {0.0f, 0.0f, 1.0f, 1.0f}}
+    };
+    auto pipeline = MakeColorPipeline(vertices);
+    std::vector<uint32_t> indices = {0, 1, 2};
+    rasterizer.DrawIndexed(target, pipeline, std::span<const uint32_t>(indices));
+    CheckTriangle(target, vertices, rasterizer.GetStatistics().pixel_count);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestSharedEdges() {
+    JobSystem job_system(2);
+    Rasterizer rasterizer(&job_system);
+
+    // Two triangles of a quad cover every pixel exactly once, their diagonal passes through pixel centers.
+    RasterTarget target;
+    target.Resize(96, 96);
+    target.Clear({0.0f, 0.0f, 0.0f, 0.0f});
+
+    std::vector<ColorVertex> vertices = {
+        {{-1.0f, -1.0f, 0.5f, 1.0f}, {1.0f, 1.0f, 1.0f, 1.0f}},
+        {{1.0f, -1.0f, 0.5f, 1.0f}, {1.0f, 1.0f, 1.0f, 1.0f}},
+        {{1.0f, 1.0f, 0.5f, 1.0f}, {1.0f, 1.0f, 1.0f, 1.0f}},
+        {{-1.0f, 1.0f, 0.5f, 1.0f}, {1.0f, 1.0f, 1.0f, 1.0f}}
+    };
+    auto pipeline = MakeColorPipeline(vertices);
+    std::vector<uint16_t> indices = {0, 1, 2, 0, 2, 3};
+    rasterizer.DrawIndexed(target, pipeline, std::span<const uint16_t>(indices));
+
+    CHECK(rasterizer.GetStatistics().pixel_count == target.GetWidth() * target.GetHeight());
+    for (auto pixel : target.GetPixels()) {
+        CHECK(pixel == 0xffffffff);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestThreadCountIndependence() {
+    // Overlapping triangles, some crossing the near plane and some outside of the view volume.
+    std::mt19937 generator(11);
+    std::uniform_real_distribution<float> position_distribution(-1.5f, 1.5f);
+    std::uniform_real_distribution<float> depth_distribution(-0.2f, 1.0f);
+    std::uniform_real_distribution<float> color_distribution(0.0f, 1.0f);
+
+    std::vector<ColorVertex> vertices(3000);
+    for (auto &vertex : vertices) {
+        vertex.position = {position_distribution(generator), position_distribution(generator),
+                           depth_distribution(generator), 1.0f};
+        vertex.color = {color_distribution(generator), color_distribution(generator),
+                        color_distribution(generator), 1.0f};
+    }
+    std::vector<uint32_t> indices(vertices.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    auto pipeline = MakeColorPipeline(vertices);
+
+    // A later triangle overwrites an earlier one, so pixels only match if every tile keeps submission order.
+    std::vector<uint32_t> thread_counts = {1, 2, std::max(std::thread::hardware_concurrency(), 4u)};
+    std::vector<uint32_t> first_pixels;
+    auto first_pixel_count = uint64_t(0);
+    for (auto thread_count : thread_counts) {
+        JobSystem job_system(thread_count);
+        Rasterizer rasterizer(&job_system);
+
+        RasterTarget target;
+        target.Resize(301, 197);
+        target.Clear({0.0f, 0.0f, 0.0f, 1.0f});
+        rasterizer.DrawIndexed(target, pipeline, std::span<const uint32_t>(indices));
+
+        std::vector<uint32_t> pixels(target.GetPixels().begin(), target.GetPixels().end());
+        if (first_pixels.empty()) {
+            first_pixels = pixels;
+            first_pixel_count = rasterizer.GetStatistics().pixel_count;
+        }
+        CHECK(pixels == first_pixels);
+        CHECK(rasterizer.GetStatistics().pixel_count == first_pixel_count);
+    }
+    CHECK(first_pixel_count > 0);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    RUN(TestTriangle);
+    RUN(TestPerspectiveCorrection);
+    RUN(TestSharedEdges);
+    RUN(TestThreadCountIndependence);
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,169 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/example.h>
+#include <atomic>
+#include <random>
+#include <thread>
+
+#include "test.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! An example checks every frame is rendered at the resolution it is updated with.
+class ResizeExample : public Example {
+public:
+    explicit ResizeExample(const Arguments &arguments) :
+        Example("Resize", arguments) {
+    }
+
+    //! Resolutions OnResize is called with, the render thread writes them.
+    std::vector<Resolution> resizes;
+
+protected:
+    void OnInit() override {
+    }
+
+    void OnTerm() override {
+    }
+
+    void OnResize(const Resolution &resolution) override {
+        // A resize is applied once, a request of the same resolution isn't applied again.
+        CHECK(resizes.empty() || resizes.back() != resolution);
+        resizes.push_back(resolution);
+    }
+
+    void OnUpdate(uint32_t index) override {
+        _frame_resolutions[index] = _resolution;
+    }
+
+    void OnRender(uint32_t index) override {
+        // Targets are resized at a frame boundary, before the first frame of a resolution is rendered.
+        CHECK(GetRenderDevice()->GetSwapchain()->GetResolution() == _frame_resolutions[index]);
+        CHECK(resizes.back() == _frame_resolutions[index]);
+    }
+
+private:
+    std::array<Resolution, kMaxFrameCount> _frame_resolutions;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+Arguments MakeArguments() {
+    Arguments arguments;
+    arguments.backend = Backend::kNull;
+    return arguments;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestLastRequestApplied() {
+    ResizeExample example(MakeArguments());
+    example.Init();
+
+    // Requests between frames are applied once, only the last one.
+    for (auto i = 1u; i <= 100; ++i) {
+        example.Resize({100 + i, 100 + i});
+    }
+    example.Update();
+    example.Render();
+    CHECK(example.resizes == std::vector<Resolution>({{200, 200}}));
+
+    // Neither later frames nor a request of the same resolution resize again.
+    example.Resize({200, 200});
+    for (auto i = 0u; i != 10; ++i) {
+        example.Update();
+        example.Render();
+    }
+    CHECK(example.resizes.size() == 1);
+
+    example.Term();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestLiveResize() {
+    ResizeExample example(MakeArguments());
+    example.Init();
+    example.Resize({640, 360});
+    example.Update();
+    example.Render();
+
+    // A live resize changing every frame isn't applied.
+    for (auto i = 1u; i <= 10; ++i) {
+        example.Resize({640 + i, 360 + i}, true);
+        example.Update();
+        example.Render();
+    }
+    CHECK(example.resizes == std::vector<Resolution>({{640, 360}}));
+
+    // A live resize is applied once a resolution stays the same for a frame.
+    example.Resize({800, 600}, true);
+    example.Update();
+    example.Render();
+    CHECK(example.resizes.size() == 1);
+
+    example.Update();
+    example.Render();
+    CHECK(example.resizes == std::vector<Resolution>({{640, 360}, {800, 600}}));
+
+    // The end of a live resize is applied right away.
+    example.Resize({1024, 768});
+    example.Update();
+    example.Render();
+    CHECK(example.resizes.back() == Resolution(1024, 768));
+
+    example.Term();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestConcurrentRequests() {
+    ResizeExample example(MakeArguments());
+    example.Init();
+    example.Resize({640, 360});
+    example.StartSimulation();
+
+    // A thread of a window requests resizes while frames are updated and rendered on other threads.
+    const auto kFinalResolution = Resolution(1280, 720);
+    std::atomic<bool> requested = false;
+    std::thread window([&example, &requested, kFinalResolution]() {
+        std::mt19937 generator(7);
+        std::uniform_int_distribution<uint32_t> size_distribution(1, 2048);
+        for (auto i = 0u; i != 100000; ++i) {
+            example.Resize({size_distribution(generator), size_distribution(generator)}, i % 2);
+            if (i % 64 == 0) {
+                std::this_thread::yield();
+            }
+        }
+        example.Resize(kFinalResolution);
+        requested = true;
+    });
+
+    while (!requested || example.resizes.empty() || example.resizes.back() != kFinalResolution) {
+        example.Render();
+    }
+    window.join();
+
+    // Every frame resizes once at most, and the last request stays.
+    for (auto i = 0u; i != 10; ++i) {
+        example.Render();
+    }
+    CHECK(example.resizes.back() == kFinalResolution);
+    CHECK(example.resizes.size() <= example.GetFrameStatistics().rendered_count);
+
+    example.Term();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    RUN(TestLastRequestApplied);
+    RUN(TestLiveResize);
+    RUN(TestConcurrentRequests);
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,184 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/shader_cache.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <thread>
+
+#include "test.h"
+
+using namespace std::chrono_literals;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+class FakeLibrary : public ShaderLibrary {
+public:
+    explicit FakeLibrary(std::string_view source) :
+    source(source) {
+    }
+
+    std::string source;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A compiler takes a while, so callers overlap, and fails sources named "error".
+class FakeCompiler : public ShaderCompiler {
+public:
+    [[nodiscard]]
+    std::string GetIdentifier() const override {
+        return "fake";
+    }
+
+    ShaderCompileResult Compile(std::string_view source, const ShaderMacros &macros) override {
+        ++compile_count;
+        if (on_compile) {
+            on_compile(source);
+        }
+        std::this_thread::sleep_for(20ms);
+
+        if (source == "error") {
+            throw std::runtime_error("Fail to compile.");
+        }
+        return {std::make_shared<FakeLibrary>(source), {}};
+    }
+
+    std::shared_ptr<ShaderLibrary> Load(std::span<const std::byte> binary) override {
+        return nullptr;
+    }
+
+    std::atomic<uint32_t> compile_count = 0;
+    std::function<void(std::string_view)> on_compile;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestKeySeparatesStrings() {
+    ShaderCache cache(std::make_unique<FakeCompiler>());
+
+    // Characters moved between a name and a value, or between macros and a source, make different keys.
+    CHECK(cache.ComputeKey("", {{"AB", "C"}}) != cache.ComputeKey("", {{"A", "BC"}}));
+    CHECK(cache.ComputeKey("", {{"A", "B"}, {"C", ""}}) != cache.ComputeKey("", {{"A", "BC"}}));
+    CHECK(cache.ComputeKey("C", {{"A", "B"}}) != cache.ComputeKey("", {{"A", "BC"}}));
+    CHECK(cache.ComputeKey("x", {{"A", "B"}}) == cache.ComputeKey("x", {{"A", "B"}}));
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestSameKeyCompilesOnce() {
+    auto compiler = std::make_unique<FakeCompiler>();
+    auto fake_compiler = compiler.get();
+    ShaderCache cache(std::move(compiler));
+
+    std::vector<std::shared_ptr<ShaderLibrary>> libraries(8);
+    std::vector<std::thread> threads;
+    for (auto &library : libraries) {
+        threads.emplace_back([&cache, &library]() {
+            library = cache.GetLibraryFromSource("source");
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    CHECK(fake_compiler->compile_count == 1);
+    for (auto &library : libraries) {
+        CHECK(library && library == libraries[0]);
+    }
+
+    auto statistics = cache.GetStatistics();
+    CHECK(statistics.compile_count == 1);
+    CHECK(statistics.memory_hit_count == libraries.size() - 1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestKeysCompileConcurrently() {
+    auto compiler = std::make_unique<FakeCompiler>();
+    auto fake_compiler = compiler.get();
+    ShaderCache cache(std::move(compiler));
+
+    // A compile of "a" waits until "b" is being compiled, it can't happen if a lock is held while compiling.
+    std::mutex mutex;
+    std::condition_variable condition;
+    auto b_started = false;
+    auto overlapped = false;
+    fake_compiler->on_compile = [&](std::string_view source) {
+        std::unique_lock lock(mutex);
+        if (source == "a") {
+            overlapped = condition.wait_for(lock, 2s, [&]() { return b_started; });
+        } else {
+            b_started = true;
+            condition.notify_all();
+        }
+    };
+
+    std::thread thread([&cache]() {
+        cache.GetLibraryFromSource("a");
+    });
+    std::this_thread::sleep_for(5ms);
+    cache.GetLibraryFromSource("b");
+    thread.join();
+
+    CHECK(overlapped);
+    CHECK(fake_compiler->compile_count == 2);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestFailureIsRetried() {
+    auto compiler = std::make_unique<FakeCompiler>();
+    auto fake_compiler = compiler.get();
+    ShaderCache cache(std::move(compiler));
+
+    // Callers waiting for a failed compile fail too, a compile is slow enough for all of them to wait.
+    fake_compiler->on_compile = [](std::string_view source) {
+        std::this_thread::sleep_for(200ms);
+    };
+
+    std::atomic<uint32_t> failure_count = 0;
+    std::vector<std::thread> threads;
+    for (auto i = 0; i != 4; ++i) {
+        threads.emplace_back([&cache, &failure_count]() {
+            try {
+                cache.GetLibraryFromSource("error");
+            }
+            catch (const std::exception &) {
+                ++failure_count;
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    CHECK(failure_count == 4);
+    CHECK(fake_compiler->compile_count == 1);
+
+    // A failed key isn't cached.
+    try {
+        cache.GetLibraryFromSource("error");
+    }
+    catch (const std::exception &) {
+        ++failure_count;
+    }
+    CHECK(failure_count == 5);
+    CHECK(fake_compiler->compile_count == 2);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    RUN(TestKeySeparatesStrings);
+    RUN(TestSameKeyCompilesOnce);
+    RUN(TestKeysCompileConcurrently);
+    RUN(TestFailureIsRetried);
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
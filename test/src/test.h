@@ -0,0 +1,34 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#ifndef TEST_H_
+#define TEST_H_
+
+#include <fmt/format.h>
+#include <cstdlib>
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Exit with a failure if a condition doesn't hold.
+#define CHECK(condition)                                                                                               \
+    do {                                                                                                               \
+        if (!(condition)) {                                                                                            \
+            fmt::print(stderr, "{}:{}: Check failed: {}.\n", __FILE__, __LINE__, #condition);                          \
+            std::exit(EXIT_FAILURE);                                                                                   \
+        }                                                                                                              \
+    } while (false)
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Run a test and report it.
+#define RUN(test)                                                                                                      \
+    do {                                                                                                               \
+        test();                                                                                                        \
+        fmt::print("{} passed.\n", #test);                                                                             \
+    } while (false)
+
+//----------------------------------------------------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,165 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/triple_buffer.h>
+#include <array>
+#include <atomic>
+#include <thread>
+
+#include "test.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr auto kSnapshotCount = 100000u;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! A snapshot is large enough that a torn copy shows up as values of different sequences.
+struct Snapshot {
+    uint64_t sequence = 0;
+    std::array<uint64_t, 32> values = {};
+    //! The number of threads use a snapshot, it is never more than one.
+    std::atomic<uint32_t> user_count = 0;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Write a snapshot, a writer owns the buffer it writes.
+void WriteSnapshot(Snapshot &snapshot, uint64_t sequence) {
+    CHECK(snapshot.user_count.fetch_add(1, std::memory_order_acq_rel) == 0);
+    snapshot.sequence = sequence;
+    snapshot.values.fill(sequence);
+    CHECK(snapshot.user_count.fetch_sub(1, std::memory_order_acq_rel) == 1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Read a snapshot, a reader owns the buffer it reads and sees every value of a single sequence.
+uint64_t ReadSnapshot(Snapshot &snapshot) {
+    CHECK(snapshot.user_count.fetch_add(1, std::memory_order_acq_rel) == 0);
+    auto sequence = snapshot.sequence;
+    for (auto value : snapshot.values) {
+        CHECK(value == sequence);
+    }
+    CHECK(snapshot.user_count.fetch_sub(1, std::memory_order_acq_rel) == 1);
+    return sequence;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestLatestPublished() {
+    TripleBuffer<uint32_t> buffer;
+    CHECK(!buffer.IsPublished());
+    CHECK(!buffer.Acquire());
+
+    // A reader skips values published before the latest one.
+    for (auto i = 1u; i != 4; ++i) {
+        buffer.GetWriteBuffer() = i;
+        buffer.Publish();
+    }
+    CHECK(buffer.IsPublished());
+    CHECK(buffer.Acquire());
+    CHECK(buffer.GetReadBuffer() == 3);
+
+    // A reader keeps its buffer until something new is published.
+    CHECK(!buffer.Acquire());
+    CHECK(buffer.GetReadBuffer() == 3);
+
+    buffer.GetWriteBuffer() = 4;
+    buffer.Publish();
+    CHECK(buffer.Acquire());
+    CHECK(buffer.GetReadBuffer() == 4);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestFreeRunning() {
+    TripleBuffer<Snapshot> buffer;
+
+    // A writer never waits, a reader sees newer snapshots only and the last one at the end.
+    std::thread writer([&buffer]() {
+        for (auto i = 1u; i <= kSnapshotCount; ++i) {
+            WriteSnapshot(buffer.GetWriteBuffer(), i);
+            buffer.Publish();
+        }
+        buffer.Close();
+    });
+
+    uint64_t last_sequence = 0;
+    auto read_count = 0u;
+    auto read = [&]() {
+        auto sequence = ReadSnapshot(buffer.GetReadBuffer());
+        CHECK(sequence > last_sequence);
+        last_sequence = sequence;
+        ++read_count;
+    };
+
+    while (buffer.WaitForPublish()) {
+        if (buffer.Acquire()) {
+            read();
+        }
+    }
+    writer.join();
+
+    // A snapshot published right before closing is still acquired.
+    if (buffer.Acquire()) {
+        read();
+    }
+    CHECK(last_sequence == kSnapshotCount);
+    CHECK(read_count);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestLockstep() {
+    TripleBuffer<Snapshot> buffer;
+
+    // A writer waits for a reader to acquire, like the simulation thread, so a reader sees every snapshot in order.
+    std::thread writer([&buffer]() {
+        for (auto i = 1u; i <= kSnapshotCount; ++i) {
+            WriteSnapshot(buffer.GetWriteBuffer(), i);
+            buffer.Publish();
+            if (!buffer.WaitForAcquire()) {
+                break;
+            }
+        }
+    });
+
+    for (auto i = 1u; i <= kSnapshotCount; ++i) {
+        CHECK(buffer.WaitForPublish());
+        CHECK(buffer.Acquire());
+        CHECK(ReadSnapshot(buffer.GetReadBuffer()) == i);
+    }
+    buffer.Close();
+    writer.join();
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestClose() {
+    TripleBuffer<uint32_t> buffer;
+
+    // Threads waiting for a buffer return once it is closed.
+    std::thread reader([&buffer]() {
+        CHECK(!buffer.WaitForPublish());
+    });
+    buffer.Close();
+    reader.join();
+
+    CHECK(buffer.IsClosed());
+    CHECK(!buffer.WaitForAcquire());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    RUN(TestLatestPublished);
+    RUN(TestFreeRunning);
+    RUN(TestLockstep);
+    RUN(TestClose);
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,158 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/upload_ring.h>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "test.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct ModelAllocation {
+    uint64_t offset = 0;
+    uint64_t size = 0;
+    std::byte pattern = {};
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+struct ModelBatch {
+    uint64_t fence = 0;
+    std::vector<ModelAllocation> allocations;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Check an allocation still holds its pattern, an overlapping allocation overwrites it.
+void CheckPattern(const std::vector<std::byte> &memory, const ModelAllocation &allocation) {
+    for (auto i = allocation.offset; i != allocation.offset + allocation.size; ++i) {
+        CHECK(memory[i] == allocation.pattern);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Run random allocations, submissions and retirements against a model of live batches. The GPU completes batches
+//! in order, a random number of fences behind.
+void TestRandomAllocations(uint64_t ring_size, uint64_t max_allocation_size, uint32_t seed) {
+    std::vector<std::byte> memory(ring_size);
+    UploadRing ring(memory.data(), ring_size);
+
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<uint64_t> size_distribution(1, max_allocation_size);
+    std::uniform_int_distribution<uint32_t> action_distribution(0, 9);
+
+    std::deque<ModelBatch> batches;
+    ModelBatch pending;
+    uint64_t fence = 0;
+    uint64_t completed_fence = 0;
+    uint64_t allocation_count = 0;
+    uint64_t failure_count = 0;
+    uint64_t wrap_count = 0;
+    uint64_t last_offset = 0;
+
+    for (auto i = 0; i != 100000; ++i) {
+        auto action = action_distribution(generator);
+        if (action < 7) {
+            auto size = size_distribution(generator);
+            auto allocation = ring.Allocate(size);
+            if (!allocation) {
+                // A ring is full only while batches hold memory.
+                CHECK(!batches.empty() || !pending.allocations.empty());
+                ++failure_count;
+                continue;
+            }
+
+            // An allocation is aligned, within memory and never wraps around the end.
+            CHECK(allocation->offset % kUploadAlignment == 0);
+            CHECK(allocation->offset + size <= ring.GetSize());
+            CHECK(allocation->data == memory.data() + allocation->offset);
+            CHECK(ring.GetUsedSize() <= ring.GetSize());
+            wrap_count += allocation->offset < last_offset;
+            last_offset = allocation->offset;
+
+            auto pattern = static_cast<std::byte>(++allocation_count);
+            std::fill_n(allocation->data, size, pattern);
+            pending.allocations.push_back({allocation->offset, size, pattern});
+        } else if (action < 9) {
+            ring.Submit(++fence);
+            if (!pending.allocations.empty()) {
+                pending.fence = fence;
+                batches.push_back(std::move(pending));
+                pending = {};
+            }
+        } else {
+            // Complete some submitted fences, live allocations must be intact before they are released.
+            completed_fence = std::uniform_int_distribution<uint64_t>(completed_fence, fence)(generator);
+            while (!batches.empty() && batches.front().fence <= completed_fence) {
+                for (auto &allocation : batches.front().allocations) {
+                    CheckPattern(memory, allocation);
+                }
+                batches.pop_front();
+            }
+            ring.Retire(completed_fence);
+        }
+
+        CHECK(ring.GetBatchCount() == batches.size());
+    }
+
+    // Every batch is released once the GPU has caught up, then a whole ring can be allocated.
+    ring.Submit(++fence);
+    ring.Retire(fence);
+    CHECK(ring.GetBatchCount() == 0);
+    CHECK(ring.GetUsedSize() == 0);
+    CHECK(ring.Allocate(ring.GetSize()));
+
+    // Allocations fail sometimes and wrap around, so both paths are exercised.
+    CHECK(failure_count > 0);
+    CHECK(wrap_count > 0);
+    fmt::print("{} allocations, {} failures, {} wraps, peak {} of {} bytes.\n", allocation_count, failure_count,
+               wrap_count, ring.GetPeakSize(), ring.GetSize());
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestLargeRing() {
+    TestRandomAllocations(64 * 1024, 4 * 1024, 1);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestSmallRing() {
+    // A size isn't a multiple of the alignment and allocations are a third of it.
+    TestRandomAllocations(1000, 300, 2);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestFenceMustIncrease() {
+    std::vector<std::byte> memory(1024);
+    UploadRing ring(memory.data(), memory.size());
+
+    CHECK(ring.Allocate(16));
+    ring.Submit(2);
+
+    auto thrown = false;
+    try {
+        ring.Submit(2);
+    }
+    catch (const std::exception &) {
+        thrown = true;
+    }
+    CHECK(thrown);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    RUN(TestLargeRing);
+    RUN(TestSmallRing);
+    RUN(TestFenceMustIncrease);
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,165 @@
+//
+// This file is part of the "Metal" project
+// See "LICENSE" for license information.
+//
+
+#include <common/vertex_layout.h>
+#include <cmath>
+#include <limits>
+
+#include "test.h"
+
+//----------------------------------------------------------------------------------------------------------------------
+
+using TestLayout = VertexLayout<Position<Float3>, Normal<Snorm8x4>, Color<Unorm8x4>, TexCoord<Half2>>;
+using PaddedLayout = VertexLayout<Position<Half3>, Color<Unorm8x4>>;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestHalf() {
+    constexpr auto kInfinity = std::numeric_limits<float>::infinity();
+
+    // Every half other than NaN survives a round trip through a float.
+    for (auto bits = 0u; bits != 0x10000u; ++bits) {
+        auto half = static_cast<uint16_t>(bits);
+        auto value = DecodeHalf(half);
+        if ((half & 0x7c00u) == 0x7c00u && (half & 0x3ffu)) {
+            CHECK(std::isnan(value));
+            CHECK(std::isnan(DecodeHalf(EncodeHalf(value))));
+        } else {
+            CHECK(EncodeHalf(value) == half);
+        }
+    }
+
+    // Signed zeros and infinities keep their signs.
+    CHECK(EncodeHalf(0.0f) == 0x0000u);
+    CHECK(EncodeHalf(-0.0f) == 0x8000u);
+    CHECK(std::signbit(DecodeHalf(0x8000u)));
+    CHECK(EncodeHalf(kInfinity) == 0x7c00u);
+    CHECK(EncodeHalf(-kInfinity) == 0xfc00u);
+
+    // The largest half, and values past it round to infinity.
+    CHECK(EncodeHalf(65504.0f) == 0x7bffu);
+    CHECK(EncodeHalf(65519.0f) == 0x7bffu);
+    CHECK(EncodeHalf(65520.0f) == 0x7c00u);
+    CHECK(EncodeHalf(-1e10f) == 0xfc00u);
+
+    // Denormals, values under half the smallest one flush to zero, and ties round to even.
+    constexpr auto kSmallestDenormal = 1.0f / 16777216.0f;
+    CHECK(EncodeHalf(kSmallestDenormal) == 0x0001u);
+    CHECK(EncodeHalf(-kSmallestDenormal) == 0x8001u);
+    CHECK(EncodeHalf(kSmallestDenormal * 0.5f) == 0x0000u);
+    CHECK(EncodeHalf(kSmallestDenormal * 0.51f) == 0x0001u);
+    CHECK(EncodeHalf(kSmallestDenormal * 1.5f) == 0x0002u);
+    CHECK(EncodeHalf(kSmallestDenormal * 2.5f) == 0x0002u);
+    CHECK(EncodeHalf(1e-10f) == 0x0000u);
+    CHECK(EncodeHalf(kSmallestDenormal * 1023.0f) == 0x03ffu);
+    CHECK(EncodeHalf(kSmallestDenormal * 1024.0f) == 0x0400u);
+
+    // Ties between normals round to even, and a carry moves into the exponent.
+    CHECK(EncodeHalf(1.0f + 1.0f / 2048.0f) == 0x3c00u);
+    CHECK(EncodeHalf(1.0f + 3.0f / 2048.0f) == 0x3c02u);
+    CHECK(EncodeHalf(2.0f - 1.0f / 4096.0f) == 0x4000u);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! Check every stored value of a normalized format decodes to a value that encodes back to it.
+template<typename F, typename T>
+void CheckNormalizedRoundTrip() {
+    for (auto i = int32_t(std::numeric_limits<T>::min()); i <= int32_t(std::numeric_limits<T>::max()); ++i) {
+        typename F::Storage storage;
+        storage.components.fill(static_cast<T>(i));
+        auto values = F::Decode(storage);
+        CHECK(values[0] >= (F::kEncoding == VertexEncoding::kUnorm ? 0.0f : -1.0f) && values[0] <= 1.0f);
+
+        // The most negative snorm value is an alias of the one after it.
+        auto expected = F::kEncoding == VertexEncoding::kSnorm && i == std::numeric_limits<T>::min() ? i + 1 : i;
+        CHECK(F::Encode(values).components[0] == expected);
+    }
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestNormalized() {
+    CheckNormalizedRoundTrip<Unorm8x4, uint8_t>();
+    CheckNormalizedRoundTrip<Snorm8x4, int8_t>();
+    CheckNormalizedRoundTrip<Unorm16x2, uint16_t>();
+    CheckNormalizedRoundTrip<Snorm16x2, int16_t>();
+
+    // Values round to nearest, and values out of range are clamped.
+    Unorm8x4::Storage unorm = {{0, 255, 128, 0}};
+    CHECK(Unorm8x4::Encode({-0.5f, 2.0f, 0.5f, 1.0f / 255.0f * 0.49f}).components == unorm.components);
+    Snorm8x4::Storage snorm = {{-127, 127, 0, -1}};
+    CHECK(Snorm8x4::Encode({-2.0f, 2.0f, -0.0f, -1.0f / 127.0f * 0.51f}).components == snorm.components);
+    CHECK(Snorm8x4::Decode({{-128, -127, 127, 0}}) == Snorm8x4::Values({-1.0f, -1.0f, 1.0f, 0.0f}));
+
+    Unorm16x4::Storage unorm16 = {{0, 0, 65535, 65535}};
+    CHECK(Unorm16x4::Encode({-1.0f, 0.0f, 1.0f, 10.0f}).components == unorm16.components);
+    Snorm16x4::Storage snorm16 = {{-32767, -32767, 32767, 32767}};
+    CHECK(Snorm16x4::Encode({-10.0f, -1.0f, 1.0f, 10.0f}).components == snorm16.components);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestVertex() {
+    // Attributes are packed in order.
+    static_assert(TestLayout::kStride == 24);
+    static_assert(TestLayout::GetOffset(1) == 12);
+    static_assert(TestLayout::GetOffset(3) == 20);
+    static_assert(TestLayout::GetIndex<TexCoord>() == 3);
+    static_assert(TestLayout::GetIndex<Tangent>() == TestLayout::kAttributeCount);
+
+    // A vertex made of values exact in its formats gives the same values back.
+    auto vertex = TestLayout::MakeVertex({1.5f, -2.0f, 1e6f}, {0.0f, 1.0f, -1.0f, 0.0f}, {1.0f, 0.0f, 0.2f, 1.0f},
+                                         {0.25f, -0.75f});
+    CHECK(TestLayout::Get<Position>(vertex) == Float3::Values({1.5f, -2.0f, 1e6f}));
+    CHECK(TestLayout::Get<Normal>(vertex) == Snorm8x4::Values({0.0f, 1.0f, -1.0f, 0.0f}));
+    CHECK(TestLayout::Get<Color>(vertex) == Unorm8x4::Values({1.0f, 0.0f, 51.0f / 255.0f, 1.0f}));
+    CHECK(TestLayout::Get<TexCoord>(vertex) == Half2::Values({0.25f, -0.75f}));
+
+    // Set changes only its own attribute.
+    TestLayout::Set<Color>(vertex, Unorm8x4::Values({0.0f, 1.0f, 0.0f, 1.0f}));
+    CHECK(TestLayout::Get<Color>(vertex) == Unorm8x4::Values({0.0f, 1.0f, 0.0f, 1.0f}));
+    CHECK(TestLayout::Get<Position>(vertex) == Float3::Values({1.5f, -2.0f, 1e6f}));
+    CHECK(TestLayout::Get<TexCoord>(vertex) == Half2::Values({0.25f, -0.75f}));
+
+    // A vertex is encoded at compile time too.
+    constexpr auto kVertex = PaddedLayout::MakeVertex({1.0f, 0.5f, -2.0f}, {1.0f, 1.0f, 1.0f, 1.0f});
+    static_assert(PaddedLayout::Get<Position>(kVertex) == Half3::Values({1.0f, 0.5f, -2.0f}));
+
+    // Attributes of a pipeline descriptor match the layout.
+    auto attributes = TestLayout::GetAttributes(2);
+    CHECK(attributes.size() == 4);
+    for (auto i = 0u; i != attributes.size(); ++i) {
+        CHECK(attributes[i].offset == TestLayout::GetOffset(i));
+        CHECK(attributes[i].buffer_index == 2);
+    }
+    CHECK(attributes[3].format == Half2::kMetalFormat);
+    CHECK(TestLayout::GetLayout().stride == TestLayout::kStride);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+void TestHalf3Padding() {
+    // Half3 takes 8 bytes so an attribute after it starts at a multiple of 4 bytes.
+    static_assert(sizeof(Half3::Storage) == 8);
+    static_assert(PaddedLayout::kStride == 12);
+    static_assert(PaddedLayout::GetOffset(1) == 8);
+
+    auto vertex = PaddedLayout::MakeVertex({1.0f, 2.0f, 3.0f}, {0.0f, 0.0f, 0.0f, 1.0f});
+    CHECK(PaddedLayout::Get<Color>(vertex) == Unorm8x4::Values({0.0f, 0.0f, 0.0f, 1.0f}));
+    CHECK(PaddedLayout::GetAttributes()[1].offset == 8);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    RUN(TestHalf);
+    RUN(TestNormalized);
+    RUN(TestVertex);
+    RUN(TestHalf3Padding);
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
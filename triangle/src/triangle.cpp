@@ -4,17 +4,17 @@
 //
 
 #include <fmt/format.h>
-#include <common/window.h>
 #include <common/example.h>
-#include <simd/simd.h>
-#include <iostream>
+#include <common/vertex_layout.h>
+#include <common/vector_math.h>
+#include <array>
+#include <span>
 
 //----------------------------------------------------------------------------------------------------------------------
 
-struct Vertex {
-    vector_float3 position;
-    vector_float3 color;
-};
+// Positions are stored as halves and colors as normalized bytes, a vertex is 12 bytes instead of 32 bytes.
+using TriangleLayout = VertexLayout<Position<Half3>, Color<Unorm8x4>>;
+using Vertex = TriangleLayout::Vertex;
 
 //----------------------------------------------------------------------------------------------------------------------
 
@@ -26,6 +26,55 @@ struct Transforms {
 
 //----------------------------------------------------------------------------------------------------------------------
 
+struct Output {
+    simd::float4 clip_space_position;
+    simd::float3 color;
+};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+constexpr Vertex kVertices[3] = {TriangleLayout::MakeVertex({ 1.0f, -1.0f, 0.0f}, {1.0f, 0.0f, 0.0f, 1.0f}),
+                                 TriangleLayout::MakeVertex({-1.0f, -1.0f, 0.0f}, {0.0f, 1.0f, 0.0f, 1.0f}),
+                                 TriangleLayout::MakeVertex({ 0.0f,  1.0f, 0.0f}, {0.0f, 0.0f, 1.0f, 1.0f})};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+const uint16_t kIndices[3] = {0, 1, 2};
+
+//----------------------------------------------------------------------------------------------------------------------
+
+// Handles commands refer to, backends resolve them to their own pipelines and buffers.
+constexpr auto kPipelineHandle = 0u;
+constexpr auto kVertexBufferHandle = 0u;
+constexpr auto kUniformBufferHandle = 1u;
+constexpr auto kIndexBufferHandle = 2u;
+
+// Draws are recorded by jobs in batches of this many draws.
+constexpr auto kDrawBatchSize = 256u;
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! The CPU equivalent of VSMain in pass_through.metal.
+inline auto VSMain(const Vertex &input, const Transforms &transforms) {
+    auto PVM = simd_mul(simd_mul(transforms.projection, transforms.view), transforms.model);
+    auto position = TriangleLayout::Get<Position>(input);
+    auto color = TriangleLayout::Get<Color>(input);
+
+    Output output;
+    output.clip_space_position = simd_mul(PVM, simd_make_float4(position[0], position[1], position[2], 1.0f));
+    output.color = simd_make_float3(color[0], color[1], color[2]);
+    return output;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
+//! The CPU equivalent of FSMain in pass_through.metal.
+inline auto FSMain(const Output &input) {
+    return simd_make_float4(input.color, 1.0f);
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+
 struct Options {
     bool use_staging_buffer = true;
 };
@@ -47,9 +96,12 @@ inline auto BuildFilePath(const std::string &file_name) {
 
 class Triangle : public Example {
 public:
-    Triangle() :
-        Example("Triangle") {
+    explicit Triangle(const Arguments &arguments) :
+        Example("Triangle", arguments) {
+        MountAssetArchive(TRIANGLE_ASSET_ARCHIVE, TRIANGLE_ASSET_DIR);
+#ifdef __OBJC__
         InitResources();
+#endif
         InitPipelines();
     }
 
@@ -61,6 +113,7 @@ protected:
     }
 
     void OnResize(const Resolution &resolution) override {
+#ifdef __OBJC__
         // Update a viewport.
         _viewport.width = static_cast<double>(GetWidth(resolution));
         _viewport.height = static_cast<double>(GetHeight(resolution));
@@ -68,24 +121,46 @@ protected:
         // Update a scissor rect.
         _scissor_rect.width = GetWidth(resolution);
         _scissor_rect.height = GetHeight(resolution);
+#endif
     }
 
     void OnUpdate(uint32_t index) override {
         if (ImGui::CollapsingHeader("Options", ImGuiTreeNodeFlags_DefaultOpen)) {
-            if (ImGui::Checkbox("Use staging buffer", &_options.use_staging_buffer)) {
-                InitResources();
-            }
+            ImGui::Checkbox("Use staging buffer", &_options.use_staging_buffer);
         }
-
-        // Transformations transforms;
-        _transforms.projection = _camera.GetProjection();
-        _transforms.view = _camera.GetView();
-        _transforms.model = matrix_identity_float4x4;
+        _frame_options[index] = _options;
+
+        // Write transforms to uniforms of the current frame.
+        auto &transforms = _transforms[index];
+        transforms = _frame_allocator->Allocate<Transforms>();
+        transforms.data->projection = _camera.GetProjection();
+        transforms.data->view = _camera.GetView();
+        transforms.data->model = matrix_identity_float4x4;
     }
 
     void OnRender(uint32_t index) override {
+        // Draws are sorted, recorded without redundant state once and executed by any backend.
+        _draw_queue.Reset();
+        SubmitDraws(index);
+        _draw_queue.Sort();
+
+        _command_stream.Reset();
+        _draw_queue.Emit(_command_stream, _job_system, kDrawBatchSize);
+
+        if (_software_device) {
+            ExecuteRasterCommands();
+            return;
+        }
+
+#ifdef __OBJC__
+        // Resources are recreated on the render thread which uses and uploads them.
+        if (_frame_options[index].use_staging_buffer != _resource_options.use_staging_buffer) {
+            _resource_options = _frame_options[index];
+            InitResources();
+        }
+
         auto desc = [MTLRenderPassDescriptor new];
-        desc.colorAttachments[0].texture = _drawable.texture;
+        desc.colorAttachments[0].texture = _color_texture;
         desc.colorAttachments[0].loadAction = MTLLoadActionClear;
         desc.colorAttachments[0].storeAction = MTLStoreActionStore;
         desc.colorAttachments[0].clearColor = MTLClearColorMake(0.0, 0.0, 0.2, 1.0);
@@ -93,106 +168,141 @@ protected:
         auto encoder = [_command_buffer renderCommandEncoderWithDescriptor:desc];
         [encoder setViewport:_viewport];
         [encoder setScissorRect:_scissor_rect];
-        [encoder setVertexBuffer:_vertex_buffer offset:0 atIndex:0];
-        [encoder setVertexBytes:&_transforms length:sizeof(Transforms) atIndex:1];
-        [encoder setRenderPipelineState:_pipeline_state];
-        [encoder drawIndexedPrimitives:MTLPrimitiveTypeTriangle indexCount:3
-                             indexType:MTLIndexTypeUInt16 indexBuffer:_index_buffer
-                     indexBufferOffset:0];
+
+        // A single draw isn't worth a parallel encoder, recorders are encoded into the encoder ImGui draws with.
+        MetalCommandResources resources;
+        resources.pipelines = {GetMetalPipelineState(_pipeline_state)};
+        resources.buffers = {_vertex_buffer, _uniform_buffer, _index_buffer};
+        for (auto i = 0u; i != _command_stream.GetRecorderCount(); ++i) {
+            EncodeCommands(_command_stream.GetRecorder(i), resources, encoder);
+        }
 
         RecordDrawImGuiCommands(desc, encoder);
 
         [encoder endEncoding];
+#endif
+    }
+
+    void OnPipelineReload() override {
+        _pipeline_state = _pipeline_cache->GetPipelineState(_pipeline_descriptor);
     }
 
 private:
+#ifdef __OBJC__
     void InitResources() {
-        // Define vertices.
-        Vertex vertices[3] = {{{ 1.0f, -1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}},
-                              {{-1.0f, -1.0f, 0.0f}, {0.0f, 1.0f, 0.0f}},
-                              {{ 0.0f,  1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}}};
-
-        // Define indices.
-        uint16_t indices[3] = {0, 1, 2};
-
-        if (_options.use_staging_buffer) {
-            auto command_buffer = [_command_queue commandBuffer];
-            auto blit_encoder = [command_buffer blitCommandEncoder];
-
-            auto staging_buffer = [_device newBufferWithBytes:vertices length:sizeof(vertices)
-                                                      options:MTLResourceStorageModeShared];
-            _vertex_buffer = [_device newBufferWithLength:sizeof(vertices) options:MTLResourceStorageModePrivate];
-            [blit_encoder copyFromBuffer:staging_buffer sourceOffset:0
-                                toBuffer:_vertex_buffer destinationOffset:0 size:sizeof(vertices)];
-
-            staging_buffer = [_device newBufferWithBytes:indices length:sizeof(indices)
-                                                 options:MTLResourceStorageModeShared];
-            _index_buffer = [_device newBufferWithLength:sizeof(indices) options:MTLResourceStorageModePrivate];
-            [blit_encoder copyFromBuffer:staging_buffer sourceOffset:0
-                                toBuffer:_index_buffer destinationOffset:0 size:sizeof(indices)];
-
-            [blit_encoder endEncoding];
-            [command_buffer commit];
+        if (_resource_options.use_staging_buffer) {
+            _vertex_buffer = [_device newBufferWithLength:sizeof(kVertices) options:MTLResourceStorageModePrivate];
+            _index_buffer = [_device newBufferWithLength:sizeof(kIndices) options:MTLResourceStorageModePrivate];
+
+            // Copies are recorded into a blit pass of the next frame.
+            if (_upload_queue) {
+                _upload_queue->Upload(_vertex_buffer, 0, kVertices, sizeof(kVertices));
+                _upload_queue->Upload(_index_buffer, 0, kIndices, sizeof(kIndices));
+            }
         } else {
-            _vertex_buffer = [_device newBufferWithBytes:vertices length:sizeof(vertices)
+            _vertex_buffer = [_device newBufferWithBytes:kVertices length:sizeof(kVertices)
                                                  options:MTLResourceStorageModeShared];
 
-            _index_buffer = [_device newBufferWithBytes:indices length:sizeof(indices)
+            _index_buffer = [_device newBufferWithBytes:kIndices length:sizeof(kIndices)
                                                 options:MTLResourceStorageModeShared];
         }
     }
+#endif
 
     void InitPipelines() {
-        auto vertex_descriptor = [MTLVertexDescriptor new];
-        vertex_descriptor.attributes[0].format = MTLVertexFormatFloat3;
-        vertex_descriptor.attributes[0].offset = 0;
-        vertex_descriptor.attributes[0].bufferIndex = 0;
-        vertex_descriptor.attributes[1].format = MTLVertexFormatFloat3;
-        vertex_descriptor.attributes[1].offset = offsetof(Vertex, color);
-        vertex_descriptor.attributes[1].bufferIndex = 0;
-        vertex_descriptor.layouts[0].stride = sizeof(Vertex);
-        vertex_descriptor.layouts[0].stepFunction = MTLVertexStepFunctionPerVertex;
-        vertex_descriptor.layouts[0].stepRate = 1;
-
-        auto descriptor = [MTLRenderPipelineDescriptor new];
-        descriptor.vertexFunction = CompileShader(_device, BuildFilePath("pass_through.metal"), "VSMain");
-        descriptor.fragmentFunction = CompileShader(_device, BuildFilePath("pass_through.metal"), "FSMain");
-        descriptor.vertexDescriptor = vertex_descriptor;
-        descriptor.rasterSampleCount = 1;
-        descriptor.colorAttachments[0].pixelFormat = kMetalLayerPixelFormat;
-        descriptor.inputPrimitiveTopology = MTLPrimitiveTopologyClassTriangle;
-
-        NSError *error;
-        _pipeline_state = [_device newRenderPipelineStateWithDescriptor:descriptor error:&error];
-
-        if (!_pipeline_state) {
-            throw std::runtime_error(fmt::format("Fail to create a pipeline state: {}", error.description.UTF8String));
+        if (_software_device) {
+            InitRasterPipeline();
+        }
+
+#ifdef __OBJC__
+        // There is no pipeline to create without a GPU.
+        if (!_pipeline_cache) {
+            return;
         }
+
+        _pipeline_descriptor.shader_path = BuildFilePath("pass_through.metal");
+        _pipeline_descriptor.vertex_entrypoint = "VSMain";
+        _pipeline_descriptor.fragment_entrypoint = "FSMain";
+        _pipeline_descriptor.attributes = TriangleLayout::GetAttributes();
+        _pipeline_descriptor.layouts = {TriangleLayout::GetLayout()};
+        _pipeline_descriptor.color_formats = {kMetalLayerPixelFormat};
+        _pipeline_descriptor.sample_count = 1;
+
+        // A pipeline state is created in the background while the rest of an example initializes.
+        _pipeline_state = _pipeline_cache->GetPipelineState(_pipeline_descriptor);
+#endif
+    }
+
+    void InitRasterPipeline() {
+        _raster_pipeline.varying_count = 3;
+
+        // Shaders read buffers commands bind, like their Metal equivalents.
+        _raster_pipeline.vertex_shader = [this](uint32_t index, RasterVertex &output) {
+            auto executor = _software_device->GetCommandExecutor();
+            auto vertices = executor->GetBinding<Vertex>(CommandStage::kVertex, 0);
+            auto transforms = executor->GetBinding<Transforms>(CommandStage::kVertex, 1);
+
+            auto vs_output = VSMain(vertices[index], *transforms);
+            output.position = {vs_output.clip_space_position.x, vs_output.clip_space_position.y,
+                               vs_output.clip_space_position.z, vs_output.clip_space_position.w};
+            output.varyings[0] = vs_output.color.x;
+            output.varyings[1] = vs_output.color.y;
+            output.varyings[2] = vs_output.color.z;
+        };
+
+        _raster_pipeline.fragment_shader = [](const float *varyings) {
+            Output fs_input;
+            fs_input.color = simd_make_float3(varyings[0], varyings[1], varyings[2]);
+            auto color = FSMain(fs_input);
+            return RasterColor{color.x, color.y, color.z, color.w};
+        };
+
+        _raster_resources.pipelines = {&_raster_pipeline};
+        _raster_resources.buffers = {std::as_bytes(std::span(kVertices)), std::as_bytes(std::span(_uniform_memory)),
+                                     std::as_bytes(std::span(kIndices))};
+    }
+
+    void SubmitDraws(uint32_t index) {
+        DrawPacket packet;
+        packet.pipeline = kPipelineHandle;
+        packet.bindings[0] = {CommandStage::kVertex, 0, kVertexBufferHandle, 0};
+        packet.bindings[1] = {CommandStage::kVertex, 1, kUniformBufferHandle,
+                              static_cast<uint32_t>(_transforms[index].offset)};
+        packet.binding_count = 2;
+        packet.index_type = CommandIndexType::kUInt16;
+        packet.index_buffer = kIndexBufferHandle;
+        packet.count = 3;
+        _draw_queue.Submit(packet);
+    }
+
+    void ExecuteRasterCommands() {
+        auto &image = _software_device->GetSoftwareSwapchain()->GetImage();
+        image.Clear({0.0f, 0.0f, 0.2f, 1.0f});
+
+        _software_device->GetCommandExecutor()->Execute(_command_stream, _raster_resources, image);
     }
 
 private:
     Options _options;
+    std::array<Options, kMaxFrameCount> _frame_options;
+    Options _resource_options;
+    PipelineDescriptor _pipeline_descriptor;
+    PipelineFuture _pipeline_state;
+    RasterPipeline _raster_pipeline;
+    SoftwareCommandResources _raster_resources;
+#ifdef __OBJC__
     id<MTLBuffer> _vertex_buffer;
     id<MTLBuffer> _index_buffer;
-    id<MTLRenderPipelineState> _pipeline_state;
     MTLViewport _viewport = {0.0, 0.0, 0.0, 0.0, 0.0, 1.0};
     MTLScissorRect _scissor_rect = {0, 0, 0, 0};
-    Transforms _transforms = {};
+#endif
+    std::array<FrameAllocation<Transforms>, kMaxFrameCount> _transforms;
 };
 
 //----------------------------------------------------------------------------------------------------------------------
 
 int main(int argc, char *argv[]) {
-    @autoreleasepool {
-        try {
-            auto example = std::make_unique<Triangle>();
-            Window::GetInstance()->MainLoop(example.get());
-        }
-        catch (const std::exception &exception) {
-            std::cerr << exception.what() << std::endl;
-        }
-    }
-    return 0;
+    return RunExample<Triangle>(argc, argv);
 }
 
 //----------------------------------------------------------------------------------------------------------------------